@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace eka2l1::common {
+    /**
+     * \brief Folder of files derived from some source content, such as parsed or compiled forms of it.
+     *
+     * Each blob is stored in its own file, named after the hash and size of the source content, so
+     * a changed source simply misses. Blobs are written whole to a temporary file first, then renamed,
+     * so a half written blob is never picked up.
+     *
+     * The layout of a blob is up to the user, which should still check it on read, since the folder
+     * may hold files from older versions.
+     */
+    class blob_cache {
+        std::string folder_;
+        std::string extension_;
+
+        std::uint32_t hit_count_;
+        std::uint32_t miss_count_;
+
+    public:
+        /**
+         * \param folder        The folder to store blobs in. Created on first write.
+         * \param extension     Extension of blob files, without the dot.
+         */
+        explicit blob_cache(const std::string &folder, const std::string &extension);
+
+        /**
+         * \brief Get the path of the file storing the blob of some source content.
+         *
+         * \param hash  Hash of the source content.
+         * \param size  Size of the source content.
+         */
+        std::string get_file_path(const std::uint64_t hash, const std::uint64_t size) const;
+
+        /**
+         * \brief Read the blob of some source content.
+         *
+         * \returns False if there is no blob for the content, or it can't be read.
+         */
+        bool read(const std::uint64_t hash, const std::uint64_t size, std::vector<std::uint8_t> &blob) const;
+
+        /**
+         * \brief Store the blob of some source content, replacing any existing one.
+         *
+         * \returns True on success.
+         */
+        bool write(const std::uint64_t hash, const std::uint64_t size, const std::uint8_t *blob, const std::size_t blob_size);
+
+        void record_hit() {
+            hit_count_++;
+        }
+
+        void record_miss() {
+            miss_count_++;
+        }
+
+        const std::string &folder() const {
+            return folder_;
+        }
+
+        std::uint32_t hit_count() const {
+            return hit_count_;
+        }
+
+        std::uint32_t miss_count() const {
+            return miss_count_;
+        }
+    };
+}
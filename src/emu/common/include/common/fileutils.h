@@ -26,6 +26,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace eka2l1::common {
     enum file_type {
@@ -125,6 +126,16 @@ namespace eka2l1::common {
      */
     FILE *open_c_file(const std::string &target_file, const char *mode);
 
+    /**
+     * @brief Read a whole file into memory.
+     *
+     * @param path              The path to the file, in UTF-8.
+     * @param content           On success, filled with the content of the file.
+     *
+     * @returns True on success.
+     */
+    bool read_whole_file(const std::string &path, std::vector<std::uint8_t> &content);
+
     struct dir_entry {
         file_type type;
         std::size_t size;
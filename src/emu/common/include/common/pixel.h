@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Pixel row conversion kernels, for pixel formats the GPU can't take directly.
+ *
+ * All kernels output 24-bit pixels, 3 bytes each, tightly packed. Sub-byte pixels are read
+ * starting from the least significant bits of each byte, like Symbian bitmaps store them.
+ *
+ * Kernels are vectorized with SSE2 on x86 and NEON on ARM, and fall back to plain C++ elsewhere.
+ */
+namespace eka2l1::common {
+    /**
+     * \brief Drop the last byte of each 32-bit pixel.
+     *
+     * \param source        The 32-bit pixels. The first three bytes in memory of each are the output pixel.
+     * \param dest          Destination of the 24-bit pixels, must hold 3 * pixel_count bytes.
+     * \param pixel_count   Number of pixels to convert.
+     */
+    void pack_32bpp_to_24bpp(const std::uint32_t *source, std::uint8_t *dest, const std::size_t pixel_count);
+
+    /**
+     * \brief Convert gray pixels to 24-bit pixels, by repeating the gray level in all three channels.
+     *
+     * Gray levels with less than 8 bits are scaled to the full range, so the brightest level is 0xFF.
+     *
+     * \param source            The gray pixels.
+     * \param dest              Destination of the 24-bit pixels, must hold 3 * pixel_count bytes.
+     * \param pixel_count       Number of pixels to convert.
+     * \param bits_per_pixel    Bits per gray pixel. Can be 1, 2, 4 or 8.
+     */
+    void expand_gray_to_24bpp(const std::uint8_t *source, std::uint8_t *dest, const std::size_t pixel_count,
+        const std::uint32_t bits_per_pixel);
+
+    /**
+     * \brief Convert palette indexed pixels to 24-bit pixels.
+     *
+     * \param source            The palette indices.
+     * \param dest              Destination of the 24-bit pixels, must hold 3 * pixel_count bytes.
+     * \param pixel_count       Number of pixels to convert.
+     * \param lookup            The palette, with 1 << bits_per_pixel entries, in the same form as the source of
+     *                          pack_32bpp_to_24bpp.
+     * \param bits_per_pixel    Bits per index. Can be 4 or 8.
+     */
+    void lookup_palette_to_24bpp(const std::uint8_t *source, std::uint8_t *dest, const std::size_t pixel_count,
+        const std::uint32_t *lookup, const std::uint32_t bits_per_pixel);
+
+    /**
+     * \brief Get the name of the instruction set the kernels were built for.
+     */
+    const char *pixel_kernels_instruction_set();
+}
@@ -42,6 +42,48 @@ namespace eka2l1::common {
     */
     bool unmap_memory(void *ptr, const std::size_t size);
 
+    /**
+     * \brief Map memory with defined size, which pages can later be aliased to other addresses.
+     *
+     * The memory is reserved and must be committed before use, like map_memory. On platforms
+     * that do not support aliasing, this is the same as map_memory.
+     *
+     * \returns A valid pointer on success. Nullptr is fail.
+     *
+     * \sa alias_memory
+    */
+    void *map_shared_memory(const std::size_t size);
+
+    /**
+     * \brief Make pages of a shared memory region also visible at another address.
+     *
+     * Both views refer to the same physical pages, so writes through one view are seen
+     * through the other one. The previous mapping at the destination is replaced.
+     *
+     * \param source Page-aligned pointer inside a region mapped by map_shared_memory.
+     * \param dest Page-aligned destination address.
+     * \param size Size of the region to alias.
+     * \param dest_prot Protection of the destination view.
+     *
+     * \returns True on success, false if the source is not shareable or aliasing is not supported.
+    */
+    bool alias_memory(void *source, void *dest, const std::size_t size, const prot dest_prot);
+
+    /**
+     * \brief Remove an alias view, leaving the destination region reserved and inaccessible.
+     *
+     * \param dest Pointer to the view previously created by alias_memory.
+     * \param size Size of the view to remove.
+     *
+     * \returns True on success.
+    */
+    bool unalias_memory(void *dest, const std::size_t size);
+
+    /**
+     * \brief Returns true if the host can alias shared memory pages to another address.
+    */
+    bool is_memory_aliasing_supported();
+
     /**
      * \brief Commit reserved memory region.
      *
@@ -98,9 +140,12 @@ namespace eka2l1::common {
     /**
      * \brief Unmap a file mapped to memory
      *
+     * \param ptr  Pointer returned by map_file.
+     * \param size Size of the mapped region. Required to unmap on POSIX, where leaving it 0 keeps the mapping.
+     *
      * \returns True on success.
     */
-    bool unmap_file(void *ptr);
+    bool unmap_file(void *ptr, const std::size_t size = 0);
 
     /**
      * @param   Align address to host page size
@@ -22,6 +22,8 @@
 
 #include <common/algorithm.h>
 #include <regex>
+#include <string>
+#include <vector>
 
 namespace eka2l1::common {
     /**
@@ -33,4 +35,34 @@ namespace eka2l1::common {
     template <typename T>
     std::size_t match_wildcard_in_string(const std::basic_string<T> &reference, const std::basic_string<T> &match_pattern,
         const bool is_fold);
+
+    /**
+     * \brief A wildcard pattern split into its literal parts, so it can be matched against many strings
+     *        without building a regex.
+     *
+     * Supports '*' (any sequence) and '?' (any single character). The whole string must match.
+     */
+    class wildcard_matcher {
+        std::vector<std::string> segments_;
+        bool leading_star_;
+        bool trailing_star_;
+        bool has_wildcard_;
+        bool is_fold_;
+
+        bool match_segment_at(const std::string &str, const std::size_t pos, const std::string &segment) const;
+
+    public:
+        explicit wildcard_matcher(const std::string &pattern, const bool is_fold);
+
+        bool match(const std::string &str) const;
+
+        /**
+         * \brief Check if the pattern contains any wildcard character.
+         *
+         * If it doesn't, a match is an equality comparison.
+         */
+        bool has_wildcard() const {
+            return has_wildcard_;
+        }
+    };
 }
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/blobcache.h>
+#include <common/fileutils.h>
+#include <common/path.h>
+
+#include <fmt/format.h>
+
+namespace eka2l1::common {
+    blob_cache::blob_cache(const std::string &folder, const std::string &extension)
+        : folder_(folder)
+        , extension_(extension)
+        , hit_count_(0)
+        , miss_count_(0) {
+    }
+
+    std::string blob_cache::get_file_path(const std::uint64_t hash, const std::uint64_t size) const {
+        return eka2l1::add_path(folder_, fmt::format("{:016X}_{:X}.{}", hash, size, extension_));
+    }
+
+    bool blob_cache::read(const std::uint64_t hash, const std::uint64_t size, std::vector<std::uint8_t> &blob) const {
+        const std::string path = get_file_path(hash, size);
+
+        if (!common::exists(path)) {
+            return false;
+        }
+
+        return common::read_whole_file(path, blob);
+    }
+
+    bool blob_cache::write(const std::uint64_t hash, const std::uint64_t size, const std::uint8_t *blob, const std::size_t blob_size) {
+        common::create_directories(folder_);
+
+        const std::string path = get_file_path(hash, size);
+        const std::string temp_path = path + ".tmp";
+
+        FILE *file = common::open_c_file(temp_path, "wb");
+        if (!file) {
+            return false;
+        }
+
+        const bool written = (fwrite(blob, 1, blob_size, file) == blob_size);
+        fclose(file);
+
+        if (written) {
+            if (common::exists(path)) {
+                common::remove(path);
+            }
+
+            if (common::move_file(temp_path, path)) {
+                return true;
+            }
+        }
+
+        common::remove(temp_path);
+        return false;
+    }
+}
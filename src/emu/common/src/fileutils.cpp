@@ -964,4 +964,25 @@ namespace eka2l1::common {
         return fopen(target_file.c_str(), mode);
 #endif
     }
+
+    bool read_whole_file(const std::string &path, std::vector<std::uint8_t> &content) {
+        const std::int64_t size = file_size(path);
+
+        if (size < 0) {
+            return false;
+        }
+
+        FILE *file = open_c_file(path, "rb");
+
+        if (!file) {
+            return false;
+        }
+
+        content.resize(static_cast<std::size_t>(size));
+
+        const bool result = (fread(content.data(), 1, content.size(), file) == content.size());
+        fclose(file);
+
+        return result;
+    }
 }
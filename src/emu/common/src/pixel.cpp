@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/algorithm.h>
+#include <common/pixel.h>
+#include <common/platform.h>
+
+#include <array>
+#include <cstring>
+
+#if EKA2L1_ARCH(X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define EKA2L1_PIXEL_SSE2 1
+#include <emmintrin.h>
+#elif EKA2L1_ARCH(ARM64) || EKA2L1_ARCH(ARM_NEON) || defined(__ARM_NEON)
+#define EKA2L1_PIXEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace eka2l1::common {
+    // Pixels are converted in chunks through a small buffer on the stack
+    static constexpr std::size_t CHUNK_PIXEL_COUNT = 256;
+
+#if EKA2L1_PIXEL_SSE2
+    // Pack four 32-bit pixels into 12 bytes. Writes 2 bytes past them, which the caller must have room for.
+    static inline void pack_four_pixels_sse2(const __m128i pixels, std::uint8_t *dest) {
+        // In each 64-bit lane, keep the first pixel's low 24 bits, and move the second one's right after it
+        const __m128i first_mask = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+        const __m128i second_mask = _mm_set_epi32(0x0000FFFF, static_cast<int>(0xFF000000), 0x0000FFFF, static_cast<int>(0xFF000000));
+
+        const __m128i packed = _mm_or_si128(_mm_and_si128(pixels, first_mask),
+            _mm_and_si128(_mm_srli_epi64(pixels, 8), second_mask));
+
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dest), packed);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dest + 6), _mm_srli_si128(packed, 8));
+    }
+#endif
+
+    void pack_32bpp_to_24bpp(const std::uint32_t *source, std::uint8_t *dest, const std::size_t pixel_count) {
+        std::size_t i = 0;
+
+#if EKA2L1_PIXEL_SSE2
+        // Keep one pixel after the group for the bytes written past it
+        for (; i + 5 <= pixel_count; i += 4, dest += 12) {
+            pack_four_pixels_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i)), dest);
+        }
+#elif EKA2L1_PIXEL_NEON
+        for (; i + 16 <= pixel_count; i += 16, dest += 48) {
+            const uint8x16x4_t pixels = vld4q_u8(reinterpret_cast<const std::uint8_t *>(source + i));
+            const uint8x16x3_t packed = { { pixels.val[0], pixels.val[1], pixels.val[2] } };
+
+            vst3q_u8(dest, packed);
+        }
+#endif
+
+        // Full 4 byte stores, the extra byte is overwritten by the next pixel
+        for (; i + 1 < pixel_count; i++, dest += 3) {
+            std::memcpy(dest, source + i, 4);
+        }
+
+        if (i < pixel_count) {
+            std::memcpy(dest, source + i, 3);
+        }
+    }
+
+    static void expand_gray8_to_24bpp(const std::uint8_t *source, std::uint8_t *dest, const std::size_t pixel_count) {
+        std::size_t i = 0;
+
+#if EKA2L1_PIXEL_SSE2
+        const __m128i zero = _mm_setzero_si128();
+
+        for (; i + 17 <= pixel_count; i += 16, dest += 48) {
+            const __m128i grays = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+            const __m128i grays_low = _mm_unpacklo_epi8(grays, zero);
+            const __m128i grays_high = _mm_unpackhi_epi8(grays, zero);
+
+            const __m128i levels[4] = {
+                _mm_unpacklo_epi16(grays_low, zero),
+                _mm_unpackhi_epi16(grays_low, zero),
+                _mm_unpacklo_epi16(grays_high, zero),
+                _mm_unpackhi_epi16(grays_high, zero)
+            };
+
+            for (int j = 0; j < 4; j++) {
+                const __m128i pixels = _mm_or_si128(_mm_or_si128(levels[j], _mm_slli_epi32(levels[j], 8)),
+                    _mm_slli_epi32(levels[j], 16));
+
+                pack_four_pixels_sse2(pixels, dest + j * 12);
+            }
+        }
+#elif EKA2L1_PIXEL_NEON
+        for (; i + 16 <= pixel_count; i += 16, dest += 48) {
+            const uint8x16_t grays = vld1q_u8(source + i);
+            const uint8x16x3_t pixels = { { grays, grays, grays } };
+
+            vst3q_u8(dest, pixels);
+        }
+#endif
+
+        for (; i < pixel_count; i++, dest += 3) {
+            std::memset(dest, source[i], 3);
+        }
+    }
+
+    template <std::uint32_t BPP>
+    struct gray_unpack_table {
+        static constexpr std::uint32_t PIXELS_PER_BYTE = 8 / BPP;
+        std::array<std::uint8_t, 256 * PIXELS_PER_BYTE> levels_;
+
+        gray_unpack_table() {
+            constexpr std::uint32_t max_level = (1 << BPP) - 1;
+
+            for (std::uint32_t value = 0; value < 256; value++) {
+                for (std::uint32_t j = 0; j < PIXELS_PER_BYTE; j++) {
+                    const std::uint32_t level = (value >> (j * BPP)) & max_level;
+                    levels_[value * PIXELS_PER_BYTE + j] = static_cast<std::uint8_t>(level * 0xFF / max_level);
+                }
+            }
+        }
+    };
+
+    template <std::uint32_t BPP>
+    static void expand_packed_gray_to_24bpp(const std::uint8_t *source, std::uint8_t *dest, const std::size_t pixel_count) {
+        using table_type = gray_unpack_table<BPP>;
+        static const table_type table;
+
+        // Room for the pixels of the last partial byte
+        std::uint8_t grays[CHUNK_PIXEL_COUNT + table_type::PIXELS_PER_BYTE];
+
+        for (std::size_t i = 0; i < pixel_count; i += CHUNK_PIXEL_COUNT) {
+            const std::size_t count = common::min(CHUNK_PIXEL_COUNT, pixel_count - i);
+            const std::size_t byte_count = (count + table_type::PIXELS_PER_BYTE - 1) / table_type::PIXELS_PER_BYTE;
+
+            for (std::size_t j = 0; j < byte_count; j++) {
+                std::memcpy(grays + j * table_type::PIXELS_PER_BYTE, table.levels_.data() + source[j] * table_type::PIXELS_PER_BYTE,
+                    table_type::PIXELS_PER_BYTE);
+            }
+
+            expand_gray8_to_24bpp(grays, dest + i * 3, count);
+            source += byte_count;
+        }
+    }
+
+    void expand_gray_to_24bpp(const std::uint8_t *source, std::uint8_t *dest, const std::size_t pixel_count,
+        const std::uint32_t bits_per_pixel) {
+        switch (bits_per_pixel) {
+        case 1:
+            expand_packed_gray_to_24bpp<1>(source, dest, pixel_count);
+            break;
+
+        case 2:
+            expand_packed_gray_to_24bpp<2>(source, dest, pixel_count);
+            break;
+
+        case 4:
+            expand_packed_gray_to_24bpp<4>(source, dest, pixel_count);
+            break;
+
+        case 8:
+            expand_gray8_to_24bpp(source, dest, pixel_count);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void lookup_palette_to_24bpp(const std::uint8_t *source, std::uint8_t *dest, const std::size_t pixel_count,
+        const std::uint32_t *lookup, const std::uint32_t bits_per_pixel) {
+        if ((bits_per_pixel != 4) && (bits_per_pixel != 8)) {
+            return;
+        }
+
+        std::uint32_t colors[CHUNK_PIXEL_COUNT + 1];
+
+        for (std::size_t i = 0; i < pixel_count; i += CHUNK_PIXEL_COUNT) {
+            const std::size_t count = common::min(CHUNK_PIXEL_COUNT, pixel_count - i);
+
+            if (bits_per_pixel == 8) {
+                for (std::size_t j = 0; j < count; j++) {
+                    colors[j] = lookup[source[j]];
+                }
+
+                source += count;
+            } else {
+                const std::size_t byte_count = (count + 1) >> 1;
+
+                for (std::size_t j = 0; j < byte_count; j++) {
+                    colors[j * 2] = lookup[source[j] & 0xF];
+                    colors[j * 2 + 1] = lookup[source[j] >> 4];
+                }
+
+                source += byte_count;
+            }
+
+            pack_32bpp_to_24bpp(colors, dest + i * 3, count);
+        }
+    }
+
+    const char *pixel_kernels_instruction_set() {
+#if EKA2L1_PIXEL_SSE2
+        return "SSE2";
+#elif EKA2L1_PIXEL_NEON
+        return "NEON";
+#else
+        return "none";
+#endif
+    }
+}
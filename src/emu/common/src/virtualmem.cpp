@@ -38,8 +38,10 @@ namespace eka2l1::common {
         return VirtualAlloc(nullptr, size,
             MEM_RESERVE, PAGE_NOACCESS);
 #else
-        return mmap(nullptr, size, PROT_NONE,
-            MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+        void *result = mmap(nullptr, size, PROT_NONE,
+            MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+
+        return (result == MAP_FAILED) ? nullptr : result;
 #endif
     }
 
@@ -59,6 +61,52 @@ namespace eka2l1::common {
         return true;
     }
 
+    void *map_shared_memory(const std::size_t size) {
+#if EKA2L1_PLATFORM(UNIX) && defined(MREMAP_FIXED)
+        void *result = mmap(nullptr, size, PROT_NONE, MAP_ANONYMOUS | MAP_SHARED | MAP_NORESERVE, -1, 0);
+        return (result == MAP_FAILED) ? nullptr : result;
+#else
+        return map_memory(size);
+#endif
+    }
+
+    bool alias_memory(void *source, void *dest, const std::size_t size, const prot dest_prot) {
+#if EKA2L1_PLATFORM(UNIX) && defined(MREMAP_FIXED)
+        // Zero old size on a shared mapping creates a new mapping of the same pages
+        void *result = mremap(source, 0, size, MREMAP_MAYMOVE | MREMAP_FIXED, dest);
+
+        if (result == MAP_FAILED) {
+            return false;
+        }
+
+        if (mprotect(dest, size, translate_protection(dest_prot)) == -1) {
+            unalias_memory(dest, size);
+            return false;
+        }
+
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool unalias_memory(void *dest, const std::size_t size) {
+#if EKA2L1_PLATFORM(UNIX) && defined(MREMAP_FIXED)
+        void *result = mmap(dest, size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED | MAP_NORESERVE, -1, 0);
+        return (result != MAP_FAILED);
+#else
+        return false;
+#endif
+    }
+
+    bool is_memory_aliasing_supported() {
+#if EKA2L1_PLATFORM(UNIX) && defined(MREMAP_FIXED)
+        return true;
+#else
+        return false;
+#endif
+    }
+
     bool commit(void *ptr, const std::size_t size, const prot commit_prot) {
 #if EKA2L1_PLATFORM(WIN32)
         DWORD oldprot = 0;
@@ -245,14 +293,25 @@ namespace eka2l1::common {
         }
 
         auto map_ptr = mmap(nullptr, map_size, prot_mode, MAP_PRIVATE, file_handle, 0);
+
+        // The mapping keeps the file referenced
+        close(file_handle);
+
+        if (map_ptr == MAP_FAILED) {
+            return nullptr;
+        }
 #endif
 
         return map_ptr;
     }
 
-    bool unmap_file(void *ptr) {
+    bool unmap_file(void *ptr, const std::size_t size) {
 #if EKA2L1_PLATFORM(WIN32)
         UnmapViewOfFile(ptr);
+#else
+        if (size != 0) {
+            return munmap(ptr, size) == 0;
+        }
 #endif
 
         return true;
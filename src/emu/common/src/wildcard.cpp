@@ -21,6 +21,8 @@
 #include <common/algorithm.h>
 #include <common/wildcard.h>
 
+#include <cctype>
+
 namespace eka2l1::common {
     template <>
     std::basic_string<char> wildcard_to_regex_string(std::basic_string<char> regexstr) {
@@ -67,4 +69,118 @@ namespace eka2l1::common {
         const bool is_fold);
     template std::size_t match_wildcard_in_string<wchar_t>(const std::wstring &reference, const std::wstring &match_pattern,
         const bool is_fold);
+
+    wildcard_matcher::wildcard_matcher(const std::string &pattern, const bool is_fold)
+        : leading_star_(false)
+        , trailing_star_(false)
+        , has_wildcard_(false)
+        , is_fold_(is_fold) {
+        std::string current;
+
+        for (std::size_t i = 0; i < pattern.length(); i++) {
+            const char c = pattern[i];
+
+            if (c == '*') {
+                if (i == 0) {
+                    leading_star_ = true;
+                }
+
+                if (!current.empty()) {
+                    segments_.push_back(std::move(current));
+                    current.clear();
+                }
+
+                has_wildcard_ = true;
+                continue;
+            }
+
+            if (c == '?') {
+                has_wildcard_ = true;
+            }
+
+            current += is_fold ? static_cast<char>(std::tolower(static_cast<unsigned char>(c))) : c;
+        }
+
+        if (!current.empty()) {
+            segments_.push_back(std::move(current));
+        }
+
+        trailing_star_ = !pattern.empty() && (pattern.back() == '*');
+    }
+
+    bool wildcard_matcher::match_segment_at(const std::string &str, const std::size_t pos, const std::string &segment) const {
+        for (std::size_t i = 0; i < segment.length(); i++) {
+            if (segment[i] == '?') {
+                continue;
+            }
+
+            const char c = is_fold_ ? static_cast<char>(std::tolower(static_cast<unsigned char>(str[pos + i]))) : str[pos + i];
+            if (c != segment[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool wildcard_matcher::match(const std::string &str) const {
+        if (segments_.empty()) {
+            return leading_star_ || str.empty();
+        }
+
+        if ((segments_.size() == 1) && !leading_star_ && !trailing_star_) {
+            return (str.length() == segments_[0].length()) && match_segment_at(str, 0, segments_[0]);
+        }
+
+        std::size_t begin_pos = 0;
+        std::size_t end_pos = str.length();
+
+        std::size_t first = 0;
+        std::size_t last = segments_.size();
+
+        // Anchored ends must match in place
+        if (!leading_star_) {
+            if ((segments_[0].length() > end_pos) || !match_segment_at(str, 0, segments_[0])) {
+                return false;
+            }
+
+            begin_pos = segments_[0].length();
+            first++;
+        }
+
+        if (!trailing_star_) {
+            const std::string &segment = segments_.back();
+
+            if ((segment.length() > end_pos - begin_pos) || !match_segment_at(str, end_pos - segment.length(), segment)) {
+                return false;
+            }
+
+            end_pos -= segment.length();
+            last--;
+        }
+
+        // Place the rest as early as possible. Since each segment has a fixed length, this never
+        // misses a match.
+        for (std::size_t i = first; i < last; i++) {
+            const std::string &segment = segments_[i];
+            bool found = false;
+
+            while (begin_pos + segment.length() <= end_pos) {
+                if (match_segment_at(str, begin_pos, segment)) {
+                    found = true;
+                    break;
+                }
+
+                begin_pos++;
+            }
+
+            if (!found) {
+                return false;
+            }
+
+            begin_pos += segment.length();
+        }
+
+        return true;
+    }
 }
@@ -119,6 +119,8 @@ namespace eka2l1::config {
         bool nearest_neighbor_filtering{ true };
         bool integer_scaling{ true };
         bool cpu_load_save{ true };
+        bool enable_fastmem{ false };
+        int cpu_core_count{ 1 };
         bool mime_detection{ true };
 
         std::atomic<bool> stepping{ false };
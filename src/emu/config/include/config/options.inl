@@ -56,6 +56,8 @@ OPTION(hide-mouse-in-screen-space, hide_mouse_in_screen_space, false)
 OPTION(enable-nearest-neighbor-filter, nearest_neighbor_filtering, true)
 OPTION(integer-scaling, integer_scaling, true)
 OPTION(cpu-load-save, cpu_load_save, true)
+OPTION(enable-fastmem, enable_fastmem, false)
+OPTION(cpu-core-count, cpu_core_count, 1)
 OPTION(mime-detection, mime_detection, true)
 OPTION(rtos-level, rtos_level, "mid")
 OPTION(ui-new-style, ui_new_style, true)
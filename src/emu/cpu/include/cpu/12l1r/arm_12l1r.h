@@ -89,5 +89,6 @@ namespace eka2l1::arm {
         }
 
         std::uint32_t get_num_instruction_executed() override;
+        std::uint64_t get_total_jit_compile_time() override;
     };
 }
\ No newline at end of file
@@ -25,8 +25,9 @@
 
 #include <cstdint>
 #include <functional>
-#include <map>
+#include <array>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1::arm::r12l1 {
@@ -74,24 +75,65 @@ namespace eka2l1::arm::r12l1 {
 
     using on_block_invalidate_callback_type = std::function<void(translated_block *)>;
 
+    // Granularity of the invalidation index. Symbian code is always mapped at least 4KB aligned.
+    static constexpr std::uint32_t BLOCK_CACHE_PAGE_BITS = 12;
+
+    // Direct-mapped lookup sits in front of the hash map. Thumb blocks are 2-byte aligned so
+    // bit 0 is dropped from the index.
+    static constexpr std::uint32_t BLOCK_CACHE_DIRECT_ENTRY_SHIFT = 1;
+    static constexpr std::uint32_t BLOCK_CACHE_DIRECT_ENTRY_COUNT = 0x2000;
+    static constexpr std::uint32_t BLOCK_CACHE_DIRECT_ENTRY_MASK = BLOCK_CACHE_DIRECT_ENTRY_COUNT - 1;
+
     class block_cache {
         using translated_block_inst = std::unique_ptr<translated_block>;
         using translated_block_key = vaddress;
 
-        std::map<translated_block_key, translated_block_inst> blocks_;
+        struct direct_entry {
+            vaddress addr_;
+            translated_block *block_;
+        };
+
+        std::unordered_map<translated_block_key, translated_block_inst> blocks_;
+
+        // Reverse index: guest page number -> blocks that have code on that page
+        std::unordered_map<vaddress, std::vector<translated_block *>> page_blocks_;
+        std::array<direct_entry, BLOCK_CACHE_DIRECT_ENTRY_COUNT> direct_;
+
         on_block_invalidate_callback_type invalidate_callback_;
 
+        direct_entry &get_direct_entry(const vaddress addr) {
+            return direct_[(addr >> BLOCK_CACHE_DIRECT_ENTRY_SHIFT) & BLOCK_CACHE_DIRECT_ENTRY_MASK];
+        }
+
+        void add_to_page(const vaddress page, translated_block *block);
+        void remove_from_pages(translated_block *block);
+        void remove_block(translated_block *block);
+
     public:
         explicit block_cache();
 
         bool add_block(const vaddress start_addr);
 
+        /**
+         * @brief Register the pages the block's guest code spans in the invalidation index.
+         *
+         * Must be called once the block has been fully translated and its size is known.
+         * Until then, the block is only indexed on the page of its start address.
+         *
+         * @param block The block to commit.
+         */
+        void commit_block(translated_block *block);
+
         // The block that is returned by this is consistent in memory
         translated_block *lookup_block(const vaddress start_addr);
 
         void flush_range(const vaddress range_start, const vaddress range_end);
         void flush_all();
 
+        std::size_t size() const {
+            return blocks_.size();
+        }
+
         void set_on_block_invalidate_callback(on_block_invalidate_callback_type cb) {
             invalidate_callback_ = cb;
         }
@@ -65,6 +65,8 @@ namespace eka2l1::arm::r12l1 {
         std::uint32_t flags_;
         std::uint32_t current_fpscr_;
 
+        std::uint64_t compile_time_;
+
         r12l1_core *parent_;
 
 #if R12L1_ENABLE_FUZZ
@@ -145,5 +147,13 @@ namespace eka2l1::arm::r12l1 {
         std::uint32_t current_compiling_fpscr() const {
             return current_fpscr_;
         }
+
+        void add_compile_time(const std::uint64_t nanosecs) {
+            compile_time_ += nanosecs;
+        }
+
+        std::uint64_t total_compile_time() const {
+            return compile_time_;
+        }
     };
 }
\ No newline at end of file
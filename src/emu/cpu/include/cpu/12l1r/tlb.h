@@ -123,5 +123,22 @@ namespace eka2l1::arm::r12l1 {
             // TLB miss
             return nullptr;
         }
+
+        /**
+         * \brief Look up an address for writing, ignoring entries that are cached read-only.
+         */
+        std::uint8_t *lookup_write(const vaddress addr) {
+            const std::size_t page_index = addr >> page_bits;
+            const std::size_t tlb_index = page_index & (TLB_ENTRY_COUNT - 1);
+            const vaddress addr_normed = addr & ~page_mask;
+
+            tlb_entry &entry = entries[tlb_index];
+
+            if (!entry.host_base || (entry.write_addr != addr_normed)) {
+                return nullptr;
+            }
+
+            return entry.host_base + (addr & page_mask);
+        }
     };
 }
\ No newline at end of file
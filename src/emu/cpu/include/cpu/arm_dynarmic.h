@@ -28,6 +28,7 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 
 namespace eka2l1 {
     class ntimer;
@@ -58,6 +59,17 @@ namespace eka2l1 {
             bool exclusive_write64(core *cc, address vaddr, std::uint64_t value) override;
         };
 
+        static constexpr std::uint64_t FASTMEM_ARENA_SIZE = 0x100000000ULL;
+        static constexpr std::uint32_t FASTMEM_PAGE_BITS = 12;
+        static constexpr std::uint32_t FASTMEM_PAGE_SIZE = 1 << FASTMEM_PAGE_BITS;
+        static constexpr std::uint32_t FASTMEM_PAGE_COUNT = static_cast<std::uint32_t>(FASTMEM_ARENA_SIZE >> FASTMEM_PAGE_BITS);
+
+        enum fastmem_page_state : std::uint8_t {
+            FASTMEM_PAGE_STATE_UNMAPPED = 0,
+            FASTMEM_PAGE_STATE_MIRRORED = 1,
+            FASTMEM_PAGE_STATE_UNSUPPORTED = 2 ///< Host memory of this page can't be aliased, always use the TLB.
+        };
+
         class dynarmic_core : public core {
             friend class dynarmic_core_callback;
 
@@ -71,9 +83,20 @@ namespace eka2l1 {
             std::uint32_t ticks_target{ 0 };
 
             bool interpreter_callback_inited;
+            Dynarmic::ExclusiveMonitor *jit_monitor;
+
+            // Host view of the whole 4GB guest address space. Pages are mirrored lazily, when the
+            // slow path fills the TLB, and dropped on the same events that dirty/flush the TLB.
+            std::uint8_t *fastmem_arena;
+            std::vector<std::uint8_t> fastmem_page_states;
+            std::uint32_t fastmem_mirrored_count;
+
+            bool init_fastmem();
+            void mirror_fastmem_page(const address vaddr, std::uint8_t *ptr, const prot protection);
+            void unmirror_fastmem_page(const address vaddr);
 
         public:
-            explicit dynarmic_core(arm::exclusive_monitor *monitor);
+            explicit dynarmic_core(arm::exclusive_monitor *monitor, const bool enable_fastmem = false);
             ~dynarmic_core() override;
 
             void run(const std::uint32_t instruction_count) override;
@@ -103,6 +126,7 @@ namespace eka2l1 {
 
             bool is_thumb_mode() override;
 
+            void set_page_table(page_table *table) override;
             void set_tlb_page(address vaddr, std::uint8_t *ptr, prot protection) override;
             void dirty_tlb_page(address addr) override;
             void flush_tlb() override;
@@ -116,6 +140,10 @@ namespace eka2l1 {
             bool should_clear_old_memory_map() const override {
                 return false;
             }
+
+            bool is_fastmem_enabled() const {
+                return fastmem_arena != nullptr;
+            }
         };
     }
 }
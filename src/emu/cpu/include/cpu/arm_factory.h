@@ -35,9 +35,13 @@ namespace eka2l1 {
          * This factory methods provide various CPU translator backend for you to choose. The CPU must accompanies
          * with other system like kernel or timing, in order to help for emulation.
          * 
+         * \param monitor        The exclusive monitor shared between cores.
+         * \param arm_type       The backend to create.
+         * \param enable_fastmem Mirror guest memory into a host-mapped address space, on backends that support it.
+         *
          * \returns An instance to the CPU executor.
          */
-        core_instance create_core(exclusive_monitor *monitor, arm_emulator_type arm_type);
+        core_instance create_core(exclusive_monitor *monitor, arm_emulator_type arm_type, const bool enable_fastmem = false);
 
         exclusive_monitor_instance create_exclusive_monitor(arm_emulator_type arm_type, const std::size_t core_count);
     }
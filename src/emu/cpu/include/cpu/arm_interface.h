@@ -22,6 +22,7 @@
 #include <array>
 #include <functional>
 #include <memory>
+#include <mutex>
 
 #include <common/types.h>
 
@@ -62,7 +63,36 @@ namespace eka2l1::arm {
     using system_call_handler_func = std::function<void(const std::uint32_t)>;
     using handle_exception_func = std::function<bool(exception_type, const std::uint32_t)>;
 
-    class core;
+    /**
+     * \brief Flat table mapping each guest page of the current address space to its host memory.
+     *
+     * The table is published by the memory model's MMU, and read inline by the CPU backends before
+     * they fall back to the memory callbacks. A null entry only means the page has not been published
+     * yet; the callbacks still decide if the access is valid.
+     */
+    struct page_table {
+        static constexpr std::uint32_t PAGE_BITS = 12;
+        static constexpr std::uint32_t PAGE_SIZE = 1 << PAGE_BITS;
+        static constexpr std::uint32_t PAGE_MASK = PAGE_SIZE - 1;
+        static constexpr std::uint32_t ENTRY_COUNT = 1 << (32 - PAGE_BITS);
+
+        std::array<std::uint8_t *, ENTRY_COUNT> pointers;
+
+        explicit page_table() {
+            pointers.fill(nullptr);
+        }
+
+        template <typename T>
+        T *get(const address addr) const {
+            // Accesses crossing the page boundary always take the slow path
+            if ((addr & PAGE_MASK) > PAGE_SIZE - sizeof(T)) {
+                return nullptr;
+            }
+
+            std::uint8_t *base = pointers[addr >> PAGE_BITS];
+            return base ? reinterpret_cast<T *>(base + (addr & PAGE_MASK)) : nullptr;
+        }
+    };
 
     class exclusive_monitor {
     public:
@@ -96,6 +126,12 @@ namespace eka2l1::arm {
     private:
         std::size_t core_num_ = 0;
 
+        std::mutex guest_lock_; ///< Held while guest code runs on the core.
+        bool in_guest_ = false;
+
+    protected:
+        page_table *page_table_ = nullptr;
+
     public:
         memory_operation_8bit_func read_8bit;
         memory_operation_8bit_func write_8bit;
@@ -164,6 +200,55 @@ namespace eka2l1::arm {
             core_num_ = num;
         }
 
+        /**
+         * \brief Mark that the calling thread starts running guest code on this core.
+         *
+         * While in guest code, the core's TLB and code cache may only be changed by the thread running it.
+         * Other threads use hold_out_of_guest.
+         */
+        void enter_guest() {
+            guest_lock_.lock();
+            in_guest_ = true;
+        }
+
+        /**
+         * \brief Mark that the calling thread stops running guest code on this core.
+         *
+         * Handlers called from guest code that may wait on another core, like system calls, must leave
+         * guest code while they run, or both cores wait on each other.
+         *
+         * \returns False if the core was not in guest code.
+         */
+        bool leave_guest() {
+            if (!in_guest_) {
+                return false;
+            }
+
+            in_guest_ = false;
+            guest_lock_.unlock();
+
+            return true;
+        }
+
+        /**
+         * \brief Keep the core out of guest code, stopping it first if it's running.
+         *
+         * A running core is stopped, so its slice ends early. Must not be called from the thread running
+         * the core while it is in guest code.
+         *
+         * \returns Lock that keeps the core out of guest code while it's held.
+         */
+        std::unique_lock<std::mutex> hold_out_of_guest() {
+            std::unique_lock<std::mutex> guard(guest_lock_, std::try_to_lock);
+
+            if (!guard.owns_lock()) {
+                stop();
+                guard.lock();
+            }
+
+            return guard;
+        }
+
         virtual void run(const std::uint32_t instruction_count) = 0;
         virtual void stop() = 0;
         virtual void step() = 0;
@@ -189,6 +274,24 @@ namespace eka2l1::arm {
 
         virtual bool is_thumb_mode() = 0;
 
+        /**
+         * \brief Set the page table that is looked up before going through the memory callbacks.
+         *
+         * \param table The table to use. Nullptr to only use the callbacks.
+         */
+        virtual void set_page_table(page_table *table) {
+            page_table_ = table;
+        }
+
+        page_table *get_page_table() const {
+            return page_table_;
+        }
+
+        template <typename T>
+        T *page_table_lookup(const address addr) const {
+            return page_table_ ? page_table_->get<T>(addr) : nullptr;
+        }
+
         virtual void set_tlb_page(const address vaddr, std::uint8_t *ptr, prot protection) = 0;
         virtual void dirty_tlb_page(const address addr) = 0;
         virtual void flush_tlb() = 0;
@@ -201,5 +304,14 @@ namespace eka2l1::arm {
         }
 
         virtual std::uint32_t get_num_instruction_executed() = 0;
+
+        /**
+         * \brief Get the total host time spent translating guest code.
+         *
+         * \returns Time in nanoseconds. Zero if the backend does not translate code, or does not track it.
+         */
+        virtual std::uint64_t get_total_jit_compile_time() {
+            return 0;
+        }
     };
 }
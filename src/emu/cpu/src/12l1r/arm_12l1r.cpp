@@ -177,4 +177,8 @@ namespace eka2l1::arm {
     std::uint32_t r12l1_core::get_num_instruction_executed() {
         return target_ticks_run_ - jit_state_.ticks_left_;
     }
+
+    std::uint64_t r12l1_core::get_total_jit_compile_time() {
+        return big_block_->total_compile_time();
+    }
 }
\ No newline at end of file
@@ -19,6 +19,8 @@
 
 #include <cpu/12l1r/block_cache.h>
 
+#include <algorithm>
+
 namespace eka2l1::arm::r12l1 {
     block_link::block_link()
         : linked_(false)
@@ -59,7 +61,63 @@ namespace eka2l1::arm::r12l1 {
 
     block_cache::block_cache()
         : invalidate_callback_(nullptr) {
-        // Nothing... Hee hee
+        std::fill(direct_.begin(), direct_.end(), direct_entry{ 0, nullptr });
+    }
+
+    static vaddress block_first_page(const translated_block *block) {
+        return block->start_address() >> BLOCK_CACHE_PAGE_BITS;
+    }
+
+    static vaddress block_last_page(const translated_block *block) {
+        if (block->size_ == 0) {
+            return block_first_page(block);
+        }
+
+        return (block->current_address() - 1) >> BLOCK_CACHE_PAGE_BITS;
+    }
+
+    void block_cache::add_to_page(const vaddress page, translated_block *block) {
+        std::vector<translated_block *> &page_list = page_blocks_[page];
+
+        if (std::find(page_list.begin(), page_list.end(), block) == page_list.end()) {
+            page_list.push_back(block);
+        }
+    }
+
+    void block_cache::remove_from_pages(translated_block *block) {
+        const vaddress last_page = block_last_page(block);
+
+        for (vaddress page = block_first_page(block); page <= last_page; page++) {
+            auto page_ite = page_blocks_.find(page);
+            if (page_ite == page_blocks_.end()) {
+                continue;
+            }
+
+            std::vector<translated_block *> &page_list = page_ite->second;
+            auto block_ite = std::find(page_list.begin(), page_list.end(), block);
+
+            if (block_ite != page_list.end()) {
+                // Order does not matter, swap with the back and pop
+                *block_ite = page_list.back();
+                page_list.pop_back();
+            }
+
+            if (page_list.empty()) {
+                page_blocks_.erase(page_ite);
+            }
+        }
+    }
+
+    void block_cache::remove_block(translated_block *block) {
+        const vaddress start_addr = block->start_address();
+
+        direct_entry &entry = get_direct_entry(start_addr);
+        if (entry.block_ == block) {
+            entry = direct_entry{ 0, nullptr };
+        }
+
+        remove_from_pages(block);
+        blocks_.erase(start_addr);
     }
 
     bool block_cache::add_block(const vaddress start_addr) {
@@ -70,49 +128,91 @@ namespace eka2l1::arm::r12l1 {
         }
 
         std::unique_ptr<translated_block> new_block = std::make_unique<translated_block>(start_addr);
+        translated_block *new_block_ptr = new_block.get();
+
         blocks_.emplace(start_addr, std::move(new_block));
 
+        // Size is not known yet, index it on the starting page for now
+        add_to_page(start_addr >> BLOCK_CACHE_PAGE_BITS, new_block_ptr);
+        get_direct_entry(start_addr) = direct_entry{ start_addr, new_block_ptr };
+
         return true;
     }
 
+    void block_cache::commit_block(translated_block *block) {
+        const vaddress last_page = block_last_page(block);
+
+        for (vaddress page = block_first_page(block) + 1; page <= last_page; page++) {
+            add_to_page(page, block);
+        }
+    }
+
     translated_block *block_cache::lookup_block(const vaddress start_addr) {
+        direct_entry &entry = get_direct_entry(start_addr);
+        if (entry.block_ && (entry.addr_ == start_addr)) {
+            return entry.block_;
+        }
+
         auto bl_res = blocks_.find(start_addr);
         if (bl_res != blocks_.end()) {
-            return bl_res->second.get();
+            entry = direct_entry{ start_addr, bl_res->second.get() };
+            return entry.block_;
         }
 
         return nullptr;
     }
 
     void block_cache::flush_range(const vaddress range_start, const vaddress range_end) {
-        // From JitBlockCache.cpp in PPSSPP!
-        do {
-            restart:
-            auto next = blocks_.lower_bound(range_start);
-            auto last = blocks_.upper_bound(range_end);
-
-            if (next != blocks_.begin()) {
-                --next;
-            }
+        const vaddress first_page = range_start >> BLOCK_CACHE_PAGE_BITS;
+        const vaddress last_page = std::max<vaddress>(range_start, range_end - 1) >> BLOCK_CACHE_PAGE_BITS;
+
+        std::vector<translated_block *> to_invalidate;
 
-            for (; next != last; ++next) {
-                const vaddress block_ite_start = next->first;
-                const vaddress block_ite_end = next->second->current_address();
+        auto collect_page = [&](const std::vector<translated_block *> &page_list) {
+            for (translated_block *block : page_list) {
+                const vaddress block_ite_start = block->start_address();
+                const vaddress block_ite_end = block->current_address();
 
                 if ((block_ite_start < range_end) && (block_ite_end > range_start)) {
-                    if (invalidate_callback_) {
-                        invalidate_callback_(next->second.get());
-                    }
+                    to_invalidate.push_back(block);
+                }
+            }
+        };
 
-                    blocks_.erase(next);
-                    goto restart;
+        // On wide ranges, walking the populated pages is cheaper than walking the range
+        if (static_cast<std::size_t>(last_page - first_page) + 1 > page_blocks_.size()) {
+            for (auto &[page, page_list] : page_blocks_) {
+                if ((page >= first_page) && (page <= last_page)) {
+                    collect_page(page_list);
+                }
+            }
+        } else {
+            for (vaddress page = first_page; page <= last_page; page++) {
+                auto page_ite = page_blocks_.find(page);
+                if (page_ite != page_blocks_.end()) {
+                    collect_page(page_ite->second);
                 }
             }
-        } while (false);
+        }
+
+        // A block spanning multiple pages is collected once per page
+        std::sort(to_invalidate.begin(), to_invalidate.end());
+        to_invalidate.erase(std::unique(to_invalidate.begin(), to_invalidate.end()), to_invalidate.end());
+
+        for (translated_block *block : to_invalidate) {
+            if (invalidate_callback_) {
+                invalidate_callback_(block);
+            }
+
+            remove_block(block);
+        }
     }
 
     void block_cache::flush_all() {
         // Just clear all of it
+        std::fill(direct_.begin(), direct_.end(), direct_entry{ 0, nullptr });
+
+        page_blocks_.clear();
         blocks_.clear();
     }
-}
\ No newline at end of file
+}
@@ -35,6 +35,8 @@
 #include <common/algorithm.h>
 #include <common/log.h>
 
+#include <chrono>
+
 namespace eka2l1::arm::r12l1 {
     static constexpr std::size_t MAX_CODE_SPACE_BYTES = common::MB(32);
 
@@ -43,7 +45,11 @@ namespace eka2l1::arm::r12l1 {
     }
 
     static translated_block *dashixiong_compile_new_block_proxy(dashixiong_block *self, core_state *state, const vaddress addr) {
-        return self->compile_new_block(state, addr);
+        const auto start = std::chrono::steady_clock::now();
+        translated_block *block = self->compile_new_block(state, addr);
+
+        self->add_compile_time(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        return block;
     }
 
     static void emit_pc_flush_with_this_emitter(common::armgen::armx_emitter *emitter, const address current_pc) {
@@ -55,6 +61,7 @@ namespace eka2l1::arm::r12l1 {
         : dispatch_func_(nullptr)
         , dispatch_ent_for_block_(nullptr)
         , flags_(0)
+        , compile_time_(0)
         , parent_(parent) {
         context_info.detect();
         clear_fast_dispatch();
@@ -317,6 +324,10 @@ namespace eka2l1::arm::r12l1 {
     }
 
     std::uint8_t dashixiong_block::read_byte(const vaddress addr) {
+        if (std::uint8_t *ptr = parent_->page_table_lookup<std::uint8_t>(addr)) {
+            return *ptr;
+        }
+
         std::uint8_t value = 0;
         bool res = parent_->read_8bit(addr, &value);
 
@@ -334,6 +345,10 @@ namespace eka2l1::arm::r12l1 {
     }
 
     std::uint16_t dashixiong_block::read_word(const vaddress addr) {
+        if (std::uint16_t *ptr = parent_->page_table_lookup<std::uint16_t>(addr)) {
+            return *ptr;
+        }
+
         std::uint16_t value = 0;
         bool res = parent_->read_16bit(addr, &value);
 
@@ -351,6 +366,10 @@ namespace eka2l1::arm::r12l1 {
     }
 
     std::uint32_t dashixiong_block::read_dword(const vaddress addr) {
+        if (std::uint32_t *ptr = parent_->page_table_lookup<std::uint32_t>(addr)) {
+            return *ptr;
+        }
+
         std::uint32_t value = 0;
         bool res = parent_->read_32bit(addr, &value);
 
@@ -368,6 +387,10 @@ namespace eka2l1::arm::r12l1 {
     }
 
     std::uint64_t dashixiong_block::read_qword(const vaddress addr) {
+        if (std::uint64_t *ptr = parent_->page_table_lookup<std::uint64_t>(addr)) {
+            return *ptr;
+        }
+
         std::uint64_t value = 0;
         bool res = parent_->read_64bit(addr, &value);
 
@@ -385,6 +408,11 @@ namespace eka2l1::arm::r12l1 {
     }
 
     void dashixiong_block::write_byte(const vaddress addr, std::uint8_t dat) {
+        if (std::uint8_t *ptr = parent_->page_table_lookup<std::uint8_t>(addr)) {
+            *ptr = dat;
+            return;
+        }
+
         bool result = parent_->write_8bit(addr, &dat);
 
         if (!result) {
@@ -399,6 +427,11 @@ namespace eka2l1::arm::r12l1 {
     }
 
     void dashixiong_block::write_word(const vaddress addr, std::uint16_t dat) {
+        if (std::uint16_t *ptr = parent_->page_table_lookup<std::uint16_t>(addr)) {
+            *ptr = dat;
+            return;
+        }
+
         bool result = parent_->write_16bit(addr, &dat);
 
         if (!result) {
@@ -413,6 +446,11 @@ namespace eka2l1::arm::r12l1 {
     }
 
     void dashixiong_block::write_dword(const vaddress addr, std::uint32_t dat) {
+        if (std::uint32_t *ptr = parent_->page_table_lookup<std::uint32_t>(addr)) {
+            *ptr = dat;
+            return;
+        }
+
         bool result = parent_->write_32bit(addr, &dat);
 
         if (!result) {
@@ -427,6 +465,11 @@ namespace eka2l1::arm::r12l1 {
     }
 
     void dashixiong_block::write_qword(const vaddress addr, std::uint64_t dat) {
+        if (std::uint64_t *ptr = parent_->page_table_lookup<std::uint64_t>(addr)) {
+            *ptr = dat;
+            return;
+        }
+
         bool result = parent_->write_64bit(addr, &dat);
 
         if (!result) {
@@ -811,6 +854,7 @@ namespace eka2l1::arm::r12l1 {
         } while (should_continue);
 
         visitor->finalize();
+        cache_.commit_block(block);
 
         end_write();
         flush_icache();
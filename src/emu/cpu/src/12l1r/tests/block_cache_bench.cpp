@@ -0,0 +1,100 @@
+#include <catch2/catch.hpp>
+#include <common/log.h>
+#include <cpu/12l1r/block_cache.h>
+
+#include <chrono>
+
+namespace eka2l1::arm::r12l1 {
+    static constexpr std::uint32_t BENCH_BLOCK_SIZE = 0x20;
+    static constexpr std::uint32_t BENCH_BLOCK_COUNT = 0x10000;
+    static constexpr std::uint32_t BENCH_CODE_BASE = 0x70000000;
+    static constexpr std::uint32_t BENCH_LOOKUP_ROUNDS = 16;
+
+    static void fill_bench_cache(block_cache &cache) {
+        for (std::uint32_t i = 0; i < BENCH_BLOCK_COUNT; i++) {
+            const std::uint32_t addr = BENCH_CODE_BASE + i * BENCH_BLOCK_SIZE;
+            cache.add_block(addr);
+
+            translated_block *block = cache.lookup_block(addr);
+            block->size_ = BENCH_BLOCK_SIZE;
+
+            cache.commit_block(block);
+        }
+    }
+
+    template <typename T>
+    static std::int64_t elapsed_us(T start) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    TEST_CASE("block_cache_page_span_invalidation", "block_cache") {
+        block_cache cache;
+
+        // Block crossing from the first page to the second one
+        cache.add_block(0xFF0);
+        cache.lookup_block(0xFF0)->size_ = 0x20;
+        cache.commit_block(cache.lookup_block(0xFF0));
+
+        cache.add_block(0x2000);
+        cache.lookup_block(0x2000)->size_ = 0x10;
+        cache.commit_block(cache.lookup_block(0x2000));
+
+        std::uint32_t invalidated = 0;
+        cache.set_on_block_invalidate_callback([&](translated_block *) {
+            invalidated++;
+        });
+
+        // Patching the second page must find the block started on the first one
+        cache.flush_range(0x1004, 0x1008);
+
+        REQUIRE(invalidated == 1);
+        REQUIRE(cache.lookup_block(0xFF0) == nullptr);
+        REQUIRE(cache.lookup_block(0x2000) != nullptr);
+    }
+
+    // Hidden, run it explicitly with the "[block_cache_bench]" tag
+    TEST_CASE("block_cache_lookup_and_flush_bench", "[.][block_cache_bench]") {
+        block_cache cache;
+        fill_bench_cache(cache);
+
+        REQUIRE(cache.size() == BENCH_BLOCK_COUNT);
+
+        auto lookup_start = std::chrono::steady_clock::now();
+        std::uint32_t found = 0;
+
+        for (std::uint32_t round = 0; round < BENCH_LOOKUP_ROUNDS; round++) {
+            for (std::uint32_t i = 0; i < BENCH_BLOCK_COUNT; i++) {
+                found += (cache.lookup_block(BENCH_CODE_BASE + i * BENCH_BLOCK_SIZE) != nullptr);
+            }
+        }
+
+        const std::int64_t lookup_us = elapsed_us(lookup_start);
+        REQUIRE(found == BENCH_BLOCK_COUNT * BENCH_LOOKUP_ROUNDS);
+
+        // Invalidate one instruction at a time over a 64KB region, like imb_range calls done by a code patcher
+        static constexpr std::uint32_t FLUSH_REGION_SIZE = 0x10000;
+        auto flush_start = std::chrono::steady_clock::now();
+
+        for (std::uint32_t off = 0; off < FLUSH_REGION_SIZE; off += 4) {
+            cache.flush_range(BENCH_CODE_BASE + off, BENCH_CODE_BASE + off + 4);
+        }
+
+        const std::int64_t flush_small_us = elapsed_us(flush_start);
+        REQUIRE(cache.size() == BENCH_BLOCK_COUNT - FLUSH_REGION_SIZE / BENCH_BLOCK_SIZE);
+
+        // Reload of a large DLL: one wide flush over the rest
+        flush_start = std::chrono::steady_clock::now();
+        cache.flush_range(BENCH_CODE_BASE, BENCH_CODE_BASE + BENCH_BLOCK_COUNT * BENCH_BLOCK_SIZE);
+
+        const std::int64_t flush_wide_us = elapsed_us(flush_start);
+        REQUIRE(cache.size() == 0);
+
+        LOG_INFO(CPU_12L1R, "Block cache bench: {} lookups in {} us, {} small flushes in {} us, wide flush of {} blocks in {} us",
+            found, lookup_us, FLUSH_REGION_SIZE / 4, flush_small_us, BENCH_BLOCK_COUNT - FLUSH_REGION_SIZE / BENCH_BLOCK_SIZE,
+            flush_wide_us);
+    }
+
+    void register_block_cache_bench() {
+        return;
+    }
+}
@@ -20,6 +20,7 @@
 #include <common/algorithm.h>
 #include <common/configure.h>
 #include <common/log.h>
+#include <common/virtualmem.h>
 
 #include <cpu/arm_dynarmic.h>
 #include <cpu/arm_utils.h>
@@ -121,6 +122,10 @@ namespace eka2l1::arm {
             return cp15.get();
         }
 
+        std::shared_ptr<dynarmic_core_cp15> get_cp15_shared() {
+            return cp15;
+        }
+
         /**
          * @brief Raise access violation and get feedback on whether we should reaccess the address again.
          * 
@@ -307,32 +312,125 @@ namespace eka2l1::arm {
     };
 
     std::unique_ptr<Dynarmic::A32::Jit> make_jit(std::unique_ptr<dynarmic_core_callback> &callback, Dynarmic::TLB<9> &tlb_obj,
-        std::shared_ptr<dynarmic_core_cp15> cp15, Dynarmic::ExclusiveMonitor *monitor) {
+        Dynarmic::ExclusiveMonitor *monitor, std::uint8_t *fastmem_arena, page_table *table) {
         Dynarmic::A32::UserConfig config;
         config.callbacks = callback.get();
-        config.coprocessors[15] = cp15;
+        config.coprocessors[15] = callback->get_cp15_shared();
         config.tlb_entries = tlb_obj.entries.data();
         config.tlb_index_mask_bits = 9;
         config.global_monitor = monitor;
         config.define_unpredictable_behaviour = true;
         config.arch_version = Dynarmic::A32::ArchVersion::v6T2;
 
+        if (table) {
+            // Entries are host page bases, null entries go through the callbacks
+            config.page_table = &table->pointers;
+            config.absolute_offset_page_table = false;
+        }
+
+        if (fastmem_arena) {
+            config.fastmem_pointer = fastmem_arena;
+
+            // Pages are mirrored lazily, a fault is not a reason to give up fastmem on that access.
+            // The faulting access is redone through the memory callbacks, which will mirror the page
+            // if it's valid, or go to the exception handler if it's not.
+            config.recompile_on_fastmem_failure = false;
+        }
+
         return std::make_unique<Dynarmic::A32::Jit>(config);
     }
 
-    dynarmic_core::dynarmic_core(arm::exclusive_monitor *monitor)
+    dynarmic_core::dynarmic_core(arm::exclusive_monitor *monitor, const bool enable_fastmem)
         : tlb_obj(12)
         , interpreter(monitor, 12)
-        , interpreter_callback_inited(false) {
+        , interpreter_callback_inited(false)
+        , jit_monitor(nullptr)
+        , fastmem_arena(nullptr)
+        , fastmem_mirrored_count(0) {
         std::shared_ptr<dynarmic_core_cp15> cp15 = std::make_shared<dynarmic_core_cp15>();
         cb = std::make_unique<dynarmic_core_callback>(*this, cp15);
 
-        auto monitor_bb = reinterpret_cast<dynarmic_exclusive_monitor *>(monitor);
+        jit_monitor = &reinterpret_cast<dynarmic_exclusive_monitor *>(monitor)->monitor_;
 
-        jit = make_jit(cb, tlb_obj, cp15, &monitor_bb->monitor_);
+        if (enable_fastmem && !init_fastmem()) {
+            LOG_WARN(CPU, "Fastmem is not supported on this host, falling back to software TLB only");
+        }
+
+        jit = make_jit(cb, tlb_obj, jit_monitor, fastmem_arena, nullptr);
     }
 
     dynarmic_core::~dynarmic_core() {
+        jit.reset();
+
+        if (fastmem_arena) {
+            common::unmap_memory(fastmem_arena, FASTMEM_ARENA_SIZE);
+        }
+    }
+
+    bool dynarmic_core::init_fastmem() {
+        if (!common::is_memory_aliasing_supported() || (common::get_host_page_size() != FASTMEM_PAGE_SIZE)) {
+            return false;
+        }
+
+        fastmem_arena = reinterpret_cast<std::uint8_t *>(common::map_memory(FASTMEM_ARENA_SIZE));
+
+        if (!fastmem_arena) {
+            return false;
+        }
+
+        fastmem_page_states.resize(FASTMEM_PAGE_COUNT, FASTMEM_PAGE_STATE_UNMAPPED);
+        fastmem_mirrored_count = 0;
+
+        return true;
+    }
+
+    void dynarmic_core::mirror_fastmem_page(const address vaddr, std::uint8_t *ptr, const prot protection) {
+        const std::uint32_t page_index = vaddr >> FASTMEM_PAGE_BITS;
+
+        if (fastmem_page_states[page_index] != FASTMEM_PAGE_STATE_UNMAPPED) {
+            return;
+        }
+
+        if (!(protection & prot_read)) {
+            fastmem_page_states[page_index] = FASTMEM_PAGE_STATE_UNSUPPORTED;
+            return;
+        }
+
+        // The JIT never executes from the arena, only reads and writes go through it.
+        const prot mirror_prot = (protection & prot_write) ? prot_read_write : prot_read;
+
+        if (common::alias_memory(ptr, fastmem_arena + (vaddr & ~(FASTMEM_PAGE_SIZE - 1)), FASTMEM_PAGE_SIZE, mirror_prot)) {
+            fastmem_page_states[page_index] = FASTMEM_PAGE_STATE_MIRRORED;
+            fastmem_mirrored_count++;
+        } else {
+            fastmem_page_states[page_index] = FASTMEM_PAGE_STATE_UNSUPPORTED;
+        }
+    }
+
+    void dynarmic_core::unmirror_fastmem_page(const address vaddr) {
+        const std::uint32_t page_index = vaddr >> FASTMEM_PAGE_BITS;
+
+        if (fastmem_page_states[page_index] == FASTMEM_PAGE_STATE_MIRRORED) {
+            common::unalias_memory(fastmem_arena + (vaddr & ~(FASTMEM_PAGE_SIZE - 1)), FASTMEM_PAGE_SIZE);
+            fastmem_mirrored_count--;
+        }
+
+        fastmem_page_states[page_index] = FASTMEM_PAGE_STATE_UNMAPPED;
+    }
+
+    void dynarmic_core::set_page_table(page_table *table) {
+        if (table == page_table_) {
+            return;
+        }
+
+        core::set_page_table(table);
+
+        // The page table is part of the JIT config, rebuild it while keeping the guest state
+        thread_context ctx;
+        save_context(ctx);
+
+        jit = make_jit(cb, tlb_obj, jit_monitor, fastmem_arena, table);
+        load_context(ctx);
     }
 
     void dynarmic_core::run(const std::uint32_t instruction_count) {
@@ -464,14 +562,32 @@ namespace eka2l1::arm {
         }
 
         tlb_obj.Add(vaddr, ptr, prot_flags);
+
+        if (fastmem_arena) {
+            mirror_fastmem_page(vaddr, ptr, protection);
+        }
     }
 
     void dynarmic_core::dirty_tlb_page(address addr) {
         tlb_obj.MakeDirty(addr);
+
+        if (fastmem_arena) {
+            unmirror_fastmem_page(addr);
+        }
     }
 
     void dynarmic_core::flush_tlb() {
         tlb_obj.Flush();
+
+        if (fastmem_arena) {
+            if (fastmem_mirrored_count != 0) {
+                // One remap of the whole arena is cheaper than dropping each mirrored page
+                common::unalias_memory(fastmem_arena, FASTMEM_ARENA_SIZE);
+                fastmem_mirrored_count = 0;
+            }
+
+            std::fill(fastmem_page_states.begin(), fastmem_page_states.end(), FASTMEM_PAGE_STATE_UNMAPPED);
+        }
     }
 
     void dynarmic_core::clear_instruction_cache() {
@@ -31,7 +31,7 @@
 #include <cpu/12l1r/exclusive_monitor.h>
 
 namespace eka2l1::arm {
-    core_instance create_core(exclusive_monitor *monitor, arm_emulator_type arm_type) {
+    core_instance create_core(exclusive_monitor *monitor, arm_emulator_type arm_type, const bool enable_fastmem) {
         switch (arm_type) {
         case arm_emulator_type::unicorn:
             return nullptr;
@@ -41,7 +41,7 @@ namespace eka2l1::arm {
             return std::make_unique<r12l1_core>(monitor, 12);
 #else
         case arm_emulator_type::dynarmic:
-            return std::make_unique<dynarmic_core>(monitor);
+            return std::make_unique<dynarmic_core>(monitor, enable_fastmem);
 #endif
 
         case arm_emulator_type::dyncom:
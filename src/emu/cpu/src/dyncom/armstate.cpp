@@ -195,6 +195,10 @@ std::uint8_t ARMul_State::ReadMemory8(std::uint32_t address) const {
         return *ptr;
     }
 
+    if (std::uint8_t *ptr = core->page_table_lookup<std::uint8_t>(address)) {
+        return *ptr;
+    }
+
     std::uint8_t value = 0;
     bool result = core->read_8bit(address, &value);
 
@@ -218,6 +222,16 @@ std::uint16_t ARMul_State::ReadMemory16(std::uint32_t address) const {
     }
 
     std::uint16_t value = 0;
+
+    if (std::uint16_t *ptr = core->page_table_lookup<std::uint16_t>(address)) {
+        value = *ptr;
+
+        if (InBigEndianMode())
+            value = eka2l1::common::byte_swap(value);
+
+        return value;
+    }
+
     bool result = core->read_16bit(address, &value);
 
     if (!result) {
@@ -243,6 +257,16 @@ std::uint32_t ARMul_State::ReadMemory32(std::uint32_t address) const {
     }
 
     std::uint32_t value = 0;
+
+    if (std::uint32_t *ptr = core->page_table_lookup<std::uint32_t>(address)) {
+        value = *ptr;
+
+        if (InBigEndianMode())
+            value = eka2l1::common::byte_swap(value);
+
+        return value;
+    }
+
     bool result = core->read_32bit(address, &value);
 
     if (!result) {
@@ -262,6 +286,10 @@ std::uint32_t ARMul_State::ReadMemory32(std::uint32_t address) const {
 }
 
 std::uint32_t ARMul_State::ReadCode(std::uint32_t address) const {
+    if (std::uint32_t *ptr = core->page_table_lookup<std::uint32_t>(address)) {
+        return *ptr;
+    }
+
     std::uint32_t value = 0;
     bool result = core->read_code(address, &value);
 
@@ -285,6 +313,16 @@ std::uint64_t ARMul_State::ReadMemory64(std::uint32_t address) const {
     }
 
     std::uint64_t value = 0;
+
+    if (std::uint64_t *ptr = core->page_table_lookup<std::uint64_t>(address)) {
+        value = *ptr;
+
+        if (InBigEndianMode())
+            value = eka2l1::common::byte_swap(value);
+
+        return value;
+    }
+
     bool result = core->read_64bit(address, &value);
 
     if (!result) {
@@ -305,7 +343,12 @@ std::uint64_t ARMul_State::ReadMemory64(std::uint32_t address) const {
 
 void ARMul_State::WriteMemory8(std::uint32_t address, std::uint8_t data) {
     eka2l1::arm::r12l1::tlb *cache = core->mem_cache();
-    if (std::uint8_t *ptr = cache->lookup(address)) {
+    if (std::uint8_t *ptr = cache->lookup_write(address)) {
+        *ptr = data;
+        return;
+    }
+
+    if (std::uint8_t *ptr = core->page_table_lookup<std::uint8_t>(address)) {
         *ptr = data;
         return;
     }
@@ -328,7 +371,12 @@ void ARMul_State::WriteMemory16(std::uint32_t address, std::uint16_t data) {
         data = eka2l1::common::byte_swap(data);
 
     eka2l1::arm::r12l1::tlb *cache = core->mem_cache();
-    if (std::uint16_t *ptr = reinterpret_cast<std::uint16_t *>(cache->lookup(address))) {
+    if (std::uint16_t *ptr = reinterpret_cast<std::uint16_t *>(cache->lookup_write(address))) {
+        *ptr = data;
+        return;
+    }
+
+    if (std::uint16_t *ptr = core->page_table_lookup<std::uint16_t>(address)) {
         *ptr = data;
         return;
     }
@@ -351,7 +399,12 @@ void ARMul_State::WriteMemory32(std::uint32_t address, std::uint32_t data) {
         data = eka2l1::common::byte_swap(data);
 
     eka2l1::arm::r12l1::tlb *cache = core->mem_cache();
-    if (std::uint32_t *ptr = reinterpret_cast<std::uint32_t *>(cache->lookup(address))) {
+    if (std::uint32_t *ptr = reinterpret_cast<std::uint32_t *>(cache->lookup_write(address))) {
+        *ptr = data;
+        return;
+    }
+
+    if (std::uint32_t *ptr = core->page_table_lookup<std::uint32_t>(address)) {
         *ptr = data;
         return;
     }
@@ -374,7 +427,12 @@ void ARMul_State::WriteMemory64(std::uint32_t address, std::uint64_t data) {
         data = eka2l1::common::byte_swap(data);
 
     eka2l1::arm::r12l1::tlb *cache = core->mem_cache();
-    if (std::uint64_t *ptr = reinterpret_cast<std::uint64_t *>(cache->lookup(address))) {
+    if (std::uint64_t *ptr = reinterpret_cast<std::uint64_t *>(cache->lookup_write(address))) {
+        *ptr = data;
+        return;
+    }
+
+    if (std::uint64_t *ptr = core->page_table_lookup<std::uint64_t>(address)) {
         *ptr = data;
         return;
     }
@@ -40,6 +40,7 @@ namespace eka2l1::dispatch {
         std::vector<buffer_info> buffers_;
         std::uint8_t current_buffer_;
         std::size_t size_per_buffer_;
+        std::size_t bytes_pushed_; ///< Bytes pushed since the last frame ended.
 
         void add_buffer();
 
@@ -58,5 +59,9 @@ namespace eka2l1::dispatch {
             std::size_t &buffer_offset);
 
         void flush(drivers::graphics_command_builder &builder);
+
+        std::size_t bytes_pushed() const {
+            return bytes_pushed_;
+        }
     };
 }
\ No newline at end of file
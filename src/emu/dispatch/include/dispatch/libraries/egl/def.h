@@ -64,6 +64,7 @@ namespace eka2l1::dispatch {
         EGL_MAJOR_VERSION_EMU = 1,
         EGL_MINOR_VERSION_EMU = 4,
         EGL_SUCCESS = 0x3000,
+        EGL_NOT_INITIALIZED_EMU = 0x3001,
         EGL_BAD_ALLOC_EMU = 0x3003,
         EGL_BAD_ATTRIBUTE_EMU = 0x3004,
         EGL_BAD_CONFIG = 0x3005,
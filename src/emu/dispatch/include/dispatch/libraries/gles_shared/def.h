@@ -22,6 +22,7 @@
 #include <dispatch/libraries/egl/def.h>
 #include <dispatch/libraries/gles_shared/consts.h>
 #include <dispatch/libraries/buffer_pusher.h>
+#include <dispatch/libraries/vertex_stream_cache.h>
 #include <dispatch/def.h>
 
 #include <common/container.h>
@@ -373,6 +374,8 @@ namespace eka2l1::dispatch {
         // Vertex and index buffers
         graphics_buffer_pusher vertex_buffer_pusher_;
         graphics_buffer_pusher index_buffer_pusher_;
+        vertex_stream_cache vertex_stream_cache_;
+        vertex_stream_stats last_frame_stream_stats_;
         bool attrib_changed_;
 
         float blend_colour_[4];
@@ -386,6 +389,13 @@ namespace eka2l1::dispatch {
 
         gles_driver_buffer *binded_buffer(const bool is_array_buffer);
 
+        /**
+         * @brief Get how much vertex and index data the last frame streamed to the driver.
+         */
+        const vertex_stream_stats &get_last_frame_stream_stats() const {
+            return last_frame_stream_stats_;
+        }
+
         virtual void init_context_state() override;
         void return_handle_to_pool(const gles_object_type type, const drivers::handle h, const int subtype = 0);
         void on_surface_changed(drivers::graphics_driver *driver, egl_surface *prev_read, egl_surface *prev_draw) override;
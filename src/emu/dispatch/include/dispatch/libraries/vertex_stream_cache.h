@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/common.h>
+#include <drivers/itc.h>
+#include <common/types.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1::drivers {
+    class graphics_driver;
+}
+
+namespace eka2l1::mem {
+    class write_watcher;
+}
+
+namespace eka2l1::dispatch {
+    struct vertex_stream_stats {
+        std::uint64_t bytes_pushed_ = 0; ///< Bytes copied into the transient pusher buffers.
+        std::uint64_t bytes_uploaded_ = 0; ///< Bytes uploaded to cached streams.
+        std::uint64_t bytes_reused_ = 0; ///< Bytes served from cached streams without any upload.
+    };
+
+    /**
+     * @brief Cache of client-side vertex and index arrays, kept in their own driver buffers.
+     *
+     * Streams are keyed by the owner, guest address, stride and size of the range that the draw reads.
+     * With a write watcher, a stream is validated by asking which of its pages were written since it
+     * was last used, and its content is not looked at unless it changed. Without one, a stream is
+     * validated with a hash of its content on each use.
+     *
+     * A range that is seen unchanged twice gets a buffer; later changes only upload what changed.
+     * Ranges that keep changing are given back to the pusher.
+     */
+    class vertex_stream_cache {
+    public:
+        static constexpr std::size_t MIN_STREAM_SIZE = 256;
+        static constexpr std::size_t MAX_TOTAL_CACHED_SIZE = 16 * 1024 * 1024;
+        static constexpr std::uint32_t MAX_CHANGE_STREAK = 4;
+        static constexpr std::uint32_t EVICT_AFTER_FRAMES = 120;
+
+        struct stream_key {
+            std::uint32_t owner_;
+            address addr_;
+            std::uint32_t stride_;
+            std::uint32_t size_;
+
+            bool operator==(const stream_key &rhs) const {
+                return (owner_ == rhs.owner_) && (addr_ == rhs.addr_) && (stride_ == rhs.stride_) && (size_ == rhs.size_);
+            }
+        };
+
+    private:
+        struct stream_key_hash {
+            std::size_t operator()(const stream_key &key) const;
+        };
+
+        struct stream_entry {
+            drivers::handle buffer_ = 0;
+            std::uint64_t hash_ = 0; ///< Hash of the content, when writes are not watched.
+            std::vector<std::uint8_t> shadow_; ///< Content uploaded to the buffer, when writes are not watched.
+            const std::uint8_t *watched_ = nullptr; ///< Host range watched for writes, if any.
+            std::uint64_t watch_stamp_ = 0;
+            std::uint32_t last_used_frame_ = 0;
+            std::uint32_t change_streak_ = 0;
+        };
+
+        std::unordered_map<stream_key, stream_entry, stream_key_hash> streams_;
+        std::size_t total_cached_size_;
+        std::uint32_t current_frame_;
+
+        mem::write_watcher *watcher_;
+        std::vector<std::uint8_t> dirty_pages_;
+
+        vertex_stream_stats current_stats_;
+
+        void release_stream(stream_entry &entry, const std::size_t size, drivers::graphics_command_builder &builder);
+        void start_tracking(stream_entry &entry, const std::uint8_t *data, const std::size_t size);
+
+        /**
+         * @brief Check if a stream changed since last used.
+         *
+         * @param dirty_start   Start of the span that may have changed.
+         * @param dirty_end     End of the span that may have changed.
+         */
+        bool check_stream_changed(stream_entry &entry, const std::uint8_t *data, const std::size_t size, std::size_t &dirty_start,
+            std::size_t &dirty_end);
+
+    public:
+        explicit vertex_stream_cache();
+
+        /**
+         * @brief Validate streams with a write watcher from now on, instead of hashing their content.
+         *
+         * Does nothing if streams are already validated with a watcher, or if the watcher is not supported.
+         */
+        void attach_write_watcher(mem::write_watcher *watcher);
+
+        /**
+         * @brief Get a driver buffer holding the given client array range.
+         *
+         * Uploads needed to bring the buffer up to date are recorded in the builder, ahead of the draw.
+         *
+         * @param drv       The driver to create buffers with.
+         * @param builder   The builder that the draw using this stream is recorded into.
+         * @param key       Identity of the range.
+         * @param data      Host pointer to the range.
+         *
+         * @returns Handle to the buffer, with the range starting at offset 0. 0 if the range should be pushed instead.
+         */
+        drivers::handle get_stream(drivers::graphics_driver *drv, drivers::graphics_command_builder &builder, const stream_key &key,
+            const std::uint8_t *data);
+
+        /**
+         * @brief End the frame, dropping streams that have not been used for a while.
+         *
+         * @param builder   The builder to record destruction of dropped buffers into. Left empty if nothing is dropped.
+         * @returns Statistics of the frame that just ended.
+         */
+        vertex_stream_stats done_frame(drivers::graphics_command_builder &builder);
+        void destroy(drivers::graphics_command_builder &builder);
+    };
+}
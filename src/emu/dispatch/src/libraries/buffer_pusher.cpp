@@ -23,6 +23,7 @@ namespace eka2l1::dispatch {
     graphics_buffer_pusher::graphics_buffer_pusher() {
         current_buffer_ = 0;
         size_per_buffer_ = 0;
+        bytes_pushed_ = 0;
     }
     
     void graphics_buffer_pusher::add_buffer() {
@@ -107,10 +108,13 @@ namespace eka2l1::dispatch {
         std::memcpy(buffers_[current_buffer_].data_ + buffer_offset, data_source, total_buffer_size);
 
         buffers_[current_buffer_].used_size_ += (((total_buffer_size + 3) / 4) * 4);
+        bytes_pushed_ += total_buffer_size;
+
         return buffers_[current_buffer_].buffer_;
     }
 
     void graphics_buffer_pusher::done_frame() {
         current_buffer_ = 0;
+        bytes_pushed_ = 0;
     }
 }
\ No newline at end of file
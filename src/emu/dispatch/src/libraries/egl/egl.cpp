@@ -82,6 +82,14 @@ namespace eka2l1::dispatch {
     }
 
     BRIDGE_FUNC_LIBRARY(egl_boolean, egl_initialize_emu, egl_display display, std::int32_t *major, std::int32_t *minor) {
+        if (!sys->get_graphics_driver()->support_shader_draw()) {
+            // Nothing would be drawn. Let the app know that there is no EGL, instead of showing a blank screen.
+            LOG_ERROR(HLE_DISPATCHER, "The graphics driver can't run GLES or VG, EGL is not available");
+            egl_push_error(sys, EGL_NOT_INITIALIZED_EMU);
+
+            return EGL_FALSE;
+        }
+
         if (major) {
             *major = EGL_MAJOR_VERSION_EMU;
         }
@@ -580,6 +580,16 @@ namespace eka2l1::dispatch {
         init_context_state();
 
         if (is_frame_swap_flush) {
+            drivers::graphics_command_builder cleanup_builder;
+
+            last_frame_stream_stats_ = vertex_stream_cache_.done_frame(cleanup_builder);
+            last_frame_stream_stats_.bytes_pushed_ = vertex_buffer_pusher_.bytes_pushed() + index_buffer_pusher_.bytes_pushed();
+
+            if (!cleanup_builder.is_empty()) {
+                retrieved = cleanup_builder.retrieve_command_list();
+                drv->submit_command_list(retrieved);
+            }
+
             vertex_buffer_pusher_.done_frame();
             index_buffer_pusher_.done_frame();
         }
@@ -843,6 +853,7 @@ namespace eka2l1::dispatch {
 
         vertex_buffer_pusher_.destroy(builder);
         index_buffer_pusher_.destroy(builder);
+        vertex_stream_cache_.destroy(builder);
 
         egl_context::destroy(driver, builder);
     }
@@ -1233,14 +1244,27 @@ namespace eka2l1::dispatch {
                 }
             }
 
-            if (!vertex_buffer_pusher_.is_initialized()) {
-                vertex_buffer_pusher_.initialize(common::MB(4));
-            }
+            vertex_stream_cache::stream_key key;
+            key.owner_ = crr_process->unique_id();
+            key.addr_ = attrib.offset_ + stride * first_index_real;
+            key.stride_ = stride;
+            key.size_ = static_cast<std::uint32_t>(total_buffer_size);
 
-            std::size_t offset_big = 0;
-            buffer_handle_drv = vertex_buffer_pusher_.push_buffer(drv, data_raw, total_buffer_size, offset_big);
+            vertex_stream_cache_.attach_write_watcher(&mem->get_control()->get_write_watcher());
+            buffer_handle_drv = vertex_stream_cache_.get_stream(drv, cmd_builder_, key, data_raw);
 
-            offset = static_cast<int>(offset_big);
+            if (buffer_handle_drv) {
+                offset = 0;
+            } else {
+                if (!vertex_buffer_pusher_.is_initialized()) {
+                    vertex_buffer_pusher_.initialize(common::MB(4));
+                }
+
+                std::size_t offset_big = 0;
+                buffer_handle_drv = vertex_buffer_pusher_.push_buffer(drv, data_raw, total_buffer_size, offset_big);
+
+                offset = static_cast<int>(offset_big);
+            }
 
             if (!attrib_not_persistent) {
                 attrib_not_persistent = true;
@@ -3197,12 +3221,28 @@ namespace eka2l1::dispatch {
                 return;
             }
 
-            if (!ctx->index_buffer_pusher_.is_initialized()) {
-                ctx->index_buffer_pusher_.initialize(common::MB(2));
+            drivers::handle to_bind = 0;
+            std::size_t offset_bytes = 0;
+
+            if (!relocated_indicies) {
+                // Indices that stay the same across frames can live in their own buffer, like vertices
+                vertex_stream_cache::stream_key key;
+                key.owner_ = kern->crr_process()->unique_id();
+                key.addr_ = indices_ptr;
+                key.stride_ = (index_type == GL_UNSIGNED_BYTE_EMU) ? 1 : 2;
+                key.size_ = static_cast<std::uint32_t>(size_ibuffer);
+
+                ctx->vertex_stream_cache_.attach_write_watcher(&kern->get_memory_system()->get_control()->get_write_watcher());
+                to_bind = ctx->vertex_stream_cache_.get_stream(drv, ctx->cmd_builder_, key, indicies_data_raw);
             }
 
-            std::size_t offset_bytes = 0;
-            drivers::handle to_bind = ctx->index_buffer_pusher_.push_buffer(drv, indicies_data_raw, size_ibuffer, offset_bytes);
+            if (!to_bind) {
+                if (!ctx->index_buffer_pusher_.is_initialized()) {
+                    ctx->index_buffer_pusher_.initialize(common::MB(2));
+                }
+
+                to_bind = ctx->index_buffer_pusher_.push_buffer(drv, indicies_data_raw, size_ibuffer, offset_bytes);
+            }
 
             ctx->cmd_builder_.set_index_buffer(to_bind);
             indices_ptr = static_cast<std::uint32_t>(offset_bytes);
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <dispatch/libraries/vertex_stream_cache.h>
+#include <common/hash.h>
+#include <mem/watch.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+namespace eka2l1::dispatch {
+    std::size_t vertex_stream_cache::stream_key_hash::operator()(const stream_key &key) const {
+        std::size_t seed = std::hash<std::uint32_t>()(key.addr_);
+        common::hash_combine(seed, key.owner_);
+        common::hash_combine(seed, key.stride_);
+        common::hash_combine(seed, key.size_);
+
+        return seed;
+    }
+
+    vertex_stream_cache::vertex_stream_cache()
+        : total_cached_size_(0)
+        , current_frame_(0)
+        , watcher_(nullptr) {
+    }
+
+    void vertex_stream_cache::attach_write_watcher(mem::write_watcher *watcher) {
+        if (watcher_ || !watcher || !watcher->is_supported()) {
+            return;
+        }
+
+        // Streams that are hashed are switched over on their next use
+        watcher_ = watcher;
+    }
+
+    void vertex_stream_cache::release_stream(stream_entry &entry, const std::size_t size, drivers::graphics_command_builder &builder) {
+        if (entry.buffer_) {
+            builder.destroy(entry.buffer_);
+            total_cached_size_ -= size;
+        }
+
+        if (entry.watched_) {
+            watcher_->unwatch(entry.watched_, size);
+        }
+
+        entry.buffer_ = 0;
+        entry.shadow_ = std::vector<std::uint8_t>();
+        entry.watched_ = nullptr;
+        entry.watch_stamp_ = 0;
+        entry.change_streak_ = 0;
+    }
+
+    void vertex_stream_cache::start_tracking(stream_entry &entry, const std::uint8_t *data, const std::size_t size) {
+        if (watcher_ && watcher_->watch(data, size)) {
+            entry.watched_ = data;
+
+            // Take what is there now as the baseline
+            watcher_->collect_dirty(data, size, entry.watch_stamp_, dirty_pages_);
+            return;
+        }
+
+        entry.hash_ = XXH64(data, size, 0);
+    }
+
+    bool vertex_stream_cache::check_stream_changed(stream_entry &entry, const std::uint8_t *data, const std::size_t size, std::size_t &dirty_start,
+        std::size_t &dirty_end) {
+        if (entry.watched_) {
+            if (!watcher_->collect_dirty(data, size, entry.watch_stamp_, dirty_pages_)) {
+                return false;
+            }
+
+            const std::size_t first_page = std::find(dirty_pages_.begin(), dirty_pages_.end(), 1) - dirty_pages_.begin();
+            const std::size_t last_page = dirty_pages_.rend() - std::find(dirty_pages_.rbegin(), dirty_pages_.rend(), 1) - 1;
+            const std::size_t page_offset = reinterpret_cast<std::uintptr_t>(data) & (mem::write_watcher::PAGE_SIZE - 1);
+
+            dirty_start = (first_page == 0) ? 0 : (first_page * mem::write_watcher::PAGE_SIZE - page_offset);
+            dirty_end = std::min<std::size_t>(size, (last_page + 1) * mem::write_watcher::PAGE_SIZE - page_offset);
+
+            return true;
+        }
+
+        const std::uint64_t hash = XXH64(data, size, 0);
+
+        if (entry.hash_ == hash) {
+            return false;
+        }
+
+        entry.hash_ = hash;
+
+        dirty_start = 0;
+        dirty_end = size;
+
+        if (!entry.shadow_.empty()) {
+            // Only the span that differs from what was uploaded
+            const auto first_diff = std::mismatch(data, data + size, entry.shadow_.begin());
+            dirty_start = static_cast<std::size_t>(first_diff.first - data);
+
+            while ((dirty_end > dirty_start) && (data[dirty_end - 1] == entry.shadow_[dirty_end - 1])) {
+                dirty_end--;
+            }
+        }
+
+        return true;
+    }
+
+    drivers::handle vertex_stream_cache::get_stream(drivers::graphics_driver *drv, drivers::graphics_command_builder &builder,
+        const stream_key &key, const std::uint8_t *data) {
+        const std::size_t size = key.size_;
+
+        if (size < MIN_STREAM_SIZE) {
+            return 0;
+        }
+
+        auto ite = streams_.find(key);
+
+        if (ite == streams_.end()) {
+            // First sighting, it may well be a one-off
+            stream_entry &entry = streams_[key];
+            entry.last_used_frame_ = current_frame_;
+
+            start_tracking(entry, data, size);
+            return 0;
+        }
+
+        stream_entry &entry = ite->second;
+        entry.last_used_frame_ = current_frame_;
+
+        if (watcher_ && (entry.watched_ != data)) {
+            // The range moved in host memory, was given back or was hashed before the watcher came
+            release_stream(entry, size, builder);
+            start_tracking(entry, data, size);
+
+            return 0;
+        }
+
+        std::size_t dirty_start = 0;
+        std::size_t dirty_end = 0;
+
+        const bool changed = check_stream_changed(entry, data, size, dirty_start, dirty_end);
+
+        if (!entry.buffer_) {
+            if (changed || (total_cached_size_ + size > MAX_TOTAL_CACHED_SIZE)) {
+                return 0;
+            }
+
+            // Seen twice unchanged, give it a buffer
+            entry.buffer_ = drivers::create_buffer(drv, nullptr, size, static_cast<drivers::buffer_upload_hint>(drivers::buffer_upload_static | drivers::buffer_upload_draw));
+
+            if (!entry.buffer_) {
+                return 0;
+            }
+
+            if (!entry.watched_) {
+                entry.shadow_.assign(data, data + size);
+            }
+
+            total_cached_size_ += size;
+
+            const void *chunk_ptr = data;
+            const std::uint32_t chunk_size = static_cast<std::uint32_t>(size);
+
+            builder.update_buffer_data(entry.buffer_, 0, 1, &chunk_ptr, &chunk_size);
+            current_stats_.bytes_uploaded_ += size;
+
+            return entry.buffer_;
+        }
+
+        if (!changed) {
+            entry.change_streak_ = 0;
+            current_stats_.bytes_reused_ += size;
+
+            return entry.buffer_;
+        }
+
+        if (++entry.change_streak_ >= MAX_CHANGE_STREAK) {
+            // Animated data, the pusher handles it better
+            release_stream(entry, size, builder);
+            return 0;
+        }
+
+        if (dirty_end > dirty_start) {
+            if (!entry.watched_) {
+                std::memcpy(entry.shadow_.data() + dirty_start, data + dirty_start, dirty_end - dirty_start);
+            }
+
+            const void *chunk_ptr = data + dirty_start;
+            const std::uint32_t chunk_size = static_cast<std::uint32_t>(dirty_end - dirty_start);
+
+            builder.update_buffer_data(entry.buffer_, dirty_start, 1, &chunk_ptr, &chunk_size);
+            current_stats_.bytes_uploaded_ += chunk_size;
+        }
+
+        return entry.buffer_;
+    }
+
+    vertex_stream_stats vertex_stream_cache::done_frame(drivers::graphics_command_builder &builder) {
+        current_frame_++;
+
+        for (auto ite = streams_.begin(); ite != streams_.end();) {
+            if (current_frame_ - ite->second.last_used_frame_ > EVICT_AFTER_FRAMES) {
+                release_stream(ite->second, ite->first.size_, builder);
+                ite = streams_.erase(ite);
+            } else {
+                ite++;
+            }
+        }
+
+        const vertex_stream_stats result = current_stats_;
+        current_stats_ = vertex_stream_stats();
+
+        return result;
+    }
+
+    void vertex_stream_cache::destroy(drivers::graphics_command_builder &builder) {
+        for (auto &[key, entry] : streams_) {
+            release_stream(entry, key.size_, builder);
+        }
+
+        streams_.clear();
+    }
+}
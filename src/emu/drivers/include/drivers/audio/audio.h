@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <drivers/audio/mixer.h>
 #include <drivers/audio/stream.h>
 #include <drivers/audio/player.h>
 #include <drivers/driver.h>
@@ -50,9 +51,20 @@ namespace eka2l1::drivers {
 
         std::mutex lock_;
 
+        std::unique_ptr<audio_mixer> mixer_;
+        std::mutex mixer_lock_;
+
         std::size_t add_master_volume_change_callback(master_audio_volume_change_callback callback);
         bool remove_master_volume_change_callback(const std::size_t handle);
 
+    protected:
+        /**
+         * \brief Destroy the mixer and its host stream.
+         *
+         * Backends must call this before tearing down, since the host stream is one of theirs.
+         */
+        void destroy_mixer();
+
     public:
         explicit audio_driver(const std::uint32_t initial_master_volume = 100, const player_type preferred_midi_backend = player_type_tsf);
         virtual ~audio_driver() {}
@@ -80,6 +92,13 @@ namespace eka2l1::drivers {
 
         virtual std::uint32_t native_sample_rate() = 0;
 
+        /**
+         * \brief Get the mixer that plays streams through a single output stream of this driver.
+         *
+         * The mixer is created on first use, at the native sample rate.
+         */
+        audio_mixer *get_mixer();
+
         std::uint32_t master_volume() const {
             return master_volume_;
         }
@@ -109,7 +128,8 @@ namespace eka2l1::drivers {
     };
 
     enum class audio_driver_backend {
-        cubeb
+        cubeb,
+        null
     };
 
     using audio_driver_instance = std::unique_ptr<audio_driver>;
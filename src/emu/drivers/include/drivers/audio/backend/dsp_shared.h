@@ -23,8 +23,12 @@
 #include <drivers/audio/dsp.h>
 
 #include <common/container.h>
+#include <common/sync.h>
 
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include <queue>
@@ -33,9 +37,16 @@ namespace eka2l1::drivers {
     using dsp_buffer = std::vector<std::uint8_t>;
 
 
+    /**
+     * \brief Output stream that plays PCM16 directly, and decodes other formats on its own thread.
+     *
+     * For compressed formats, a decode thread keeps a lookahead of decoded samples in the ring buffer,
+     * so the audio callback only ever copies samples out of it.
+     */
     struct dsp_output_stream_shared : public dsp_output_stream {
     protected:
         static constexpr std::size_t RING_BUFFER_MAX_SAMPLE_COUNT = 0x20000;
+        static constexpr std::uint32_t DEFAULT_DECODE_LOOKAHEAD_MS = 200;
 
         drivers::audio_driver *aud_;
         std::unique_ptr<drivers::audio_output_stream> stream_;
@@ -46,18 +57,60 @@ namespace eka2l1::drivers {
         bool virtual_stop;
         bool more_requested;
 
+        std::mutex decode_lock_; ///< Held while data is queued, decoded, or pushed to the ring buffer by the guest.
+
+        std::unique_ptr<std::thread> decode_thread_;
+        common::event decode_event_;
+        std::atomic<bool> decode_requested_;
+        std::atomic<bool> decode_thread_quit_;
+        std::atomic<std::uint32_t> decode_lookahead_ms_;
+        std::vector<std::uint8_t> decode_buffer_; ///< Reused by each decode, so it's allocated only once it grows.
+
+        std::atomic<std::uint64_t> underrun_count_;
+        std::atomic<std::uint64_t> underrun_frame_count_;
+
     protected:
         virtual bool internal_decode_running_out();
 
+        std::size_t decode_lookahead_sample_count() const;
+
+        void decode_loop();
+        void request_decode();
+
+        /**
+         * \brief Stop the decode thread.
+         *
+         * Must be called in the destructor of the stream implementing decode_data.
+         */
+        void stop_decode_thread();
+
     public:
         explicit dsp_output_stream_shared(drivers::audio_driver *aud);
         ~dsp_output_stream_shared() override;
 
+        /**
+         * \brief Decode the next piece of queued data.
+         *
+         * Called on the decode thread, with the decode lock held.
+         *
+         * \param dest     Receives the decoded PCM16 samples.
+         * \returns False if there is nothing left to decode for now.
+         */
         virtual bool decode_data(std::vector<std::uint8_t> &dest) = 0;
         virtual void queue_data_decode(const std::uint8_t *original, const std::size_t original_size) = 0;
 
         std::size_t data_callback(std::int16_t *buffer, const std::size_t frame_count);
 
+        void decode_lookahead(const std::uint32_t milliseconds) override;
+
+        std::uint64_t underrun_count() const override {
+            return underrun_count_;
+        }
+
+        std::uint64_t underrun_frame_count() const override {
+            return underrun_frame_count_;
+        }
+
         bool write(const std::uint8_t *data, const std::uint32_t data_size) override;
 
         void volume(const std::uint32_t new_volume) override;
@@ -38,8 +38,7 @@ namespace eka2l1::drivers {
         std::uint8_t *custom_io_buffer_;
         std::uint64_t timestamp_in_base_;
         std::vector<std::uint8_t> queued_data_;
-
-        std::mutex decode_lock_;
+        std::atomic<std::size_t> queued_data_size_;
 
         enum state {
             STATE_NONE,
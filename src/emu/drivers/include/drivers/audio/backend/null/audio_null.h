@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/audio/audio.h>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief An output stream that plays nothing, and never pulls data.
+     */
+    struct null_audio_output_stream : public audio_output_stream {
+    private:
+        bool playing_;
+        bool pausing_;
+        float volume_;
+
+    public:
+        explicit null_audio_output_stream(audio_driver *driver, const std::uint32_t sample_rate, const std::uint8_t channels);
+
+        bool start() override;
+        bool stop() override;
+        void pause() override;
+
+        bool is_playing() override;
+        bool is_pausing() override;
+
+        bool set_volume(const float volume) override;
+        float get_volume() const override;
+
+        bool current_frame_position(std::uint64_t *pos) override;
+    };
+
+    /**
+     * \brief Audio driver with no host device, for headless runs.
+     */
+    struct null_audio_driver : public audio_driver {
+    public:
+        explicit null_audio_driver(const std::uint32_t initial_master_volume = 100, const player_type preferred_midi_backend = player_type_tsf);
+        ~null_audio_driver() override;
+
+        std::unique_ptr<audio_output_stream> new_output_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback) override;
+
+        std::unique_ptr<audio_input_stream> new_input_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback) override;
+
+        std::uint32_t native_sample_rate() override;
+    };
+}
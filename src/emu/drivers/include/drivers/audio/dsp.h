@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace eka2l1::drivers {
@@ -140,6 +141,27 @@ namespace eka2l1::drivers {
             return 10;
         }
 
+        /**
+         * @brief       Set how much audio is decoded ahead of playback, for compressed formats.
+         * @param       milliseconds      The duration of audio to keep decoded.
+         */
+        virtual void decode_lookahead(const std::uint32_t milliseconds) {
+        }
+
+        /**
+         * @brief       Get the number of times the stream ran out of samples while playing.
+         */
+        virtual std::uint64_t underrun_count() const {
+            return 0;
+        }
+
+        /**
+         * @brief       Get the number of silent frames played in place of missing samples.
+         */
+        virtual std::uint64_t underrun_frame_count() const {
+            return 0;
+        }
+
         virtual bool is_playing() const override {
             return false;
         }
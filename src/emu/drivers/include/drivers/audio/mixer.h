@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/audio/stream.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace eka2l1::drivers {
+    class audio_mixer;
+
+    /**
+     * \brief State of a stream mixed by the audio mixer.
+     *
+     * Shared between the stream and the mixer, so the mixer can keep using it for the block it is
+     * mixing while the stream is destroyed.
+     */
+    struct mixer_source {
+        std::mutex callback_lock_; ///< Held while the data callback runs.
+        data_callback callback_;
+
+        std::uint32_t sample_rate_;
+        std::uint8_t channels_;
+
+        std::atomic<bool> playing_;
+        std::atomic<bool> pausing_;
+        std::atomic<std::int32_t> gain_; ///< Volume, with 1.0 being 1 << 15.
+        std::atomic<std::uint64_t> frames_played_; ///< Frames pulled from the callback, in the stream's sample rate.
+
+        // Used only by the thread mixing
+        std::uint64_t step_; ///< Source frames per output frame, as 32.32 fixed point.
+        std::uint64_t position_; ///< Position of the next output frame in the source buffer, as 32.32 fixed point.
+        std::vector<std::int16_t> source_; ///< Stereo source frames pulled but not consumed yet, starting with the one at the position.
+        std::size_t source_frame_count_; ///< Number of frames in the source buffer.
+
+        explicit mixer_source(const std::uint32_t sample_rate, const std::uint8_t channels, data_callback callback);
+    };
+
+    /**
+     * \brief An output stream that is mixed with others into the mixer's host stream.
+     */
+    struct mixer_output_stream : public audio_output_stream {
+    private:
+        audio_mixer *mixer_;
+        std::shared_ptr<mixer_source> source_;
+        float volume_;
+
+    public:
+        explicit mixer_output_stream(audio_driver *driver, audio_mixer *mixer, std::shared_ptr<mixer_source> source);
+        ~mixer_output_stream() override;
+
+        bool start() override;
+        bool stop() override;
+        void pause() override;
+
+        bool is_playing() override;
+        bool is_pausing() override;
+
+        bool set_volume(const float volume) override;
+        float get_volume() const override;
+
+        bool current_frame_position(std::uint64_t *pos) override;
+    };
+
+    /**
+     * \brief Mix many output streams into a single host output stream.
+     *
+     * Streams are pulled and mixed in blocks of BLOCK_FRAME_COUNT frames, in the host stream's callback.
+     * Each stream is converted to the host sample rate with linear interpolation, and to stereo, and
+     * its volume is applied before it's added to the block with saturation.
+     *
+     * The data callback of a stream is never called while the stream is being destroyed, but the
+     * mixer does not hold any lock of its own while calling it, so a callback may create or destroy
+     * other streams.
+     */
+    class audio_mixer {
+    public:
+        static constexpr std::uint8_t CHANNEL_COUNT = 2;
+        static constexpr std::size_t BLOCK_FRAME_COUNT = 256;
+
+    private:
+        audio_driver *driver_;
+        std::unique_ptr<audio_output_stream> host_stream_;
+        std::uint32_t sample_rate_;
+
+        std::mutex lock_;
+        std::vector<std::shared_ptr<mixer_source>> sources_;
+        std::atomic<bool> host_started_;
+
+        // Used only by the thread mixing
+        std::vector<std::shared_ptr<mixer_source>> mixing_sources_;
+        std::vector<std::int16_t> source_block_;
+
+        bool render_source(mixer_source &source, std::int16_t *dest, const std::size_t frame_count);
+
+    public:
+        /**
+         * \brief Create a mixer.
+         *
+         * \param driver        The driver to create the host stream with.
+         * \param sample_rate   Sample rate of the host stream.
+         * \param create_host   True to create the host stream. Else the owner must call mix itself.
+         */
+        explicit audio_mixer(audio_driver *driver, const std::uint32_t sample_rate, const bool create_host = true);
+        ~audio_mixer();
+
+        /**
+         * \brief Create a signed 16-bit LE output stream mixed by this mixer.
+         *
+         * \param sample_rate   Sample rate of the stream.
+         * \param channels      Number of channels of the stream, 1 or 2.
+         * \param callback      The callback that the stream will use to retrieve data.
+         *
+         * \returns The stream, or nullptr if the mixer has no host stream to play on.
+         */
+        std::unique_ptr<audio_output_stream> new_output_stream(const std::uint32_t sample_rate,
+            const std::uint8_t channels, data_callback callback);
+
+        void remove_source(mixer_source *source);
+        void source_started();
+
+        /**
+         * \brief Mix all playing streams.
+         *
+         * \param dest          Destination of the stereo frames.
+         * \param frame_count   Number of frames to mix.
+         *
+         * \returns Number of frames written, which is always frame_count.
+         */
+        std::size_t mix(std::int16_t *dest, const std::size_t frame_count);
+
+        std::uint32_t sample_rate() const {
+            return sample_rate_;
+        }
+
+        std::size_t source_count();
+    };
+
+    /**
+     * \brief Add 16-bit samples to others, clamping the sums.
+     *
+     * \param dest      Samples to add to. Receives the sums.
+     * \param source    Samples to add.
+     * \param count     Number of samples.
+     */
+    void mix_samples_saturated(std::int16_t *dest, const std::int16_t *source, const std::size_t count);
+}
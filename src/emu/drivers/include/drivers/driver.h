@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <condition_variable>
 #include <mutex>
@@ -29,12 +30,17 @@ namespace eka2l1 {
 }
 
 namespace eka2l1::drivers {
+    static constexpr std::size_t COMMAND_MAX_DATA_WORD = 10;
+
     /**
      * \brief Represent a command for driver.
+     *
+     * This is the decoded form, which the driver dispatches. Inside a command list, only the non-zero
+     * data words are stored.
      */
     struct command {
         std::uint32_t opcode_;
-        std::uint64_t data_[10];
+        std::uint64_t data_[COMMAND_MAX_DATA_WORD];
         int *status_;
 
         explicit command()
@@ -50,51 +56,144 @@ namespace eka2l1::drivers {
         }
     };
 
+    static constexpr std::size_t COMMAND_BLOCK_SIZE = 64 * 1024;
+
+    /**
+     * \brief A chunk of memory holding encoded commands or their payloads.
+     */
+    struct alignas(16) command_block {
+        command_block *next_;
+        std::uint8_t *data_;
+
+        std::size_t capacity_;
+        std::size_t used_;
+
+        bool external_; ///< The data is a heap buffer handed over by the client, freed with the block.
+    };
+
+    /**
+     * \brief Recycle command blocks between the threads building command lists and the driver thread.
+     *
+     * Blocks of the standard size are kept for reuse once the driver retires the list owning them,
+     * so a steady frame rate does not hit the heap. Larger blocks are freed right away.
+     */
+    class command_block_pool {
+        std::mutex lock_;
+        command_block *free_;
+        std::size_t free_count_;
+
+    public:
+        static constexpr std::size_t MAX_FREE_BLOCK_COUNT = 64;
+
+        explicit command_block_pool();
+        ~command_block_pool();
+
+        /**
+         * \brief Get a block that has at least the given capacity.
+         */
+        command_block *acquire(const std::size_t min_capacity = COMMAND_BLOCK_SIZE);
+
+        /**
+         * \brief Wrap a heap buffer allocated with new[] in a block, taking its ownership.
+         */
+        command_block *adopt(std::uint8_t *data, const std::size_t size);
+
+        /**
+         * \brief Give back a chain of blocks.
+         */
+        void release(command_block *chain);
+    };
+
+    command_block_pool &get_command_block_pool();
+
     /**
-     * \brief A linked list of command.
+     * \brief A list of commands, encoded in a byte stream.
+     *
+     * Each command takes a 4-byte header (opcode, and a mask of which data words are stored), its
+     * status pointer if it has one, and then its non-zero data words. Payloads that the commands point to are bump-allocated in the
+     * list's own blocks, and stay alive until the driver retires the list.
+     *
+     * Copying the list does not copy the blocks. Once the list is handed to the driver, the driver
+     * owns them.
      */
     struct command_list {
-        command *base_;
+        command_block *stream_head_;
+        command_block *stream_tail_;
+        command_block *payload_head_;
+        command_block *payload_current_;
+
+        command pending_;
+        bool has_pending_;
 
         std::size_t size_;
-        std::size_t max_cap_;
 
-        explicit command_list(std::size_t max_cap = 0)
-            : base_(nullptr)
-            , size_(0)
-            , max_cap_(max_cap) {
-        }
+        explicit command_list();
 
         bool empty() const {
             return (size_ == 0);
         }
 
-        command *retrieve_next() {
-            if (!max_cap_) {
-                return nullptr;
-            }
-
-            if (!base_) {
-                renew();
-            }
-
-            command *res = base_ + size_;
-            res->status_ = nullptr;
-
-            size_++;
+        /**
+         * \brief Get a zeroed command to fill in.
+         *
+         * The command is encoded on the next call, or on flush. Do not hold the pointer past that.
+         */
+        command *retrieve_next();
+
+        /**
+         * \brief Encode the command retrieved last, if any.
+         */
+        void flush();
+
+        /**
+         * \brief Encode a filled command to the end of the list.
+         */
+        void push(const command &cmd);
+
+        /**
+         * \brief Allocate memory for a command payload, which lives until the list is retired.
+         */
+        std::uint8_t *allocate_payload(const std::size_t size);
+
+        /**
+         * \brief Take ownership of a heap buffer allocated with new[], freed when the list is retired.
+         */
+        void adopt_payload(std::uint8_t *data, const std::size_t size);
+
+        /**
+         * \brief Move all commands and payloads of another list to the end of this list.
+         *
+         * The other list is left empty.
+         */
+        void append(command_list &another);
+
+        /**
+         * \brief Give back all blocks, freeing commands and payloads. The list is left empty.
+         */
+        void retire();
+
+        /**
+         * \brief Get the number of bytes the encoded commands take.
+         */
+        std::size_t stream_size() const;
+    };
 
-            return res;
-        }
+    /**
+     * \brief Decode the commands of a flushed list in order.
+     */
+    class command_reader {
+        const command_block *block_;
+        std::size_t offset_;
 
-        void renew() {
-            if (max_cap_ == 0) {
-                return;
-            }
-            // NOTE: After command all iterated, the base will be deleted.
-            // No memory leak!
-            base_ = new command[max_cap_];
-            size_ = 0;
-        }
+    public:
+        explicit command_reader(const command_list &list);
+
+        /**
+         * \brief Decode the next command.
+         *
+         * \returns False if there is no more command.
+         */
+        bool next(command &cmd);
     };
 
     class driver {
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/graphics.h>
+
+#include <common/queue.h>
+
+#include <atomic>
+#include <string>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief Graphics driver with no host device, for headless runs.
+     *
+     * Commands are consumed and dropped. Object creation hands out handles that refer to nothing,
+     * and anything read back from the driver is left untouched. Shader programs are never linked.
+     */
+    class null_graphics_driver : public graphics_driver {
+        eka2l1::request_queue<command_list> list_queue_;
+        std::atomic_bool should_stop_;
+
+        drivers::handle next_handle_;
+
+        void dispatch(command &cmd);
+
+    public:
+        explicit null_graphics_driver();
+        ~null_graphics_driver() override;
+
+        void run() override;
+        void abort() override;
+        void wait_for(int *status) override;
+
+        bool aborted() const override {
+            return should_stop_.load();
+        }
+
+        void update_bitmap(drivers::handle h, const std::size_t size, const eka2l1::vec2 &offset,
+            const eka2l1::vec2 &dim, const void *data, const std::size_t pixels_per_line = 0) override;
+
+        void set_viewport(const eka2l1::rect &viewport) override;
+        void update_surface(void *surface) override;
+        void submit_command_list(command_list &cmd_list) override;
+
+        void set_upscale_shader(const std::string &name) override;
+        std::string get_active_upscale_shader() const override;
+
+        bool support_extension(const graphics_driver_extension ext) override;
+        bool query_extension_value(const graphics_driver_extension_query query, void *data_ptr) override;
+    };
+}
@@ -32,6 +32,7 @@
 
 #include <memory>
 #include <queue>
+#include <vector>
 
 namespace eka2l1::drivers {
     struct ogl_state {
@@ -82,6 +83,11 @@ namespace eka2l1::drivers {
         GLuint pen_vbo;
         GLuint pen_ibo;
 
+        GLuint quad_vbo;
+        GLuint quad_ibo;
+        std::size_t quad_ibo_capacity_;
+        std::vector<GLfloat> quad_vertices_;
+
         GLint color_loc;
         GLint proj_loc;
         GLint model_loc;
@@ -153,6 +159,7 @@ namespace eka2l1::drivers {
 
         void clear(command &cmd);
         void draw_bitmap(command &cmd);
+        void draw_bitmap_quads(command &cmd);
         void draw_rectangle(command &cmd);
         void clip_rect(command &cmd);
         void clip_region(command &cmd);
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <drivers/graphics/graphics.h>
+
+#include <common/queue.h>
+#include <common/vecx.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::drivers {
+    /**
+     * \brief Bitmap stored in host memory, as RGBA8 pixels packed in a 32-bit word (red in the lowest byte).
+     *
+     * Rows are stored top to bottom, the same way the OpenGL backend sees bitmaps through its projection.
+     */
+    struct software_bitmap {
+        eka2l1::vec2 size_;
+        int bpp_;
+
+        std::vector<std::uint32_t> pixels_;
+        bool render_target_;
+
+        explicit software_bitmap(const eka2l1::vec2 &size, const int bpp);
+        void resize(const eka2l1::vec2 &new_size);
+
+        std::uint32_t *row(const int y) {
+            return pixels_.data() + static_cast<std::size_t>(y) * size_.x;
+        }
+
+        const std::uint32_t *row(const int y) const {
+            return pixels_.data() + static_cast<std::size_t>(y) * size_.x;
+        }
+    };
+
+    using software_bitmap_ptr = std::unique_ptr<software_bitmap>;
+
+    struct software_blend_state {
+        bool enabled_ = false;
+
+        blend_equation rgb_equation_ = blend_equation::add;
+        blend_equation a_equation_ = blend_equation::add;
+        blend_factor rgb_frag_factor_ = blend_factor::one;
+        blend_factor rgb_current_factor_ = blend_factor::zero;
+        blend_factor a_frag_factor_ = blend_factor::one;
+        blend_factor a_current_factor_ = blend_factor::zero;
+
+        std::uint32_t constant_ = 0;
+    };
+
+    struct software_render_state {
+        std::uint32_t brush_color_ = 0xFFFFFFFF;
+        software_blend_state blend_;
+
+        bool clipping_ = false;
+        bool region_clipping_ = false;
+
+        eka2l1::rect scissor_;
+        std::vector<eka2l1::rect> region_;
+
+        pen_style pen_style_ = pen_style_none;
+        int point_size_ = 1;
+    };
+
+    enum software_draw_op_kind : std::uint8_t {
+        software_draw_op_fill,
+        software_draw_op_bitmap,
+        software_draw_op_points
+    };
+
+    /**
+     * \brief A draw recorded against the bound target, with the state it was issued with.
+     *
+     * Draws are binned into screen tiles and rasterized when the batch is flushed.
+     */
+    struct software_draw_op {
+        software_draw_op_kind kind_;
+
+        eka2l1::rect dest_;
+        eka2l1::rect bounds_;
+
+        std::uint32_t clip_begin_;
+        std::uint32_t clip_count_;
+
+        std::uint32_t color_;
+        software_blend_state blend_;
+
+        // Bitmap draws
+        const software_bitmap *source_;
+        const software_bitmap *mask_;
+        eka2l1::rect source_rect_;
+        eka2l1::vec2 origin_;
+        float rotation_;
+        std::uint32_t flags_;
+
+        // Pen draws, which are squares of the point size
+        std::uint32_t point_begin_;
+        std::uint32_t point_count_;
+        int point_size_;
+    };
+
+    class software_tile_workers {
+        std::vector<std::thread> threads_;
+
+        std::mutex lock_;
+        std::condition_variable work_cond_;
+        std::condition_variable done_cond_;
+
+        std::function<void(std::size_t)> job_;
+        std::size_t job_count_;
+        std::atomic<std::size_t> next_job_;
+
+        std::size_t working_count_;
+        std::uint64_t generation_;
+        bool stop_;
+
+        void drain_jobs();
+        void worker_loop();
+
+    public:
+        explicit software_tile_workers(const std::size_t thread_count);
+        ~software_tile_workers();
+
+        std::size_t thread_count() const {
+            return threads_.size();
+        }
+
+        /**
+         * \brief Run a job for each index in [0, count), spread over the workers and the calling thread.
+         *
+         * Returns when all jobs are done.
+         */
+        void run(const std::size_t count, const std::function<void(std::size_t)> &job);
+    };
+
+    /**
+     * \brief Graphics driver that rasterizes on the CPU, for runs without a GPU.
+     *
+     * Covers the immediate (2D) command set: bitmaps and blits, masks, brush and pen draws, clipping
+     * and blending. Draws are recorded into a batch, binned into tiles, and the tiles are rasterized
+     * in parallel when something needs the pixels (a target switch, a read back, an upload, or the end
+     * of a command list).
+     *
+     * GLES and VG are not supported yet: they are refused at EGL initialization. Advanced mode objects
+     * created anyway are given handles, but shader programs are never linked and their draws are dropped.
+     */
+    class software_graphics_driver : public graphics_driver {
+        eka2l1::request_queue<command_list> list_queue_;
+        std::atomic_bool should_stop_;
+
+        drivers::handle next_handle_;
+
+        std::vector<software_bitmap_ptr> bitmaps_;
+        software_bitmap screen_;
+        software_bitmap *binding_;
+
+        software_render_state state_;
+        software_render_state backup_state_;
+
+        std::vector<software_draw_op> batch_;
+        std::vector<eka2l1::rect> batch_clips_;
+        std::vector<eka2l1::point> batch_points_;
+        std::vector<software_bitmap_ptr> batch_copies_;
+        std::vector<std::vector<std::uint32_t>> tile_bins_;
+        std::vector<std::uint32_t> active_tiles_;
+
+        std::unique_ptr<software_tile_workers> workers_;
+        bool warned_advanced_draw_;
+
+        software_bitmap *get_bitmap(const drivers::handle h);
+        software_bitmap *current_target();
+
+        const software_bitmap *snapshot_source(const software_bitmap *source);
+        bool prepare_op(software_draw_op &op, const bool scissor_only = false);
+
+        void flush_batch();
+        void rasterize_tile(const std::size_t tile_index);
+
+        void create_bitmap(command &cmd);
+        void bind_bitmap(command &cmd);
+        void update_bitmap(command &cmd);
+        void read_bitmap(command &cmd);
+        void resize_bitmap(command &cmd);
+        void destroy_bitmap(command &cmd);
+        void clip_rect(command &cmd);
+        void clip_region(command &cmd);
+        void set_feature(command &cmd);
+        void blend_formula(command &cmd);
+        void clear(command &cmd);
+        void draw_rectangle(command &cmd);
+        void draw_bitmap(command &cmd);
+        void draw_bitmap_quads(command &cmd);
+        void draw_line(const eka2l1::point &start, const eka2l1::point &end);
+        void draw_line(command &cmd);
+        void draw_polygon(command &cmd);
+
+        void dispatch(command &cmd);
+
+    public:
+        explicit software_graphics_driver(const std::size_t thread_count = 0);
+        ~software_graphics_driver() override;
+
+        void run() override;
+        void abort() override;
+        void wait_for(int *status) override;
+
+        bool aborted() const override {
+            return should_stop_.load();
+        }
+
+        void update_bitmap(drivers::handle h, const std::size_t size, const eka2l1::vec2 &offset,
+            const eka2l1::vec2 &dim, const void *data, const std::size_t pixels_per_line = 0) override;
+
+        void set_viewport(const eka2l1::rect &viewport) override;
+        void update_surface(void *surface) override;
+        void submit_command_list(command_list &cmd_list) override;
+
+        void set_upscale_shader(const std::string &name) override;
+        std::string get_active_upscale_shader() const override;
+
+        bool support_shader_draw() const override {
+            return false;
+        }
+
+        bool support_extension(const graphics_driver_extension ext) override;
+        bool query_extension_value(const graphics_driver_extension_query query, void *data_ptr) override;
+    };
+}
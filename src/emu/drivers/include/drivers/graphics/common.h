@@ -26,7 +26,9 @@ namespace eka2l1::drivers {
 
     enum class graphic_api {
         opengl,
-        vulkan
+        vulkan,
+        null,
+        software
     };
 
     class graphics_object {
@@ -66,6 +66,7 @@ namespace eka2l1::drivers {
         graphics_driver_resize_bitmap,
         graphics_driver_read_bitmap,
         graphics_driver_clip_region,
+        graphics_driver_draw_bitmap_quads,
 
         // Mode 1: Advance - Lower access to functions
         graphics_driver_create_shader_module,
@@ -140,6 +141,15 @@ namespace eka2l1::drivers {
             return false;
         }
 
+        /**
+         * \brief Check if the driver can run shader programs, and the draws that use them.
+         *
+         * Drivers that can't only handle the immediate (2D) command set, and can't back GLES or VG.
+         */
+        virtual bool support_shader_draw() const {
+            return true;
+        }
+
         /**
          * \brief Set a hook when display function is called.
          *
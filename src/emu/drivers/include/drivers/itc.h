@@ -209,7 +209,6 @@ namespace eka2l1::drivers {
     void read_framebuffer(graphics_driver *driver, drivers::handle h, const eka2l1::vec2 pos, const eka2l1::vec2 size, drivers::texture_format format, drivers::texture_data_type dt, void *data_ptr);
 
     static constexpr std::size_t MAX_THRESHOLD_TO_FLUSH = 12000;
-    static constexpr std::size_t MAX_CAP_COMMAND_COUNT = 12800;
 
     #define PACK_2U32_TO_U64(a, b) (static_cast<std::uint64_t>(b) << 32) | static_cast<std::uint32_t>(a)
 
@@ -222,19 +221,23 @@ namespace eka2l1::drivers {
     std::uint64_t pack_from_two_floats(const float f1, const float f2);
     void unpack_to_two_floats(const std::uint64_t source, float &f1, float &f2);
 
+    /**
+     * \brief One textured quad of a quad list, drawn without rotation.
+     */
+    struct bitmap_quad {
+        eka2l1::rect dest_;
+        eka2l1::rect source_;
+    };
+
     class graphics_command_builder {
     protected:
         command_list list_;
 
     public:
-        explicit graphics_command_builder()
-            : list_(MAX_CAP_COMMAND_COUNT) {
-        }
+        explicit graphics_command_builder() = default;
 
         ~graphics_command_builder() {
-            if (list_.base_) {
-                delete list_.base_;
-            }
+            list_.retire();
         }
 
         bool is_empty() const {
@@ -246,16 +249,14 @@ namespace eka2l1::drivers {
         }
 
         void reset_list() {
-            delete list_.base_;
-
-            list_.size_ = 0;
-            list_.base_ = nullptr;
+            list_.retire();
         }
 
         command_list retrieve_command_list() {
+            list_.flush();
+
             command_list copy = list_;
-            list_.base_ = nullptr;
-            list_.size_ = 0;
+            list_ = command_list();
 
             return copy;
         }
@@ -264,24 +265,13 @@ namespace eka2l1::drivers {
             return list_.retrieve_next();
         }
 
-        bool merge(command_list &another) {
-            if (!another.base_ || !another.size_) {
-                return true;
-            }
-
-            if (list_.base_ == nullptr) {
-                list_ = another;
-            } else {
-                if (another.size_ + list_.size_ > list_.max_cap_) {
-                    return false;
-                }
-
-                std::memcpy(list_.base_ + list_.size_, another.base_, another.size_ * sizeof(command));
-                list_.size_ += another.size_;
-            }
-
-            delete[] another.base_;
-            return true;
+        /**
+         * \brief Move commands of another list to the end of this builder's list.
+         *
+         * Lists are chained together, so this never runs out of room.
+         */
+        void merge(command_list &another) {
+            list_.append(another);
         }
 
         void set_brush_color_detail(const eka2l1::vec4 &color);
@@ -333,6 +323,7 @@ namespace eka2l1::drivers {
          * \param offset            The offset of the bitmap (pixels).
          * \param dim               The dimensions of bitmap (pixels).
          * \param pixels_per_line   Number of pixels per row. Use 0 for default.
+         * \param need_copy         If false, the data must be allocated with new[], and is freed with the command list.
          * 
          * \returns Handle to the texture.
          */
@@ -379,6 +370,20 @@ namespace eka2l1::drivers {
             const eka2l1::rect &source_rect, const eka2l1::vec2 &origin = eka2l1::vec2(0, 0),
             const float rotation = 0.0f, const std::uint32_t flags = 0);
 
+        /**
+         * \brief Draw a list of quads sampling the same bitmap, in one draw.
+         *
+         * Each quad is drawn like a draw_bitmap with no mask, origin or rotation. Empty source rectangles
+         * are not allowed here. The list is copied into the command list.
+         *
+         * \param h            The handle of the bitmap to sample from.
+         * \param quads        Pointer to the quads to draw.
+         * \param quad_count   Number of quads in the list.
+         * \param flags        Drawing flags. Only bitmap_draw_flag_use_brush applies.
+         */
+        void draw_bitmap_quads(drivers::handle h, const bitmap_quad *quads, const std::size_t quad_count,
+            const std::uint32_t flags = 0);
+
         /**
          * \brief Draw a rectangle with brush color.
          * 
@@ -477,6 +482,9 @@ namespace eka2l1::drivers {
          */
         void update_buffer_data(drivers::handle h, const std::size_t offset, const int chunk_count, const void **chunk_ptr, const std::uint32_t *chunk_size);
 
+        /**
+         * \brief Update buffer data with a buffer allocated with new[], which is freed with the command list.
+         */
         void update_buffer_data_no_copy(drivers::handle h, const std::size_t offset, const void *ptr, const std::uint32_t size);
 
         /**
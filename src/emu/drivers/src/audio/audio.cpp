@@ -19,6 +19,7 @@
 
 #include <drivers/audio/audio.h>
 #include <drivers/audio/backend/cubeb/audio_cubeb.h>
+#include <drivers/audio/backend/null/audio_null.h>
 
 #include <common/platform.h>
 
@@ -135,6 +136,26 @@ namespace eka2l1::drivers {
         }
     }
 
+    audio_mixer *audio_driver::get_mixer() {
+        const std::lock_guard<std::mutex> guard(mixer_lock_);
+
+        if (!mixer_) {
+            std::uint32_t sample_rate = native_sample_rate();
+            if (sample_rate == 0) {
+                sample_rate = 44100;
+            }
+
+            mixer_ = std::make_unique<audio_mixer>(this, sample_rate);
+        }
+
+        return mixer_.get();
+    }
+
+    void audio_driver::destroy_mixer() {
+        const std::lock_guard<std::mutex> guard(mixer_lock_);
+        mixer_.reset();
+    }
+
     audio_driver_instance make_audio_driver(const audio_driver_backend backend, const std::uint32_t initial_master_vol,
         const player_type preferred_midi_backend) {
         switch (backend) {
@@ -142,6 +163,10 @@ namespace eka2l1::drivers {
             return std::make_unique<cubeb_audio_driver>(initial_master_vol, preferred_midi_backend);
         }
 
+        case audio_driver_backend::null: {
+            return std::make_unique<null_audio_driver>(initial_master_vol, preferred_midi_backend);
+        }
+
         default:
             break;
         }
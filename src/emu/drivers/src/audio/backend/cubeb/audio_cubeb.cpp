@@ -43,6 +43,8 @@ namespace eka2l1::drivers {
     }
 
     cubeb_audio_driver::~cubeb_audio_driver() {
+        // The mixer plays on a cubeb stream
+        destroy_mixer();
         BAE_DriverDeactivated(this);
         
         if (context_) {
@@ -17,7 +17,9 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/algorithm.h>
 #include <common/log.h>
+#include <common/thread.h>
 #include <drivers/audio/backend/dsp_shared.h>
 
 namespace eka2l1::drivers {
@@ -26,10 +28,17 @@ namespace eka2l1::drivers {
         , aud_(aud)
         , virtual_stop(true)
         , more_requested(false)
-        , avg_frame_count_(0) {
+        , avg_frame_count_(0)
+        , decode_requested_(false)
+        , decode_thread_quit_(false)
+        , decode_lookahead_ms_(DEFAULT_DECODE_LOOKAHEAD_MS)
+        , underrun_count_(0)
+        , underrun_frame_count_(0) {
     }
 
     dsp_output_stream_shared::~dsp_output_stream_shared() {
+        stop_decode_thread();
+
         if (stream_) {
             stream_->stop();
         }
@@ -52,10 +61,14 @@ namespace eka2l1::drivers {
             stream_.reset();
         }
 
-        channels_ = channels;
-        freq_ = freq;
+        {
+            const std::lock_guard<std::mutex> guard(decode_lock_);
 
-        stream_ = aud_->new_output_stream(freq, channels, [this](std::int16_t *buffer, const std::size_t nb_frames) {
+            channels_ = channels;
+            freq_ = freq;
+        }
+
+        stream_ = aud_->get_mixer()->new_output_stream(freq, channels, [this](std::int16_t *buffer, const std::size_t nb_frames) {
             return data_callback(buffer, nb_frames);
         });
 
@@ -86,7 +99,7 @@ namespace eka2l1::drivers {
 
             // Create default stream. This follows default MMFDevSound default setting closely
             // Even though this is a generic stream... ;)
-            stream_ = aud_->new_output_stream(8000, 1, [this](std::int16_t *buffer, const std::size_t nb_frames) {
+            stream_ = aud_->get_mixer()->new_output_stream(8000, 1, [this](std::int16_t *buffer, const std::size_t nb_frames) {
                 return data_callback(buffer, nb_frames);
             });
 
@@ -117,16 +130,82 @@ namespace eka2l1::drivers {
         virtual_stop = true;
         more_requested = false;
 
-        buffer_.reset();
+        {
+            const std::lock_guard<std::mutex> guard(decode_lock_);
+            buffer_.reset();
+        }
 
         return true;
     }
 
+    void dsp_output_stream_shared::decode_lookahead(const std::uint32_t milliseconds) {
+        decode_lookahead_ms_ = milliseconds;
+    }
+
+    std::size_t dsp_output_stream_shared::decode_lookahead_sample_count() const {
+        // Leave room in the ring buffer for the decoded piece that goes over the lookahead
+        return common::min<std::size_t>(static_cast<std::size_t>(freq_) * channels_ * decode_lookahead_ms_ / 1000,
+            RING_BUFFER_MAX_SAMPLE_COUNT / 2);
+    }
+
+    void dsp_output_stream_shared::request_decode() {
+        if (!decode_requested_.exchange(true)) {
+            decode_event_.set();
+        }
+    }
+
+    void dsp_output_stream_shared::decode_loop() {
+        common::set_thread_name("DSP decode thread");
+
+        while (!decode_thread_quit_) {
+            decode_event_.wait();
+            decode_event_.reset();
+
+            decode_requested_ = false;
+
+            if (decode_thread_quit_) {
+                break;
+            }
+
+            while (!decode_thread_quit_) {
+                // Take the lock one piece at a time, so guest writes don't wait for the whole lookahead
+                const std::lock_guard<std::mutex> guard(decode_lock_);
+
+                if ((buffer_.size() >= decode_lookahead_sample_count()) || !decode_data(decode_buffer_)) {
+                    break;
+                }
+
+                buffer_.push(decode_buffer_.data(), (decode_buffer_.size() + 1) / 2);
+            }
+        }
+    }
+
+    void dsp_output_stream_shared::stop_decode_thread() {
+        if (!decode_thread_) {
+            return;
+        }
+
+        decode_thread_quit_ = true;
+        decode_event_.set();
+
+        decode_thread_->join();
+        decode_thread_.reset();
+    }
+
     bool dsp_output_stream_shared::write(const std::uint8_t *data, const std::uint32_t data_size) {
         // Copy buffer to queue
         if (format_ != PCM16_FOUR_CC_CODE) {
             queue_data_decode(data, data_size);
+
+            if (!decode_thread_) {
+                decode_thread_quit_ = false;
+                decode_thread_ = std::make_unique<std::thread>(&dsp_output_stream_shared::decode_loop, this);
+            }
+
+            request_decode();
         } else {
+            // The ring buffer takes one producer at a time
+            const std::lock_guard<std::mutex> guard(decode_lock_);
             buffer_.push(data, (data_size + 1) / 2);
         }
 
@@ -151,18 +230,13 @@ namespace eka2l1::drivers {
             avg_frame_count_ = (avg_frame_count_ + frame_count) / 2;
         }
 
-        if (format_ != PCM16_FOUR_CC_CODE) {
-            // Running on low
-            if (buffer_.size() <= (avg_frame_count_ * channels_ * 4)) {
-                std::vector<std::uint8_t> target_buffer;
-                decode_data(target_buffer);
+        std::size_t frame_to_wrote = buffer_.pop(buffer, frame_count * channels_) / channels_;
 
-                buffer_.push(target_buffer.data(), (target_buffer.size() + 1) / 2);
-            }
+        // Let the decode thread top up what was just played
+        if ((format_ != PCM16_FOUR_CC_CODE) && (buffer_.size() < decode_lookahead_sample_count())) {
+            request_decode();
         }
 
-        std::size_t frame_to_wrote = buffer_.pop(buffer, frame_count * channels_) / channels_;
-
         samples_copied_ += frame_to_wrote * channels_;
 
         std::size_t sample_to_wrote = frame_to_wrote * channels_;
@@ -184,6 +258,11 @@ namespace eka2l1::drivers {
         frame_wrote += frame_to_wrote;
 
         if (frame_wrote < frame_count) {
+            if (!virtual_stop && (samples_copied_ != 0)) {
+                underrun_count_++;
+                underrun_frame_count_ += frame_count - frame_wrote;
+            }
+
             std::memset(&buffer[frame_wrote * channels_], 0, (frame_count - frame_wrote) * channels_ * sizeof(std::int16_t));
         }
 
@@ -49,11 +49,14 @@ namespace eka2l1::drivers {
         , io_(nullptr)
         , custom_io_buffer_(nullptr)
         , timestamp_in_base_(0)
+        , queued_data_size_(0)
         , state_(STATE_NONE) {
         format(PCM16_FOUR_CC_CODE);
     }
 
     dsp_output_stream_ffmpeg::~dsp_output_stream_ffmpeg() {
+        stop_decode_thread();
+
         if (codec_) {
             avcodec_close(codec_);
             avcodec_free_context(&codec_);
@@ -84,6 +87,8 @@ namespace eka2l1::drivers {
             queued_data_.erase(queued_data_.begin(), queued_data_.begin() + read_size);
         }
 
+        queued_data_size_ = queued_data_.size();
+
         return (read_size <= 0) ? AVERROR_EOF : read_size;
     }
 
@@ -94,6 +99,8 @@ namespace eka2l1::drivers {
     }
 
     bool dsp_output_stream_ffmpeg::format(const four_cc fmt) {
+        const std::lock_guard<std::mutex> guard(decode_lock_);
+
         if ((fmt == PCM16_FOUR_CC_CODE) || (fmt == PCM8_FOUR_CC_CODE)) {
             if (codec_) {
                 avcodec_close(codec_);
@@ -190,6 +197,8 @@ namespace eka2l1::drivers {
 
         queued_data_.resize(queued_data_.size() + original_size);
         std::memcpy(queued_data_.data() + queued_data_.size() - original_size, original, original_size);
+
+        queued_data_size_ = queued_data_.size();
     }
 
     bool dsp_output_stream_ffmpeg::decode_data(std::vector<std::uint8_t> &dest) {
@@ -309,7 +318,7 @@ namespace eka2l1::drivers {
     }
 
     bool dsp_output_stream_ffmpeg::internal_decode_running_out() {
-        return ((format_ != drivers::PCM16_FOUR_CC_CODE) && (queued_data_.size() <= CUSTOM_IO_BUFFER_SIZE * 2)) ||
+        return ((format_ != drivers::PCM16_FOUR_CC_CODE) && (queued_data_size_ <= CUSTOM_IO_BUFFER_SIZE * 2)) ||
             dsp_output_stream_shared::internal_decode_running_out();
     }
 }
\ No newline at end of file
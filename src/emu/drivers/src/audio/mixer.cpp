@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/audio/audio.h>
+#include <drivers/audio/mixer.h>
+
+#include <common/algorithm.h>
+#include <common/log.h>
+#include <common/platform.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if EKA2L1_ARCH(X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define EKA2L1_MIXER_SSE2 1
+#include <emmintrin.h>
+#elif EKA2L1_ARCH(ARM64) || EKA2L1_ARCH(ARM_NEON) || defined(__ARM_NEON)
+#define EKA2L1_MIXER_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace eka2l1::drivers {
+    static constexpr std::uint64_t FIXED_ONE = 1ULL << 32;
+    static constexpr std::int32_t UNITY_GAIN = 1 << 15;
+
+    void mix_samples_saturated(std::int16_t *dest, const std::int16_t *source, const std::size_t count) {
+        std::size_t i = 0;
+
+#if EKA2L1_MIXER_SSE2
+        for (; i + 8 <= count; i += 8) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dest + i));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), _mm_adds_epi16(a, b));
+        }
+#elif EKA2L1_MIXER_NEON
+        for (; i + 8 <= count; i += 8) {
+            vst1q_s16(dest + i, vqaddq_s16(vld1q_s16(dest + i), vld1q_s16(source + i)));
+        }
+#endif
+
+        for (; i < count; i++) {
+            dest[i] = static_cast<std::int16_t>(common::clamp<std::int32_t>(-32768, 32767,
+                static_cast<std::int32_t>(dest[i]) + source[i]));
+        }
+    }
+
+    mixer_source::mixer_source(const std::uint32_t sample_rate, const std::uint8_t channels, data_callback callback)
+        : callback_(callback)
+        , sample_rate_(sample_rate)
+        , channels_(channels)
+        , playing_(false)
+        , pausing_(false)
+        , gain_(UNITY_GAIN)
+        , frames_played_(0)
+        , step_(0)
+        , position_(0)
+        , source_frame_count_(0) {
+    }
+
+    mixer_output_stream::mixer_output_stream(audio_driver *driver, audio_mixer *mixer, std::shared_ptr<mixer_source> source)
+        : audio_output_stream(driver, source->sample_rate_, source->channels_)
+        , mixer_(mixer)
+        , source_(source)
+        , volume_(1.0f) {
+    }
+
+    mixer_output_stream::~mixer_output_stream() {
+        {
+            // Wait for the callback in progress, the mixer may still hold the source after that
+            const std::lock_guard<std::mutex> guard(source_->callback_lock_);
+            source_->callback_ = nullptr;
+            source_->playing_ = false;
+        }
+
+        mixer_->remove_source(source_.get());
+    }
+
+    bool mixer_output_stream::start() {
+        source_->pausing_ = false;
+        source_->playing_ = true;
+
+        mixer_->source_started();
+        return true;
+    }
+
+    bool mixer_output_stream::stop() {
+        source_->playing_ = false;
+        source_->pausing_ = false;
+
+        return true;
+    }
+
+    void mixer_output_stream::pause() {
+        source_->pausing_ = true;
+    }
+
+    bool mixer_output_stream::is_playing() {
+        return source_->playing_;
+    }
+
+    bool mixer_output_stream::is_pausing() {
+        return source_->pausing_;
+    }
+
+    bool mixer_output_stream::set_volume(const float volume) {
+        // Master volume is applied by the host stream
+        volume_ = volume;
+        source_->gain_ = static_cast<std::int32_t>(common::clamp(0.0f, 1.0f, volume) * UNITY_GAIN);
+
+        return true;
+    }
+
+    float mixer_output_stream::get_volume() const {
+        return volume_;
+    }
+
+    bool mixer_output_stream::current_frame_position(std::uint64_t *pos) {
+        *pos = source_->frames_played_;
+        return true;
+    }
+
+    audio_mixer::audio_mixer(audio_driver *driver, const std::uint32_t sample_rate, const bool create_host)
+        : driver_(driver)
+        , sample_rate_(sample_rate)
+        , host_started_(false)
+        , source_block_(BLOCK_FRAME_COUNT * CHANNEL_COUNT) {
+        if (create_host) {
+            host_stream_ = driver_->new_output_stream(sample_rate, CHANNEL_COUNT, [this](std::int16_t *buffer, const std::size_t frame_count) {
+                return mix(buffer, frame_count);
+            });
+
+            if (!host_stream_) {
+                LOG_ERROR(DRIVER_AUD, "Unable to create the output stream of the audio mixer!");
+            } else {
+                // Get the master volume applied
+                host_stream_->set_volume(1.0f);
+            }
+        } else {
+            host_started_ = true;
+        }
+    }
+
+    audio_mixer::~audio_mixer() {
+        if (host_stream_) {
+            host_stream_->stop();
+        }
+    }
+
+    std::unique_ptr<audio_output_stream> audio_mixer::new_output_stream(const std::uint32_t sample_rate,
+        const std::uint8_t channels, data_callback callback) {
+        if ((sample_rate == 0) || (channels == 0) || (channels > CHANNEL_COUNT)) {
+            LOG_ERROR(DRIVER_AUD, "Audio mixer can't take a stream with {} channels at {}Hz", channels, sample_rate);
+            return nullptr;
+        }
+
+        if (!host_stream_ && !host_started_) {
+            return nullptr;
+        }
+
+        std::shared_ptr<mixer_source> source = std::make_shared<mixer_source>(sample_rate, channels, callback);
+        source->step_ = (static_cast<std::uint64_t>(sample_rate) << 32) / sample_rate_;
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            sources_.push_back(source);
+        }
+
+        return std::make_unique<mixer_output_stream>(driver_, this, source);
+    }
+
+    void audio_mixer::remove_source(mixer_source *source) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        auto ite = std::find_if(sources_.begin(), sources_.end(), [source](const std::shared_ptr<mixer_source> &target) {
+            return target.get() == source;
+        });
+
+        if (ite != sources_.end()) {
+            sources_.erase(ite);
+        }
+    }
+
+    void audio_mixer::source_started() {
+        if (host_started_.exchange(true)) {
+            return;
+        }
+
+        if (!host_stream_->start()) {
+            LOG_ERROR(DRIVER_AUD, "Unable to start the output stream of the audio mixer!");
+            host_started_ = false;
+        }
+    }
+
+    std::size_t audio_mixer::source_count() {
+        const std::lock_guard<std::mutex> guard(lock_);
+        return sources_.size();
+    }
+
+    bool audio_mixer::render_source(mixer_source &source, std::int16_t *dest, const std::size_t frame_count) {
+        const std::lock_guard<std::mutex> guard(source.callback_lock_);
+
+        if (!source.callback_ || !source.playing_ || source.pausing_) {
+            return false;
+        }
+
+        const std::int32_t gain = source.gain_;
+
+        if ((source.step_ == FIXED_ONE) && (source.channels_ == CHANNEL_COUNT)) {
+            // Nothing to convert, pull straight to the destination
+            source.callback_(dest, frame_count);
+            source.frames_played_ += frame_count;
+
+            if (gain != UNITY_GAIN) {
+                for (std::size_t i = 0; i < frame_count * CHANNEL_COUNT; i++) {
+                    dest[i] = static_cast<std::int16_t>((dest[i] * gain) >> 15);
+                }
+            }
+
+            return true;
+        }
+
+        // Frames are interpolated between two source frames, so the frame after the last output frame is needed too.
+        // Frames left over from the previous block are used first, only the missing ones are pulled
+        const std::uint64_t start = source.position_;
+        const std::uint64_t end = start + source.step_ * frame_count;
+        const std::size_t consumed = static_cast<std::size_t>(end >> 32);
+        const std::size_t needed = common::max(static_cast<std::size_t>((start + source.step_ * (frame_count - 1)) >> 32) + 2,
+            consumed);
+
+        if (source.source_.size() < needed * CHANNEL_COUNT) {
+            source.source_.resize(needed * CHANNEL_COUNT);
+        }
+
+        std::int16_t *frames = source.source_.data();
+
+        if (needed > source.source_frame_count_) {
+            const std::size_t pull_count = needed - source.source_frame_count_;
+            std::int16_t *pull_dest = frames + source.source_frame_count_ * CHANNEL_COUNT;
+
+            if (source.channels_ == CHANNEL_COUNT) {
+                source.callback_(pull_dest, pull_count);
+            } else {
+                // Pull to the second half, then spread each sample to both channels from the front
+                std::int16_t *mono = pull_dest + pull_count;
+                source.callback_(mono, pull_count);
+
+                for (std::size_t i = 0; i < pull_count; i++) {
+                    pull_dest[i * CHANNEL_COUNT] = mono[i];
+                    pull_dest[i * CHANNEL_COUNT + 1] = mono[i];
+                }
+            }
+
+            source.frames_played_ += pull_count;
+            source.source_frame_count_ = needed;
+        }
+
+        std::uint64_t position = start;
+
+        for (std::size_t i = 0; i < frame_count; i++, position += source.step_) {
+            const std::size_t index = static_cast<std::size_t>(position >> 32) * CHANNEL_COUNT;
+            const std::int32_t fraction = static_cast<std::int32_t>((position >> 17) & 0x7FFF);
+
+            for (std::size_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+                const std::int32_t first = frames[index + channel];
+                const std::int32_t second = frames[index + CHANNEL_COUNT + channel];
+                const std::int32_t value = first + (((second - first) * fraction) >> 15);
+
+                dest[i * CHANNEL_COUNT + channel] = static_cast<std::int16_t>((value * gain) >> 15);
+            }
+        }
+
+        // Keep the frames the next block starts with
+        source.source_frame_count_ -= consumed;
+
+        std::memmove(frames, frames + consumed * CHANNEL_COUNT, source.source_frame_count_ * CHANNEL_COUNT * sizeof(std::int16_t));
+        source.position_ = end - (static_cast<std::uint64_t>(consumed) << 32);
+
+        return true;
+    }
+
+    std::size_t audio_mixer::mix(std::int16_t *dest, const std::size_t frame_count) {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            mixing_sources_.assign(sources_.begin(), sources_.end());
+        }
+
+        for (std::size_t offset = 0; offset < frame_count; offset += BLOCK_FRAME_COUNT) {
+            const std::size_t block_frame_count = common::min(BLOCK_FRAME_COUNT, frame_count - offset);
+            std::int16_t *block = dest + offset * CHANNEL_COUNT;
+
+            bool block_empty = true;
+
+            for (const std::shared_ptr<mixer_source> &source : mixing_sources_) {
+                // The first stream goes directly to the destination, the rest is added to it
+                if (!render_source(*source, block_empty ? block : source_block_.data(), block_frame_count)) {
+                    continue;
+                }
+
+                if (!block_empty) {
+                    mix_samples_saturated(block, source_block_.data(), block_frame_count * CHANNEL_COUNT);
+                }
+
+                block_empty = false;
+            }
+
+            if (block_empty) {
+                std::memset(block, 0, block_frame_count * CHANNEL_COUNT * sizeof(std::int16_t));
+            }
+        }
+
+        mixing_sources_.clear();
+        return frame_count;
+    }
+}
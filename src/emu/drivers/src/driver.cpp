@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/driver.h>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace eka2l1::drivers {
+    struct command_header {
+        std::uint16_t opcode_;
+        std::uint16_t word_mask_; ///< Bit N set if data word N is stored. Zero words are not.
+    };
+
+    static_assert(sizeof(command_header) == 4);
+    static_assert(COMMAND_MAX_DATA_WORD < 15);
+
+    static constexpr std::uint16_t COMMAND_HEADER_HAS_STATUS = 1 << 15;
+
+    // Payloads bigger than this get a block of their own, so they don't waste the rest of a shared one
+    static constexpr std::size_t MAX_SHARED_PAYLOAD_SIZE = COMMAND_BLOCK_SIZE / 4;
+    static constexpr std::size_t PAYLOAD_ALIGNMENT = 16;
+
+    command_block_pool::command_block_pool()
+        : free_(nullptr)
+        , free_count_(0) {
+    }
+
+    command_block_pool::~command_block_pool() {
+        while (free_) {
+            command_block *next = free_->next_;
+            delete[] reinterpret_cast<std::uint8_t *>(free_);
+
+            free_ = next;
+        }
+    }
+
+    command_block *command_block_pool::acquire(const std::size_t min_capacity) {
+        command_block *block = nullptr;
+
+        if (min_capacity <= COMMAND_BLOCK_SIZE) {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            if (free_) {
+                block = free_;
+                free_ = free_->next_;
+                free_count_--;
+            }
+        }
+
+        if (!block) {
+            const std::size_t capacity = std::max<std::size_t>(min_capacity, COMMAND_BLOCK_SIZE);
+            std::uint8_t *raw = new std::uint8_t[sizeof(command_block) + capacity];
+
+            block = new (raw) command_block;
+            block->data_ = raw + sizeof(command_block);
+            block->capacity_ = capacity;
+            block->external_ = false;
+        }
+
+        block->next_ = nullptr;
+        block->used_ = 0;
+
+        return block;
+    }
+
+    command_block *command_block_pool::adopt(std::uint8_t *data, const std::size_t size) {
+        command_block *block = new command_block;
+
+        block->next_ = nullptr;
+        block->data_ = data;
+        block->capacity_ = size;
+        block->used_ = size;
+        block->external_ = true;
+
+        return block;
+    }
+
+    void command_block_pool::release(command_block *chain) {
+        while (chain) {
+            command_block *next = chain->next_;
+
+            if (chain->external_) {
+                delete[] chain->data_;
+                delete chain;
+            } else {
+                bool recycled = false;
+
+                if (chain->capacity_ == COMMAND_BLOCK_SIZE) {
+                    const std::lock_guard<std::mutex> guard(lock_);
+
+                    if (free_count_ < MAX_FREE_BLOCK_COUNT) {
+                        chain->next_ = free_;
+                        free_ = chain;
+                        free_count_++;
+
+                        recycled = true;
+                    }
+                }
+
+                if (!recycled) {
+                    delete[] reinterpret_cast<std::uint8_t *>(chain);
+                }
+            }
+
+            chain = next;
+        }
+    }
+
+    command_block_pool &get_command_block_pool() {
+        static command_block_pool pool;
+        return pool;
+    }
+
+    command_list::command_list()
+        : stream_head_(nullptr)
+        , stream_tail_(nullptr)
+        , payload_head_(nullptr)
+        , payload_current_(nullptr)
+        , has_pending_(false)
+        , size_(0) {
+    }
+
+    static void encode_command(command_list &list, const command &cmd) {
+        command_header header;
+        header.opcode_ = static_cast<std::uint16_t>(cmd.opcode_);
+        header.word_mask_ = (cmd.status_ ? COMMAND_HEADER_HAS_STATUS : 0);
+
+        std::size_t word_count = 0;
+
+        for (std::size_t i = 0; i < COMMAND_MAX_DATA_WORD; i++) {
+            if (cmd.data_[i] != 0) {
+                header.word_mask_ |= static_cast<std::uint16_t>(1 << i);
+                word_count++;
+            }
+        }
+
+        const std::size_t record_size = sizeof(command_header) + (cmd.status_ ? sizeof(int *) : 0)
+            + word_count * sizeof(std::uint64_t);
+
+        // Records never cross a block, the reader moves to the next block once one is used up
+        if (!list.stream_tail_ || (list.stream_tail_->used_ + record_size > list.stream_tail_->capacity_)) {
+            command_block *block = get_command_block_pool().acquire();
+
+            if (list.stream_tail_) {
+                list.stream_tail_->next_ = block;
+            } else {
+                list.stream_head_ = block;
+            }
+
+            list.stream_tail_ = block;
+        }
+
+        std::uint8_t *dest = list.stream_tail_->data_ + list.stream_tail_->used_;
+
+        std::memcpy(dest, &header, sizeof(command_header));
+        dest += sizeof(command_header);
+
+        if (cmd.status_) {
+            std::memcpy(dest, &cmd.status_, sizeof(int *));
+            dest += sizeof(int *);
+        }
+
+        for (std::size_t i = 0; i < COMMAND_MAX_DATA_WORD; i++) {
+            if (cmd.data_[i] != 0) {
+                std::memcpy(dest, &cmd.data_[i], sizeof(std::uint64_t));
+                dest += sizeof(std::uint64_t);
+            }
+        }
+
+        list.stream_tail_->used_ += record_size;
+    }
+
+    command *command_list::retrieve_next() {
+        flush();
+
+        pending_ = command();
+        has_pending_ = true;
+        size_++;
+
+        return &pending_;
+    }
+
+    void command_list::flush() {
+        if (has_pending_) {
+            encode_command(*this, pending_);
+            has_pending_ = false;
+        }
+    }
+
+    void command_list::push(const command &cmd) {
+        flush();
+        encode_command(*this, cmd);
+
+        size_++;
+    }
+
+    static void link_payload_block(command_list &list, command_block *block) {
+        block->next_ = list.payload_head_;
+        list.payload_head_ = block;
+    }
+
+    std::uint8_t *command_list::allocate_payload(const std::size_t size) {
+        const std::size_t aligned_size = (size + PAYLOAD_ALIGNMENT - 1) & ~(PAYLOAD_ALIGNMENT - 1);
+
+        if (aligned_size > MAX_SHARED_PAYLOAD_SIZE) {
+            command_block *block = get_command_block_pool().acquire(aligned_size);
+            block->used_ = aligned_size;
+
+            link_payload_block(*this, block);
+            return block->data_;
+        }
+
+        if (!payload_current_ || (payload_current_->used_ + aligned_size > payload_current_->capacity_)) {
+            payload_current_ = get_command_block_pool().acquire();
+            link_payload_block(*this, payload_current_);
+        }
+
+        std::uint8_t *result = payload_current_->data_ + payload_current_->used_;
+        payload_current_->used_ += aligned_size;
+
+        return result;
+    }
+
+    void command_list::adopt_payload(std::uint8_t *data, const std::size_t size) {
+        if (data) {
+            link_payload_block(*this, get_command_block_pool().adopt(data, size));
+        }
+    }
+
+    void command_list::append(command_list &another) {
+        flush();
+        another.flush();
+
+        if (another.stream_head_) {
+            if (stream_tail_) {
+                stream_tail_->next_ = another.stream_head_;
+            } else {
+                stream_head_ = another.stream_head_;
+            }
+
+            stream_tail_ = another.stream_tail_;
+        }
+
+        if (another.payload_head_) {
+            command_block *last = another.payload_head_;
+
+            while (last->next_) {
+                last = last->next_;
+            }
+
+            last->next_ = payload_head_;
+            payload_head_ = another.payload_head_;
+
+            if (!payload_current_) {
+                payload_current_ = another.payload_current_;
+            }
+        }
+
+        size_ += another.size_;
+        another = command_list();
+    }
+
+    void command_list::retire() {
+        command_block_pool &pool = get_command_block_pool();
+
+        pool.release(stream_head_);
+        pool.release(payload_head_);
+
+        *this = command_list();
+    }
+
+    std::size_t command_list::stream_size() const {
+        std::size_t total = 0;
+
+        for (const command_block *block = stream_head_; block; block = block->next_) {
+            total += block->used_;
+        }
+
+        return total;
+    }
+
+    command_reader::command_reader(const command_list &list)
+        : block_(list.stream_head_)
+        , offset_(0) {
+    }
+
+    bool command_reader::next(command &cmd) {
+        while (block_ && (offset_ >= block_->used_)) {
+            block_ = block_->next_;
+            offset_ = 0;
+        }
+
+        if (!block_) {
+            return false;
+        }
+
+        const std::uint8_t *source = block_->data_ + offset_;
+        command_header header;
+
+        std::memcpy(&header, source, sizeof(command_header));
+        source += sizeof(command_header);
+
+        cmd.opcode_ = header.opcode_;
+        cmd.status_ = nullptr;
+
+        if (header.word_mask_ & COMMAND_HEADER_HAS_STATUS) {
+            std::memcpy(&cmd.status_, source, sizeof(int *));
+            source += sizeof(int *);
+        }
+
+        for (std::size_t i = 0; i < COMMAND_MAX_DATA_WORD; i++) {
+            if (header.word_mask_ & (1 << i)) {
+                std::memcpy(&cmd.data_[i], source, sizeof(std::uint64_t));
+                source += sizeof(std::uint64_t);
+            } else {
+                cmd.data_[i] = 0;
+            }
+        }
+        offset_ = static_cast<std::size_t>(source - block_->data_);
+
+        return true;
+    }
+}
@@ -284,8 +284,6 @@ namespace eka2l1::drivers {
         unpack_u64_to_2u32(cmd.data_[4], dim.x, dim.y);
 
         update_bitmap(handle, size, offset, dim, data, pixels_per_line);
-
-        delete[] data;
     }
 
     void shared_graphics_driver::update_texture(command &cmd) {
@@ -310,8 +308,6 @@ namespace eka2l1::drivers {
         }
 
         obj->update_data(this, static_cast<int>(lvl), offset, dim, pixels_per_line, data_format, data_type, data, size, unpack_alignment);
-
-        delete[] data;
     }
 
     void shared_graphics_driver::create_bitmap(command &cmd) {
@@ -589,11 +585,6 @@ namespace eka2l1::drivers {
 
             drivers::handle *store = reinterpret_cast<drivers::handle*>(cmd.data_[8]);
             *store = res;
-        } else {
-            if (data != nullptr) {
-                std::uint8_t *data_org = reinterpret_cast<std::uint8_t*>(data);
-                delete[] data_org;
-            }
         }
 
         finish(cmd.status_, 0);
@@ -628,9 +619,6 @@ namespace eka2l1::drivers {
             *store = res;
 
             finish(cmd.status_, 0);
-        } else if ((initial_data != nullptr) && (existing_handle)) {
-            std::uint8_t *data_casted = reinterpret_cast<std::uint8_t*>(initial_data);
-            delete[] data_casted;
         }
     }
 
@@ -662,9 +650,6 @@ namespace eka2l1::drivers {
             *store = res;
 
             finish(cmd.status_, 0);
-        } else if ((descs != nullptr) && (existing_handle)) {
-            std::uint8_t *data_casted = reinterpret_cast<std::uint8_t*>(descs);
-            delete[] data_casted;
         }
     }
 
@@ -832,8 +817,6 @@ namespace eka2l1::drivers {
         }
 
         bufobj->update_data(this, data, offset, size);
-
-        delete[] data;
     }
 
     void shared_graphics_driver::destroy_object(command &cmd) {
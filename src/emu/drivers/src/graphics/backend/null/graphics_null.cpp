@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/graphics/backend/null/graphics_null.h>
+
+#include <common/log.h>
+
+namespace eka2l1::drivers {
+    null_graphics_driver::null_graphics_driver()
+        : graphics_driver(graphic_api::null)
+        , should_stop_(false)
+        , next_handle_(1) {
+        list_queue_.max_pending_count_ = 128;
+    }
+
+    null_graphics_driver::~null_graphics_driver() {
+        abort();
+    }
+
+    static void store_new_handle(const std::uint64_t store_ptr, const drivers::handle h) {
+        drivers::handle *store = reinterpret_cast<drivers::handle *>(store_ptr);
+
+        if (store) {
+            *store = h;
+        }
+    }
+
+    void null_graphics_driver::dispatch(command &cmd) {
+        // Payloads live in the command list, and are freed when the list is retired.
+        // Creation commands with an existing handle are the recreate variant, which has no handle to store.
+        switch (cmd.opcode_) {
+        case graphics_driver_create_bitmap:
+            store_new_handle(cmd.data_[2], next_handle_++);
+            break;
+
+        case graphics_driver_create_shader_module:
+            store_new_handle(cmd.data_[3], next_handle_++);
+            break;
+
+        case graphics_driver_create_shader_program:
+            // There is no metadata to give back, so let the program fail to link
+            finish(cmd.status_, -1);
+            return;
+
+        case graphics_driver_create_renderbuffer:
+            if (cmd.data_[2] == 0) {
+                store_new_handle(cmd.data_[3], next_handle_++);
+            }
+
+            break;
+
+        case graphcis_driver_create_framebuffer:
+            store_new_handle(cmd.data_[6], next_handle_++);
+            break;
+
+        case graphics_driver_create_texture:
+            if (cmd.data_[7] == 0) {
+                store_new_handle(cmd.data_[8], next_handle_++);
+            }
+
+            break;
+
+        case graphics_driver_create_buffer:
+            if (cmd.data_[3] == 0) {
+                store_new_handle(cmd.data_[4], next_handle_++);
+            }
+
+            break;
+
+        case graphics_driver_create_input_descriptor:
+            if (cmd.data_[2] == 0) {
+                store_new_handle(cmd.data_[3], next_handle_++);
+            }
+
+            break;
+
+        case graphics_driver_display:
+            if (disp_hook_) {
+                disp_hook_();
+            }
+
+            break;
+
+        default:
+            break;
+        }
+
+        finish(cmd.status_, 0);
+    }
+
+    void null_graphics_driver::run() {
+        while (!should_stop_) {
+            std::optional<command_list> list = list_queue_.pop();
+
+            if (!list) {
+                if (!should_stop_) {
+                    LOG_ERROR(DRIVER_GRAPHICS, "Corrupted graphics command list! Emulation halt.");
+                }
+
+                break;
+            }
+
+            command_reader reader(*list);
+            command cmd;
+
+            while (reader.next(cmd)) {
+                dispatch(cmd);
+            }
+
+            list->retire();
+        }
+    }
+
+    void null_graphics_driver::abort() {
+        list_queue_.abort();
+        should_stop_ = true;
+
+        cond_.notify_all();
+    }
+
+    void null_graphics_driver::wait_for(int *status) {
+        if (should_stop_) {
+            return;
+        }
+
+        driver::wait_for(status);
+    }
+
+    void null_graphics_driver::submit_command_list(command_list &list) {
+        if ((list.size_ == 0) || should_stop_) {
+            list.retire();
+            return;
+        }
+
+        list.flush();
+        list_queue_.push(list);
+    }
+
+    void null_graphics_driver::update_bitmap(drivers::handle h, const std::size_t size, const eka2l1::vec2 &offset,
+        const eka2l1::vec2 &dim, const void *data, const std::size_t pixels_per_line) {
+    }
+
+    void null_graphics_driver::set_viewport(const eka2l1::rect &viewport) {
+    }
+
+    void null_graphics_driver::update_surface(void *surface) {
+    }
+
+    void null_graphics_driver::set_upscale_shader(const std::string &name) {
+    }
+
+    std::string null_graphics_driver::get_active_upscale_shader() const {
+        return "Default";
+    }
+
+    bool null_graphics_driver::support_extension(const graphics_driver_extension ext) {
+        return false;
+    }
+
+    bool null_graphics_driver::query_extension_value(const graphics_driver_extension_query query, void *data_ptr) {
+        return false;
+    }
+}
@@ -21,6 +21,7 @@
 #include <common/log.h>
 #include <common/platform.h>
 #include <common/rgb.h>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
@@ -82,6 +83,9 @@ namespace eka2l1::drivers {
         , line_style(pen_style_none)
         , active_input_descriptors_(nullptr)
         , index_buffer_current_(0)
+        , quad_vbo(0)
+        , quad_ibo(0)
+        , quad_ibo_capacity_(0)
         , feature_flags_(0)
         , active_upscale_shader_("Default") {
         context_ = graphics::make_gl_context(info, false, true);
@@ -195,12 +199,12 @@ namespace eka2l1::drivers {
         pen_program.reset();
 
         GLuint vao_to_del[3] = { sprite_vao, brush_vao, pen_vao };
-        GLuint vbo_to_del[3] = { sprite_vbo, brush_vbo, pen_vbo };
-        GLuint ibo_to_del[2] = { sprite_ibo, pen_ibo };
+        GLuint vbo_to_del[4] = { sprite_vbo, brush_vbo, pen_vbo, quad_vbo };
+        GLuint ibo_to_del[3] = { sprite_ibo, pen_ibo, quad_ibo };
 
         glDeleteVertexArrays(3, vao_to_del);
-        glDeleteBuffers(3, vbo_to_del);
-        glDeleteBuffers(2, ibo_to_del);
+        glDeleteBuffers(4, vbo_to_del);
+        glDeleteBuffers(3, ibo_to_del);
     }
 
     bool ogl_graphics_driver::support_extension(const graphics_driver_extension ext) {
@@ -327,6 +331,10 @@ namespace eka2l1::drivers {
 
         glGenBuffers(1, &pen_ibo);
 
+        // Quad lists are streamed through their own buffers, the index buffer grows with the longest list
+        glGenBuffers(1, &quad_vbo);
+        glGenBuffers(1, &quad_ibo);
+
         color_loc = sprite_program->get_uniform_location("u_color").value_or(-1);
         proj_loc = sprite_program->get_uniform_location("u_proj").value_or(-1);
         model_loc = sprite_program->get_uniform_location("u_model").value_or(-1);
@@ -729,6 +737,121 @@ namespace eka2l1::drivers {
         glBindVertexArray(0);
     }
 
+    // Indices are 16-bit, four vertices per quad
+    static constexpr std::size_t MAX_QUADS_PER_DRAW = 65536 / 4;
+
+    void ogl_graphics_driver::draw_bitmap_quads(command &cmd) {
+        if (!sprite_program) {
+            do_init();
+        }
+
+        const drivers::handle to_draw = static_cast<drivers::handle>(cmd.data_[0]);
+        const bitmap_quad *quads = reinterpret_cast<const bitmap_quad *>(cmd.data_[1]);
+        const std::size_t quad_count = static_cast<std::size_t>(cmd.data_[2]);
+        const std::uint32_t flags = static_cast<std::uint32_t>(cmd.data_[3]);
+
+        bitmap *bmp = get_bitmap(to_draw);
+        texture *draw_texture = nullptr;
+
+        if (!bmp) {
+            draw_texture = reinterpret_cast<texture *>(get_graphics_object(to_draw));
+
+            if (!draw_texture) {
+                LOG_ERROR(DRIVER_GRAPHICS, "Invalid bitmap handle to draw");
+                return;
+            }
+        } else {
+            draw_texture = bmp->tex.get();
+        }
+
+        if (!quads || (quad_count == 0)) {
+            return;
+        }
+
+        sprite_program->use(this);
+
+        // The vertices are already in target space
+        const glm::mat4 model_matrix = glm::identity<glm::mat4>();
+        const GLfloat color[] = { 255.0f, 255.0f, 255.0f, 255.0f };
+
+        glUniformMatrix4fv(model_loc, 1, false, glm::value_ptr(model_matrix));
+        glUniformMatrix4fv(proj_loc, 1, false, glm::value_ptr(projection_matrix));
+        glUniform4fv(color_loc, 1, (flags & bitmap_draw_flag_use_brush) ? brush_color.elements.data() : color);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(draw_texture->driver_handle()));
+
+        const std::size_t quads_per_draw = common::min(quad_count, MAX_QUADS_PER_DRAW);
+
+        glBindVertexArray(sprite_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, quad_vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_ibo);
+
+        if (quad_ibo_capacity_ < quads_per_draw) {
+            std::vector<GLushort> indices(quads_per_draw * 6);
+
+            // Same winding as a single sprite
+            for (std::size_t i = 0; i < quads_per_draw; i++) {
+                const GLushort base = static_cast<GLushort>(i * 4);
+
+                indices[i * 6] = base;
+                indices[i * 6 + 1] = base + 1;
+                indices[i * 6 + 2] = base + 2;
+                indices[i * 6 + 3] = base;
+                indices[i * 6 + 4] = base + 3;
+                indices[i * 6 + 5] = base + 1;
+            }
+
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+
+            quad_ibo_capacity_ = quads_per_draw;
+        }
+
+        const float texel_width = 1.0f / draw_texture->get_size().x;
+        const float texel_height = 1.0f / draw_texture->get_size().y;
+
+        for (std::size_t first = 0; first < quad_count; first += MAX_QUADS_PER_DRAW) {
+            const std::size_t count = common::min(quad_count - first, MAX_QUADS_PER_DRAW);
+            quad_vertices_.resize(count * 16);
+
+            GLfloat *vert = quad_vertices_.data();
+
+            for (std::size_t i = first; i < first + count; i++, vert += 16) {
+                const float left = static_cast<float>(quads[i].dest_.top.x);
+                const float top = static_cast<float>(quads[i].dest_.top.y);
+                const float right = left + quads[i].dest_.size.x;
+                const float bottom = top + quads[i].dest_.size.y;
+
+                const float tex_left = quads[i].source_.top.x * texel_width;
+                const float tex_top = quads[i].source_.top.y * texel_height;
+                const float tex_right = (quads[i].source_.top.x + quads[i].source_.size.x) * texel_width;
+                const float tex_bottom = (quads[i].source_.top.y + quads[i].source_.size.y) * texel_height;
+
+                // Bottom left, top right, top left, bottom right
+                const GLfloat quad_verts[16] = {
+                    left, bottom, tex_left, tex_bottom,
+                    right, top, tex_right, tex_top,
+                    left, top, tex_left, tex_top,
+                    right, bottom, tex_right, tex_bottom
+                };
+
+                std::memcpy(vert, quad_verts, sizeof(quad_verts));
+            }
+
+            glBufferData(GL_ARRAY_BUFFER, quad_vertices_.size() * sizeof(GLfloat), nullptr, GL_STREAM_DRAW);
+            glBufferData(GL_ARRAY_BUFFER, quad_vertices_.size() * sizeof(GLfloat), quad_vertices_.data(), GL_STREAM_DRAW);
+
+            glEnableVertexAttribArray(in_position_loc);
+            glVertexAttribPointer(in_position_loc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid *)0);
+            glEnableVertexAttribArray(in_texcoord_loc);
+            glVertexAttribPointer(in_texcoord_loc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid *)(2 * sizeof(GLfloat)));
+
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(count * 6), GL_UNSIGNED_SHORT, 0);
+        }
+
+        glBindVertexArray(0);
+    }
+
     void ogl_graphics_driver::clip_rect(command &cmd) {
         eka2l1::rect clip_rect;
         unpack_u64_to_2u32(cmd.data_[0], clip_rect.top.x, clip_rect.top.y);
@@ -756,8 +879,6 @@ namespace eka2l1::drivers {
 
         unpack_to_two_floats(cmd.data_[2], scale, temp);
 
-        delete[] to_clip_rects;
-
         if (to_clip.empty()) {
             glDisable(GL_SCISSOR_TEST);
             glDisable(GL_STENCIL_TEST);
@@ -1328,8 +1449,6 @@ namespace eka2l1::drivers {
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicies.size() * sizeof(int), indicies.data(), GL_STATIC_DRAW);
 
         glDrawElements(GL_LINES, static_cast<GLsizei>(indicies.size()), GL_UNSIGNED_INT, 0);
-
-        delete[] point_list;
     }
 
     void ogl_graphics_driver::set_cull_face(command &cmd) {
@@ -1382,56 +1501,40 @@ namespace eka2l1::drivers {
         switch (var_type) {
         case shader_var_type::integer: {
             glUniform1iv(binding, static_cast<GLsizei>((cmd.data_[2] + 3) / 4), reinterpret_cast<const GLint *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::real:
             glUniform1fv(binding, static_cast<GLsizei>((cmd.data_[2] + 3) / 4), reinterpret_cast<const GLfloat*>(data));
-            delete[] data;
-
             return;
 
         case shader_var_type::mat2: {
             glUniformMatrix2fv(binding, static_cast<GLsizei>((cmd.data_[2] + 15) / 16), GL_FALSE, reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::mat3: {
             glUniformMatrix2fv(binding, static_cast<GLsizei>((cmd.data_[2] + 35) / 36), GL_FALSE, reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::mat4: {
             glUniformMatrix4fv(binding, static_cast<GLsizei>((cmd.data_[2] + 63) / 64), GL_FALSE, reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::vec2: {
             glUniform2fv(binding, static_cast<GLsizei>((cmd.data_[2] + 7) / 8), reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::vec3: {
             glUniform3fv(binding, static_cast<GLsizei>((cmd.data_[2] + 11) / 12), reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
         case shader_var_type::vec4: {
             glUniform4fv(binding, static_cast<GLsizei>((cmd.data_[2] + 15) / 16), reinterpret_cast<const GLfloat *>(data));
-            delete[] data;
-
             return;
         }
 
@@ -1460,8 +1563,6 @@ namespace eka2l1::drivers {
 
         if (starting_slots + count >= GL_BACKEND_MAX_VBO_SLOTS) {
             LOG_ERROR(DRIVER_GRAPHICS, "Slot to bind VBO exceed maximum (startSlot={}, count={})", starting_slots, count);
-            delete[] arr;
-
             return;
         }
 
@@ -1474,8 +1575,6 @@ namespace eka2l1::drivers {
 
             vbo_slots_[starting_slots + i] = bufobj->buffer_handle();
         }
-
-        delete[] arr;
     }
 
     void ogl_graphics_driver::bind_index_buffer(command &cmd) {
@@ -1701,13 +1800,12 @@ namespace eka2l1::drivers {
     }
 
     void ogl_graphics_driver::submit_command_list(command_list &list) {
-        if ((list.size_ == 0) || !list.base_ || should_stop) {
-            if (list.base_) {
-                delete[] list.base_;
-            }
-
+        if ((list.size_ == 0) || should_stop) {
+            list.retire();
             return;
         }
+
+        list.flush();
         list_queue.push(list);
     }
 
@@ -1725,6 +1823,10 @@ namespace eka2l1::drivers {
             break;
         }
 
+        case graphics_driver_draw_bitmap_quads:
+            draw_bitmap_quads(cmd);
+            break;
+
         case graphics_driver_clip_rect:
         case graphics_driver_clip_bitmap_rect: {
             clip_rect(cmd);
@@ -1896,11 +1998,15 @@ namespace eka2l1::drivers {
                 break;
             }
 
-            for (std::size_t i = 0; i < list->size_; i++) {
-                dispatch(list->base_[i]);
+            command_reader reader(*list);
+            command cmd;
+
+            while (reader.next(cmd)) {
+                dispatch(cmd);
             }
 
-            delete[] list->base_;
+            // Payloads live in the list, so it can only be retired once every command is done
+            list->retire();
         }
     }
 
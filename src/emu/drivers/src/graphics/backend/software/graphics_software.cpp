@@ -0,0 +1,1680 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <drivers/graphics/backend/software/graphics_software.h>
+#include <drivers/itc.h>
+
+#include <common/algorithm.h>
+#include <common/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace eka2l1::drivers {
+    static constexpr drivers::handle SOFTWARE_HANDLE_BITMAP = (1ULL << 32);
+    static constexpr int SOFTWARE_TILE_SIZE = 64;
+    static constexpr std::size_t SOFTWARE_MAX_WORKER_COUNT = 7;
+
+    static inline std::uint32_t make_pixel(const std::uint32_t r, const std::uint32_t g, const std::uint32_t b, const std::uint32_t a) {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    static inline std::uint32_t pixel_channel(const std::uint32_t pixel, const int channel) {
+        return (pixel >> (channel * 8)) & 0xFF;
+    }
+
+    // Exact round(a * b / 255) for a, b in [0, 255 * 255]
+    static inline std::uint32_t div_255(const std::uint32_t v) {
+        return (v + 128 + ((v + 128) >> 8)) >> 8;
+    }
+
+    static inline std::uint32_t modulate_pixel(const std::uint32_t pixel, const std::uint32_t color) {
+        if (color == 0xFFFFFFFF) {
+            return pixel;
+        }
+
+        return make_pixel(div_255(pixel_channel(pixel, 0) * pixel_channel(color, 0)),
+            div_255(pixel_channel(pixel, 1) * pixel_channel(color, 1)),
+            div_255(pixel_channel(pixel, 2) * pixel_channel(color, 2)),
+            div_255(pixel_channel(pixel, 3) * pixel_channel(color, 3)));
+    }
+
+    static eka2l1::rect clip_rect_to(const eka2l1::rect &target, const eka2l1::rect &clip) {
+        const int left = common::max(target.top.x, clip.top.x);
+        const int top = common::max(target.top.y, clip.top.y);
+        const int right = common::min(target.top.x + target.size.x, clip.top.x + clip.size.x);
+        const int bottom = common::min(target.top.y + target.size.y, clip.top.y + clip.size.y);
+
+        if ((left >= right) || (top >= bottom)) {
+            return eka2l1::rect({ 0, 0 }, { 0, 0 });
+        }
+
+        return eka2l1::rect({ left, top }, { right - left, bottom - top });
+    }
+
+    static bool rect_has_area(const eka2l1::rect &r) {
+        return (r.size.x > 0) && (r.size.y > 0);
+    }
+
+    // Split possibly overlapping rectangles into disjoint ones, so that no pixel is drawn twice
+    // when a draw is clipped to all of them.
+    static std::vector<eka2l1::rect> make_disjoint_rects(const std::vector<eka2l1::rect> &rects) {
+        std::vector<int> edges;
+
+        for (const eka2l1::rect &r : rects) {
+            if (rect_has_area(r)) {
+                edges.push_back(r.top.y);
+                edges.push_back(r.top.y + r.size.y);
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        std::vector<eka2l1::rect> result;
+        std::vector<std::pair<int, int>> spans;
+
+        for (std::size_t i = 0; i + 1 < edges.size(); i++) {
+            const int band_top = edges[i];
+            const int band_bottom = edges[i + 1];
+
+            spans.clear();
+
+            for (const eka2l1::rect &r : rects) {
+                if (rect_has_area(r) && (r.top.y <= band_top) && (r.top.y + r.size.y >= band_bottom)) {
+                    spans.emplace_back(r.top.x, r.top.x + r.size.x);
+                }
+            }
+
+            std::sort(spans.begin(), spans.end());
+
+            for (std::size_t j = 0; j < spans.size();) {
+                int left = spans[j].first;
+                int right = spans[j].second;
+
+                for (j++; (j < spans.size()) && (spans[j].first <= right); j++) {
+                    right = common::max(right, spans[j].second);
+                }
+
+                result.push_back(eka2l1::rect({ left, band_top }, { right - left, band_bottom - band_top }));
+            }
+        }
+
+        return result;
+    }
+
+    static std::uint32_t get_blend_factor(const blend_factor factor, const std::uint32_t src, const std::uint32_t dest,
+        const std::uint32_t constant, const int channel) {
+        switch (factor) {
+        case blend_factor::one:
+            return 255;
+
+        case blend_factor::zero:
+            return 0;
+
+        case blend_factor::frag_out_alpha:
+            return pixel_channel(src, 3);
+
+        case blend_factor::one_minus_frag_out_alpha:
+            return 255 - pixel_channel(src, 3);
+
+        case blend_factor::current_alpha:
+            return pixel_channel(dest, 3);
+
+        case blend_factor::one_minus_current_alpha:
+            return 255 - pixel_channel(dest, 3);
+
+        case blend_factor::frag_out_color:
+            return pixel_channel(src, channel);
+
+        case blend_factor::one_minus_frag_out_color:
+            return 255 - pixel_channel(src, channel);
+
+        case blend_factor::current_color:
+            return pixel_channel(dest, channel);
+
+        case blend_factor::one_minus_current_color:
+            return 255 - pixel_channel(dest, channel);
+
+        case blend_factor::frag_out_alpha_saturate:
+            return (channel == 3) ? 255 : common::min<std::uint32_t>(pixel_channel(src, 3), 255 - pixel_channel(dest, 3));
+
+        case blend_factor::constant_colour:
+            return pixel_channel(constant, channel);
+
+        case blend_factor::one_minus_constant_colour:
+            return 255 - pixel_channel(constant, channel);
+
+        case blend_factor::constant_alpha:
+            return pixel_channel(constant, 3);
+
+        case blend_factor::one_minus_constant_alpha:
+            return 255 - pixel_channel(constant, 3);
+
+        default:
+            break;
+        }
+
+        return 255;
+    }
+
+    static std::uint32_t blend_pixel(const software_blend_state &blend, const std::uint32_t src, const std::uint32_t dest) {
+        std::uint32_t result = 0;
+
+        for (int channel = 0; channel < 4; channel++) {
+            const bool is_alpha = (channel == 3);
+
+            const std::uint32_t src_factor = get_blend_factor(is_alpha ? blend.a_frag_factor_ : blend.rgb_frag_factor_,
+                src, dest, blend.constant_, channel);
+            const std::uint32_t dest_factor = get_blend_factor(is_alpha ? blend.a_current_factor_ : blend.rgb_current_factor_,
+                src, dest, blend.constant_, channel);
+
+            const int src_term = static_cast<int>(pixel_channel(src, channel) * src_factor);
+            const int dest_term = static_cast<int>(pixel_channel(dest, channel) * dest_factor);
+
+            int value = 0;
+
+            switch (is_alpha ? blend.a_equation_ : blend.rgb_equation_) {
+            case blend_equation::sub:
+                value = src_term - dest_term;
+                break;
+
+            case blend_equation::isub:
+                value = dest_term - src_term;
+                break;
+
+            default:
+                value = src_term + dest_term;
+                break;
+            }
+
+            value = common::clamp(0, 255 * 255, value);
+            result |= div_255(static_cast<std::uint32_t>(value)) << (channel * 8);
+        }
+
+        return result;
+    }
+
+    // The formula the window server and the font atlas use: source over on the color, alpha added.
+    static bool is_source_over_blend(const software_blend_state &blend) {
+        return (blend.rgb_equation_ == blend_equation::add) && (blend.a_equation_ == blend_equation::add)
+            && (blend.rgb_frag_factor_ == blend_factor::frag_out_alpha) && (blend.rgb_current_factor_ == blend_factor::one_minus_frag_out_alpha)
+            && (blend.a_frag_factor_ == blend_factor::one) && (blend.a_current_factor_ == blend_factor::one);
+    }
+
+    // Span loops below work on plain arrays with no cross pixel dependency, so the compiler can
+    // vectorize them.
+    static void fill_span(std::uint32_t *dest, const int count, const std::uint32_t color, const software_blend_state &blend) {
+        if (!blend.enabled_) {
+            std::fill_n(dest, count, color);
+            return;
+        }
+
+        if (is_source_over_blend(blend)) {
+            const std::uint32_t alpha = pixel_channel(color, 3);
+            const std::uint32_t inv_alpha = 255 - alpha;
+
+            const std::uint32_t r = pixel_channel(color, 0) * alpha;
+            const std::uint32_t g = pixel_channel(color, 1) * alpha;
+            const std::uint32_t b = pixel_channel(color, 2) * alpha;
+            const std::uint32_t a = alpha * 255;
+
+            for (int i = 0; i < count; i++) {
+                const std::uint32_t d = dest[i];
+
+                dest[i] = div_255(r + (d & 0xFF) * inv_alpha)
+                    | (div_255(g + ((d >> 8) & 0xFF) * inv_alpha) << 8)
+                    | (div_255(b + ((d >> 16) & 0xFF) * inv_alpha) << 16)
+                    | (common::min<std::uint32_t>(255, div_255(a) + (d >> 24)) << 24);
+            }
+
+            return;
+        }
+
+        for (int i = 0; i < count; i++) {
+            dest[i] = blend_pixel(blend, color, dest[i]);
+        }
+    }
+
+    static void write_span(std::uint32_t *dest, const std::uint32_t *source, const int count, const software_blend_state &blend) {
+        if (!blend.enabled_) {
+            std::memcpy(dest, source, count * sizeof(std::uint32_t));
+            return;
+        }
+
+        if (is_source_over_blend(blend)) {
+            for (int i = 0; i < count; i++) {
+                const std::uint32_t s = source[i];
+                const std::uint32_t d = dest[i];
+
+                const std::uint32_t alpha = s >> 24;
+                const std::uint32_t inv_alpha = 255 - alpha;
+
+                dest[i] = div_255((s & 0xFF) * alpha + (d & 0xFF) * inv_alpha)
+                    | (div_255(((s >> 8) & 0xFF) * alpha + ((d >> 8) & 0xFF) * inv_alpha) << 8)
+                    | (div_255(((s >> 16) & 0xFF) * alpha + ((d >> 16) & 0xFF) * inv_alpha) << 16)
+                    | (common::min<std::uint32_t>(255, alpha + (d >> 24)) << 24);
+            }
+
+            return;
+        }
+
+        for (int i = 0; i < count; i++) {
+            dest[i] = blend_pixel(blend, source[i], dest[i]);
+        }
+    }
+
+    software_bitmap::software_bitmap(const eka2l1::vec2 &size, const int bpp)
+        : size_(common::max(size.x, 0), common::max(size.y, 0))
+        , bpp_(bpp)
+        , render_target_(false) {
+        pixels_.resize(static_cast<std::size_t>(size_.x) * size_.y, 0);
+    }
+
+    void software_bitmap::resize(const eka2l1::vec2 &new_size) {
+        std::vector<std::uint32_t> new_pixels(static_cast<std::size_t>(common::max(new_size.x, 0)) * common::max(new_size.y, 0), 0);
+
+        // Like a framebuffer blit on the GPU backend, rendered content is stretched to the new size.
+        // Content that was only uploaded is dropped with the old texture.
+        if (render_target_ && (size_.x > 0) && (size_.y > 0)) {
+            for (int y = 0; y < new_size.y; y++) {
+                const std::uint32_t *source_row = row(static_cast<int>(static_cast<std::int64_t>(y) * size_.y / new_size.y));
+                std::uint32_t *dest_row = new_pixels.data() + static_cast<std::size_t>(y) * new_size.x;
+
+                for (int x = 0; x < new_size.x; x++) {
+                    dest_row[x] = source_row[static_cast<std::int64_t>(x) * size_.x / new_size.x];
+                }
+            }
+        }
+
+        size_ = eka2l1::vec2(common::max(new_size.x, 0), common::max(new_size.y, 0));
+        pixels_ = std::move(new_pixels);
+    }
+
+    software_tile_workers::software_tile_workers(const std::size_t thread_count)
+        : job_count_(0)
+        , next_job_(0)
+        , working_count_(0)
+        , generation_(0)
+        , stop_(false) {
+        for (std::size_t i = 0; i < thread_count; i++) {
+            threads_.emplace_back([this]() { worker_loop(); });
+        }
+    }
+
+    software_tile_workers::~software_tile_workers() {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            stop_ = true;
+        }
+
+        work_cond_.notify_all();
+
+        for (std::thread &thr : threads_) {
+            thr.join();
+        }
+    }
+
+    void software_tile_workers::drain_jobs() {
+        while (true) {
+            const std::size_t index = next_job_.fetch_add(1);
+
+            if (index >= job_count_) {
+                break;
+            }
+
+            job_(index);
+        }
+    }
+
+    void software_tile_workers::worker_loop() {
+        std::uint64_t seen_generation = 0;
+
+        while (true) {
+            {
+                std::unique_lock<std::mutex> ulock(lock_);
+                work_cond_.wait(ulock, [&]() { return stop_ || (generation_ != seen_generation); });
+
+                if (stop_) {
+                    return;
+                }
+
+                seen_generation = generation_;
+            }
+
+            drain_jobs();
+
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            if (--working_count_ == 0) {
+                done_cond_.notify_one();
+            }
+        }
+    }
+
+    void software_tile_workers::run(const std::size_t count, const std::function<void(std::size_t)> &job) {
+        if (threads_.empty() || (count <= 1)) {
+            for (std::size_t i = 0; i < count; i++) {
+                job(i);
+            }
+
+            return;
+        }
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            job_ = job;
+            job_count_ = count;
+            next_job_ = 0;
+            working_count_ = threads_.size();
+            generation_++;
+        }
+
+        work_cond_.notify_all();
+        drain_jobs();
+
+        std::unique_lock<std::mutex> ulock(lock_);
+        done_cond_.wait(ulock, [&]() { return working_count_ == 0; });
+
+        job_ = nullptr;
+    }
+
+    software_graphics_driver::software_graphics_driver(const std::size_t thread_count)
+        : graphics_driver(graphic_api::software)
+        , should_stop_(false)
+        , next_handle_(1)
+        , screen_(eka2l1::vec2(0, 0), 32)
+        , binding_(nullptr)
+        , warned_advanced_draw_(false) {
+        list_queue_.max_pending_count_ = 128;
+
+        std::size_t worker_count = thread_count;
+
+        if (worker_count == 0) {
+            // The driver thread rasterizes too
+            const std::size_t hardware_count = std::thread::hardware_concurrency();
+            worker_count = common::min<std::size_t>((hardware_count > 1) ? (hardware_count - 1) : 0, SOFTWARE_MAX_WORKER_COUNT);
+        } else {
+            worker_count--;
+        }
+
+        workers_ = std::make_unique<software_tile_workers>(worker_count);
+    }
+
+    software_graphics_driver::~software_graphics_driver() {
+        abort();
+    }
+
+    software_bitmap *software_graphics_driver::get_bitmap(const drivers::handle h) {
+        if ((h & SOFTWARE_HANDLE_BITMAP) == 0) {
+            return nullptr;
+        }
+
+        const drivers::handle index = (h & ~SOFTWARE_HANDLE_BITMAP);
+
+        if ((index == 0) || (index > bitmaps_.size())) {
+            return nullptr;
+        }
+
+        return bitmaps_[index - 1].get();
+    }
+
+    software_bitmap *software_graphics_driver::current_target() {
+        return binding_ ? binding_ : &screen_;
+    }
+
+    const software_bitmap *software_graphics_driver::snapshot_source(const software_bitmap *source) {
+        if (source != current_target()) {
+            return source;
+        }
+
+        // Drawing a bitmap to itself reads what was there before the batch draws over it
+        flush_batch();
+
+        batch_copies_.push_back(std::make_unique<software_bitmap>(*source));
+        return batch_copies_.back().get();
+    }
+
+    bool software_graphics_driver::prepare_op(software_draw_op &op, const bool scissor_only) {
+        software_bitmap *target = current_target();
+        const eka2l1::rect target_rect({ 0, 0 }, target->size_);
+
+        eka2l1::rect bounds = clip_rect_to(op.bounds_, target_rect);
+
+        if (state_.clipping_) {
+            bounds = clip_rect_to(bounds, state_.scissor_);
+        }
+
+        if (!rect_has_area(bounds)) {
+            return false;
+        }
+
+        op.clip_begin_ = static_cast<std::uint32_t>(batch_clips_.size());
+
+        if (!scissor_only && state_.region_clipping_ && !state_.region_.empty()) {
+            eka2l1::rect used_bounds;
+
+            for (const eka2l1::rect &region_rect : state_.region_) {
+                const eka2l1::rect clipped = clip_rect_to(region_rect, bounds);
+
+                if (rect_has_area(clipped)) {
+                    if (batch_clips_.size() == op.clip_begin_) {
+                        used_bounds = clipped;
+                    } else {
+                        used_bounds.merge(clipped);
+                    }
+
+                    batch_clips_.push_back(clipped);
+                }
+            }
+
+            bounds = used_bounds;
+        } else {
+            batch_clips_.push_back(bounds);
+        }
+
+        op.clip_count_ = static_cast<std::uint32_t>(batch_clips_.size() - op.clip_begin_);
+        op.bounds_ = bounds;
+
+        if (op.clip_count_ == 0) {
+            return false;
+        }
+
+        batch_.push_back(op);
+        return true;
+    }
+
+    void software_graphics_driver::flush_batch() {
+        if (batch_.empty()) {
+            // Copies made for the draw being recorded are still needed
+            return;
+        }
+
+        software_bitmap *target = current_target();
+        target->render_target_ = true;
+
+        const int tiles_x = (target->size_.x + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+        const int tiles_y = (target->size_.y + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+
+        tile_bins_.resize(static_cast<std::size_t>(tiles_x) * tiles_y);
+        active_tiles_.clear();
+
+        // Bin the draws to the tiles they touch, in the order they were issued
+        for (std::size_t i = 0; i < batch_.size(); i++) {
+            const eka2l1::rect &bounds = batch_[i].bounds_;
+
+            const int tile_left = bounds.top.x / SOFTWARE_TILE_SIZE;
+            const int tile_top = bounds.top.y / SOFTWARE_TILE_SIZE;
+            const int tile_right = (bounds.top.x + bounds.size.x - 1) / SOFTWARE_TILE_SIZE;
+            const int tile_bottom = (bounds.top.y + bounds.size.y - 1) / SOFTWARE_TILE_SIZE;
+
+            for (int ty = tile_top; ty <= tile_bottom; ty++) {
+                for (int tx = tile_left; tx <= tile_right; tx++) {
+                    std::vector<std::uint32_t> &bin = tile_bins_[ty * tiles_x + tx];
+
+                    if (bin.empty()) {
+                        active_tiles_.push_back(static_cast<std::uint32_t>(ty * tiles_x + tx));
+                    }
+
+                    bin.push_back(static_cast<std::uint32_t>(i));
+                }
+            }
+        }
+
+        // Tiles don't share pixels, so each can go to its own core
+        workers_->run(active_tiles_.size(), [this](const std::size_t index) {
+            rasterize_tile(active_tiles_[index]);
+        });
+
+        for (const std::uint32_t tile_index : active_tiles_) {
+            tile_bins_[tile_index].clear();
+        }
+
+        batch_.clear();
+        batch_clips_.clear();
+        batch_points_.clear();
+        batch_copies_.clear();
+    }
+
+    static void rasterize_fill(software_bitmap *target, const software_draw_op &op, const eka2l1::rect &area) {
+        for (int y = area.top.y; y < area.top.y + area.size.y; y++) {
+            fill_span(target->row(y) + area.top.x, area.size.x, op.color_, op.blend_);
+        }
+    }
+
+    static void rasterize_points(software_bitmap *target, const software_draw_op &op, const eka2l1::point *points,
+        const eka2l1::rect &area) {
+        for (std::uint32_t i = 0; i < op.point_count_; i++) {
+            const eka2l1::rect point_rect({ points[i].x - op.point_size_ / 2, points[i].y - op.point_size_ / 2 },
+                { op.point_size_, op.point_size_ });
+
+            const eka2l1::rect clipped = clip_rect_to(point_rect, area);
+
+            if (rect_has_area(clipped)) {
+                rasterize_fill(target, op, clipped);
+            }
+        }
+    }
+
+    static std::uint32_t sample_source(const software_draw_op &op, const int source_x, const int source_y) {
+        const software_bitmap *source = op.source_;
+        const std::uint32_t texel = source->row(source_y)[source_x];
+
+        if (!op.mask_) {
+            return modulate_pixel(texel, op.color_);
+        }
+
+        // Mask is sampled at the same normalized coordinates as the source
+        const software_bitmap *mask = op.mask_;
+        const int mask_x = common::clamp(0, mask->size_.x - 1, static_cast<int>(static_cast<std::int64_t>(source_x) * mask->size_.x / source->size_.x));
+        const int mask_y = common::clamp(0, mask->size_.y - 1, static_cast<int>(static_cast<std::int64_t>(source_y) * mask->size_.y / source->size_.y));
+
+        std::uint32_t mask_value = mask->row(mask_y)[mask_x] & 0xFF;
+
+        if (op.flags_ & bitmap_draw_flag_invert_mask) {
+            mask_value = 255 - mask_value;
+        }
+
+        if (op.flags_ & bitmap_draw_flag_flat_blending) {
+            mask_value = (mask_value > 0) ? 255 : 0;
+        }
+
+        return (modulate_pixel(texel, op.color_) & 0x00FFFFFF) | (mask_value << 24);
+    }
+
+    static inline int map_to_source(const int dest_offset, const int dest_size, const int source_top, const int source_size) {
+        // Nearest texel to the destination pixel's center
+        return source_top + static_cast<int>(((2 * static_cast<std::int64_t>(dest_offset) + 1) * source_size) / (2 * static_cast<std::int64_t>(dest_size)));
+    }
+
+    static void rasterize_bitmap(software_bitmap *target, const software_draw_op &op, const eka2l1::rect &area) {
+        const eka2l1::rect &dest = op.dest_;
+        const eka2l1::rect &source_rect = op.source_rect_;
+
+        const int max_x = op.source_->size_.x - 1;
+        const int max_y = op.source_->size_.y - 1;
+
+        const bool flip = (op.flags_ & bitmap_draw_flag_flip);
+        const bool straight_copy = (op.rotation_ == 0.0f) && (op.color_ == 0xFFFFFFFF) && !op.mask_ && !flip
+            && (dest.size == source_rect.size);
+
+        std::uint32_t span[SOFTWARE_TILE_SIZE];
+
+        if (op.rotation_ == 0.0f) {
+            for (int y = area.top.y; y < area.top.y + area.size.y; y++) {
+                int source_y = map_to_source(y - dest.top.y, dest.size.y, 0, source_rect.size.y);
+
+                if (flip) {
+                    source_y = source_rect.size.y - 1 - source_y;
+                }
+
+                source_y = common::clamp(0, max_y, source_rect.top.y + source_y);
+
+                std::uint32_t *dest_row = target->row(y) + area.top.x;
+
+                if (straight_copy && (source_rect.top.x + area.top.x - dest.top.x >= 0) && (source_rect.top.x + area.top.x - dest.top.x + area.size.x <= max_x + 1)) {
+                    write_span(dest_row, op.source_->row(source_y) + source_rect.top.x + area.top.x - dest.top.x, area.size.x, op.blend_);
+                    continue;
+                }
+
+                for (int x = 0; x < area.size.x; x++) {
+                    const int source_x = common::clamp(0, max_x, map_to_source(area.top.x + x - dest.top.x, dest.size.x, source_rect.top.x, source_rect.size.x));
+                    span[x] = sample_source(op, source_x, source_y);
+                }
+
+                write_span(dest_row, span, area.size.x, op.blend_);
+            }
+
+            return;
+        }
+
+        // Rotated around the origin, map each pixel center back to the unrotated destination
+        const float pivot_x = static_cast<float>(dest.top.x + op.origin_.x);
+        const float pivot_y = static_cast<float>(dest.top.y + op.origin_.y);
+
+        float rotation = std::fmod(op.rotation_, 360.0f);
+
+        if (rotation < 0.0f) {
+            rotation += 360.0f;
+        }
+
+        float cos_value = std::cos(rotation * 3.14159265358979f / 180.0f);
+        float sin_value = std::sin(rotation * 3.14159265358979f / 180.0f);
+
+        // Keep the right angles the screen rotates by exact
+        if (rotation == 90.0f) {
+            cos_value = 0.0f;
+            sin_value = 1.0f;
+        } else if (rotation == 180.0f) {
+            cos_value = -1.0f;
+            sin_value = 0.0f;
+        } else if (rotation == 270.0f) {
+            cos_value = 0.0f;
+            sin_value = -1.0f;
+        }
+
+        for (int y = area.top.y; y < area.top.y + area.size.y; y++) {
+            std::uint32_t *dest_row = target->row(y) + area.top.x;
+
+            int span_begin = -1;
+            int span_count = 0;
+
+            for (int x = 0; x < area.size.x; x++) {
+                const float local_x = static_cast<float>(area.top.x + x) + 0.5f - pivot_x;
+                const float local_y = static_cast<float>(y) + 0.5f - pivot_y;
+
+                const float unrotated_x = cos_value * local_x + sin_value * local_y + pivot_x - dest.top.x;
+                const float unrotated_y = -sin_value * local_x + cos_value * local_y + pivot_y - dest.top.y;
+
+                const int dest_x = static_cast<int>(std::floor(unrotated_x));
+                const int dest_y = static_cast<int>(std::floor(unrotated_y));
+
+                const bool inside = (dest_x >= 0) && (dest_y >= 0) && (dest_x < dest.size.x) && (dest_y < dest.size.y);
+
+                if (!inside) {
+                    if (span_count != 0) {
+                        write_span(dest_row + span_begin, span + span_begin, span_count, op.blend_);
+                        span_count = 0;
+                    }
+
+                    continue;
+                }
+
+                int source_y = map_to_source(dest_y, dest.size.y, 0, source_rect.size.y);
+
+                if (flip) {
+                    source_y = source_rect.size.y - 1 - source_y;
+                }
+
+                source_y = common::clamp(0, max_y, source_rect.top.y + source_y);
+
+                const int source_x = common::clamp(0, max_x, map_to_source(dest_x, dest.size.x, source_rect.top.x, source_rect.size.x));
+
+                if (span_count == 0) {
+                    span_begin = x;
+                }
+
+                span[x] = sample_source(op, source_x, source_y);
+                span_count++;
+            }
+
+            if (span_count != 0) {
+                write_span(dest_row + span_begin, span + span_begin, span_count, op.blend_);
+            }
+        }
+    }
+
+    void software_graphics_driver::rasterize_tile(const std::size_t tile_index) {
+        software_bitmap *target = current_target();
+
+        const int tiles_x = (target->size_.x + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+        const eka2l1::rect tile_rect({ static_cast<int>(tile_index % tiles_x) * SOFTWARE_TILE_SIZE, static_cast<int>(tile_index / tiles_x) * SOFTWARE_TILE_SIZE },
+            { SOFTWARE_TILE_SIZE, SOFTWARE_TILE_SIZE });
+
+        for (const std::uint32_t op_index : tile_bins_[tile_index]) {
+            const software_draw_op &op = batch_[op_index];
+
+            for (std::uint32_t i = 0; i < op.clip_count_; i++) {
+                const eka2l1::rect area = clip_rect_to(batch_clips_[op.clip_begin_ + i], tile_rect);
+
+                if (!rect_has_area(area)) {
+                    continue;
+                }
+
+                switch (op.kind_) {
+                case software_draw_op_fill:
+                    rasterize_fill(target, op, area);
+                    break;
+
+                case software_draw_op_bitmap:
+                    rasterize_bitmap(target, op, area);
+                    break;
+
+                case software_draw_op_points:
+                    rasterize_points(target, op, batch_points_.data() + op.point_begin_, area);
+                    break;
+
+                default:
+                    break;
+                }
+            }
+        }
+    }
+
+    void software_graphics_driver::create_bitmap(command &cmd) {
+        eka2l1::vec2 size;
+        const int bpp = static_cast<int>(cmd.data_[1]);
+        drivers::handle *result = reinterpret_cast<drivers::handle *>(cmd.data_[2]);
+
+        unpack_u64_to_2u32(cmd.data_[0], size.x, size.y);
+
+        auto slot_free = std::find(bitmaps_.begin(), bitmaps_.end(), nullptr);
+        drivers::handle h = 0;
+
+        if (slot_free != bitmaps_.end()) {
+            *slot_free = std::make_unique<software_bitmap>(size, bpp);
+            h = std::distance(bitmaps_.begin(), slot_free) + 1;
+        } else {
+            bitmaps_.push_back(std::make_unique<software_bitmap>(size, bpp));
+            h = bitmaps_.size();
+        }
+
+        if (result) {
+            *result = h | SOFTWARE_HANDLE_BITMAP;
+        }
+    }
+
+    void software_graphics_driver::bind_bitmap(command &cmd) {
+        const drivers::handle h = cmd.data_[0];
+
+        if (h == 0) {
+            flush_batch();
+            binding_ = nullptr;
+
+            return;
+        }
+
+        software_bitmap *bmp = get_bitmap(h);
+
+        if (!bmp) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Bitmap handle invalid to be binded");
+            return;
+        }
+
+        if (bmp != binding_) {
+            flush_batch();
+            binding_ = bmp;
+        }
+    }
+
+    void software_graphics_driver::update_bitmap(drivers::handle h, const std::size_t size, const eka2l1::vec2 &offset,
+        const eka2l1::vec2 &dim, const void *data, const std::size_t pixels_per_line) {
+        software_bitmap *bmp = get_bitmap(h);
+
+        if (!bmp || !data) {
+            return;
+        }
+
+        // A pending draw may sample the old content
+        flush_batch();
+
+        int bytes_per_pixel = 4;
+
+        switch (bmp->bpp_) {
+        case 8:
+            bytes_per_pixel = 1;
+            break;
+
+        case 12:
+        case 16:
+            bytes_per_pixel = 2;
+            break;
+
+        case 24:
+            bytes_per_pixel = 3;
+            break;
+
+        default:
+            break;
+        }
+
+        // Rows are 4-byte aligned, as they are unpacked on the GPU backend
+        const std::size_t row_pixels = (pixels_per_line == 0) ? static_cast<std::size_t>(dim.x) : pixels_per_line;
+        const std::size_t row_bytes = ((row_pixels * bytes_per_pixel) + 3) & ~static_cast<std::size_t>(3);
+
+        const std::uint8_t *source = reinterpret_cast<const std::uint8_t *>(data);
+
+        const int right = common::min(offset.x + dim.x, bmp->size_.x);
+        const int bottom = common::min(offset.y + dim.y, bmp->size_.y);
+
+        for (int y = common::max(offset.y, 0); y < bottom; y++) {
+            const std::size_t row_offset = static_cast<std::size_t>(y - offset.y) * row_bytes;
+
+            if ((size != 0) && (row_offset + (right - offset.x) * bytes_per_pixel > size)) {
+                break;
+            }
+
+            const std::uint8_t *source_row = source + row_offset;
+            std::uint32_t *dest_row = bmp->row(y);
+
+            for (int x = common::max(offset.x, 0); x < right; x++) {
+                const std::uint8_t *texel = source_row + (x - offset.x) * bytes_per_pixel;
+
+                switch (bmp->bpp_) {
+                case 8:
+                    // Expanded to all channels, so that it can be an alpha mask or a gray bitmap
+                    dest_row[x] = texel[0] * 0x01010101U;
+                    break;
+
+                case 12: {
+                    const std::uint16_t value = static_cast<std::uint16_t>(texel[0] | (texel[1] << 8));
+                    dest_row[x] = make_pixel(((value >> 8) & 0xF) * 17, ((value >> 4) & 0xF) * 17, (value & 0xF) * 17, 255);
+                    break;
+                }
+
+                case 16: {
+                    const std::uint16_t value = static_cast<std::uint16_t>(texel[0] | (texel[1] << 8));
+                    dest_row[x] = make_pixel(((value >> 11) * 255 + 15) / 31, (((value >> 5) & 0x3F) * 255 + 31) / 63,
+                        ((value & 0x1F) * 255 + 15) / 31, 255);
+
+                    break;
+                }
+
+                case 24:
+                    dest_row[x] = make_pixel(texel[2], texel[1], texel[0], 255);
+                    break;
+
+                default:
+                    dest_row[x] = make_pixel(texel[2], texel[1], texel[0], texel[3]);
+                    break;
+                }
+            }
+        }
+    }
+
+    void software_graphics_driver::update_bitmap(command &cmd) {
+        eka2l1::vec2 offset;
+        eka2l1::vec2 dim;
+
+        unpack_u64_to_2u32(cmd.data_[3], offset.x, offset.y);
+        unpack_u64_to_2u32(cmd.data_[4], dim.x, dim.y);
+
+        update_bitmap(cmd.data_[0], static_cast<std::size_t>(cmd.data_[2]), offset, dim,
+            reinterpret_cast<const void *>(cmd.data_[1]), static_cast<std::size_t>(cmd.data_[5]));
+    }
+
+    void software_graphics_driver::read_bitmap(command &cmd) {
+        software_bitmap *bmp = get_bitmap(cmd.data_[0]);
+        std::uint8_t *ptr = reinterpret_cast<std::uint8_t *>(cmd.data_[4]);
+
+        if (!bmp || !ptr) {
+            finish(cmd.status_, 0);
+            return;
+        }
+
+        eka2l1::point pos(0, 0);
+        eka2l1::object_size size(0, 0);
+        const std::uint32_t bpp = static_cast<std::uint32_t>(cmd.data_[3]);
+
+        unpack_u64_to_2u32(cmd.data_[1], pos.x, pos.y);
+        unpack_u64_to_2u32(cmd.data_[2], size.x, size.y);
+
+        int bytes_per_pixel = 0;
+
+        switch (bpp) {
+        case 8:
+        case 32:
+            bytes_per_pixel = 4;
+            break;
+
+        case 24:
+            bytes_per_pixel = 3;
+            break;
+
+        case 12:
+        case 16:
+            bytes_per_pixel = 2;
+            break;
+
+        default:
+            LOG_ERROR(DRIVER_GRAPHICS, "Unsupported BPP type to read format from (value={})", bpp);
+            finish(cmd.status_, 0);
+
+            return;
+        }
+
+        flush_batch();
+
+        const std::size_t row_bytes = ((static_cast<std::size_t>(size.x) * bytes_per_pixel) + 3) & ~static_cast<std::size_t>(3);
+
+        for (int y = 0; y < size.y; y++) {
+            std::uint8_t *dest = ptr + y * row_bytes;
+
+            if ((pos.y + y < 0) || (pos.y + y >= bmp->size_.y)) {
+                continue;
+            }
+
+            const std::uint32_t *source_row = bmp->row(pos.y + y);
+
+            for (int x = 0; x < size.x; x++, dest += bytes_per_pixel) {
+                if ((pos.x + x < 0) || (pos.x + x >= bmp->size_.x)) {
+                    continue;
+                }
+
+                const std::uint32_t pixel = source_row[pos.x + x];
+
+                // Same layouts as a framebuffer read back on the GPU backend
+                switch (bpp) {
+                case 12: {
+                    const std::uint16_t value = static_cast<std::uint16_t>(((pixel_channel(pixel, 0) / 17) << 8) | ((pixel_channel(pixel, 3) / 17) << 12)
+                        | ((pixel_channel(pixel, 1) / 17) << 4) | (pixel_channel(pixel, 2) / 17));
+
+                    std::memcpy(dest, &value, sizeof(value));
+                    break;
+                }
+
+                case 16: {
+                    const std::uint16_t value = static_cast<std::uint16_t>(((pixel_channel(pixel, 0) & 0xF8) << 8)
+                        | ((pixel_channel(pixel, 1) & 0xFC) << 3) | (pixel_channel(pixel, 2) >> 3));
+
+                    std::memcpy(dest, &value, sizeof(value));
+                    break;
+                }
+
+                default:
+                    for (int i = 0; i < bytes_per_pixel; i++) {
+                        dest[i] = static_cast<std::uint8_t>(pixel_channel(pixel, i));
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        finish(cmd.status_, 1);
+    }
+
+    void software_graphics_driver::resize_bitmap(command &cmd) {
+        software_bitmap *bmp = get_bitmap(cmd.data_[0]);
+
+        if (!bmp) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Bitmap handle invalid to be resized");
+            return;
+        }
+
+        eka2l1::vec2 new_size = { 0, 0 };
+        unpack_u64_to_2u32(cmd.data_[1], new_size.x, new_size.y);
+
+        flush_batch();
+        bmp->resize(new_size);
+    }
+
+    void software_graphics_driver::destroy_bitmap(command &cmd) {
+        const drivers::handle index = (cmd.data_[0] & ~SOFTWARE_HANDLE_BITMAP);
+
+        if ((index == 0) || (index > bitmaps_.size())) {
+            LOG_ERROR(DRIVER_GRAPHICS, "Invalid bitmap handle to destroy");
+            return;
+        }
+
+        flush_batch();
+
+        if (binding_ == bitmaps_[index - 1].get()) {
+            binding_ = nullptr;
+        }
+
+        bitmaps_[index - 1].reset();
+    }
+
+    void software_graphics_driver::clip_rect(command &cmd) {
+        eka2l1::rect clip;
+        unpack_u64_to_2u32(cmd.data_[0], clip.top.x, clip.top.y);
+        unpack_u64_to_2u32(cmd.data_[1], clip.size.x, clip.size.y);
+
+        // Plain clip rectangles come from GLES, which has its origin at the bottom left
+        if ((cmd.opcode_ == graphics_driver_clip_rect) && binding_) {
+            clip.top.y = binding_->size_.y - (clip.top.y + clip.size.y);
+        }
+
+        state_.scissor_ = clip;
+    }
+
+    void software_graphics_driver::clip_region(command &cmd) {
+        const eka2l1::rect *rects = reinterpret_cast<const eka2l1::rect *>(cmd.data_[1]);
+        const std::size_t rect_count = static_cast<std::size_t>(cmd.data_[0]);
+
+        float scale = 0.0f;
+        float temp = 0.0f;
+
+        unpack_to_two_floats(cmd.data_[2], scale, temp);
+
+        std::vector<eka2l1::rect> scaled;
+
+        for (std::size_t i = 0; i < rect_count; i++) {
+            if (rects[i].valid()) {
+                eka2l1::rect to_add = rects[i];
+                to_add.scale(scale);
+
+                scaled.push_back(to_add);
+            }
+        }
+
+        state_.region_.clear();
+
+        if (rect_count == 0) {
+            state_.clipping_ = false;
+            state_.region_clipping_ = false;
+
+            return;
+        }
+
+        if (rect_count == 1) {
+            state_.clipping_ = true;
+            state_.region_clipping_ = false;
+            state_.scissor_ = scaled.empty() ? eka2l1::rect({ 0, 0 }, { 0, 0 }) : scaled[0];
+
+            return;
+        }
+
+        state_.clipping_ = false;
+        state_.region_clipping_ = true;
+        state_.region_ = make_disjoint_rects(scaled);
+    }
+
+    void software_graphics_driver::set_feature(command &cmd) {
+        drivers::graphics_feature feature;
+        bool enable = true;
+
+        unpack_u64_to_2u32(cmd.data_[0], feature, enable);
+
+        switch (feature) {
+        case drivers::graphics_feature::blend:
+            state_.blend_.enabled_ = enable;
+            break;
+
+        case drivers::graphics_feature::clipping:
+            state_.clipping_ = enable;
+            break;
+
+        case drivers::graphics_feature::stencil_test:
+            state_.region_clipping_ = enable;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void software_graphics_driver::blend_formula(command &cmd) {
+        software_blend_state &blend = state_.blend_;
+
+        unpack_u64_to_2u32(cmd.data_[0], blend.rgb_equation_, blend.a_equation_);
+        unpack_u64_to_2u32(cmd.data_[1], blend.rgb_frag_factor_, blend.rgb_current_factor_);
+        unpack_u64_to_2u32(cmd.data_[2], blend.a_frag_factor_, blend.a_current_factor_);
+    }
+
+    static std::uint32_t float_color_to_pixel(const float r, const float g, const float b, const float a) {
+        const auto to_channel = [](const float value) {
+            return static_cast<std::uint32_t>(common::clamp(0.0f, 1.0f, value) * 255.0f + 0.5f);
+        };
+
+        return make_pixel(to_channel(r), to_channel(g), to_channel(b), to_channel(a));
+    }
+
+    void software_graphics_driver::clear(command &cmd) {
+        if (!(cmd.data_[3] & draw_buffer_bit_color_buffer)) {
+            // No depth or stencil buffer to clear
+            return;
+        }
+
+        float color[4];
+
+        unpack_to_two_floats(cmd.data_[0], color[0], color[1]);
+        unpack_to_two_floats(cmd.data_[1], color[2], color[3]);
+
+        software_bitmap *target = current_target();
+
+        software_draw_op op{};
+        op.kind_ = software_draw_op_fill;
+        op.bounds_ = eka2l1::rect({ 0, 0 }, target->size_);
+        op.color_ = float_color_to_pixel(color[0], color[1], color[2], color[3]);
+
+        // Clear is not blended, and only cares about the scissor
+        prepare_op(op, true);
+    }
+
+    void software_graphics_driver::draw_rectangle(command &cmd) {
+        eka2l1::rect brush_rect;
+        unpack_u64_to_2u32(cmd.data_[0], brush_rect.top.x, brush_rect.top.y);
+        unpack_u64_to_2u32(cmd.data_[1], brush_rect.size.x, brush_rect.size.y);
+
+        software_bitmap *target = current_target();
+
+        if (brush_rect.size.x == 0) {
+            brush_rect.size.x = target->size_.x;
+        }
+
+        if (brush_rect.size.y == 0) {
+            brush_rect.size.y = target->size_.y;
+        }
+
+        software_draw_op op{};
+        op.kind_ = software_draw_op_fill;
+        op.bounds_ = brush_rect;
+        op.color_ = state_.brush_color_;
+        op.blend_ = state_.blend_;
+
+        prepare_op(op);
+    }
+
+    void software_graphics_driver::draw_bitmap(command &cmd) {
+        const std::uint32_t flags = static_cast<std::uint32_t>(cmd.data_[7] >> 32);
+        const software_bitmap *source = get_bitmap(cmd.data_[0]);
+
+        if (!source) {
+            // Textures from the advanced mode have no storage here
+            if (!warned_advanced_draw_) {
+                LOG_WARN(DRIVER_GRAPHICS, "Drawing non-bitmap textures is not supported by the software driver");
+                warned_advanced_draw_ = true;
+            }
+
+            return;
+        }
+
+        const software_bitmap *mask = nullptr;
+
+        if (cmd.data_[1]) {
+            mask = get_bitmap(cmd.data_[1]);
+
+            if (!mask) {
+                LOG_ERROR(DRIVER_GRAPHICS, "Mask handle was provided but invalid!");
+                return;
+            }
+        }
+
+        software_draw_op op{};
+        op.kind_ = software_draw_op_bitmap;
+        op.flags_ = flags;
+        op.blend_ = state_.blend_;
+        op.color_ = (flags & bitmap_draw_flag_use_brush) ? state_.brush_color_ : 0xFFFFFFFF;
+
+        unpack_u64_to_2u32(cmd.data_[2], op.dest_.top.x, op.dest_.top.y);
+        unpack_u64_to_2u32(cmd.data_[3], op.dest_.size.x, op.dest_.size.y);
+        unpack_u64_to_2u32(cmd.data_[4], op.source_rect_.top.x, op.source_rect_.top.y);
+        unpack_u64_to_2u32(cmd.data_[5], op.source_rect_.size.x, op.source_rect_.size.y);
+        unpack_u64_to_2u32(cmd.data_[6], op.origin_.x, op.origin_.y);
+
+        const std::uint32_t rot_f32 = static_cast<std::uint32_t>(cmd.data_[7]);
+        std::memcpy(&op.rotation_, &rot_f32, sizeof(float));
+
+        if (op.source_rect_.size.x == 0) {
+            op.source_rect_.size.x = source->size_.x;
+        }
+
+        if (op.source_rect_.size.y == 0) {
+            op.source_rect_.size.y = source->size_.y;
+        }
+
+        if (op.dest_.size.x == 0) {
+            op.dest_.size.x = op.source_rect_.size.x;
+        }
+
+        if (op.dest_.size.y == 0) {
+            op.dest_.size.y = op.source_rect_.size.y;
+        }
+
+        if (!rect_has_area(op.dest_) || !rect_has_area(op.source_rect_) || (source->size_.x == 0) || (source->size_.y == 0)) {
+            return;
+        }
+
+        if (mask && ((mask->size_.x == 0) || (mask->size_.y == 0))) {
+            return;
+        }
+
+        op.source_ = snapshot_source(source);
+        op.mask_ = mask ? snapshot_source(mask) : nullptr;
+        op.bounds_ = op.dest_;
+
+        if (op.rotation_ != 0.0f) {
+            // Bounds of the destination rotated around the origin
+            const float pivot_x = static_cast<float>(op.dest_.top.x + op.origin_.x);
+            const float pivot_y = static_cast<float>(op.dest_.top.y + op.origin_.y);
+            const float radians = op.rotation_ * 3.14159265358979f / 180.0f;
+
+            float min_x = 0, min_y = 0, max_x = 0, max_y = 0;
+
+            for (int i = 0; i < 4; i++) {
+                const float corner_x = static_cast<float>(op.dest_.top.x + ((i & 1) ? op.dest_.size.x : 0)) - pivot_x;
+                const float corner_y = static_cast<float>(op.dest_.top.y + ((i & 2) ? op.dest_.size.y : 0)) - pivot_y;
+
+                const float x = std::cos(radians) * corner_x - std::sin(radians) * corner_y + pivot_x;
+                const float y = std::sin(radians) * corner_x + std::cos(radians) * corner_y + pivot_y;
+
+                min_x = (i == 0) ? x : common::min(min_x, x);
+                min_y = (i == 0) ? y : common::min(min_y, y);
+                max_x = (i == 0) ? x : common::max(max_x, x);
+                max_y = (i == 0) ? y : common::max(max_y, y);
+            }
+
+            const int left = static_cast<int>(std::floor(min_x)) - 1;
+            const int top = static_cast<int>(std::floor(min_y)) - 1;
+
+            op.bounds_ = eka2l1::rect({ left, top }, { static_cast<int>(std::ceil(max_x)) + 1 - left,
+                static_cast<int>(std::ceil(max_y)) + 1 - top });
+        }
+
+        prepare_op(op);
+    }
+
+    void software_graphics_driver::draw_bitmap_quads(command &cmd) {
+        const software_bitmap *source = get_bitmap(cmd.data_[0]);
+
+        if (!source) {
+            if (!warned_advanced_draw_) {
+                LOG_WARN(DRIVER_GRAPHICS, "Drawing non-bitmap textures is not supported by the software driver");
+                warned_advanced_draw_ = true;
+            }
+
+            return;
+        }
+
+        const bitmap_quad *quads = reinterpret_cast<const bitmap_quad *>(cmd.data_[1]);
+        const std::size_t quad_count = static_cast<std::size_t>(cmd.data_[2]);
+        const std::uint32_t flags = static_cast<std::uint32_t>(cmd.data_[3]) & bitmap_draw_flag_use_brush;
+
+        if (!quads || (source->size_.x == 0) || (source->size_.y == 0)) {
+            return;
+        }
+
+        // Every quad samples the same bitmap, so it only has to be snapshotted once
+        const software_bitmap *sampled = snapshot_source(source);
+
+        for (std::size_t i = 0; i < quad_count; i++) {
+            if (!rect_has_area(quads[i].dest_) || !rect_has_area(quads[i].source_)) {
+                continue;
+            }
+
+            software_draw_op op{};
+            op.kind_ = software_draw_op_bitmap;
+            op.flags_ = flags;
+            op.blend_ = state_.blend_;
+            op.color_ = (flags & bitmap_draw_flag_use_brush) ? state_.brush_color_ : 0xFFFFFFFF;
+            op.dest_ = quads[i].dest_;
+            op.bounds_ = quads[i].dest_;
+            op.source_rect_ = quads[i].source_;
+            op.source_ = sampled;
+
+            prepare_op(op);
+        }
+    }
+
+    void software_graphics_driver::draw_line(const eka2l1::point &start, const eka2l1::point &end) {
+        std::uint16_t pattern = 0xFFFF;
+
+        switch (state_.pen_style_) {
+        case pen_style_none:
+            return;
+
+        case pen_style_dotted:
+            pattern = 0x6666;
+            break;
+
+        case pen_style_dashed:
+            pattern = 0x3F3F;
+            break;
+
+        case pen_style_dashed_dot:
+            pattern = 0xFF18;
+            break;
+
+        case pen_style_dashed_dot_dot:
+            pattern = 0x7E66;
+            break;
+
+        default:
+            break;
+        }
+
+        software_draw_op op{};
+        op.kind_ = software_draw_op_points;
+        op.color_ = state_.brush_color_;
+        op.blend_ = state_.blend_;
+        op.point_size_ = common::max(state_.point_size_, 1);
+        op.point_begin_ = static_cast<std::uint32_t>(batch_points_.size());
+
+        // Bresenham, without the last pixel like a line on the GPU
+        const int delta_x = common::abs(end.x - start.x);
+        const int delta_y = -common::abs(end.y - start.y);
+        const int step_x = (start.x < end.x) ? 1 : -1;
+        const int step_y = (start.y < end.y) ? 1 : -1;
+
+        int error = delta_x + delta_y;
+        eka2l1::point current = start;
+
+        eka2l1::point top_left = start;
+        eka2l1::point bottom_right = start;
+
+        while (current != end) {
+            const float distance = std::sqrt(static_cast<float>((current.x - start.x) * (current.x - start.x) + (current.y - start.y) * (current.y - start.y)));
+
+            if (pattern & (1 << (static_cast<std::uint32_t>(std::round(distance)) & 15))) {
+                batch_points_.push_back(current);
+
+                top_left.x = common::min(top_left.x, current.x);
+                top_left.y = common::min(top_left.y, current.y);
+                bottom_right.x = common::max(bottom_right.x, current.x);
+                bottom_right.y = common::max(bottom_right.y, current.y);
+            }
+
+            const int error2 = error * 2;
+
+            if (error2 >= delta_y) {
+                error += delta_y;
+                current.x += step_x;
+            }
+
+            if (error2 <= delta_x) {
+                error += delta_x;
+                current.y += step_y;
+            }
+        }
+
+        op.point_count_ = static_cast<std::uint32_t>(batch_points_.size() - op.point_begin_);
+
+        if (op.point_count_ == 0) {
+            return;
+        }
+
+        const int half_size = op.point_size_ / 2;
+
+        op.bounds_ = eka2l1::rect({ top_left.x - half_size, top_left.y - half_size },
+            { bottom_right.x - top_left.x + op.point_size_, bottom_right.y - top_left.y + op.point_size_ });
+
+        if (!prepare_op(op)) {
+            batch_points_.resize(op.point_begin_);
+        }
+    }
+
+    void software_graphics_driver::draw_line(command &cmd) {
+        eka2l1::point start;
+        eka2l1::point end;
+
+        unpack_u64_to_2u32(cmd.data_[0], start.x, start.y);
+        unpack_u64_to_2u32(cmd.data_[1], end.x, end.y);
+
+        draw_line(start, end);
+    }
+
+    void software_graphics_driver::draw_polygon(command &cmd) {
+        const std::size_t point_count = static_cast<std::size_t>(cmd.data_[0]);
+        const eka2l1::point *point_list = reinterpret_cast<const eka2l1::point *>(cmd.data_[1]);
+
+        for (std::size_t i = 0; i + 1 < point_count; i++) {
+            draw_line(point_list[i], point_list[i + 1]);
+        }
+    }
+
+    static void store_new_handle(const std::uint64_t store_ptr, const drivers::handle h) {
+        drivers::handle *store = reinterpret_cast<drivers::handle *>(store_ptr);
+
+        if (store) {
+            *store = h;
+        }
+    }
+
+    void software_graphics_driver::dispatch(command &cmd) {
+        switch (cmd.opcode_) {
+        case graphics_driver_create_bitmap:
+            create_bitmap(cmd);
+            break;
+
+        case graphics_driver_bind_bitmap:
+            bind_bitmap(cmd);
+            break;
+
+        case graphics_driver_update_bitmap:
+            update_bitmap(cmd);
+            break;
+
+        case graphics_driver_read_bitmap:
+            read_bitmap(cmd);
+            return;
+
+        case graphics_driver_resize_bitmap:
+            resize_bitmap(cmd);
+            break;
+
+        case graphics_driver_destroy_bitmap:
+            destroy_bitmap(cmd);
+            break;
+
+        case graphics_driver_set_brush_color: {
+            std::uint32_t r, g, b, a;
+            unpack_u64_to_2u32(cmd.data_[0], r, g);
+            unpack_u64_to_2u32(cmd.data_[1], b, a);
+
+            state_.brush_color_ = make_pixel(r & 0xFF, g & 0xFF, b & 0xFF, a & 0xFF);
+            break;
+        }
+
+        case graphics_driver_clip_rect:
+        case graphics_driver_clip_bitmap_rect:
+            clip_rect(cmd);
+            break;
+
+        case graphics_driver_clip_region:
+            clip_region(cmd);
+            break;
+
+        case graphics_driver_set_feature:
+            set_feature(cmd);
+            break;
+
+        case graphics_driver_blend_formula:
+            blend_formula(cmd);
+            break;
+
+        case graphics_driver_set_blend_colour: {
+            float color[4];
+
+            unpack_to_two_floats(cmd.data_[0], color[0], color[1]);
+            unpack_to_two_floats(cmd.data_[1], color[2], color[3]);
+
+            state_.blend_.constant_ = float_color_to_pixel(color[0], color[1], color[2], color[3]);
+            break;
+        }
+
+        case graphics_driver_backup_state:
+            backup_state_ = state_;
+            break;
+
+        case graphics_driver_restore_state:
+            // Same as the GPU backend, the brush and pen are not part of the backup
+            state_.blend_ = backup_state_.blend_;
+            state_.clipping_ = backup_state_.clipping_;
+            state_.scissor_ = backup_state_.scissor_;
+            break;
+
+        case graphics_driver_clear:
+            clear(cmd);
+            break;
+
+        case graphics_driver_draw_rectangle:
+            draw_rectangle(cmd);
+            break;
+
+        case graphics_driver_draw_bitmap:
+            draw_bitmap(cmd);
+            break;
+
+        case graphics_driver_draw_bitmap_quads:
+            draw_bitmap_quads(cmd);
+            break;
+
+        case graphics_driver_draw_line:
+            draw_line(cmd);
+            break;
+
+        case graphics_driver_draw_polygon:
+            draw_polygon(cmd);
+            break;
+
+        case graphics_driver_set_point_size:
+            state_.point_size_ = static_cast<int>(static_cast<std::uint8_t>(cmd.data_[0]));
+            break;
+
+        case graphics_driver_set_pen_style:
+            state_.pen_style_ = static_cast<pen_style>(cmd.data_[0]);
+            break;
+
+        case graphics_driver_set_swapchain_size: {
+            eka2l1::vec2 size;
+            unpack_u64_to_2u32(cmd.data_[0], size.x, size.y);
+
+            if (size != screen_.size_) {
+                flush_batch();
+                screen_ = software_bitmap(size, 32);
+            }
+
+            break;
+        }
+
+        case graphics_driver_display:
+            flush_batch();
+
+            if (disp_hook_) {
+                disp_hook_();
+            }
+
+            break;
+
+        // Advanced mode objects have handles, but no storage. Creation commands with an existing
+        // handle are the recreate variant, which has no handle to store.
+        case graphics_driver_create_shader_module:
+            store_new_handle(cmd.data_[3], next_handle_++);
+            break;
+
+        case graphics_driver_create_shader_program:
+            // No shaders to run them with, so let the program fail to link. EGL refuses this driver, so this
+            // is only reached by callers that skip it.
+            finish(cmd.status_, -1);
+            return;
+
+        case graphics_driver_create_renderbuffer:
+            if (cmd.data_[2] == 0) {
+                store_new_handle(cmd.data_[3], next_handle_++);
+            }
+
+            break;
+
+        case graphcis_driver_create_framebuffer:
+            store_new_handle(cmd.data_[6], next_handle_++);
+            break;
+
+        case graphics_driver_create_texture:
+            if (cmd.data_[7] == 0) {
+                store_new_handle(cmd.data_[8], next_handle_++);
+            }
+
+            break;
+
+        case graphics_driver_create_buffer:
+            if (cmd.data_[3] == 0) {
+                store_new_handle(cmd.data_[4], next_handle_++);
+            }
+
+            break;
+
+        case graphics_driver_create_input_descriptor:
+            if (cmd.data_[2] == 0) {
+                store_new_handle(cmd.data_[3], next_handle_++);
+            }
+
+            break;
+
+        case graphics_driver_draw_array:
+        case graphics_driver_draw_indexed:
+            if (!warned_advanced_draw_) {
+                LOG_WARN(DRIVER_GRAPHICS, "Shader draws are not supported by the software driver and are dropped");
+                warned_advanced_draw_ = true;
+            }
+
+            break;
+
+        default:
+            break;
+        }
+
+        finish(cmd.status_, 0);
+    }
+
+    void software_graphics_driver::run() {
+        while (!should_stop_) {
+            std::optional<command_list> list = list_queue_.pop();
+
+            if (!list) {
+                if (!should_stop_) {
+                    LOG_ERROR(DRIVER_GRAPHICS, "Corrupted graphics command list! Emulation halt.");
+                }
+
+                break;
+            }
+
+            command_reader reader(*list);
+            command cmd;
+
+            while (reader.next(cmd)) {
+                dispatch(cmd);
+            }
+
+            // Payloads the draws point to are freed with the list
+            flush_batch();
+            list->retire();
+        }
+    }
+
+    void software_graphics_driver::abort() {
+        // Stop first, so the run loop doesn't take the aborted queue for a corrupted one
+        should_stop_ = true;
+        list_queue_.abort();
+
+        cond_.notify_all();
+    }
+
+    void software_graphics_driver::wait_for(int *status) {
+        if (should_stop_) {
+            return;
+        }
+
+        driver::wait_for(status);
+    }
+
+    void software_graphics_driver::submit_command_list(command_list &list) {
+        if ((list.size_ == 0) || should_stop_) {
+            list.retire();
+            return;
+        }
+
+        list.flush();
+        list_queue_.push(list);
+    }
+
+    void software_graphics_driver::set_viewport(const eka2l1::rect &viewport) {
+    }
+
+    void software_graphics_driver::update_surface(void *surface) {
+    }
+
+    void software_graphics_driver::set_upscale_shader(const std::string &name) {
+    }
+
+    std::string software_graphics_driver::get_active_upscale_shader() const {
+        return "Default";
+    }
+
+    bool software_graphics_driver::support_extension(const graphics_driver_extension ext) {
+        return false;
+    }
+
+    bool software_graphics_driver::query_extension_value(const graphics_driver_extension_query query, void *data_ptr) {
+        return false;
+    }
+}
@@ -17,7 +17,9 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <drivers/graphics/backend/null/graphics_null.h>
 #include <drivers/graphics/backend/ogl/graphics_ogl.h>
+#include <drivers/graphics/backend/software/graphics_software.h>
 #include <drivers/graphics/graphics.h>
 
 #include <common/log.h>
@@ -30,6 +32,14 @@ namespace eka2l1::drivers {
             return std::make_unique<ogl_graphics_driver>(info);
         }
 
+        case graphic_api::null: {
+            return std::make_unique<null_graphics_driver>();
+        }
+
+        case graphic_api::software: {
+            return std::make_unique<software_graphics_driver>();
+        }
+
         default:
             break;
         }
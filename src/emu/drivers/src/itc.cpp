@@ -32,11 +32,8 @@ namespace eka2l1::drivers {
         int status = -100;
         cmd.status_ = &status;
 
-        command_list cmd_list(1);
-        cmd_list.renew();
-
-        cmd_list.size_ = 1;
-        *cmd_list.base_ = cmd;
+        command_list cmd_list;
+        cmd_list.push(cmd);
 
         std::unique_lock<std::mutex> ulock(drv->mut_);
         drv->submit_command_list(cmd_list);
@@ -45,13 +42,13 @@ namespace eka2l1::drivers {
         return status;
     }
 
-    static std::uint64_t make_data_copy(const void *source, const std::size_t size) {
+    static std::uint64_t make_data_copy(command_list &list, const void *source, const std::size_t size) {
         if (!source) {
             return 0;
         }
 
-        std::uint8_t *copy = new std::uint8_t[size];
-        std::copy(reinterpret_cast<const std::uint8_t *>(source), reinterpret_cast<const std::uint8_t *>(source) + size, copy);
+        std::uint8_t *copy = list.allocate_payload(size);
+        std::memcpy(copy, source, size);
 
         return reinterpret_cast<std::uint64_t>(copy);
     }
@@ -285,7 +282,7 @@ namespace eka2l1::drivers {
 
             cmd->opcode_ = graphics_driver_clip_region;
             cmd->data_[0] = static_cast<std::uint64_t>(region.rects_.size());
-            cmd->data_[1] = make_data_copy(region.rects_.data(), region.rects_.size() * sizeof(eka2l1::rect));
+            cmd->data_[1] = make_data_copy(list_, region.rects_.data(), region.rects_.size() * sizeof(eka2l1::rect));
             cmd->data_[2] = pack_from_two_floats(scale_factor, 0.0f);
         }
     }
@@ -316,7 +313,11 @@ namespace eka2l1::drivers {
         cmd->opcode_ = graphics_driver_update_bitmap;
 
         cmd->data_[0] = h;
-        cmd->data_[1] = (need_copy ? make_data_copy(data, size) : reinterpret_cast<std::uint64_t>(data));
+        cmd->data_[1] = (need_copy ? make_data_copy(list_, data, size) : reinterpret_cast<std::uint64_t>(data));
+
+        if (!need_copy) {
+            list_.adopt_payload(reinterpret_cast<std::uint8_t *>(const_cast<char *>(data)), size);
+        }
         cmd->data_[2] = size;
         cmd->data_[3] = PACK_2U32_TO_U64(offset.x, offset.y);
         cmd->data_[4] = PACK_2U32_TO_U64(dim.x, dim.y);
@@ -331,7 +332,7 @@ namespace eka2l1::drivers {
         cmd->opcode_ = graphics_driver_update_texture;
 
         cmd->data_[0] = h;
-        cmd->data_[1] = make_data_copy(data, size);
+        cmd->data_[1] = make_data_copy(list_, data, size);
         cmd->data_[2] = size;
         cmd->data_[3] = lvl | (static_cast<std::uint64_t>(data_format) << 8) | (static_cast<std::uint64_t>(data_type) << 24); 
         cmd->data_[4] = PACK_2U32_TO_U64(offset.x, offset.y);
@@ -356,6 +357,24 @@ namespace eka2l1::drivers {
         cmd->data_[7] = (static_cast<std::uint64_t>(flags) << 32) | *reinterpret_cast<const std::uint32_t*>(&rotation);
     }
 
+    void graphics_command_builder::draw_bitmap_quads(drivers::handle h, const bitmap_quad *quads, const std::size_t quad_count,
+        const std::uint32_t flags) {
+        if (quad_count == 0) {
+            return;
+        }
+
+        bitmap_quad *quads_copied = reinterpret_cast<bitmap_quad *>(list_.allocate_payload(quad_count * sizeof(bitmap_quad)));
+        std::memcpy(quads_copied, quads, quad_count * sizeof(bitmap_quad));
+
+        command *cmd = list_.retrieve_next();
+        cmd->opcode_ = graphics_driver_draw_bitmap_quads;
+
+        cmd->data_[0] = h;
+        cmd->data_[1] = reinterpret_cast<std::uint64_t>(quads_copied);
+        cmd->data_[2] = quad_count;
+        cmd->data_[3] = flags;
+    }
+
     void graphics_command_builder::bind_bitmap(const drivers::handle h) {
         command *cmd = list_.retrieve_next();
 
@@ -400,7 +419,7 @@ namespace eka2l1::drivers {
         cmd->opcode_ = graphics_driver_set_uniform;
 
         cmd->data_[0] = PACK_2U32_TO_U64(binding, var_type);
-        cmd->data_[1] = make_data_copy(data, data_size);
+        cmd->data_[1] = make_data_copy(list_, data, data_size);
         cmd->data_[2] = data_size;
     }
 
@@ -433,7 +452,7 @@ namespace eka2l1::drivers {
         command *cmd = list_.retrieve_next();
         cmd->opcode_ = graphics_driver_bind_vertex_buffers;
 
-        cmd->data_[0] = make_data_copy(h, sizeof(drivers::handle) * count);
+        cmd->data_[0] = make_data_copy(list_, h, sizeof(drivers::handle) * count);
         cmd->data_[1] = PACK_2U32_TO_U64(starting_slot, count);
     }
 
@@ -451,7 +470,7 @@ namespace eka2l1::drivers {
             total_chunk_size += chunk_size[i];
         }
 
-        std::uint8_t *data = new std::uint8_t[total_chunk_size];
+        std::uint8_t *data = list_.allocate_payload(total_chunk_size);
 
         for (int i = 0; i < chunk_count; i++) {
             std::copy(reinterpret_cast<const std::uint8_t *>(chunk_ptr[i]), reinterpret_cast<const std::uint8_t *>(chunk_ptr[i]) + chunk_size[i], data + cursor);
@@ -467,6 +486,9 @@ namespace eka2l1::drivers {
     }
 
     void graphics_command_builder::update_buffer_data_no_copy(drivers::handle h, const std::size_t offset, const void *ptr, const std::uint32_t size) {
+        // The buffer is handed over, and freed with the list
+        list_.adopt_payload(reinterpret_cast<std::uint8_t *>(const_cast<void *>(ptr)), size);
+
         command *cmd = list_.retrieve_next();
         cmd->opcode_ = graphics_driver_update_buffer;
         cmd->data_[0] = h;
@@ -627,8 +649,8 @@ namespace eka2l1::drivers {
     }
 
     void graphics_command_builder::draw_polygons(const eka2l1::point *point_list, const std::size_t point_count) {
-        eka2l1::point *point_list_copied = new eka2l1::point[point_count];
-        memcpy(point_list_copied, point_list, point_count * sizeof(eka2l1::point));
+        eka2l1::point *point_list_copied = reinterpret_cast<eka2l1::point *>(list_.allocate_payload(point_count * sizeof(eka2l1::point)));
+        std::memcpy(point_list_copied, point_list, point_count * sizeof(eka2l1::point));
 
         command *cmd = list_.retrieve_next();
 
@@ -670,7 +692,7 @@ namespace eka2l1::drivers {
         cmd->opcode_ = graphics_driver_create_texture;
         cmd->data_[0] = dim | (static_cast<std::uint64_t>(mip_levels) << 8) | (static_cast<std::uint64_t>(internal_format) << 16)
             | (static_cast<std::uint64_t>(data_format) << 32) | (static_cast<std::uint64_t>(data_type) << 48);
-        cmd->data_[1] = make_data_copy(data, data_size);
+        cmd->data_[1] = make_data_copy(list_, data, data_size);
         cmd->data_[2] = data_size;
         cmd->data_[3] = pixels_per_line;
         cmd->data_[4] = static_cast<std::uint64_t>(unpack_alignment);
@@ -682,7 +704,7 @@ namespace eka2l1::drivers {
     void graphics_command_builder::recreate_buffer(drivers::handle h, const void *initial_data, const std::size_t initial_size, const buffer_upload_hint upload_hint) {
         command *cmd = list_.retrieve_next();
         cmd->opcode_ = graphics_driver_create_buffer;
-        cmd->data_[0] = make_data_copy(initial_data, initial_size);
+        cmd->data_[0] = make_data_copy(list_, initial_data, initial_size);
         cmd->data_[1] = initial_size;
         cmd->data_[2] = static_cast<std::uint64_t>(upload_hint);
         cmd->data_[3] = h;
@@ -707,7 +729,7 @@ namespace eka2l1::drivers {
         command *cmd = list_.retrieve_next();
         cmd->opcode_ = graphics_driver_create_input_descriptor;
     
-        cmd->data_[0] = make_data_copy(descriptors, count * sizeof(input_descriptor));
+        cmd->data_[0] = make_data_copy(list_, descriptors, count * sizeof(input_descriptor));
         cmd->data_[1] = count;
         cmd->data_[2] = h;
         cmd->data_[3] = reinterpret_cast<std::uint64_t>(&h);
@@ -167,6 +167,15 @@ namespace eka2l1 {
                 return pos_access;
             }
 
+            const chunk_type get_chunk_type() const {
+                return type;
+            }
+
+            /*! \brief Check if a page of the chunk is committed.
+             * \param page_index Index of the page, counting from the start of the chunk.
+             */
+            bool is_page_committed(const std::uint32_t page_index);
+
             void *host_base();
         };
     }
@@ -11,6 +11,8 @@ namespace eka2l1::kernel {
 
     class condvar : public kernel_obj {
     private:
+        friend class eka2l1::kernel_system;
+
         kernel::thread_priority_queue waits;
         common::roundabout suspended;
 
@@ -37,6 +37,8 @@
 #include <kernel/process.h>
 #include <kernel/scheduler.h>
 #include <kernel/sema.h>
+#include <kernel/smp/balancer.h>
+#include <kernel/smp/core.h>
 #include <kernel/timer.h>
 #include <kernel/undertaker.h>
 
@@ -56,6 +58,7 @@
 #include <cpu/arm_analyser.h>
 #include <config/panic_blacklist.h>
 
+#include <array>
 #include <atomic>
 #include <exception>
 #include <functional>
@@ -159,8 +162,8 @@ namespace eka2l1 {
     static constexpr std::uint32_t DEFAULT_EMULATED_CPU_HZ = common::MHZ(434);
 
     struct find_handle {
-        std::uint32_t index; ///< Index of the object in the separate object container.
-            ///< On EKA2L1 this index starts from 1.
+        std::uint32_t index; ///< Unique ID of the object, masked by FIND_HANDLE_IDX_MASK.
+            ///< Stays valid when other objects are destroyed.
         std::uint64_t object_id; ///< The ID of the kernel object.
         kernel_obj_ptr obj; ///< The corresponded kernel object found.
     };
@@ -271,6 +274,17 @@ namespace eka2l1 {
         void reset();
     };
 
+    /**
+     * \brief Running totals of guest activity, for profiling.
+     *
+     * These are only ever added to. Cores bump them without holding the kernel lock.
+     */
+    struct kernel_counters {
+        std::atomic<std::uint64_t> instructions_executed_{ 0 };
+        std::atomic<std::uint64_t> svc_calls_{ 0 };
+        std::atomic<std::uint64_t> ipc_messages_{ 0 };
+    };
+
     class kernel_system {
     private:
         friend class debugger_base;
@@ -281,6 +295,8 @@ namespace eka2l1 {
         std::array<std::unique_ptr<ipc_msg>, 0x1000> msgs_;
         std::mutex kern_lock_;
 
+        kernel_counters counters_;
+
         std::vector<kernel_obj_unq_ptr> threads_;
         std::vector<kernel_obj_unq_ptr> processes_;
         std::vector<kernel_obj_unq_ptr> servers_;
@@ -302,7 +318,9 @@ namespace eka2l1 {
 
         std::unique_ptr<kernel::btrace> btrace_inst_;
         std::unique_ptr<hle::lib_manager> lib_mngr_;
-        std::unique_ptr<kernel::thread_scheduler> thr_sch_;
+        std::vector<std::unique_ptr<kernel::thread_scheduler>> schedulers_; ///< One sub-scheduler per core.
+        std::vector<std::unique_ptr<kernel::smp::core_runner>> core_runners_; ///< Host threads of secondary cores.
+        std::unique_ptr<kernel::smp::load_balancer> balancer_;
 
         ntimer *timing_;
         memory_system *mem_;
@@ -312,7 +330,7 @@ namespace eka2l1 {
         config::app_settings *app_settings_;
         disasm *disassembler_;
 
-        arm::core *cpu_;
+        std::vector<arm::core *> cores_;
         loader::rom *rom_info_;
 
         //! Handles for some globally shared processes
@@ -364,6 +382,44 @@ namespace eka2l1 {
 
         config::panic_blacklist panic_blacklist_;
 
+        /**
+         * @brief Objects of one type, keyed by their lowercased name.
+         *
+         * Renames only mark the index as dirty, it's rebuilt on the next lookup.
+         */
+        struct object_name_index {
+            std::unordered_multimap<std::string, kernel_obj_ptr> objects_;
+            bool dirty_ = false;
+        };
+
+        std::array<object_name_index, static_cast<std::size_t>(kernel::object_type::unk)> name_indices_;
+        std::unordered_map<std::string, common::wildcard_matcher> find_pattern_cache_;
+
+        std::vector<kernel_obj_unq_ptr> *get_object_container(const kernel::object_type type);
+        object_name_index &get_object_name_index(const kernel::object_type type);
+
+        void add_object_to_name_index(kernel_obj_ptr obj);
+        void remove_object_from_name_index(kernel_obj_ptr obj);
+
+        /**
+         * @brief Insert an object to its container, keeping the container sorted by unique ID.
+         *
+         * Objects are usually added in creation order, but some (like servers made by the HLE side)
+         * may be added long after their ID was taken. Lookups by ID binary search the containers.
+         *
+         * @returns The inserted object.
+         */
+        kernel_obj_ptr insert_object_sorted(std::vector<kernel_obj_unq_ptr> &container, kernel_obj_unq_ptr obj);
+
+        const common::wildcard_matcher &get_find_pattern(const std::string &pattern);
+        kernel_obj_ptr find_object_by_exact_name(const std::string &name, const kernel::uid start_after, kernel::object_type type,
+            const bool use_full_name, const bool case_sensitive);
+
+        void absorb_object_internals(common::chunkyseri &seri, kernel_obj_ptr obj);
+        std::uint64_t get_object_digest(kernel_obj_ptr obj);
+        std::vector<kernel::uid> get_ready_threads(const std::size_t core_index);
+        void requeue_ready_threads(const std::size_t core_index, const std::vector<kernel::uid> &order);
+
     protected:
         void setup_new_process(process_ptr pr);
 
@@ -375,6 +431,7 @@ namespace eka2l1 {
         bool cpu_exception_handle_unpredictable(arm::core *core, const address occurred);
         bool cpu_handle_access_violation(arm::core *core, const address occurred, const bool read);
         void cpu_exception_thread_handle(arm::core *core);
+        void install_core_handlers(arm::core *core);
 
     public:
         explicit kernel_system(system *esys, ntimer *timing, io_system *io_sys, config::state *conf,
@@ -385,10 +442,45 @@ namespace eka2l1 {
         void wipeout();
         void reset();
 
-        kernel::thread_scheduler *get_thread_scheduler() {
-            return thr_sch_.get();
+        /**
+         * @brief Get the scheduler of the core the calling host thread drives.
+         */
+        kernel::thread_scheduler *get_thread_scheduler();
+
+        kernel::thread_scheduler *get_core_scheduler(const std::size_t core_index);
+
+        std::size_t get_core_count() const {
+            return cores_.size();
         }
 
+        /**
+         * @brief Add a secondary core to the kernel.
+         * 
+         * The core gets its own sub-scheduler and a host thread that runs it. Threads are placed on it
+         * by the load balancer.
+         * 
+         * @param core The core to add. Its core number must be the next core index.
+         */
+        void add_core(arm::core *core);
+
+        /**
+         * @brief Set the core which the calling host thread drives.
+         */
+        void set_current_core(const std::size_t core_index);
+
+        /**
+         * @brief Choose the sub-scheduler that a new thread of the given process should be put on.
+         * 
+         * Threads of a process stay on one core, since most guest code is not SMP-safe.
+         */
+        kernel::thread_scheduler *pick_thread_scheduler(kernel::process *owner);
+
+        /**
+         * @brief Pause all secondary cores, waiting for their current timeslice to finish.
+         */
+        void pause_secondary_cores();
+        void resume_secondary_cores();
+
         bool cpu_exception_handler(arm::core *core, arm::exception_type exception_type, const std::uint32_t exception_data);
 
         void call_ipc_send_callbacks(const std::string &server_name, const int ord, const ipc_arg &args,
@@ -453,12 +545,19 @@ namespace eka2l1 {
 
         std::optional<find_handle> find_object(const std::string &name, int start, kernel::object_type type, const bool use_full_name = false);
 
+        /**
+         * @brief Mark the name index of an object type as outdated.
+         *
+         * Must be called when names of objects in the kernel change.
+         */
+        void invalidate_object_name_index(const kernel::object_type type);
+
         void add_custom_server(std::unique_ptr<service::server> &svr) {
             if (!svr.get()) {
                 return;
             }
 
-            servers_.push_back(std::move(svr));
+            insert_object_sorted(servers_, std::move(svr));
         }
 
         bool destroy(kernel_obj_ptr obj);
@@ -484,7 +583,26 @@ namespace eka2l1 {
             const std::uint32_t stack_size = 0);
 
         bool should_terminate();
-        void do_state(common::chunkyseri &seri);
+
+        /**
+         * @brief Save or restore the state of the guest machine.
+         *
+         * This covers CPU contexts of all threads, committed memory of all chunks, the ready queues,
+         * semaphore counts, property values and the guest clock. Pages with the same content are stored
+         * once, and pages filled with zero are not stored.
+         *
+         * HLE services keep their state on the host and it is not saved, so nothing is restored while a
+         * session to an HLE server is open. Restoring is done in place, within the same session: the kernel
+         * must hold the same objects it did when the state was saved, with the same IPC messages in flight,
+         * threads waiting on the same objects, and mutexes, timers and message queues in the same state,
+         * else nothing is restored. Cores must not be running guest code while this is called.
+         *
+         * @param seri       The serializer to save to or restore from.
+         * @param check_only When restoring, only check that the state can be restored, without applying it.
+         *
+         * @returns False if the state can't be restored.
+         */
+        bool do_state(common::chunkyseri &seri, const bool check_only = false);
 
         codeseg_ptr pull_codeseg_by_uids(const kernel::uid uid0, const kernel::uid uid1,
             const kernel::uid uid2);
@@ -526,6 +644,11 @@ namespace eka2l1 {
          */
         arm::core *get_cpu();
 
+        /**
+         * @brief Invalidate instruction cache of a range on all cores.
+         */
+        void imb_range(const address addr, const std::uint32_t size);
+
         int get_ipc_realtime_signal_event() const {
             return realtime_ipc_signal_evt_;
         }
@@ -604,45 +727,7 @@ namespace eka2l1 {
 
         template <typename T>
         T *get_by_name_and_type(const std::string &name, const kernel::object_type obj_type) {
-            switch (obj_type) {
-#define OBJECT_SEARCH(obj_type, obj_map)                                               \
-    case kernel::object_type::obj_type: {                                              \
-        auto res = std::find_if(obj_map.begin(), obj_map.end(), [&](const auto &rhs) { \
-            std::string the_full_name;                                                 \
-            rhs->full_name(the_full_name);                                             \
-            return the_full_name == name;                                              \
-        });                                                                            \
-        if (res == obj_map.end())                                                      \
-            return nullptr;                                                            \
-        return reinterpret_cast<T *>(res->get());                                      \
-    }
-
-                OBJECT_SEARCH(mutex, mutexes_)
-                OBJECT_SEARCH(sema, semas_)
-                OBJECT_SEARCH(condvar, condvars_)
-                OBJECT_SEARCH(chunk, chunks_)
-                OBJECT_SEARCH(thread, threads_)
-                OBJECT_SEARCH(process, processes_)
-                OBJECT_SEARCH(change_notifier, change_notifiers_)
-                OBJECT_SEARCH(library, libraries_)
-                OBJECT_SEARCH(codeseg, codesegs_)
-                OBJECT_SEARCH(server, servers_)
-                OBJECT_SEARCH(prop, props_)
-                OBJECT_SEARCH(prop_ref, prop_refs_)
-                OBJECT_SEARCH(session, sessions_)
-                OBJECT_SEARCH(timer, timers_)
-                OBJECT_SEARCH(msg_queue, message_queues_)
-                OBJECT_SEARCH(logical_device, logical_devices_)
-                OBJECT_SEARCH(logical_channel, logical_channels_)
-                OBJECT_SEARCH(undertaker, undertakers_)
-
-#undef OBJECT_SEARCH
-
-            default:
-                break;
-            }
-
-            return nullptr;
+            return reinterpret_cast<T *>(find_object_by_exact_name(name, 0, obj_type, true, true));
         }
 
         /*! \brief Get kernel object by name
@@ -708,8 +793,7 @@ namespace eka2l1 {
 #define ADD_OBJECT_TO_CONTAINER(type, container, additional_setup) \
     case type:                                                     \
         additional_setup;                                          \
-        container.push_back(std::move(obj));                       \
-        return reinterpret_cast<T *>(container.back().get());
+        return reinterpret_cast<T *>(insert_object_sorted(container, std::move(obj)));
 
             switch (obj_type) {
                 ADD_OBJECT_TO_CONTAINER(kernel::object_type::thread, threads_, )
@@ -791,6 +875,10 @@ namespace eka2l1 {
             kern_lock_.unlock();
         }
 
+        kernel_counters &get_counters() {
+            return counters_;
+        }
+
         void stop_cores_idling();
         bool should_core_idle_when_inactive();
 
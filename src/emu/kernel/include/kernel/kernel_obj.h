@@ -168,9 +168,7 @@ namespace eka2l1 {
              * @brief Rename the kernel object. 
              * @param new_name The new name of object.
              */
-            virtual void rename(const std::string &new_name) {
-                obj_name = new_name;
-            }
+            virtual void rename(const std::string &new_name);
 
             virtual void do_state(common::chunkyseri &seri);
         };
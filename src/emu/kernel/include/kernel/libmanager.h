@@ -67,6 +67,7 @@ namespace eka2l1 {
     namespace loader {
         struct e32img;
         struct romimg;
+        class e32img_cache;
 
         using e32img_ptr = std::shared_ptr<e32img>;
         using romimg_ptr = std::shared_ptr<romimg>;
@@ -136,6 +137,9 @@ namespace eka2l1 {
             std::vector<patch_pending_entry> patch_pendings_;
             std::map<address, address> trampoline_lookup_;
 
+            // Parsed E32 images stored on disk, to skip decompressing and parsing them on next load
+            std::unique_ptr<loader::e32img_cache> e32img_cache_;
+
         protected:
             const std::uint8_t *entry_points_call_routine_;
             const std::uint8_t *thread_entry_routine_;
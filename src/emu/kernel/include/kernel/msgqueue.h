@@ -33,6 +33,8 @@ namespace eka2l1::kernel {
     class thread;
 
     class msg_queue : public kernel_obj {
+        friend class eka2l1::kernel_system;
+
         std::uint32_t max_msg_length_;
         std::uint32_t max_length_;
 
@@ -30,6 +30,7 @@ namespace eka2l1 {
         */
         class mutex : public kernel_obj {
             friend class condvar;
+            friend class eka2l1::kernel_system;
 
             //! The lock count
             int lock_count;
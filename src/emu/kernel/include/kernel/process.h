@@ -279,6 +279,37 @@ namespace eka2l1::kernel {
 
         void *get_ptr_on_addr_space(address addr);
 
+        /**
+         * @brief Get the host pointer of a range in the address space, if the range is contiguous on the host.
+         *
+         * @param addr              Start address of the range.
+         * @param size              Size of the range in bytes.
+         *
+         * @returns Host pointer to the start of the range. Null if a page of the range is not mapped, or
+         *          does not follow the previous page in host memory.
+         */
+        void *get_contiguous_ptr_on_addr_space(const address addr, const std::uint32_t size);
+
+        /**
+         * @brief Copy data between a range of the address space and host memory, page by page.
+         *
+         * @param addr              Start address of the range.
+         * @param host              The host memory to copy from or to.
+         * @param size              Size of the range in bytes.
+         * @param to_addr_space     True to copy from the host memory to the address space.
+         *
+         * @returns False if a page of the range is not mapped.
+         */
+        bool copy_on_addr_space(const address addr, void *host, const std::uint32_t size, const bool to_addr_space);
+
+        /**
+         * @brief Report a write done by the host to memory of the address space, so write watchers see it.
+         *
+         * Writes through copy_on_addr_space are reported already. Writers to pointers got from
+         * get_ptr_on_addr_space or get_contiguous_ptr_on_addr_space must call this.
+         */
+        void note_host_write(const void *host_ptr, const std::size_t size);
+
         std::u16string get_cmd_args() const {
             return cmd_args;
         }
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <kernel/common.h>
+#include <mem/ptr.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace eka2l1 {
+    class kernel_system;
+    class ntimer;
+
+    namespace kernel {
+        class codeseg;
+        class process;
+
+        struct profiler_sample {
+            kernel::uid process_uid_ = 0;
+            kernel::uid thread_uid_ = 0;
+            address pc_ = 0;
+            address lr_ = 0;
+        };
+
+        /**
+         * \brief Ring of samples, with one producer and one consumer.
+         *
+         * Neither side ever blocks. The producer drops the sample when the ring is full.
+         */
+        class profiler_sample_ring {
+        public:
+            static constexpr std::size_t CAPACITY = 8192;
+
+        private:
+            std::array<profiler_sample, CAPACITY> samples_;
+
+            std::atomic<std::size_t> head_{ 0 }; ///< Next slot to be read.
+            std::atomic<std::size_t> tail_{ 0 }; ///< Next slot to be written.
+
+        public:
+            bool push(const profiler_sample &sample);
+            bool pop(profiler_sample &sample);
+        };
+
+        struct profiler_module {
+            std::string name_;
+            address begin_ = 0;
+            address end_ = 0;
+
+            std::vector<std::pair<address, std::uint32_t>> exports_; ///< Export address and ordinal, sorted by address.
+        };
+
+        /**
+         * \brief Map from guest code addresses to module and export.
+         *
+         * There is no symbol information in ROM or E32 images other than the export table, so an address
+         * is named after the nearest export before it, which is usually the function it belongs to.
+         */
+        class profiler_symbol_map {
+            std::map<kernel::uid, std::vector<profiler_module>> modules_; ///< Modules of each process. Key 0 is ROM code.
+
+            const profiler_module *find_module(const kernel::uid process_uid, const address addr) const;
+
+        public:
+            /**
+             * \brief Add a module.
+             *
+             * \param process_uid  UID of the process the code is mapped in, 0 if it's at the same address everywhere.
+             * \param mod          The module. Export list does not need to be sorted.
+             *
+             * \returns False if a module already starts at the same address.
+             */
+            bool add_module(const kernel::uid process_uid, profiler_module mod);
+
+            /**
+             * \brief Get the name of the function an address belongs to.
+             *
+             * \returns Either "module!ordN", "module" if it's before the first export, or "[unknown]".
+             */
+            std::string resolve(const kernel::uid process_uid, const address addr) const;
+        };
+
+        /**
+         * \brief Sampling profiler of guest code.
+         *
+         * The timing thread reads the PC and LR of each core's running thread at a fixed interval, without
+         * taking the kernel lock. Registers are read while the core may be running, so a sample may be slightly
+         * off, which does not matter in a statistical profile. With a JIT backend, the PC may also be the start
+         * of the block being run, rather than the exact instruction.
+         *
+         * Samples are resolved and aggregated in drain(), which the owner must call regularly, so the ring does
+         * not fill up. The profiler must be destroyed before the kernel is reset.
+         */
+        class guest_profiler {
+            kernel_system *kern_;
+            ntimer *timing_;
+
+            std::uint32_t interval_us_;
+            int sample_evt_;
+            std::size_t codeseg_loaded_cb_handle_;
+
+            std::atomic<bool> sampling_;
+            std::atomic<int> sampling_in_progress_;
+            std::atomic<std::uint64_t> dropped_count_;
+            std::atomic<std::uint64_t> idle_count_;
+
+            profiler_sample_ring ring_;
+
+            std::mutex lock_;
+            profiler_symbol_map symbols_;
+            std::map<kernel::uid, std::string> process_names_;
+
+            std::map<std::string, std::uint64_t> stacks_; ///< Collapsed stack and its sample count.
+            std::map<kernel::uid, std::map<std::string, std::uint64_t>> self_counts_;
+            std::uint64_t sample_count_;
+
+            void sample();
+            void add_codeseg(kernel::process *pr, kernel::codeseg *seg);
+            std::string get_process_name(const kernel::uid process_uid) const;
+
+        public:
+            explicit guest_profiler(kernel_system *kern, const std::uint32_t interval_us = 1000);
+            ~guest_profiler();
+
+            void start();
+            void stop();
+
+            /**
+             * \brief Resolve and aggregate samples taken so far.
+             */
+            void drain();
+
+            /**
+             * \brief Write samples in collapsed stack format, one "process;caller;function count" per line.
+             *
+             * The file can be given to flamegraph.pl, speedscope and similar tools.
+             */
+            bool write_collapsed_stacks(const std::string &path);
+
+            /**
+             * \brief Write a table of the functions with the most samples, for each process.
+             *
+             * \param path  Path to write the table to.
+             * \param top   Maximum number of functions listed per process.
+             */
+            bool write_top_report(const std::string &path, const std::size_t top = 30);
+
+            std::uint64_t sample_count() const {
+                return sample_count_;
+            }
+
+            std::uint64_t dropped_count() const {
+                return dropped_count_.load(std::memory_order_relaxed);
+            }
+
+            std::uint64_t idle_count() const {
+                return idle_count_.load(std::memory_order_relaxed);
+            }
+        };
+    }
+}
@@ -52,6 +52,8 @@ namespace eka2l1 {
  		 *
 		*/
         class property : public kernel::kernel_obj, public std::pair<int, int> {
+            friend class eka2l1::kernel_system;
+
         public:
             typedef void (*data_change_callback_handler)(void *userdata, service::property *prop);
 
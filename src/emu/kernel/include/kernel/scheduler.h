@@ -27,6 +27,7 @@
 #include <common/sync.h>
 
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
@@ -55,12 +56,18 @@ namespace eka2l1 {
 
         class thread_scheduler {
         private:
+            friend class eka2l1::kernel_system;
+
             kernel::thread *readys[64];
             std::uint32_t ready_mask[2]{ 0, 0 };
 
             kernel::thread *crr_thread;
             kernel::process *crr_process;
 
+            // Published for the profiler, which reads them without the kernel lock. Zero when idle.
+            std::atomic<uid> running_thread_uid_{ 0 };
+            std::atomic<uid> running_process_uid_{ 0 };
+
             ntimer *timing;
             kernel_system *kern;
             arm::core *run_core;
@@ -74,6 +81,8 @@ namespace eka2l1 {
             common::event idle_event;
 
         protected:
+            bool should_idle() const;
+
             kernel::thread *next_ready_thread();
             void switch_context(kernel::thread *oldt, kernel::thread *newt);
             void call_process_switch_callbacks(kernel::process *old, kernel::process *new_one);
@@ -84,6 +93,7 @@ namespace eka2l1 {
             ~thread_scheduler();
 
             void stop_idling();
+            void prepare_reschedule();
 
             void queue_thread_ready(kernel::thread *thr);
             void dequeue_thread_from_ready(kernel::thread *thr);
@@ -97,6 +107,12 @@ namespace eka2l1 {
             void unschedule(kernel::thread *thr);
             bool stop(kernel::thread *thr);
 
+            /**
+             * @brief   Move a thread that is not running to another core's scheduler.
+             * @returns False if the thread does not belong to this scheduler or is running.
+             */
+            bool migrate_thread(kernel::thread *thr, thread_scheduler *target);
+
             bool should_terminate() {
                 return false;
             }
@@ -108,6 +124,18 @@ namespace eka2l1 {
             kernel::process *current_process() const {
                 return crr_process;
             }
+
+            uid running_thread_uid() const {
+                return running_thread_uid_.load(std::memory_order_acquire);
+            }
+
+            uid running_process_uid() const {
+                return running_process_uid_.load(std::memory_order_acquire);
+            }
+
+            arm::core *get_core() const {
+                return run_core;
+            }
         };
     }
 }
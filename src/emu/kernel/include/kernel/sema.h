@@ -31,6 +31,8 @@ namespace eka2l1 {
 
     namespace kernel {
         class semaphore : public kernel_obj {
+            friend class eka2l1::kernel_system;
+
             int32_t avail_count;
             kernel::thread_priority_queue waits;
             common::roundabout suspended;
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <kernel/common.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace eka2l1 {
+    class kernel_system;
+    class ntimer;
+}
+
+namespace eka2l1::kernel::smp {
+    /**
+     * \brief Periodically spread thread groups across cores by their load.
+     * 
+     * A thread group here is all threads of one process. Guest code is mostly not written
+     * with SMP in mind, so threads of a process never run on different cores at the same time.
+     * 
+     * See README.txt for how load units and heaviness are decided.
+     */
+    class load_balancer {
+    public:
+        static constexpr std::int64_t REBALANCE_PERIOD_US = 107000;
+        static constexpr std::uint32_t HEAVY_LOAD_UNIT = 4095 * 90 / 100;
+        static constexpr std::uint32_t INACTIVE_LOAD_UNIT = 8;
+
+    private:
+        struct group_stat {
+            std::uint64_t last_active_time_ = 0;
+            bool seen_ = false;
+        };
+
+        kernel_system *kern_;
+        ntimer *timing_;
+
+        int rebalance_evt_;
+        std::uint64_t last_rebalance_time_;
+
+        std::unordered_map<kernel::uid, group_stat> stats_;
+
+        void schedule_next();
+
+    public:
+        explicit load_balancer(kernel_system *kern, ntimer *timing);
+        ~load_balancer();
+
+        /**
+         * \brief Do a balance pass. The kernel must be locked by the caller.
+         */
+        void rebalance();
+    };
+}
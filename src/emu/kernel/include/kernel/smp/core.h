@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/sync.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace eka2l1 {
+    class kernel_system;
+}
+
+namespace eka2l1::kernel::smp {
+    /**
+     * \brief Host thread that drives a secondary guest core.
+     * 
+     * Core 0 is still driven by the system loop. Every other core gets a runner, which runs
+     * the current thread of the core's sub-scheduler for a timeslice, then reschedules, the same
+     * way the system loop does.
+     * 
+     * Guest code runs without the kernel lock. Anything entering the kernel (system calls, reschedule)
+     * takes it, so kernel state is still only touched by one core at a time.
+     */
+    class core_runner {
+        kernel_system *kern_;
+        std::size_t core_index_;
+
+        std::unique_ptr<std::thread> thread_;
+        std::mutex run_lock_; ///< Held while the core executes a slice.
+
+        std::atomic<bool> should_stop_;
+        std::atomic<bool> should_pause_;
+
+        common::event resume_evt_;
+
+        void loop();
+        void interrupt();
+
+    public:
+        explicit core_runner(kernel_system *kern, const std::size_t core_index);
+        ~core_runner();
+
+        void start();
+
+        /**
+         * \brief Stop the host thread and wait for it to exit.
+         */
+        void stop();
+
+        /**
+         * \brief Pause the core, waiting for the slice it is executing to finish.
+         * 
+         * On return, the core does not run guest code nor touch the kernel until it's resumed.
+         */
+        void pause();
+        void resume();
+
+        bool is_running() const {
+            return thread_ != nullptr;
+        }
+    };
+}
@@ -41,6 +41,8 @@ namespace eka2l1 {
         };
 
         class timer : public kernel_obj {
+            friend class eka2l1::kernel_system;
+
             ntimer *timing;
             int callback_type;
 
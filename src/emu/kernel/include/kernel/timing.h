@@ -26,7 +26,9 @@
 #include <cstdint>
 #include <functional>
 #include <mutex>
+#include <optional>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace eka2l1 {
@@ -59,6 +61,125 @@ namespace eka2l1 {
         class chunkyseri;
     }
 
+    /**
+     * @brief Pending timer events, ordered by deadline.
+     *
+     * Events are kept in a 4-ary min-heap keyed by (deadline, schedule sequence), so events with
+     * the same deadline come out in the order they were scheduled. Each event is also linked into
+     * a list keyed by (event type, userdata), so cancelling only has to walk the matching events and
+     * flag one; cancelled entries are dropped when they reach the top of the heap, or swept out when
+     * they make up most of it.
+     *
+     * This class is not thread-safe.
+     */
+    class timer_queue {
+    public:
+        static constexpr std::uint32_t HEAP_ARITY = 4;
+        static constexpr std::uint32_t INVALID_SLOT = 0xFFFFFFFF;
+        static constexpr std::size_t MIN_CANCELLED_TO_SWEEP = 64;
+
+    private:
+        struct slot {
+            event evt;
+            std::uint64_t sequence;
+            std::uint32_t prev_same_key;
+            std::uint32_t next_same_key;
+            bool cancelled;
+        };
+
+        struct heap_node {
+            std::uint64_t event_time;
+            std::uint64_t sequence;
+            std::uint32_t slot_index;
+
+            bool operator<(const heap_node &rhs) const {
+                return (event_time < rhs.event_time) || ((event_time == rhs.event_time) && (sequence < rhs.sequence));
+            }
+        };
+
+        struct event_key {
+            int event_type;
+            std::uint64_t event_user_data;
+
+            bool operator==(const event_key &rhs) const {
+                return (event_type == rhs.event_type) && (event_user_data == rhs.event_user_data);
+            }
+        };
+
+        struct event_key_hash {
+            std::size_t operator()(const event_key &key) const {
+                return std::hash<std::uint64_t>()(key.event_user_data ^ (static_cast<std::uint64_t>(key.event_type) << 48));
+            }
+        };
+
+        std::vector<slot> slots_;
+        std::vector<std::uint32_t> free_slots_;
+        std::vector<heap_node> heap_;
+
+        // Most recently scheduled event of each (type, userdata) pair
+        std::unordered_map<event_key, std::uint32_t, event_key_hash> key_heads_;
+
+        std::uint64_t next_sequence_;
+        std::size_t cancelled_count_;
+
+        void sift_up(std::size_t pos);
+        void sift_down(std::size_t pos);
+
+        void remove_top();
+        void drop_cancelled_top();
+        void sweep_cancelled();
+
+        void link_slot(const std::uint32_t index);
+        void unlink_slot(const std::uint32_t index);
+        void free_slot(const std::uint32_t index);
+
+    public:
+        explicit timer_queue();
+
+        /**
+         * @brief Add an event to the queue.
+         */
+        void push(const event &evt);
+
+        /**
+         * @brief   Cancel the event with the latest deadline that matches the given type and userdata.
+         *
+         * Of matching events with the same deadline, the one scheduled first is cancelled.
+         *
+         * @returns True if an event was cancelled.
+         */
+        bool cancel(const int event_type, const std::uint64_t userdata);
+
+        /**
+         * @brief   Get the event with the earliest deadline.
+         * @returns Nullptr if there is no pending event.
+         */
+        const event *top();
+
+        /**
+         * @brief   Remove and return the event with the earliest deadline.
+         */
+        std::optional<event> pop();
+
+        void clear();
+
+        /**
+         * @brief Get all pending events, in the order they would be popped.
+         */
+        std::vector<event> pending() const;
+
+        /**
+         * @brief Number of pending events, excluding cancelled ones.
+         */
+        std::size_t size() const {
+            return heap_.size() - cancelled_count_;
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+    };
+
     class ntimer;
 
     /**
@@ -66,7 +187,7 @@ namespace eka2l1 {
      */
     class ntimer {
     private:
-        std::vector<event> events_;
+        timer_queue events_;
         std::mutex lock_;
 
         common::event new_event_evt_;
@@ -158,6 +279,21 @@ namespace eka2l1 {
         std::uint32_t get_clock_frequency_mhz();
 
         void set_realtime_level(const realtime_level lvl);
+
+        /**
+         * @brief Save or restore pending events.
+         *
+         * Deadlines are stored relative to the current time, so restored events fire as far in the
+         * future as they would have when saved. Event types must be registered the same way they
+         * were when the state was saved.
+         *
+         * @param seri       The serializer to save to or restore from.
+         * @param check_only When restoring, only check that the events can be restored, without applying them.
+         *
+         * @returns False if the state can't be restored. Nothing is changed in that case.
+         */
+        bool do_state(common::chunkyseri &seri, const bool check_only = false);
+
         realtime_level get_realtime_level() const {
             return acc_level_;
         }
@@ -240,6 +240,10 @@ namespace eka2l1 {
             return mmc_impl_->allocate(size);
         }
 
+        bool chunk::is_page_committed(const std::uint32_t page_index) {
+            return mmc_impl_->is_page_committed(page_index);
+        }
+
         void *chunk::host_base() {
             return mmc_impl_->host_base();
         }
@@ -56,6 +56,9 @@
 #include <config/config.h>
 
 namespace eka2l1 {
+    // The core that the calling host thread drives. Core 0 is driven by the system loop.
+    static thread_local std::size_t current_core_index = 0;
+
     void kernel_global_data::reset() {
         // Reset all these to 0
         char_set_.char_data_set_ = 0;
@@ -66,14 +69,13 @@ namespace eka2l1 {
         config::state *old_conf, config::app_settings *settings, loader::rom *rom_info, arm::core *cpu, disasm *disassembler)
         : btrace_inst_(nullptr)
         , lib_mngr_(nullptr)
-        , thr_sch_(nullptr)
         , timing_(timing)
         , io_(io_sys)
         , sys_(esys)
         , conf_(old_conf)
         , app_settings_(settings)
         , disassembler_(disassembler)
-        , cpu_(cpu)
+        , cores_({ cpu })
         , rom_info_(rom_info)
         , kernel_handles_(this, kernel::handle_array_owner::kernel)
         , realtime_ipc_signal_evt_(0)
@@ -94,11 +96,20 @@ namespace eka2l1 {
     }
 
     kernel_system::~kernel_system() {
+        for (auto &runner : core_runners_) {
+            runner->stop();
+        }
+
         wipeout();
     }
 
     void kernel_system::wipeout() {
         wiping_ = true;
+
+        // Secondary cores must not touch anything while objects are being destroyed
+        pause_secondary_cores();
+
+        balancer_.reset();
         timing_->remove_event(realtime_ipc_signal_evt_);
 
         if (rom_map_) {
@@ -143,14 +154,32 @@ namespace eka2l1 {
         if (btrace_inst_)
             btrace_inst_->close_trace_session();
 
-        cpu_->clear_instruction_cache();
+        for (auto &index : name_indices_) {
+            index.objects_.clear();
+            index.dirty_ = false;
+        }
+
+        find_pattern_cache_.clear();
+
+        for (arm::core *core : cores_) {
+            core->clear_instruction_cache();
+        }
+
         wiping_ = false;
     }
 
     void kernel_system::reset() {
         wipeout();
 
-        thr_sch_ = std::make_unique<kernel::thread_scheduler>(this, timing_, cpu_);
+        schedulers_.clear();
+
+        for (arm::core *core : cores_) {
+            schedulers_.push_back(std::make_unique<kernel::thread_scheduler>(this, timing_, core));
+        }
+
+        if (cores_.size() > 1) {
+            balancer_ = std::make_unique<kernel::smp::load_balancer>(this, timing_);
+        }
 
         // Instantiate btrace
         btrace_inst_ = std::make_unique<kernel::btrace>(this, io_);
@@ -181,7 +210,84 @@ namespace eka2l1 {
         dll_global_data_offset_.clear();
 
         // Clear CPU caches. No reason to keep it.
-        cpu_->clear_instruction_cache();
+        for (arm::core *core : cores_) {
+            core->clear_instruction_cache();
+        }
+
+        resume_secondary_cores();
+    }
+
+    void kernel_system::add_core(arm::core *core) {
+        assert(core->core_number() == cores_.size());
+
+        cores_.push_back(core);
+        schedulers_.push_back(std::make_unique<kernel::thread_scheduler>(this, timing_, core));
+
+        if (!balancer_) {
+            balancer_ = std::make_unique<kernel::smp::load_balancer>(this, timing_);
+        }
+
+        if (lib_mngr_) {
+            install_core_handlers(core);
+        }
+
+        core_runners_.push_back(std::make_unique<kernel::smp::core_runner>(this, cores_.size() - 1));
+        core_runners_.back()->start();
+    }
+
+    void kernel_system::set_current_core(const std::size_t core_index) {
+        current_core_index = core_index;
+    }
+
+    kernel::thread_scheduler *kernel_system::get_thread_scheduler() {
+        return get_core_scheduler(current_core_index);
+    }
+
+    kernel::thread_scheduler *kernel_system::get_core_scheduler(const std::size_t core_index) {
+        if (core_index >= schedulers_.size()) {
+            return nullptr;
+        }
+
+        return schedulers_[core_index].get();
+    }
+
+    kernel::thread_scheduler *kernel_system::pick_thread_scheduler(kernel::process *owner) {
+        if (schedulers_.size() == 1) {
+            return schedulers_[0].get();
+        }
+
+        // Keep the thread with the rest of its group
+        std::vector<std::size_t> thread_counts(schedulers_.size(), 0);
+
+        for (auto &thr_obj : threads_) {
+            kernel::thread *thr = reinterpret_cast<kernel::thread *>(thr_obj.get());
+
+            if (!thr || !thr->get_scheduler()) {
+                continue;
+            }
+
+            if (owner && (thr->owning_process() == owner)) {
+                return thr->get_scheduler();
+            }
+
+            thread_counts[thr->get_scheduler()->get_core()->core_number()]++;
+        }
+
+        // New group. Put it on the core with the least threads, the balancer will correct it later
+        return schedulers_[std::distance(thread_counts.begin(),
+            std::min_element(thread_counts.begin(), thread_counts.end()))].get();
+    }
+
+    void kernel_system::pause_secondary_cores() {
+        for (auto &runner : core_runners_) {
+            runner->pause();
+        }
+    }
+
+    void kernel_system::resume_secondary_cores() {
+        for (auto &runner : core_runners_) {
+            runner->resume();
+        }
     }
 
     void kernel_system::cpu_exception_thread_handle(arm::core *core) {
@@ -455,28 +561,48 @@ namespace eka2l1 {
         kern_ver_ = ver;
         lib_mngr_ = std::make_unique<hle::lib_manager>(this, io_, mem_);
 
+        for (arm::core *core : cores_) {
+            install_core_handlers(core);
+        }
+    }
+
+    void kernel_system::install_core_handlers(arm::core *core) {
         // Set CPU SVC handler
-        cpu_->system_call_handler = [this](const std::uint32_t ordinal) {
+        core->system_call_handler = [this, core](const std::uint32_t ordinal) {
+            // The call may wait for other cores, so let them reach into this one meanwhile
+            const bool was_in_guest = core->leave_guest();
+
             // crr_thread()->add_last_syscall(ordinal);
             get_lib_manager()->call_svc(ordinal);
 
             // EKA1 does not use BX LR to jump back, they let kernel do it
             if (is_eka1()) {
-                const std::uint32_t jump_back = cpu_->get_lr();
-                std::uint32_t cpsr = cpu_->get_cpsr() & ~0x20;
+                const std::uint32_t jump_back = core->get_lr();
+                std::uint32_t cpsr = core->get_cpsr() & ~0x20;
 
                 if (jump_back & 0b1) {
                     cpsr |= 0x20;
                 }
 
                 // Set pc and ARM/thumb flag
-                cpu_->set_pc(jump_back & ~0b1);
-                cpu_->set_cpsr(cpsr);
+                core->set_pc(jump_back & ~0b1);
+                core->set_cpsr(cpsr);
+            }
+
+            if (was_in_guest) {
+                core->enter_guest();
             }
         };
 
-        cpu_->exception_handler = [this](arm::exception_type exception_type, const std::uint32_t data) -> bool {
-            return cpu_exception_handler(cpu_, exception_type, data);
+        core->exception_handler = [this, core](arm::exception_type exception_type, const std::uint32_t data) -> bool {
+            const bool was_in_guest = core->leave_guest();
+            const bool result = cpu_exception_handler(core, exception_type, data);
+
+            if (was_in_guest) {
+                core->enter_guest();
+            }
+
+            return result;
         };
     }
 
@@ -556,25 +682,31 @@ namespace eka2l1 {
     }
 
     kernel::thread *kernel_system::crr_thread() {
-        return thr_sch_->current_thread();
+        return get_thread_scheduler()->current_thread();
     }
 
     kernel::process *kernel_system::crr_process() {
-        return thr_sch_->current_process();
+        return get_thread_scheduler()->current_process();
     }
 
     arm::core *kernel_system::get_cpu() {
-        return cpu_;
+        return cores_[current_core_index];
+    }
+
+    void kernel_system::imb_range(const address addr, const std::uint32_t size) {
+        for (arm::core *core : cores_) {
+            core->imb_range(addr, size);
+        }
     }
 
     void kernel_system::reschedule() {
         lock();
-        thr_sch_->reschedule();
+        get_thread_scheduler()->reschedule();
         unlock();
     }
 
     void kernel_system::unschedule_wakeup() {
-        thr_sch_->unschedule_wakeup();
+        get_thread_scheduler()->unschedule_wakeup();
     }
 
     void kernel_system::prepare_reschedule() {
@@ -760,6 +892,7 @@ namespace eka2l1 {
         });                                                                                                      \
         if (res == obj_map.end())                                                                                \
             return false;                                                                                        \
+        remove_object_from_name_index(res->get());                                                               \
         (*res)->destroy();                                                                                       \
         obj_map.erase(res);                                                                                      \
         return true;                                                                                             \
@@ -1159,102 +1292,252 @@ namespace eka2l1 {
         return reinterpret_cast<codeseg_ptr>(res->get());
     }
 
-    std::optional<find_handle> kernel_system::find_object(const std::string &name, int start, kernel::object_type type, const bool use_full_name) {
-        find_handle handle_find_info;
-        std::regex filter(common::wildcard_to_regex_string(name), std::regex_constants::icase);
-        start = (start & FIND_HANDLE_IDX_MASK) + 1;
-
-        // NOTE: See about the starting index of find handle info in the struct's document!
+    std::vector<kernel_obj_unq_ptr> *kernel_system::get_object_container(const kernel::object_type type) {
         switch (type) {
-#define OBJECT_SEARCH(obj_type, obj_map)                                                           \
-    case kernel::object_type::obj_type: {                                                          \
-        auto res = std::find_if(obj_map.begin() + start - 1, obj_map.end(), [&](const auto &rhs) { \
-            std::string to_compare = "";                                                           \
-            if (use_full_name) {                                                                   \
-                rhs->full_name(to_compare);                                                        \
-            } else {                                                                               \
-                to_compare = rhs->name();                                                          \
-            }                                                                                      \
-            return std::regex_match(to_compare, filter);                                           \
-        });                                                                                        \
-        if (res == obj_map.end())                                                                  \
-            return std::nullopt;                                                                   \
-        handle_find_info.index = ((static_cast<std::uint32_t>(std::distance(obj_map.begin(),       \
-                                       res))                                                       \
-                                      + 1)                                                         \
-                                     & FIND_HANDLE_IDX_MASK)                                       \
-            | (static_cast<std::uint32_t>(type) << FIND_HANDLE_OBJ_TYPE_SHIFT);                    \
-        handle_find_info.object_id = (*res)->unique_id();                                          \
-        handle_find_info.obj = reinterpret_cast<kernel_obj_ptr>(res->get());                       \
-        return handle_find_info;                                                                   \
+#define GET_CONTAINER(obj_type, container) \
+    case kernel::object_type::obj_type:    \
+        return &container;
+
+            GET_CONTAINER(mutex, mutexes_)
+            GET_CONTAINER(sema, semas_)
+            GET_CONTAINER(condvar, condvars_)
+            GET_CONTAINER(chunk, chunks_)
+            GET_CONTAINER(thread, threads_)
+            GET_CONTAINER(process, processes_)
+            GET_CONTAINER(change_notifier, change_notifiers_)
+            GET_CONTAINER(library, libraries_)
+            GET_CONTAINER(codeseg, codesegs_)
+            GET_CONTAINER(server, servers_)
+            GET_CONTAINER(prop, props_)
+            GET_CONTAINER(prop_ref, prop_refs_)
+            GET_CONTAINER(session, sessions_)
+            GET_CONTAINER(timer, timers_)
+            GET_CONTAINER(msg_queue, message_queues_)
+            GET_CONTAINER(logical_device, logical_devices_)
+            GET_CONTAINER(logical_channel, logical_channels_)
+            GET_CONTAINER(undertaker, undertakers_)
+
+#undef GET_CONTAINER
+
+        default:
+            break;
+        }
+
+        return nullptr;
     }
 
-            OBJECT_SEARCH(mutex, mutexes_)
-            OBJECT_SEARCH(sema, semas_)
-            OBJECT_SEARCH(condvar, condvars_)
-            OBJECT_SEARCH(chunk, chunks_)
-            OBJECT_SEARCH(thread, threads_)
-            OBJECT_SEARCH(process, processes_)
-            OBJECT_SEARCH(change_notifier, change_notifiers_)
-            OBJECT_SEARCH(library, libraries_)
-            OBJECT_SEARCH(codeseg, codesegs_)
-            OBJECT_SEARCH(server, servers_)
-            OBJECT_SEARCH(prop, props_)
-            OBJECT_SEARCH(prop_ref, prop_refs_)
-            OBJECT_SEARCH(session, sessions_)
-            OBJECT_SEARCH(timer, timers_)
-            OBJECT_SEARCH(msg_queue, message_queues_)
-            OBJECT_SEARCH(logical_device, logical_devices_)
-            OBJECT_SEARCH(logical_channel, logical_channels_)
-            OBJECT_SEARCH(undertaker, undertakers_)
+    kernel_system::object_name_index &kernel_system::get_object_name_index(const kernel::object_type type) {
+        object_name_index &index = name_indices_[static_cast<std::size_t>(type)];
 
-#undef OBJECT_SEARCH
+        if (index.dirty_) {
+            index.objects_.clear();
 
-        default:
-            break;
+            if (std::vector<kernel_obj_unq_ptr> *container = get_object_container(type)) {
+                for (auto &obj : *container) {
+                    index.objects_.emplace(common::lowercase_string(obj->name()), obj.get());
+                }
+            }
+
+            index.dirty_ = false;
+        }
+
+        return index;
+    }
+
+    void kernel_system::add_object_to_name_index(kernel_obj_ptr obj) {
+        const std::size_t type_index = static_cast<std::size_t>(obj->get_object_type());
+
+        // A dirty index picks the object up when it's rebuilt
+        if ((type_index >= name_indices_.size()) || name_indices_[type_index].dirty_) {
+            return;
+        }
+
+        name_indices_[type_index].objects_.emplace(common::lowercase_string(obj->name()), obj);
+    }
+
+    kernel_obj_ptr kernel_system::insert_object_sorted(std::vector<kernel_obj_unq_ptr> &container, kernel_obj_unq_ptr obj) {
+        // Most of the time the object is the newest one, so check the back first
+        auto pos = container.end();
+
+        if (!container.empty() && (container.back()->unique_id() > obj->unique_id())) {
+            pos = std::upper_bound(container.begin(), container.end(), obj->unique_id(), [](const kernel::uid lhs, const auto &rhs) {
+                return lhs < rhs->unique_id();
+            });
         }
 
-        return std::nullopt;
+        kernel_obj_ptr result = container.insert(pos, std::move(obj))->get();
+        add_object_to_name_index(result);
+
+        return result;
+    }
+
+    void kernel_system::remove_object_from_name_index(kernel_obj_ptr obj) {
+        const std::size_t type_index = static_cast<std::size_t>(obj->get_object_type());
+
+        if ((type_index >= name_indices_.size()) || name_indices_[type_index].dirty_) {
+            return;
+        }
+
+        auto &objects = name_indices_[type_index].objects_;
+        auto range = objects.equal_range(common::lowercase_string(obj->name()));
+
+        for (auto ite = range.first; ite != range.second; ite++) {
+            if (ite->second == obj) {
+                objects.erase(ite);
+                return;
+            }
+        }
+
+        // The name changed without anyone telling us. Rebuild on next lookup.
+        name_indices_[type_index].dirty_ = true;
+    }
+
+    void kernel_system::invalidate_object_name_index(const kernel::object_type type) {
+        const std::size_t type_index = static_cast<std::size_t>(type);
+
+        if (type_index < name_indices_.size()) {
+            name_indices_[type_index].objects_.clear();
+            name_indices_[type_index].dirty_ = true;
+        }
+    }
+
+    const common::wildcard_matcher &kernel_system::get_find_pattern(const std::string &pattern) {
+        static constexpr std::size_t MAX_CACHED_FIND_PATTERNS = 64;
+
+        auto ite = find_pattern_cache_.find(pattern);
+        if (ite != find_pattern_cache_.end()) {
+            return ite->second;
+        }
+
+        if (find_pattern_cache_.size() >= MAX_CACHED_FIND_PATTERNS) {
+            find_pattern_cache_.clear();
+        }
+
+        return find_pattern_cache_.emplace(pattern, common::wildcard_matcher(pattern, true)).first->second;
+    }
+
+    kernel_obj_ptr kernel_system::find_object_by_exact_name(const std::string &name, const kernel::uid start_after, kernel::object_type type,
+            const bool use_full_name, const bool case_sensitive) {
+        if (static_cast<std::size_t>(type) >= name_indices_.size()) {
+            return nullptr;
+        }
+
+        // Only the object's own name is indexed. Names can't contain colons, so with a full name,
+        // the part after the last separator is the key.
+        std::string key = common::lowercase_string(name);
+
+        if (use_full_name) {
+            const std::size_t last_sep = key.rfind("::");
+            if (last_sep != std::string::npos) {
+                key.erase(0, last_sep + 2);
+            }
+        }
+
+        const std::string name_lowered = common::lowercase_string(name);
+        auto range = get_object_name_index(type).objects_.equal_range(key);
+
+        kernel_obj_ptr result = nullptr;
+
+        for (auto ite = range.first; ite != range.second; ite++) {
+            kernel_obj_ptr obj = ite->second;
+
+            // Take the first one after the start point, in creation order
+            if ((obj->unique_id() <= start_after) || (result && (obj->unique_id() >= result->unique_id()))) {
+                continue;
+            }
+
+            if (use_full_name || case_sensitive) {
+                std::string to_compare;
+
+                if (use_full_name) {
+                    obj->full_name(to_compare);
+                } else {
+                    to_compare = obj->name();
+                }
+
+                if (case_sensitive ? (to_compare != name) : (common::lowercase_string(to_compare) != name_lowered)) {
+                    continue;
+                }
+            }
+
+            result = obj;
+        }
+
+        return result;
+    }
+
+    std::optional<find_handle> kernel_system::find_object(const std::string &name, int start, kernel::object_type type, const bool use_full_name) {
+        // NOTE: See about the index of find handle info in the struct's document!
+        const kernel::uid start_after = static_cast<kernel::uid>(start & FIND_HANDLE_IDX_MASK);
+        const common::wildcard_matcher &pattern = get_find_pattern(name);
+
+        kernel_obj_ptr result = nullptr;
+
+        if (!pattern.has_wildcard()) {
+            result = find_object_by_exact_name(name, start_after, type, use_full_name, false);
+        } else {
+            std::vector<kernel_obj_unq_ptr> *container = get_object_container(type);
+
+            if (!container) {
+                return std::nullopt;
+            }
+
+            auto ite = std::upper_bound(container->begin(), container->end(), start_after, [](const kernel::uid lhs, const auto &rhs) {
+                return lhs < rhs->unique_id();
+            });
+
+            for (; ite != container->end(); ite++) {
+                std::string to_compare;
+
+                if (use_full_name) {
+                    (*ite)->full_name(to_compare);
+                } else {
+                    to_compare = (*ite)->name();
+                }
+
+                if (pattern.match(to_compare)) {
+                    result = ite->get();
+                    break;
+                }
+            }
+        }
+
+        if (!result) {
+            return std::nullopt;
+        }
+
+        find_handle handle_find_info;
+        handle_find_info.index = (static_cast<std::uint32_t>(result->unique_id()) & FIND_HANDLE_IDX_MASK)
+            | (static_cast<std::uint32_t>(type) << FIND_HANDLE_OBJ_TYPE_SHIFT);
+        handle_find_info.object_id = result->unique_id();
+        handle_find_info.obj = result;
+
+        return handle_find_info;
     }
 
     kernel_obj_ptr kernel_system::get_object_from_find_handle(const std::uint32_t find_handle) {
-        const std::uint32_t index = (find_handle & FIND_HANDLE_IDX_MASK) - 1;
+        const kernel::uid uid = static_cast<kernel::uid>(find_handle & FIND_HANDLE_IDX_MASK);
         const kernel::object_type objtype = static_cast<kernel::object_type>(find_handle >> FIND_HANDLE_OBJ_TYPE_SHIFT);
 
-        switch (objtype) {
-#define GET_OBJECT(typename, container)   \
-    case kernel::object_type::typename: { \
-        if (index >= container.size())    \
-            return nullptr;               \
-        return container[index].get();    \
-    }
-            GET_OBJECT(mutex, mutexes_)
-            GET_OBJECT(sema, semas_)
-            GET_OBJECT(condvar, condvars_)
-            GET_OBJECT(chunk, chunks_)
-            GET_OBJECT(thread, threads_)
-            GET_OBJECT(process, processes_)
-            GET_OBJECT(change_notifier, change_notifiers_)
-            GET_OBJECT(library, libraries_)
-            GET_OBJECT(codeseg, codesegs_)
-            GET_OBJECT(server, servers_)
-            GET_OBJECT(prop, props_)
-            GET_OBJECT(prop_ref, prop_refs_)
-            GET_OBJECT(session, sessions_)
-            GET_OBJECT(timer, timers_)
-            GET_OBJECT(msg_queue, message_queues_)
+        std::vector<kernel_obj_unq_ptr> *container = get_object_container(objtype);
 
-        default:
-            break;
+        if (!container) {
+            return nullptr;
+        }
+
+        auto res = std::lower_bound(container->begin(), container->end(), uid, [](const auto &lhs, const kernel::uid rhs) {
+            return lhs->unique_id() < rhs;
+        });
 
-#undef GET_OBJECT
+        if ((res == container->end()) || ((*res)->unique_id() != uid)) {
+            return nullptr;
         }
 
-        return nullptr;
+        return res->get();
     }
 
     bool kernel_system::should_terminate() {
-        return thr_sch_->should_terminate();
+        return get_thread_scheduler()->should_terminate();
     }
 
     bool kernel_system::map_rom(const mem::vm_address addr, const std::string &path) {
@@ -1283,8 +1566,8 @@ namespace eka2l1 {
     }
 
     void kernel_system::stop_cores_idling() {
-        if (should_core_idle_when_inactive()) {
-            thr_sch_->stop_idling();
+        for (auto &scheduler : schedulers_) {
+            scheduler->stop_idling();
         }
     }
 
@@ -1385,14 +1668,6 @@ namespace eka2l1 {
         kernel_info() {}
     };
 
-    void kernel_system::do_state(common::chunkyseri &seri) {
-        auto s = seri.section("Kernel", 1);
-
-        if (!s) {
-            return;
-        }
-    }
-
     std::uint64_t kernel_system::universal_time() {
         return base_time_ + timing_->microseconds();
     }
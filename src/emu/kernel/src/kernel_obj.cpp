@@ -57,6 +57,14 @@ namespace eka2l1 {
             seri.absorb(access_count);
         }
 
+        void kernel_obj::rename(const std::string &new_name) {
+            obj_name = new_name;
+
+            if (kern) {
+                kern->invalidate_object_name_index(obj_type);
+            }
+        }
+
         void kernel_obj::full_name(std::string &name_will_full) {
             // If there is a owner and its access type is not global
             if (owner && (access != kernel::access_type::global_access)) {
@@ -34,6 +34,7 @@
 #include <config/config.h>
 
 #include <loader/e32img.h>
+#include <loader/e32img_cache.h>
 #include <loader/romimage.h>
 #include <mem/page.h>
 #include <utils/dll.h>
@@ -46,35 +47,6 @@
 #include <cctype>
 
 namespace eka2l1::hle {
-    // Given relocation entries, relocate the code and data
-    static bool build_relocation_list(const std::vector<loader::e32_reloc_entry> &entries, std::vector<std::uint64_t> &relocation_list, const loader::relocate_section sect) {
-        for (std::uint32_t i = 0; i < entries.size(); i++) {
-            const loader::e32_reloc_entry &entry = entries[i];
-
-            for (const auto &rel_info : entry.rels_info) {
-                // Get the lower 12 bit for virtual_address
-                const std::uint32_t virtual_addr = entry.base + (rel_info & 0x0FFF);
-                loader::relocation_type rel_type = static_cast<loader::relocation_type>(rel_info & 0xF000);
-
-                relocation_list.push_back((virtual_addr) | (static_cast<std::uint64_t>(rel_type) << 32) | (static_cast<std::uint64_t>(sect) << 48));
-            }
-        }
-
-        return true;
-    }
-
-    static bool build_relocation_list(std::vector<std::uint64_t> &relocation_list, loader::e32img *img) {
-        if (!build_relocation_list(img->code_reloc_section.entries, relocation_list, loader::relocate_section::relocate_section_text)) {
-            return false;
-        }
-
-        if ((img->header.bss_size) || (img->header.data_size)) {
-            return build_relocation_list(img->data_reloc_section.entries, relocation_list, loader::relocate_section::relocate_section_data);
-        }
-
-        return true;
-    }
-
     static std::string get_real_dll_name(std::string dll_name) {
         const std::string ext = eka2l1::path_extension(dll_name);
         size_t dll_name_end_pos = dll_name.find_first_of("{");
@@ -236,7 +208,7 @@ namespace eka2l1::hle {
         info.code_data = reinterpret_cast<std::uint8_t *>(&img->data[img->header.code_offset]);
 
         // Add relocation info in
-        build_relocation_list(info.relocation_list, img);
+        info.relocation_list = img->relocation_list;
 
         if (force_code_addr != 0) {
             info.code_load_addr = force_code_addr;
@@ -847,7 +819,7 @@ namespace eka2l1::hle {
 
                 eka2l1::ro_file_stream image_data_stream(f.get());
 
-                auto parse_result = loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_data_stream));
+                auto parse_result = e32img_cache_->load(reinterpret_cast<common::ro_stream *>(&image_data_stream));
                 if (parse_result != std::nullopt) {
                     f->close();
                     result.first = std::move(parse_result);
@@ -939,7 +911,7 @@ namespace eka2l1::hle {
 
                 return load_as_romimg(*romimg, lib_path);
             } else {
-                auto e32img = loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_data_stream));
+                auto e32img = e32img_cache_->load(reinterpret_cast<common::ro_stream *>(&image_data_stream));
                 if (!e32img) {
                     return nullptr;
                 }
@@ -1052,6 +1024,7 @@ namespace eka2l1::hle {
         }
 
         epoc_import_func func = res->second;
+        kern_->get_counters().svc_calls_.fetch_add(1, std::memory_order_relaxed);
 
         if (kern_->get_config()->log_svc) {
             LOG_TRACE(KERNEL, "Calling SVC 0x{:x} {}", svcnum, func.name);
@@ -1253,6 +1226,11 @@ namespace eka2l1::hle {
             break;
         }
 
+        std::string current_dir;
+        common::get_current_directory(current_dir);
+
+        e32img_cache_ = std::make_unique<loader::e32img_cache>(eka2l1::absolute_path("cache/e32img/", current_dir));
+
         if (kern_->is_eka1()) {
             search_paths.push_back(u"\\System\\Libs\\");
             search_paths.push_back(u"\\System\\Programs\\");
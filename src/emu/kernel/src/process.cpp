@@ -18,6 +18,7 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/algorithm.h>
 #include <common/chunkyseri.h>
 #include <common/cvt.h>
 #include <common/log.h>
@@ -35,6 +36,8 @@
 #include <mem/mmu.h>
 #include <mem/process.h>
 
+#include <cstring>
+
 namespace eka2l1::kernel {
     std::int32_t process::refresh_generation() {
         if (flags & FLAG_KERNEL_PROCESS) {
@@ -84,6 +87,9 @@ namespace eka2l1::kernel {
         codeseg = std::move(arg_codeseg);
         uids = codeseg->get_uids();
 
+        // The third UID is part of our name
+        kern->invalidate_object_name_index(kernel::object_type::process);
+
         // Attach this codeseg to our process
         codeseg->attach(this);
         codeseg->unmark();
@@ -322,6 +328,8 @@ namespace eka2l1::kernel {
         uids = std::move(type);
         generation_ = refresh_generation();
 
+        kern->invalidate_object_name_index(kernel::object_type::process);
+
         reload_compat_setting();
 
         kern->run_uid_of_process_change_callback(this, old_type);
@@ -387,7 +395,7 @@ namespace eka2l1::kernel {
     }
 
     bool process::run() {
-        return kern->get_thread_scheduler()->schedule(&(*primary_thread));
+        return primary_thread->get_scheduler()->schedule(&(*primary_thread));
     }
 
     std::uint32_t process::get_entry_point_address() {
@@ -453,6 +461,59 @@ namespace eka2l1::kernel {
         return mem->get_control()->get_host_pointer(mm_impl_->address_space_id(), addr);
     }
 
+    void *process::get_contiguous_ptr_on_addr_space(const address addr, const std::uint32_t size) {
+        std::uint8_t *start = reinterpret_cast<std::uint8_t *>(get_ptr_on_addr_space(addr));
+
+        if (!start || (size == 0)) {
+            return start;
+        }
+
+        const std::uint64_t page_size = mem->get_control()->page_size();
+        const std::uint64_t end = static_cast<std::uint64_t>(addr) + size;
+
+        // The range may cross into another chunk, or into a page that is not committed
+        for (std::uint64_t page = (addr & ~(page_size - 1)) + page_size; page < end; page += page_size) {
+            if (get_ptr_on_addr_space(static_cast<address>(page)) != start + (page - addr)) {
+                return nullptr;
+            }
+        }
+
+        return start;
+    }
+
+    bool process::copy_on_addr_space(const address addr, void *host, const std::uint32_t size, const bool to_addr_space) {
+        const std::uint64_t page_size = mem->get_control()->page_size();
+        std::uint8_t *host_bytes = reinterpret_cast<std::uint8_t *>(host);
+
+        std::uint64_t current = addr;
+        const std::uint64_t end = static_cast<std::uint64_t>(addr) + size;
+
+        while (current < end) {
+            const std::uint64_t copy_size = common::min<std::uint64_t>(end, (current & ~(page_size - 1)) + page_size) - current;
+            std::uint8_t *guest = reinterpret_cast<std::uint8_t *>(get_ptr_on_addr_space(static_cast<address>(current)));
+
+            if (!guest) {
+                return false;
+            }
+
+            if (to_addr_space) {
+                std::memcpy(guest, host_bytes, copy_size);
+                mem->note_host_write(guest, copy_size);
+            } else {
+                std::memcpy(host_bytes, guest, copy_size);
+            }
+
+            host_bytes += copy_size;
+            current += copy_size;
+        }
+
+        return true;
+    }
+
+    void process::note_host_write(const void *host_ptr, const std::size_t size) {
+        mem->note_host_write(host_ptr, size);
+    }
+
     // EKA2L1 doesn't use multicore yet, so rendezvous and logon
     // are just simple.
     void process::logon(eka2l1::ptr<epoc::request_status> logon_request, bool rendezvous) {
@@ -670,4 +731,16 @@ namespace eka2l1 {
     void *get_raw_pointer(kernel::process *pr, address addr) {
         return pr->get_ptr_on_addr_space(addr);
     }
+
+    void note_host_write(kernel::process *pr, const void *host_ptr, const std::size_t size) {
+        pr->note_host_write(host_ptr, size);
+    }
+
+    void *get_contiguous_raw_pointer(kernel::process *pr, address addr, const std::uint32_t size) {
+        return pr->get_contiguous_ptr_on_addr_space(addr, size);
+    }
+
+    bool copy_on_addr_space(kernel::process *pr, address addr, void *host, const std::uint32_t size, const bool to_addr_space) {
+        return pr->copy_on_addr_space(addr, host, size, to_addr_space);
+    }
 }
@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <kernel/codeseg.h>
+#include <kernel/kernel.h>
+#include <kernel/process.h>
+#include <kernel/profiler.h>
+#include <kernel/scheduler.h>
+#include <kernel/timing.h>
+
+#include <cpu/arm_interface.h>
+
+#include <common/fileutils.h>
+#include <common/log.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+namespace eka2l1::kernel {
+    bool profiler_sample_ring::push(const profiler_sample &sample) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail - head_.load(std::memory_order_acquire) >= CAPACITY) {
+            return false;
+        }
+
+        samples_[tail % CAPACITY] = sample;
+        tail_.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool profiler_sample_ring::pop(profiler_sample &sample) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        sample = samples_[head % CAPACITY];
+        head_.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool profiler_symbol_map::add_module(const kernel::uid process_uid, profiler_module mod) {
+        std::vector<profiler_module> &modules = modules_[process_uid];
+
+        auto ite = std::lower_bound(modules.begin(), modules.end(), mod.begin_, [](const profiler_module &lhs, const address rhs) {
+            return lhs.begin_ < rhs;
+        });
+
+        if ((ite != modules.end()) && (ite->begin_ == mod.begin_)) {
+            return false;
+        }
+
+        std::sort(mod.exports_.begin(), mod.exports_.end());
+        modules.insert(ite, std::move(mod));
+
+        return true;
+    }
+
+    const profiler_module *profiler_symbol_map::find_module(const kernel::uid process_uid, const address addr) const {
+        auto modules_ite = modules_.find(process_uid);
+
+        if (modules_ite == modules_.end()) {
+            return nullptr;
+        }
+
+        const std::vector<profiler_module> &modules = modules_ite->second;
+
+        auto ite = std::upper_bound(modules.begin(), modules.end(), addr, [](const address lhs, const profiler_module &rhs) {
+            return lhs < rhs.begin_;
+        });
+
+        if (ite == modules.begin()) {
+            return nullptr;
+        }
+
+        ite--;
+        return (addr < ite->end_) ? &(*ite) : nullptr;
+    }
+
+    std::string profiler_symbol_map::resolve(const kernel::uid process_uid, const address addr) const {
+        const profiler_module *mod = find_module(process_uid, addr);
+
+        if (!mod) {
+            mod = find_module(0, addr);
+        }
+
+        if (!mod) {
+            return "[unknown]";
+        }
+
+        auto ite = std::upper_bound(mod->exports_.begin(), mod->exports_.end(), addr,
+            [](const address lhs, const std::pair<address, std::uint32_t> &rhs) {
+                return lhs < rhs.first;
+            });
+
+        if (ite == mod->exports_.begin()) {
+            return mod->name_;
+        }
+
+        ite--;
+        return fmt::format("{}!ord{}", mod->name_, ite->second);
+    }
+
+    // Names end up in a collapsed stack line, where semicolons and spaces are separators
+    static std::string make_frame_name(std::string name) {
+        std::replace_if(name.begin(), name.end(), [](const char c) {
+            return (c == ';') || (c == ' ') || (c == '\n');
+        }, '_');
+
+        return name;
+    }
+
+    guest_profiler::guest_profiler(kernel_system *kern, const std::uint32_t interval_us)
+        : kern_(kern)
+        , timing_(kern->get_ntimer())
+        , interval_us_(std::max<std::uint32_t>(interval_us, 100))
+        , sample_evt_(-1)
+        , codeseg_loaded_cb_handle_(0)
+        , sampling_(false)
+        , sampling_in_progress_(0)
+        , dropped_count_(0)
+        , idle_count_(0)
+        , sample_count_(0) {
+        sample_evt_ = timing_->register_event("GuestProfilerSample", [this](std::uint64_t userdata, int cycles_late) {
+            sampling_in_progress_++;
+
+            if (sampling_.load(std::memory_order_acquire)) {
+                sample();
+                timing_->schedule_event(interval_us_, sample_evt_, 0);
+            }
+
+            sampling_in_progress_--;
+        });
+
+        kern_->lock();
+
+        // Pick up what's loaded already, later loads come from the callback
+        for (auto &seg_obj : kern_->get_codeseg_list()) {
+            kernel::codeseg *seg = reinterpret_cast<kernel::codeseg *>(seg_obj.get());
+
+            if (!seg) {
+                continue;
+            }
+
+            for (kernel::process *pr : seg->attached_processes()) {
+                add_codeseg(pr, seg);
+            }
+        }
+
+        codeseg_loaded_cb_handle_ = kern_->register_codeseg_loaded_callback([this](const std::string &name, kernel::process *attacher,
+                                                                                codeseg_ptr target) {
+            add_codeseg(attacher, target);
+        });
+
+        kern_->unlock();
+    }
+
+    guest_profiler::~guest_profiler() {
+        stop();
+
+        kern_->lock();
+        kern_->unregister_codeseg_loaded_callback(codeseg_loaded_cb_handle_);
+        kern_->unlock();
+
+        timing_->remove_event(sample_evt_);
+    }
+
+    void guest_profiler::start() {
+        if (sampling_.exchange(true)) {
+            return;
+        }
+
+        timing_->schedule_event(interval_us_, sample_evt_, 0);
+    }
+
+    void guest_profiler::stop() {
+        if (!sampling_.exchange(false)) {
+            return;
+        }
+
+        // A sample in progress may schedule the next one, so cancel after it's done
+        while (sampling_in_progress_.load() != 0) {
+            std::this_thread::yield();
+        }
+
+        timing_->unschedule_event(sample_evt_, 0);
+    }
+
+    void guest_profiler::sample() {
+        const std::size_t core_count = kern_->get_core_count();
+
+        for (std::size_t i = 0; i < core_count; i++) {
+            kernel::thread_scheduler *scheduler = kern_->get_core_scheduler(i);
+
+            if (!scheduler) {
+                continue;
+            }
+
+            profiler_sample sample;
+            sample.thread_uid_ = scheduler->running_thread_uid();
+
+            if (sample.thread_uid_ == 0) {
+                idle_count_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            arm::core *core = scheduler->get_core();
+
+            sample.process_uid_ = scheduler->running_process_uid();
+            sample.pc_ = core->get_pc();
+            sample.lr_ = core->get_lr();
+
+            if (!ring_.push(sample)) {
+                dropped_count_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void guest_profiler::add_codeseg(kernel::process *pr, kernel::codeseg *seg) {
+        if (!pr || !seg) {
+            return;
+        }
+
+        profiler_module mod;
+        mod.name_ = make_frame_name(seg->name());
+        mod.begin_ = seg->get_code_run_addr(pr);
+        mod.end_ = mod.begin_ + seg->get_code_size();
+
+        if (mod.begin_ == 0) {
+            return;
+        }
+
+        const std::vector<std::uint32_t> exports = seg->get_export_table(pr);
+
+        for (std::size_t i = 0; i < exports.size(); i++) {
+            // Clear the Thumb bit. Exports outside the code are data, and useless to name code
+            const address export_addr = exports[i] & ~1;
+
+            if ((export_addr >= mod.begin_) && (export_addr < mod.end_)) {
+                mod.exports_.emplace_back(export_addr, static_cast<std::uint32_t>(i + 1));
+            }
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        symbols_.add_module(seg->is_rom() ? 0 : pr->unique_id(), std::move(mod));
+        process_names_[pr->unique_id()] = make_frame_name(pr->name());
+    }
+
+    std::string guest_profiler::get_process_name(const kernel::uid process_uid) const {
+        auto ite = process_names_.find(process_uid);
+
+        if (ite == process_names_.end()) {
+            return fmt::format("process_{}", process_uid);
+        }
+
+        return ite->second;
+    }
+
+    void guest_profiler::drain() {
+        const std::lock_guard<std::mutex> guard(lock_);
+        profiler_sample sample;
+
+        while (ring_.pop(sample)) {
+            const std::string function = symbols_.resolve(sample.process_uid_, sample.pc_);
+            const std::string caller = symbols_.resolve(sample.process_uid_, sample.lr_ & ~1);
+
+            stacks_[fmt::format("{};{};{}", get_process_name(sample.process_uid_), caller, function)]++;
+            self_counts_[sample.process_uid_][function]++;
+
+            sample_count_++;
+        }
+    }
+
+    bool guest_profiler::write_collapsed_stacks(const std::string &path) {
+        drain();
+
+        FILE *file = common::open_c_file(path, "wb");
+
+        if (!file) {
+            LOG_ERROR(KERNEL, "Unable to open {} to write profiler stacks", path);
+            return false;
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        for (const auto &[stack, count] : stacks_) {
+            const std::string line = fmt::format("{} {}\n", stack, count);
+            fwrite(line.data(), 1, line.size(), file);
+        }
+
+        fclose(file);
+        return true;
+    }
+
+    bool guest_profiler::write_top_report(const std::string &path, const std::size_t top) {
+        drain();
+
+        FILE *file = common::open_c_file(path, "wb");
+
+        if (!file) {
+            LOG_ERROR(KERNEL, "Unable to open {} to write profiler report", path);
+            return false;
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        std::string report = fmt::format("{} samples every {}us, {} idle, {} dropped\n", sample_count_, interval_us_,
+            idle_count(), dropped_count());
+
+        for (const auto &[process_uid, counts] : self_counts_) {
+            std::vector<std::pair<std::string, std::uint64_t>> functions(counts.begin(), counts.end());
+            std::uint64_t process_total = 0;
+
+            for (const auto &function : functions) {
+                process_total += function.second;
+            }
+
+            std::sort(functions.begin(), functions.end(), [](const auto &lhs, const auto &rhs) {
+                return lhs.second > rhs.second;
+            });
+
+            report += fmt::format("\n{} ({} samples)\n", get_process_name(process_uid), process_total);
+
+            for (std::size_t i = 0; i < std::min(top, functions.size()); i++) {
+                report += fmt::format("{:>10} {:>7.2f}%  {}\n", functions[i].second,
+                    functions[i].second * 100.0 / process_total, functions[i].first);
+            }
+        }
+
+        fwrite(report.data(), 1, report.size(), file);
+        fclose(file);
+
+        return true;
+    }
+}
@@ -64,8 +64,17 @@ namespace eka2l1::kernel {
         stop_idling();
     }
 
+    bool thread_scheduler::should_idle() const {
+        // Secondary cores have nothing else to do while no thread is ready, so they always sleep
+        return (run_core->core_number() != 0) || kern->should_core_idle_when_inactive();
+    }
+
+    void thread_scheduler::prepare_reschedule() {
+        run_core->stop();
+    }
+
     void thread_scheduler::stop_idling() {
-        if (kern->should_core_idle_when_inactive()) {
+        if (should_idle()) {
             idle_event.set();
         }
     }
@@ -83,13 +92,12 @@ namespace eka2l1::kernel {
             oldt->decrease_access_count();
         }
 
-        memory_system *mem = kern->get_memory_system();
-
-        if (!core_mmu) {
-            core_mmu = mem->get_mmu(run_core);
-        }
-
         if (newt) {
+            // Secondary cores may reschedule before the memory system is installed, so get the MMU lazily here
+            if (!core_mmu) {
+                core_mmu = kern->get_memory_system()->get_mmu(run_core);
+            }
+
             // cancel wake up
             // timing->unschedule_event(wakeup_evt, newt->unique_id());
             crr_thread = newt;
@@ -121,13 +129,18 @@ namespace eka2l1::kernel {
             }
 
             run_core->load_context(crr_thread->ctx);
+
+            running_process_uid_.store(crr_process->unique_id(), std::memory_order_relaxed);
+            running_thread_uid_.store(crr_thread->unique_id(), std::memory_order_release);
+
             //LOG_TRACE(KERNEL, "Switched to {}", crr_thread->name());
         } else {
             // No current thread is eligible to run. Let the core that this scheduler currently handle sleeps.
             crr_thread = nullptr;
+            running_thread_uid_.store(0, std::memory_order_release);
 
             // Let free access to kernel now
-            if (kern->should_core_idle_when_inactive()) {
+            if (should_idle()) {
                 kern->unlock();
                 idle_event.wait();
                 idle_event.reset();
@@ -180,7 +193,7 @@ namespace eka2l1::kernel {
                 queue_thread_ready(old_friend);
             }
 
-            if (!next_thread && kern->should_core_idle_when_inactive()) {
+            if (!next_thread && should_idle()) {
                 // Use our old outdated friend, it seems only one thread exists
                 next_thread = old_friend;
             }
@@ -199,7 +212,7 @@ namespace eka2l1::kernel {
             thr->scheduler_link.previous = thr;
 
             // Well no need to idle anymore :D
-            if (kern->should_core_idle_when_inactive() && !crr_thread)
+            if (should_idle() && !crr_thread)
                 idle_event.set();
 
             return;
@@ -217,7 +230,7 @@ namespace eka2l1::kernel {
         readys[thr->real_priority]->scheduler_link.previous = thr;
 
         // Well no need to idle anymore :D
-        if (kern->should_core_idle_when_inactive() && !crr_thread)
+        if (should_idle() && !crr_thread)
             idle_event.set();
     }
 
@@ -263,7 +276,7 @@ namespace eka2l1::kernel {
         thr->state = thread_state::ready;
 
         queue_thread_ready(thr);
-        kern->prepare_reschedule();
+        prepare_reschedule();
 
         return true;
     }
@@ -301,7 +314,7 @@ namespace eka2l1::kernel {
         }
 
         dequeue_thread_from_ready(thr);
-        kern->prepare_reschedule();
+        prepare_reschedule();
 
         return true;
     }
@@ -326,7 +339,7 @@ namespace eka2l1::kernel {
 
         queue_thread_ready(thr);
 
-        kern->prepare_reschedule();
+        prepare_reschedule();
 
         return true;
     }
@@ -358,7 +371,28 @@ namespace eka2l1::kernel {
         thr->state = thread_state::stop;
 
         if (crr_thread == thr) {
-            kern->prepare_reschedule();
+            prepare_reschedule();
+        }
+
+        return true;
+    }
+
+    bool thread_scheduler::migrate_thread(kernel::thread *thr, thread_scheduler *target) {
+        if ((thr->scheduler != this) || (target == this) || (crr_thread == thr)) {
+            return false;
+        }
+
+        const bool in_ready_queue = (thr->state == thread_state::ready);
+
+        if (in_ready_queue) {
+            dequeue_thread_from_ready(thr);
+        }
+
+        thr->scheduler = target;
+
+        if (in_ready_queue) {
+            target->queue_thread_ready(thr);
+            target->prepare_reschedule();
         }
 
         return true;
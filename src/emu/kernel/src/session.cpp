@@ -171,6 +171,7 @@ namespace eka2l1 {
             msg->session_ptr_lle = cookie_address;
 
             in_progress_msgs_.push(&msg->session_msg_link);
+            kern->get_counters().ipc_messages_.fetch_add(1, std::memory_order_relaxed);
 
             return svr->deliver(msg);
         }
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <kernel/kernel.h>
+#include <kernel/process.h>
+#include <kernel/scheduler.h>
+#include <kernel/smp/avail.h>
+#include <kernel/smp/balancer.h>
+#include <kernel/thread.h>
+#include <kernel/timing.h>
+
+#include <cpu/arm_interface.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace eka2l1::kernel::smp {
+    struct thread_group {
+        kernel::process *owner_;
+        std::vector<kernel::thread *> threads_;
+        std::uint32_t load_unit_ = 0;
+        bool movable_ = true;
+    };
+
+    load_balancer::load_balancer(kernel_system *kern, ntimer *timing)
+        : kern_(kern)
+        , timing_(timing)
+        , rebalance_evt_(-1)
+        , last_rebalance_time_(0) {
+        rebalance_evt_ = timing_->register_event("SmpPeriodicRebalance", [this](std::uint64_t userdata, std::uint64_t cycles_late) {
+            kern_->lock();
+            rebalance();
+            kern_->unlock();
+
+            schedule_next();
+        });
+
+        last_rebalance_time_ = timing_->microseconds();
+        schedule_next();
+    }
+
+    load_balancer::~load_balancer() {
+        timing_->unschedule_event(rebalance_evt_, 0);
+        timing_->remove_event(rebalance_evt_);
+    }
+
+    void load_balancer::schedule_next() {
+        timing_->schedule_event(REBALANCE_PERIOD_US, rebalance_evt_, 0);
+    }
+
+    static std::uint32_t calculate_load_unit(const std::uint64_t delta, const std::uint64_t delta_time) {
+        if (delta_time == 0) {
+            return 0;
+        }
+
+        const std::uint64_t unit = ((std::min(delta, delta_time) * cpu_availability::idle_unit) + (delta_time / 2)) / delta_time;
+        return static_cast<std::uint32_t>(unit);
+    }
+
+    void load_balancer::rebalance() {
+        const std::size_t core_count = kern_->get_core_count();
+
+        if (core_count <= 1) {
+            return;
+        }
+
+        const std::uint64_t now = timing_->microseconds();
+        const std::uint64_t delta_time = now - last_rebalance_time_;
+
+        last_rebalance_time_ = now;
+
+        std::unordered_map<kernel::uid, thread_group> groups;
+
+        for (auto &thr_obj : kern_->get_thread_list()) {
+            kernel::thread *thr = reinterpret_cast<kernel::thread *>(thr_obj.get());
+
+            if (!thr || !thr->owning_process() || (thr->current_state() == kernel::thread_state::stop)) {
+                continue;
+            }
+
+            thread_group &group = groups[thr->owning_process()->unique_id()];
+            group.owner_ = thr->owning_process();
+            group.threads_.push_back(thr);
+        }
+
+        for (auto &stat : stats_) {
+            stat.second.seen_ = false;
+        }
+
+        std::vector<thread_group *> to_balance;
+
+        for (auto &[uid, group] : groups) {
+            std::uint64_t active_time = 0;
+
+            for (kernel::thread *thr : group.threads_) {
+                active_time += thr->get_real_active_time();
+
+                // Its context lives on the host core now, it can't be moved until switched out
+                for (std::size_t i = 0; i < core_count; i++) {
+                    if (kern_->get_core_scheduler(i)->current_thread() == thr) {
+                        group.movable_ = false;
+                    }
+                }
+            }
+
+            group_stat &stat = stats_[uid];
+            group.load_unit_ = calculate_load_unit(active_time - std::min(active_time, stat.last_active_time_), delta_time);
+
+            stat.last_active_time_ = active_time;
+            stat.seen_ = true;
+
+            // Barely ran since last time, leave it where it is
+            if (group.load_unit_ >= INACTIVE_LOAD_UNIT) {
+                to_balance.push_back(&group);
+            }
+        }
+
+        // Forget about processes that are gone
+        for (auto ite = stats_.begin(); ite != stats_.end();) {
+            if (!ite->second.seen_) {
+                ite = stats_.erase(ite);
+            } else {
+                ite++;
+            }
+        }
+
+        // Heaviest first, so each one gets the least loaded core left
+        std::sort(to_balance.begin(), to_balance.end(), [](const thread_group *lhs, const thread_group *rhs) {
+            return lhs->load_unit_ > rhs->load_unit_;
+        });
+
+        cpu_availability avail(static_cast<std::uint32_t>(core_count));
+
+        // Groups that can't move this time still take up their current core
+        for (thread_group *group : to_balance) {
+            if (!group->movable_) {
+                const std::uint32_t core_index = static_cast<std::uint32_t>(group->threads_[0]->get_scheduler()->get_core()->core_number());
+
+                if (group->load_unit_ >= HEAVY_LOAD_UNIT) {
+                    avail.set_load_max(core_index);
+                } else {
+                    avail.add_load(core_index, group->load_unit_);
+                }
+            }
+        }
+
+        for (thread_group *group : to_balance) {
+            if (!group->movable_) {
+                continue;
+            }
+
+            const std::uint32_t target_index = avail.find_lowest_load();
+
+            if (group->load_unit_ >= HEAVY_LOAD_UNIT) {
+                avail.set_load_max(target_index);
+            } else {
+                avail.add_load(target_index, group->load_unit_);
+            }
+
+            thread_scheduler *target = kern_->get_core_scheduler(target_index);
+
+            for (kernel::thread *thr : group->threads_) {
+                thr->get_scheduler()->migrate_thread(thr, target);
+            }
+        }
+    }
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ * 
+ * This file is part of EKA2L1 project.
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <kernel/kernel.h>
+#include <kernel/scheduler.h>
+#include <kernel/smp/core.h>
+#include <kernel/thread.h>
+
+#include <common/thread.h>
+#include <cpu/arm_interface.h>
+
+#include <fmt/format.h>
+
+namespace eka2l1::kernel::smp {
+    core_runner::core_runner(kernel_system *kern, const std::size_t core_index)
+        : kern_(kern)
+        , core_index_(core_index)
+        , should_stop_(false)
+        , should_pause_(false) {
+    }
+
+    core_runner::~core_runner() {
+        stop();
+    }
+
+    void core_runner::start() {
+        if (thread_) {
+            return;
+        }
+
+        should_stop_ = false;
+        resume_evt_.reset();
+
+        thread_ = std::make_unique<std::thread>([this]() {
+            loop();
+        });
+    }
+
+    void core_runner::interrupt() {
+        if (kernel::thread_scheduler *scheduler = kern_->get_core_scheduler(core_index_)) {
+            scheduler->prepare_reschedule();
+            scheduler->stop_idling();
+        }
+    }
+
+    void core_runner::stop() {
+        if (!thread_) {
+            return;
+        }
+
+        should_stop_ = true;
+
+        interrupt();
+        resume_evt_.set();
+
+        thread_->join();
+        thread_.reset();
+    }
+
+    void core_runner::pause() {
+        should_pause_ = true;
+        interrupt();
+
+        // Wait for the slice in progress to finish
+        const std::lock_guard<std::mutex> guard(run_lock_);
+    }
+
+    void core_runner::resume() {
+        should_pause_ = false;
+        resume_evt_.set();
+    }
+
+    void core_runner::loop() {
+        const std::string thread_name = fmt::format("Guest core {}", core_index_);
+
+        common::set_thread_name(thread_name.c_str());
+        kern_->set_current_core(core_index_);
+
+        while (!should_stop_) {
+            if (should_pause_) {
+                resume_evt_.wait();
+                continue;
+            }
+
+            const std::lock_guard<std::mutex> guard(run_lock_);
+
+            // Check again, pause may have slipped in before we took the lock
+            if (should_pause_ || should_stop_) {
+                continue;
+            }
+
+            kernel::thread_scheduler *scheduler = kern_->get_core_scheduler(core_index_);
+
+            if (!scheduler) {
+                continue;
+            }
+
+            arm::core *run_core = scheduler->get_core();
+            kernel::thread *to_run = scheduler->current_thread();
+
+            if (to_run) {
+                run_core->enter_guest();
+                run_core->run(to_run->get_remaining_screenticks());
+                run_core->leave_guest();
+
+                const std::uint32_t executed = run_core->get_num_instruction_executed();
+                to_run->add_ticks(executed);
+
+                kern_->get_counters().instructions_executed_.fetch_add(executed, std::memory_order_relaxed);
+            }
+
+            // Sleeps inside when there's nothing to run on this core
+            kern_->reschedule();
+        }
+    }
+}
@@ -0,0 +1,732 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/chunkyseri.h>
+#include <common/log.h>
+
+#include <cpu/arm_interface.h>
+#include <kernel/chunk.h>
+#include <kernel/condvar.h>
+#include <kernel/ipc.h>
+#include <kernel/kernel.h>
+#include <kernel/msgqueue.h>
+#include <kernel/mutex.h>
+#include <kernel/property.h>
+#include <kernel/scheduler.h>
+#include <kernel/sema.h>
+#include <kernel/thread.h>
+#include <kernel/timer.h>
+#include <kernel/timing.h>
+#include <mem/control.h>
+#include <mem/mem.h>
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <xxhash.h>
+
+namespace eka2l1 {
+    // Page reference of a page filled with zero, which content is not stored
+    static constexpr std::uint32_t SNAPSHOT_ZERO_PAGE = 0xFFFFFFFF;
+
+    struct snapshot_object {
+        kernel::object_type type_;
+        kernel::uid uid_;
+        std::vector<std::uint8_t> internals_; ///< State restored in place, which depends on the object type.
+        std::uint64_t digest_; ///< Digest of state that is not restored, which must not have changed to restore.
+
+        void do_state(common::chunkyseri &seri) {
+            seri.absorb(type_);
+            seri.absorb(uid_);
+            seri.absorb_container(internals_);
+            seri.absorb(digest_);
+        }
+
+        bool operator==(const snapshot_object &rhs) const {
+            return (type_ == rhs.type_) && (uid_ == rhs.uid_);
+        }
+    };
+
+    /**
+     * \brief An IPC message in use. HLE services don't save their state, so messages in flight must match.
+     */
+    struct snapshot_message {
+        std::uint32_t slot_;
+        kernel::uid thread_uid_;
+        kernel::uid session_uid_;
+        std::int32_t function_;
+        address request_status_;
+        ipc_message_status status_;
+
+        void do_state(common::chunkyseri &seri) {
+            seri.absorb(slot_);
+            seri.absorb(thread_uid_);
+            seri.absorb(session_uid_);
+            seri.absorb(function_);
+            seri.absorb(request_status_);
+            seri.absorb(status_);
+        }
+
+        bool operator==(const snapshot_message &rhs) const {
+            return (slot_ == rhs.slot_) && (thread_uid_ == rhs.thread_uid_) && (session_uid_ == rhs.session_uid_)
+                && (function_ == rhs.function_) && (request_status_ == rhs.request_status_) && (status_ == rhs.status_);
+        }
+    };
+
+    struct snapshot_ready_queue {
+        std::vector<kernel::uid> threads_; ///< Ready threads, by priority then by the order they run in.
+
+        void do_state(common::chunkyseri &seri) {
+            seri.absorb_container(threads_);
+        }
+    };
+
+    struct snapshot_thread {
+        kernel::uid uid_;
+        kernel::thread_state state_;
+        kernel::uid wait_obj_uid_;
+        arm::core::thread_context ctx_;
+
+        void do_state(common::chunkyseri &seri) {
+            seri.absorb(uid_);
+            seri.absorb(state_);
+            seri.absorb(wait_obj_uid_);
+
+            for (std::uint32_t &reg : ctx_.cpu_registers) {
+                seri.absorb(reg);
+            }
+
+            for (std::uint32_t &reg : ctx_.fpu_registers) {
+                seri.absorb(reg);
+            }
+
+            seri.absorb(ctx_.cpsr);
+            seri.absorb(ctx_.fpscr);
+            seri.absorb(ctx_.uprw);
+        }
+    };
+
+    struct snapshot_page_run {
+        std::uint32_t start_;
+        std::uint32_t count_;
+
+        void do_state(common::chunkyseri &seri) {
+            seri.absorb(start_);
+            seri.absorb(count_);
+        }
+    };
+
+    struct snapshot_chunk {
+        kernel::uid uid_;
+        std::uint32_t page_count_;
+        std::uint32_t bottom_page_;
+        std::uint32_t top_page_;
+
+        std::vector<snapshot_page_run> runs_; ///< Committed pages.
+        std::vector<std::uint32_t> page_refs_; ///< Content of each committed page, in the order of the runs.
+
+        void do_state(common::chunkyseri &seri) {
+            seri.absorb(uid_);
+            seri.absorb(page_count_);
+            seri.absorb(bottom_page_);
+            seri.absorb(top_page_);
+            seri.absorb_container_do(runs_);
+            seri.absorb_container(page_refs_);
+        }
+    };
+
+    /**
+     * \brief Collect committed pages, storing each distinct content once.
+     */
+    struct snapshot_page_collector {
+        std::uint32_t page_size_;
+        std::uint64_t zero_page_hash_;
+
+        std::vector<const std::uint8_t *> pages_;
+        std::unordered_map<std::uint64_t, std::uint32_t> page_indices_;
+
+        explicit snapshot_page_collector(const std::uint32_t page_size)
+            : page_size_(page_size) {
+            const std::vector<std::uint8_t> zero_page(page_size, 0);
+            zero_page_hash_ = XXH64(zero_page.data(), page_size, 0);
+        }
+
+        bool is_zero(const std::uint8_t *page) const {
+            for (std::uint32_t i = 0; i < page_size_; i++) {
+                if (page[i] != 0) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        std::uint32_t add(const std::uint8_t *page) {
+            const std::uint64_t hash = XXH64(page, page_size_, 0);
+
+            if ((hash == zero_page_hash_) && is_zero(page)) {
+                return SNAPSHOT_ZERO_PAGE;
+            }
+
+            auto ite = page_indices_.find(hash);
+
+            if (ite != page_indices_.end()) {
+                if (std::memcmp(pages_[ite->second], page, page_size_) == 0) {
+                    return ite->second;
+                }
+            } else {
+                page_indices_.emplace(hash, static_cast<std::uint32_t>(pages_.size()));
+            }
+
+            // On a hash collision, the page is just stored again
+            pages_.push_back(page);
+            return static_cast<std::uint32_t>(pages_.size() - 1);
+        }
+    };
+
+    static snapshot_chunk make_chunk_snapshot(kernel::chunk *target, snapshot_page_collector &collector) {
+        snapshot_chunk result;
+        const std::uint32_t page_size = collector.page_size_;
+
+        result.uid_ = target->unique_id();
+        result.page_count_ = static_cast<std::uint32_t>(target->max_size() / page_size);
+        result.bottom_page_ = target->bottom_offset() / page_size;
+        result.top_page_ = target->top_offset() / page_size;
+
+        const std::uint8_t *host = reinterpret_cast<const std::uint8_t *>(target->host_base());
+
+        if (!host) {
+            return result;
+        }
+
+        for (std::uint32_t i = 0; i < result.page_count_; i++) {
+            if (!target->is_page_committed(i)) {
+                continue;
+            }
+
+            if (result.runs_.empty() || (result.runs_.back().start_ + result.runs_.back().count_ != i)) {
+                result.runs_.push_back(snapshot_page_run{ i, 0 });
+            }
+
+            result.runs_.back().count_++;
+            result.page_refs_.push_back(collector.add(host + static_cast<std::size_t>(i) * page_size));
+        }
+
+        return result;
+    }
+
+    static bool is_chunk_snapshot_valid(const snapshot_chunk &state, const std::uint32_t page_content_count) {
+        std::size_t total_pages = 0;
+
+        for (const snapshot_page_run &run : state.runs_) {
+            if ((run.start_ > state.page_count_) || (run.count_ > state.page_count_ - run.start_)) {
+                return false;
+            }
+
+            total_pages += run.count_;
+        }
+
+        if (total_pages != state.page_refs_.size()) {
+            return false;
+        }
+
+        for (const std::uint32_t ref : state.page_refs_) {
+            if ((ref != SNAPSHOT_ZERO_PAGE) && (ref >= page_content_count)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Check that saved internals have exactly the layout absorb_object_internals reads.
+     */
+    static bool is_object_internals_valid(const snapshot_object &state) {
+        switch (state.type_) {
+        case kernel::object_type::sema:
+            return state.internals_.size() == sizeof(std::int32_t);
+
+        case kernel::object_type::prop: {
+            std::uint32_t bin_size = 0;
+
+            if (state.internals_.size() < sizeof(int) + sizeof(std::uint32_t)) {
+                return false;
+            }
+
+            std::memcpy(&bin_size, state.internals_.data() + sizeof(int), sizeof(std::uint32_t));
+            return state.internals_.size() == sizeof(int) + sizeof(std::uint32_t) + bin_size;
+        }
+
+        default:
+            break;
+        }
+
+        return state.internals_.empty();
+    }
+
+    static void restore_chunk_commit_state(kernel::chunk *target, const snapshot_chunk &state, const std::uint32_t page_size) {
+        switch (target->get_chunk_type()) {
+        case kernel::chunk_type::normal:
+            target->adjust(static_cast<std::size_t>(state.top_page_) * page_size);
+            return;
+
+        case kernel::chunk_type::double_ended:
+            target->adjust_de(static_cast<std::size_t>(state.bottom_page_) * page_size,
+                static_cast<std::size_t>(state.top_page_) * page_size);
+            return;
+
+        default:
+            break;
+        }
+
+        std::vector<bool> should_commit(state.page_count_, false);
+
+        for (const snapshot_page_run &run : state.runs_) {
+            std::fill(should_commit.begin() + run.start_, should_commit.begin() + run.start_ + run.count_, true);
+        }
+
+        // Commit and decommit in runs of pages that need the same change
+        std::uint32_t i = 0;
+
+        while (i < state.page_count_) {
+            const bool commit = should_commit[i];
+
+            if (target->is_page_committed(i) == commit) {
+                i++;
+                continue;
+            }
+
+            std::uint32_t end = i + 1;
+
+            while ((end < state.page_count_) && (should_commit[end] == commit) && (target->is_page_committed(end) != commit)) {
+                end++;
+            }
+
+            if (commit) {
+                target->commit(i * page_size, (end - i) * page_size);
+            } else {
+                target->decommit(i * page_size, (end - i) * page_size);
+            }
+
+            i = end;
+        }
+    }
+
+    void kernel_system::absorb_object_internals(common::chunkyseri &seri, kernel_obj_ptr obj) {
+        switch (obj->get_object_type()) {
+        case kernel::object_type::sema:
+            seri.absorb(reinterpret_cast<kernel::semaphore *>(obj)->avail_count);
+            break;
+
+        case kernel::object_type::prop: {
+            service::property *prop = reinterpret_cast<service::property *>(obj);
+
+            // Subscribers are not notified, the value goes back to what they saw before
+            seri.absorb(prop->ndata);
+            seri.absorb_container(prop->bindata);
+
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    std::uint64_t kernel_system::get_object_digest(kernel_obj_ptr obj) {
+        std::vector<std::uint64_t> fields;
+
+        switch (obj->get_object_type()) {
+        case kernel::object_type::thread: {
+            kernel::thread *thr = reinterpret_cast<kernel::thread *>(obj);
+            fields = { static_cast<std::uint64_t>(thr->real_priority), static_cast<std::uint64_t>(thr->last_priority),
+                static_cast<std::uint64_t>(thr->priority), static_cast<std::uint64_t>(thr->exit_type) };
+
+            break;
+        }
+
+        case kernel::object_type::mutex: {
+            kernel::mutex *mut = reinterpret_cast<kernel::mutex *>(obj);
+            fields = { static_cast<std::uint64_t>(mut->lock_count), mut->holding ? mut->holding->unique_id() : 0 };
+
+            break;
+        }
+
+        case kernel::object_type::condvar: {
+            kernel::condvar *cond = reinterpret_cast<kernel::condvar *>(obj);
+            fields = { cond->holding_ ? cond->holding_->unique_id() : 0 };
+
+            break;
+        }
+
+        case kernel::object_type::timer: {
+            kernel::timer *tmr = reinterpret_cast<kernel::timer *>(obj);
+            const epoc::notify_info &nof = tmr->info.done_nof;
+
+            fields = { tmr->outstanding, nof.sts.ptr_address(), nof.requester ? nof.requester->unique_id() : 0 };
+            break;
+        }
+
+        case kernel::object_type::msg_queue: {
+            kernel::msg_queue *queue = reinterpret_cast<kernel::msg_queue *>(obj);
+            std::queue<std::vector<std::uint8_t>> msgs = queue->msgs_;
+
+            fields = { msgs.size(), queue->avail_notifies_.size(), queue->free_notifies_.size() };
+
+            for (; !msgs.empty(); msgs.pop()) {
+                fields.push_back(XXH64(msgs.front().data(), msgs.front().size(), 0));
+            }
+
+            break;
+        }
+
+        default:
+            return 0;
+        }
+
+        return XXH64(fields.data(), fields.size() * sizeof(std::uint64_t), 0);
+    }
+
+    std::vector<kernel::uid> kernel_system::get_ready_threads(const std::size_t core_index) {
+        kernel::thread_scheduler *scheduler = schedulers_[core_index].get();
+        std::vector<kernel::uid> result;
+
+        for (int priority = 63; priority >= 0; priority--) {
+            kernel::thread *first = scheduler->readys[priority];
+            kernel::thread *thr = first;
+
+            while (thr) {
+                result.push_back(thr->unique_id());
+                thr = thr->scheduler_link.next;
+
+                if (thr == first) {
+                    break;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    void kernel_system::requeue_ready_threads(const std::size_t core_index, const std::vector<kernel::uid> &order) {
+        kernel::thread_scheduler *scheduler = schedulers_[core_index].get();
+
+        for (const kernel::uid id : get_ready_threads(core_index)) {
+            scheduler->dequeue_thread_from_ready(get_by_id<kernel::thread>(id));
+        }
+
+        // Each thread goes to the back of its priority's queue
+        for (const kernel::uid id : order) {
+            scheduler->queue_thread_ready(get_by_id<kernel::thread>(id));
+        }
+    }
+
+    bool kernel_system::do_state(common::chunkyseri &seri, const bool check_only) {
+        auto s = seri.section("Kernel", 1);
+
+        if (!s) {
+            return false;
+        }
+
+        const bool reading = (seri.get_seri_mode() == common::SERI_MODE_READ);
+
+        auto collect_objects = [this](const bool with_internals) {
+            std::vector<snapshot_object> result;
+
+            for (int type = 0; type < static_cast<int>(kernel::object_type::unk); type++) {
+                const kernel::object_type obj_type = static_cast<kernel::object_type>(type);
+
+                if (std::vector<kernel_obj_unq_ptr> *container = get_object_container(obj_type)) {
+                    for (const kernel_obj_unq_ptr &obj : *container) {
+                        snapshot_object state{ obj_type, obj->unique_id(), {}, get_object_digest(obj.get()) };
+
+                        if (with_internals) {
+                            common::chunkyseri measurer(nullptr, 0, common::SERI_MODE_MEASURE);
+                            absorb_object_internals(measurer, obj.get());
+
+                            state.internals_.resize(measurer.size());
+
+                            common::chunkyseri writer(state.internals_.data(), state.internals_.size(), common::SERI_MODE_WRITE);
+                            absorb_object_internals(writer, obj.get());
+                        }
+
+                        result.push_back(std::move(state));
+                    }
+                }
+            }
+
+            return result;
+        };
+
+        auto find_object = [this](const snapshot_object &state) -> kernel_obj_ptr {
+            std::vector<kernel_obj_unq_ptr> *container = get_object_container(state.type_);
+
+            if (!container) {
+                return nullptr;
+            }
+
+            // Objects are sorted by unique ID
+            auto ite = std::lower_bound(container->begin(), container->end(), state.uid_,
+                [](const kernel_obj_unq_ptr &obj, const kernel::uid uid) { return obj->unique_id() < uid; });
+
+            return ((ite != container->end()) && ((*ite)->unique_id() == state.uid_)) ? ite->get() : nullptr;
+        };
+
+        auto collect_messages = [this]() {
+            std::vector<snapshot_message> result;
+
+            for (std::size_t i = 0; i < msgs_.size(); i++) {
+                ipc_msg *msg = msgs_[i].get();
+
+                if (!msg || ((msg->msg_status != ipc_message_status::delivered) && (msg->msg_status != ipc_message_status::accepted))) {
+                    continue;
+                }
+
+                result.push_back(snapshot_message{ static_cast<std::uint32_t>(i), msg->own_thr ? msg->own_thr->unique_id() : 0,
+                    msg->msg_session ? msg->msg_session->unique_id() : 0, msg->function, msg->request_sts.ptr_address(), msg->msg_status });
+            }
+
+            return result;
+        };
+
+        std::vector<snapshot_object> objects;
+        std::vector<snapshot_thread> threads;
+        std::vector<kernel::uid> running_threads;
+        std::vector<snapshot_ready_queue> ready_queues;
+        std::vector<snapshot_message> messages;
+        std::vector<snapshot_chunk> chunks;
+
+        std::uint32_t page_size = static_cast<std::uint32_t>(mem_->get_page_size());
+        snapshot_page_collector collector(page_size);
+
+        std::uint64_t universal = 0;
+        kernel::uid uid_counter = 0;
+
+        if (!reading) {
+            universal = universal_time();
+            uid_counter = uid_counter_.load();
+
+            for (std::size_t i = 0; i < schedulers_.size(); i++) {
+                kernel::thread *running = schedulers_[i]->current_thread();
+
+                // The running thread's context only lives in its core
+                if (running) {
+                    cores_[i]->save_context(running->ctx);
+                }
+
+                running_threads.push_back(running ? running->unique_id() : 0);
+                ready_queues.push_back(snapshot_ready_queue{ get_ready_threads(i) });
+            }
+
+            objects = collect_objects(true);
+            messages = collect_messages();
+
+            for (const kernel_obj_unq_ptr &obj : threads_) {
+                kernel::thread *thr = reinterpret_cast<kernel::thread *>(obj.get());
+                threads.push_back(snapshot_thread{ thr->unique_id(), thr->state, thr->wait_obj ? thr->wait_obj->unique_id() : 0, thr->ctx });
+            }
+
+            for (const kernel_obj_unq_ptr &obj : chunks_) {
+                chunks.push_back(make_chunk_snapshot(reinterpret_cast<kernel::chunk *>(obj.get()), collector));
+            }
+        }
+
+        seri.absorb(universal);
+        seri.absorb(uid_counter);
+        seri.absorb(page_size);
+        seri.absorb_container_do(objects);
+        seri.absorb_container_do(threads);
+        seri.absorb_container(running_threads);
+        seri.absorb_container_do(ready_queues);
+        seri.absorb_container_do(messages);
+        seri.absorb_container_do(chunks);
+
+        std::uint32_t page_content_count = static_cast<std::uint32_t>(collector.pages_.size());
+        seri.absorb(page_content_count);
+
+        const std::uint8_t *page_contents = seri.current();
+        const std::size_t page_contents_size = static_cast<std::size_t>(page_content_count) * page_size;
+
+        if (!reading) {
+            for (const std::uint8_t *page : collector.pages_) {
+                seri.absorb_impl(const_cast<std::uint8_t *>(page), page_size);
+            }
+
+            return true;
+        }
+
+        // Check everything before touching anything, a state that does not fit is not partially restored
+        if ((seri.left() < page_contents_size) || (page_size != static_cast<std::uint32_t>(mem_->get_page_size()))) {
+            LOG_ERROR(KERNEL, "Kernel state is truncated or was saved with a different page size");
+            return false;
+        }
+
+        seri.absorb_impl(nullptr, page_contents_size);
+
+        // HLE services keep what their clients did on the host, and that is not in the state
+        for (const kernel_obj_unq_ptr &obj : sessions_) {
+            service::server *svr = reinterpret_cast<service::session *>(obj.get())->get_server();
+
+            if (svr && svr->is_hle()) {
+                LOG_ERROR(KERNEL, "A session to HLE server {} is open, its state can't be restored", svr->name());
+                return false;
+            }
+        }
+
+        const std::vector<snapshot_object> current_objects = collect_objects(false);
+
+        if (current_objects != objects) {
+            LOG_ERROR(KERNEL, "Kernel objects changed since the state was saved, can't restore it");
+            return false;
+        }
+
+        for (std::size_t i = 0; i < objects.size(); i++) {
+            if (current_objects[i].digest_ != objects[i].digest_) {
+                LOG_ERROR(KERNEL, "Kernel object {} changed in a way that can't be restored since the state was saved", objects[i].uid_);
+                return false;
+            }
+        }
+
+        if (collect_messages() != messages) {
+            LOG_ERROR(KERNEL, "IPC messages in flight changed since the state was saved, can't restore it");
+            return false;
+        }
+
+        if ((running_threads.size() != schedulers_.size()) || (ready_queues.size() != schedulers_.size())) {
+            LOG_ERROR(KERNEL, "State was saved with {} cores, but there are {} now", running_threads.size(), schedulers_.size());
+            return false;
+        }
+
+        for (std::size_t i = 0; i < schedulers_.size(); i++) {
+            kernel::thread *running = schedulers_[i]->current_thread();
+
+            if ((running ? running->unique_id() : 0) != running_threads[i]) {
+                LOG_ERROR(KERNEL, "Core {} runs a different thread than when the state was saved, can't restore it", i);
+                return false;
+            }
+
+            // Threads may have been run in a different order, but the same ones must be ready
+            std::vector<kernel::uid> saved_ready = ready_queues[i].threads_;
+            std::vector<kernel::uid> current_ready = get_ready_threads(i);
+
+            std::sort(saved_ready.begin(), saved_ready.end());
+            std::sort(current_ready.begin(), current_ready.end());
+
+            if (saved_ready != current_ready) {
+                LOG_ERROR(KERNEL, "Core {} has different threads ready than when the state was saved, can't restore it", i);
+                return false;
+            }
+        }
+
+        for (const snapshot_thread &state : threads) {
+            kernel::thread *thr = get_by_id<kernel::thread>(state.uid_);
+            const kernel::uid wait_obj_uid = (thr && thr->wait_obj) ? thr->wait_obj->unique_id() : 0;
+
+            if (!thr || (thr->state != state.state_) || (wait_obj_uid != state.wait_obj_uid_)) {
+                LOG_ERROR(KERNEL, "Thread {} is not waiting on what it was when the state was saved, can't restore it",
+                    thr ? thr->name() : std::to_string(state.uid_));
+                return false;
+            }
+        }
+
+        for (const snapshot_chunk &state : chunks) {
+            kernel::chunk *target = get_by_id<kernel::chunk>(state.uid_);
+
+            if (!target || (target->max_size() / page_size != state.page_count_) || !is_chunk_snapshot_valid(state, page_content_count)) {
+                LOG_ERROR(KERNEL, "Saved memory of chunk {} is corrupted or does not fit the chunk", state.uid_);
+                return false;
+            }
+        }
+
+        for (const snapshot_object &state : objects) {
+            if (!is_object_internals_valid(state)) {
+                LOG_ERROR(KERNEL, "Saved state of kernel object {} is corrupted", state.uid_);
+                return false;
+            }
+        }
+
+        if (check_only) {
+            return true;
+        }
+
+        // Restore memory. Only pages that changed are written to, and reported to the write watcher.
+        mem::write_watcher &watcher = mem_->get_control()->get_write_watcher();
+        const std::vector<std::uint8_t> zero_page(page_size, 0);
+
+        for (const snapshot_chunk &state : chunks) {
+            kernel::chunk *target = get_by_id<kernel::chunk>(state.uid_);
+            restore_chunk_commit_state(target, state, page_size);
+
+            std::uint8_t *host = reinterpret_cast<std::uint8_t *>(target->host_base());
+            std::size_t ref_index = 0;
+
+            if (!host) {
+                continue;
+            }
+
+            for (const snapshot_page_run &run : state.runs_) {
+                for (std::uint32_t i = run.start_; i < run.start_ + run.count_; i++) {
+                    const std::uint32_t ref = state.page_refs_[ref_index++];
+                    const std::uint8_t *content = (ref == SNAPSHOT_ZERO_PAGE) ? zero_page.data()
+                                                                              : page_contents + static_cast<std::size_t>(ref) * page_size;
+
+                    std::uint8_t *page = host + static_cast<std::size_t>(i) * page_size;
+
+                    if (std::memcmp(page, content, page_size) != 0) {
+                        std::memcpy(page, content, page_size);
+                        watcher.note_write(page, page_size);
+                    }
+                }
+            }
+        }
+
+        for (snapshot_object &state : objects) {
+            if (!state.internals_.empty()) {
+                common::chunkyseri reader(state.internals_.data(), state.internals_.size(), common::SERI_MODE_READ);
+                absorb_object_internals(reader, find_object(state));
+            }
+        }
+
+        for (const snapshot_thread &state : threads) {
+            get_by_id<kernel::thread>(state.uid_)->ctx = state.ctx_;
+        }
+
+        for (std::size_t i = 0; i < schedulers_.size(); i++) {
+            requeue_ready_threads(i, ready_queues[i].threads_);
+
+            kernel::thread *running = schedulers_[i]->current_thread();
+
+            if (running) {
+                cores_[i]->load_context(running->ctx);
+            }
+
+            // Code may have been restored too
+            cores_[i]->clear_instruction_cache();
+            cores_[i]->flush_tlb();
+        }
+
+        uid_counter_ = uid_counter;
+        base_time_ = universal - timing_->microseconds();
+
+        return true;
+    }
+}
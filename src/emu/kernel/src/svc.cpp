@@ -1476,7 +1476,7 @@ namespace eka2l1::epoc {
             }
         }
 
-        kern->get_cpu()->imb_range(addr.ptr_address(), size);
+        kern->imb_range(addr.ptr_address(), size);
     }
 
     /********************/
@@ -2292,7 +2292,7 @@ namespace eka2l1::epoc {
 
         switch (thr->current_state()) {
         case kernel::thread_state::create: {
-            kern->get_thread_scheduler()->schedule(&(*thr));
+            thr->get_scheduler()->schedule(&(*thr));
             break;
         }
 
@@ -3115,7 +3115,7 @@ namespace eka2l1::epoc {
         codeseg_ptr ss = get_codeseg_from_addr(kern, process_to_operate, addr, false);
 
         if (ss) {
-            kern->get_cpu()->imb_range(addr, len);
+            kern->imb_range(addr, len);
         }
 
         return epoc::error_none;
@@ -360,7 +360,7 @@ namespace eka2l1 {
 
             reset_thread_ctx(epa, stack_top, thread_free_modify_local_storage_vptr, initial);
 
-            scheduler = kern->get_thread_scheduler();
+            scheduler = kern->pick_thread_scheduler(owner);
             wait_object_timeout_callback_type = timing->get_register_event("ThreadWaitObjectTimeoutCallbackType");
 
             if (wait_object_timeout_callback_type == -1) {
@@ -574,7 +574,7 @@ namespace eka2l1 {
                 mama->kill(exit_type, exit_category, exit_reason);
             }
 
-            kern->prepare_reschedule();
+            scheduler->prepare_reschedule();
             decrease_access_count();
 
             return true;
@@ -624,7 +624,10 @@ namespace eka2l1 {
         void thread::set_priority(const thread_priority new_pri) {
             priority = new_pri;
             update_priority();
-            kern->prepare_reschedule();
+
+            if (scheduler) {
+                scheduler->prepare_reschedule();
+            }
         }
 
         void thread::wait_for_any_request() {
@@ -32,6 +32,249 @@
 #include <vector>
 
 namespace eka2l1 {
+    timer_queue::timer_queue()
+        : next_sequence_(0)
+        , cancelled_count_(0) {
+    }
+
+    void timer_queue::sift_up(std::size_t pos) {
+        const heap_node node = heap_[pos];
+
+        while (pos > 0) {
+            const std::size_t parent = (pos - 1) / HEAP_ARITY;
+            if (!(node < heap_[parent])) {
+                break;
+            }
+
+            heap_[pos] = heap_[parent];
+            pos = parent;
+        }
+
+        heap_[pos] = node;
+    }
+
+    void timer_queue::sift_down(std::size_t pos) {
+        const heap_node node = heap_[pos];
+        const std::size_t count = heap_.size();
+
+        while (true) {
+            const std::size_t first_child = pos * HEAP_ARITY + 1;
+            if (first_child >= count) {
+                break;
+            }
+
+            const std::size_t last_child = std::min<std::size_t>(first_child + HEAP_ARITY, count);
+            std::size_t smallest = first_child;
+
+            for (std::size_t child = first_child + 1; child < last_child; child++) {
+                if (heap_[child] < heap_[smallest]) {
+                    smallest = child;
+                }
+            }
+
+            if (!(heap_[smallest] < node)) {
+                break;
+            }
+
+            heap_[pos] = heap_[smallest];
+            pos = smallest;
+        }
+
+        heap_[pos] = node;
+    }
+
+    void timer_queue::link_slot(const std::uint32_t index) {
+        slot &target = slots_[index];
+        const event_key key{ target.evt.event_type, target.evt.event_user_data };
+
+        auto result = key_heads_.emplace(key, index);
+        target.prev_same_key = INVALID_SLOT;
+        target.next_same_key = INVALID_SLOT;
+
+        if (!result.second) {
+            target.next_same_key = result.first->second;
+            slots_[result.first->second].prev_same_key = index;
+            result.first->second = index;
+        }
+    }
+
+    void timer_queue::unlink_slot(const std::uint32_t index) {
+        slot &target = slots_[index];
+
+        if (target.next_same_key != INVALID_SLOT) {
+            slots_[target.next_same_key].prev_same_key = target.prev_same_key;
+        }
+
+        if (target.prev_same_key != INVALID_SLOT) {
+            slots_[target.prev_same_key].next_same_key = target.next_same_key;
+        } else {
+            const event_key key{ target.evt.event_type, target.evt.event_user_data };
+
+            if (target.next_same_key == INVALID_SLOT) {
+                key_heads_.erase(key);
+            } else {
+                key_heads_[key] = target.next_same_key;
+            }
+        }
+
+        target.prev_same_key = INVALID_SLOT;
+        target.next_same_key = INVALID_SLOT;
+    }
+
+    void timer_queue::free_slot(const std::uint32_t index) {
+        free_slots_.push_back(index);
+    }
+
+    void timer_queue::remove_top() {
+        heap_[0] = heap_.back();
+        heap_.pop_back();
+
+        if (!heap_.empty()) {
+            sift_down(0);
+        }
+    }
+
+    void timer_queue::drop_cancelled_top() {
+        while (!heap_.empty() && slots_[heap_[0].slot_index].cancelled) {
+            free_slot(heap_[0].slot_index);
+            remove_top();
+
+            cancelled_count_--;
+        }
+    }
+
+    void timer_queue::sweep_cancelled() {
+        std::size_t kept = 0;
+
+        for (std::size_t i = 0; i < heap_.size(); i++) {
+            if (slots_[heap_[i].slot_index].cancelled) {
+                free_slot(heap_[i].slot_index);
+                continue;
+            }
+
+            heap_[kept++] = heap_[i];
+        }
+
+        heap_.resize(kept);
+        cancelled_count_ = 0;
+
+        // Rebuild from the last parent upwards
+        if (kept > 1) {
+            for (std::size_t i = (kept - 2) / HEAP_ARITY + 1; i-- > 0;) {
+                sift_down(i);
+            }
+        }
+    }
+
+    void timer_queue::push(const event &evt) {
+        std::uint32_t index = 0;
+
+        if (!free_slots_.empty()) {
+            index = free_slots_.back();
+            free_slots_.pop_back();
+        } else {
+            index = static_cast<std::uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+
+        slots_[index].evt = evt;
+        slots_[index].sequence = next_sequence_++;
+        slots_[index].cancelled = false;
+
+        link_slot(index);
+
+        heap_.push_back(heap_node{ evt.event_time, slots_[index].sequence, index });
+        sift_up(heap_.size() - 1);
+    }
+
+    bool timer_queue::cancel(const int event_type, const std::uint64_t userdata) {
+        auto ite = key_heads_.find(event_key{ event_type, userdata });
+        if (ite == key_heads_.end()) {
+            return false;
+        }
+
+        std::uint32_t index = ite->second;
+
+        for (std::uint32_t candidate = slots_[index].next_same_key; candidate != INVALID_SLOT;
+             candidate = slots_[candidate].next_same_key) {
+            const slot &current = slots_[candidate];
+            const slot &best = slots_[index];
+
+            if ((current.evt.event_time > best.evt.event_time) || ((current.evt.event_time == best.evt.event_time) && (current.sequence < best.sequence))) {
+                index = candidate;
+            }
+        }
+
+        unlink_slot(index);
+        slots_[index].cancelled = true;
+
+        cancelled_count_++;
+
+        if ((cancelled_count_ >= MIN_CANCELLED_TO_SWEEP) && (cancelled_count_ * 2 > heap_.size())) {
+            sweep_cancelled();
+        }
+
+        return true;
+    }
+
+    const event *timer_queue::top() {
+        drop_cancelled_top();
+
+        if (heap_.empty()) {
+            return nullptr;
+        }
+
+        return &slots_[heap_[0].slot_index].evt;
+    }
+
+    std::optional<event> timer_queue::pop() {
+        drop_cancelled_top();
+
+        if (heap_.empty()) {
+            return std::nullopt;
+        }
+
+        const std::uint32_t index = heap_[0].slot_index;
+        const event evt = slots_[index].evt;
+
+        unlink_slot(index);
+        free_slot(index);
+        remove_top();
+
+        return evt;
+    }
+
+    void timer_queue::clear() {
+        slots_.clear();
+        free_slots_.clear();
+        heap_.clear();
+        key_heads_.clear();
+
+        cancelled_count_ = 0;
+    }
+
+    std::vector<event> timer_queue::pending() const {
+        std::vector<heap_node> nodes;
+        nodes.reserve(heap_.size());
+
+        for (const heap_node &node : heap_) {
+            if (!slots_[node.slot_index].cancelled) {
+                nodes.push_back(node);
+            }
+        }
+
+        std::sort(nodes.begin(), nodes.end());
+
+        std::vector<event> events;
+        events.reserve(nodes.size());
+
+        for (const heap_node &node : nodes) {
+            events.push_back(slots_[node.slot_index].evt);
+        }
+
+        return events;
+    }
+
     ntimer::ntimer(const std::uint32_t cpu_hz) {
         CPU_HZ_ = cpu_hz;
         should_stop_ = false;
@@ -143,14 +386,10 @@ namespace eka2l1 {
         std::unique_lock<std::mutex> unq(lock_);
         std::uint64_t global_timer = teletimer_->microseconds();
 
-        while (!events_.empty() && events_.back().event_time <= global_timer) {
-            event evt = std::move(events_.back());
-            events_.pop_back();
-
-            std::stable_sort(events_.begin(), events_.end(), [](const event &lhs, const event &rhs) {
-                return lhs.event_time > rhs.event_time;
-            });
+        const event *next = events_.top();
 
+        while (next && next->event_time <= global_timer) {
+            const event evt = events_.pop().value();
             unq.unlock();
 
             if (event_types_[evt.event_type].callback) {
@@ -159,10 +398,11 @@ namespace eka2l1 {
             }
 
             unq.lock();
+            next = events_.top();
         }
 
-        if (!events_.empty()) {
-            return static_cast<std::uint64_t>(events_.back().event_time - global_timer);
+        if (next) {
+            return static_cast<std::uint64_t>(next->event_time - global_timer);
         }
 
         return std::nullopt;
@@ -177,12 +417,10 @@ namespace eka2l1 {
         evt.event_type = event_type;
         evt.event_user_data = userdata;
 
-        bool should_nof = (events_.empty()) || (events_.back().event_time > evt.event_time);
-        events_.push_back(evt);
+        const event *next = events_.top();
+        const bool should_nof = (!next) || (next->event_time > evt.event_time);
 
-        std::stable_sort(events_.begin(), events_.end(), [](const event &lhs, const event &rhs) {
-            return lhs.event_time > rhs.event_time;
-        });
+        events_.push(evt);
 
         if (should_nof) {
             new_event_evt_.set();
@@ -192,20 +430,7 @@ namespace eka2l1 {
     bool ntimer::unschedule_event(int event_type, uint64_t userdata) {
         const std::lock_guard<std::mutex> guard(lock_);
 
-        auto res = std::find_if(events_.begin(), events_.end(),
-            [&](auto evt) { return (evt.event_type == event_type) && (evt.event_user_data == userdata); });
-
-        if (res != events_.end()) {
-            events_.erase(res);
-
-            std::stable_sort(events_.begin(), events_.end(), [](const event &lhs, const event &rhs) {
-                return lhs.event_time > rhs.event_time;
-            });
-
-            return true;
-        }
-
-        return false;
+        return events_.cancel(event_type, userdata);
     }
 
     bool ntimer::set_clock_frequency_mhz(const std::uint32_t cpu_mhz) {
@@ -265,6 +490,71 @@ namespace eka2l1 {
         event_types_.clear();
     }
 
+    bool ntimer::do_state(common::chunkyseri &seri, const bool check_only) {
+        auto s = seri.section("Timing", 1);
+
+        if (!s) {
+            return false;
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+        const std::uint64_t now = teletimer_->microseconds();
+
+        std::vector<event> events;
+
+        if (seri.get_seri_mode() != common::SERI_MODE_READ) {
+            events = events_.pending();
+        }
+
+        std::uint32_t count = static_cast<std::uint32_t>(events.size());
+        seri.absorb(count);
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            events.resize(count);
+        }
+
+        for (event &evt : events) {
+            std::string type_name;
+            std::uint64_t delay = 0;
+
+            if (seri.get_seri_mode() != common::SERI_MODE_READ) {
+                type_name = event_types_[evt.event_type].name;
+                delay = (evt.event_time > now) ? (evt.event_time - now) : 0;
+            }
+
+            seri.absorb(evt.event_type);
+            seri.absorb(type_name);
+            seri.absorb(delay);
+            seri.absorb(evt.event_user_data);
+
+            if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+                if ((evt.event_type < 0) || (static_cast<std::size_t>(evt.event_type) >= event_types_.size())
+                    || (event_types_[evt.event_type].name != type_name) || !event_types_[evt.event_type].callback) {
+                    LOG_ERROR(KERNEL, "Saved timer event type {} ({}) is not registered", type_name, evt.event_type);
+                    return false;
+                }
+
+                evt.event_time = now + delay;
+            }
+        }
+
+        if (check_only) {
+            return true;
+        }
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            events_.clear();
+
+            for (const event &evt : events) {
+                events_.push(evt);
+            }
+
+            new_event_evt_.set();
+        }
+
+        return true;
+    }
+
     bool ntimer::is_paused() const {
         return should_paused_.load();
     }
@@ -183,6 +183,9 @@ namespace eka2l1 {
             e32_reloc_section code_reloc_section;
             e32_reloc_section data_reloc_section;
 
+            // Relocations of both sections, each packed as: offset | (type << 32) | (section << 48)
+            std::vector<std::uint64_t> relocation_list;
+
             uint32_t rt_code_addr;
             uint32_t rt_data_addr;
 
@@ -212,7 +215,7 @@ namespace eka2l1 {
          * @brief Parse an E32 Image from stream.
          * 
          * @param stream     The stream to parse from.
-         * @param read_reloc If this is true, relocation section will be parsed.
+         * @param read_reloc If this is true, relocation section will be parsed, and the relocation list built.
          * 
          * @returns An optional contains E32 Image. Nullopt if invalid.
          */
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <common/blobcache.h>
+#include <loader/e32img.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace eka2l1 {
+    namespace common {
+        class ro_stream;
+    }
+
+    namespace loader {
+        /**
+         * \brief Persistent cache of decompressed and parsed E32 images.
+         *
+         * Each image is stored in its own blob, named after the hash and size of the original
+         * image's content. The blob holds the uncompressed image, the export and import tables
+         * and the built relocation list in a flat layout, which is mapped to memory on load. A hit
+         * skips decompression and parsing of the original image.
+         *
+         * Images loaded from the cache have no relocation sections, only the relocation list.
+         */
+        class e32img_cache {
+            common::blob_cache blobs_;
+
+        public:
+            explicit e32img_cache(const std::string &folder);
+
+            /**
+             * \brief Load an E32 image, from the cache if possible.
+             *
+             * On a miss, the image is parsed from the stream, and stored in the cache.
+             *
+             * \param stream    The stream containing the whole original image.
+             * \returns The image, or nullopt if the stream does not contain a valid E32 image.
+             */
+            std::optional<e32img> load(common::ro_stream *stream);
+
+            /**
+             * \brief Find a cached image.
+             *
+             * \param hash  XXH64 hash of the original image's content.
+             * \param size  Size of the original image.
+             *
+             * \returns The image, or nullopt if it's not cached, or the cache file is unusable.
+             */
+            std::optional<e32img> lookup(const std::uint64_t hash, const std::uint64_t size);
+
+            /**
+             * \brief Store a parsed image in the cache.
+             *
+             * \param img   The image, parsed with relocations.
+             * \param hash  XXH64 hash of the original image's content.
+             * \param size  Size of the original image.
+             *
+             * \returns True on success.
+             */
+            bool store(const e32img &img, const std::uint64_t hash, const std::uint64_t size);
+
+            std::uint32_t hit_count() const {
+                return blobs_.hit_count();
+            }
+
+            std::uint32_t miss_count() const {
+                return blobs_.miss_count();
+            }
+        };
+    }
+}
@@ -136,6 +136,18 @@ namespace eka2l1::loader {
         }
     }
 
+    static void build_relocation_list(const e32_reloc_section &section, std::vector<std::uint64_t> &relocation_list, const relocate_section sect) {
+        for (const e32_reloc_entry &entry : section.entries) {
+            for (const auto &rel_info : entry.rels_info) {
+                // Get the lower 12 bit for virtual_address
+                const std::uint32_t virtual_addr = entry.base + (rel_info & 0x0FFF);
+                const relocation_type rel_type = static_cast<relocation_type>(rel_info & 0xF000);
+
+                relocation_list.push_back((virtual_addr) | (static_cast<std::uint64_t>(rel_type) << 32) | (static_cast<std::uint64_t>(sect) << 48));
+            }
+        }
+    }
+
     static void parse_export_dir(e32img &img) {
         if (img.header.export_dir_offset == 0) {
             return;
@@ -406,9 +418,8 @@ namespace eka2l1::loader {
             decompressed_stream.read(reinterpret_cast<void *>(&import.dll_name_offset), 4);
             decompressed_stream.read(reinterpret_cast<void *>(&import.number_of_imports), 4);
 
-            img.dll_names.push_back(import.dll_name);
-
             if (import.number_of_imports == 0) {
+                img.dll_names.push_back(import.dll_name);
                 continue;
             }
 
@@ -425,6 +436,7 @@ namespace eka2l1::loader {
                 }
             }
 
+            img.dll_names.push_back(import.dll_name);
             decompressed_stream.seek(static_cast<uint32_t>(crr_size), common::beg);
 
             import.ordinals.resize(import.number_of_imports);
@@ -439,6 +451,12 @@ namespace eka2l1::loader {
                 img.code_reloc_section, img.header.code_reloc_offset);
             read_relocations(reinterpret_cast<common::ro_stream *>(&decompressed_stream),
                 img.data_reloc_section, img.header.data_reloc_offset);
+
+            build_relocation_list(img.code_reloc_section, img.relocation_list, relocate_section_text);
+
+            if ((img.header.bss_size) || (img.header.data_size)) {
+                build_relocation_list(img.data_reloc_section, img.relocation_list, relocate_section_data);
+            }
         }
 
         return img;
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <loader/e32img_cache.h>
+
+#include <common/algorithm.h>
+#include <common/buffer.h>
+#include <common/fileutils.h>
+#include <common/log.h>
+#include <common/virtualmem.h>
+
+#include <cstring>
+#include <type_traits>
+
+#include <xxhash.h>
+
+namespace eka2l1::loader {
+    static constexpr std::uint32_t E32IMG_CACHE_MAGIC = 0x43323345; // E32C
+    static constexpr std::uint32_t E32IMG_CACHE_VERSION = 1;
+
+    struct e32img_cache_section {
+        std::uint32_t offset_;
+        std::uint32_t count_;
+    };
+
+    struct e32img_cache_import_block {
+        std::uint32_t dll_name_offset_;
+        std::int32_t number_of_imports_;
+        std::uint32_t ordinal_count_;
+        std::uint32_t dll_name_length_;
+
+        // Followed by the ordinals, then the DLL name, padded to 4 bytes
+    };
+
+    struct e32img_cache_file_header {
+        std::uint32_t magic_;
+        std::uint32_t version_;
+        std::uint32_t header_size_;
+        std::uint32_t file_size_;
+        std::uint64_t source_hash_;
+        std::uint64_t source_size_;
+
+        std::uint32_t epoc_ver_;
+        std::uint32_t uncompressed_size_;
+        std::uint32_t has_extended_header_;
+        std::int32_t import_section_size_;
+
+        e32img_header header_;
+        e32img_header_extended header_extended_;
+
+        e32img_cache_section data_; ///< Uncompressed image, in bytes.
+        e32img_cache_section exports_; ///< Export directory, in 32-bit words.
+        e32img_cache_section iat_; ///< Import address table, in 32-bit words.
+        e32img_cache_section imports_; ///< Import blocks, in count of blocks.
+        e32img_cache_section relocations_; ///< Relocation list, in 64-bit words.
+    };
+
+    static_assert(std::is_trivially_copyable<e32img_cache_file_header>::value, "Cache header must be stored as is");
+
+    // Sections are 8 bytes aligned, so they can be used in place from the mapped file
+    static constexpr std::size_t SECTION_ALIGNMENT = 8;
+
+    template <typename T>
+    static e32img_cache_section append_section(std::vector<std::uint8_t> &blob, const T *items, const std::size_t count) {
+        blob.resize(common::align(blob.size(), SECTION_ALIGNMENT), 0);
+
+        e32img_cache_section section{ static_cast<std::uint32_t>(blob.size()), static_cast<std::uint32_t>(count) };
+        const std::uint8_t *bytes = reinterpret_cast<const std::uint8_t *>(items);
+
+        blob.insert(blob.end(), bytes, bytes + count * sizeof(T));
+        return section;
+    }
+
+    template <typename T>
+    static const T *get_section(const std::uint8_t *file, const std::size_t file_size, const e32img_cache_section &section) {
+        if (static_cast<std::uint64_t>(section.offset_) + static_cast<std::uint64_t>(section.count_) * sizeof(T) > file_size) {
+            return nullptr;
+        }
+
+        return reinterpret_cast<const T *>(file + section.offset_);
+    }
+
+    e32img_cache::e32img_cache(const std::string &folder)
+        : blobs_(folder, "e32c") {
+    }
+
+    std::optional<e32img> e32img_cache::load(common::ro_stream *stream) {
+        if (!stream) {
+            return std::nullopt;
+        }
+
+        // Don't bother hashing other kinds of file
+        stream->seek(0, common::seek_where::beg);
+        if (!is_e32img(stream)) {
+            return std::nullopt;
+        }
+
+        std::vector<std::uint8_t> content(stream->size());
+
+        if (stream->read(content.data(), content.size()) != content.size()) {
+            return std::nullopt;
+        }
+
+        const std::uint64_t hash = XXH64(content.data(), content.size(), 0);
+
+        if (auto img = lookup(hash, content.size())) {
+            blobs_.record_hit();
+            return img;
+        }
+
+        blobs_.record_miss();
+
+        common::ro_buf_stream content_stream(content.data(), content.size());
+        auto img = parse_e32img(reinterpret_cast<common::ro_stream *>(&content_stream));
+
+        if (img && !store(*img, hash, content.size())) {
+            LOG_WARN(LOADER, "Unable to store E32 image in the cache folder {}", blobs_.folder());
+        }
+
+        return img;
+    }
+
+    std::optional<e32img> e32img_cache::lookup(const std::uint64_t hash, const std::uint64_t size) {
+        // Mapped rather than read, most of the file is copied straight out
+        const std::string path = blobs_.get_file_path(hash, size);
+        const std::int64_t file_size = common::file_size(path);
+
+        if (file_size < static_cast<std::int64_t>(sizeof(e32img_cache_file_header))) {
+            return std::nullopt;
+        }
+
+        std::uint8_t *file = reinterpret_cast<std::uint8_t *>(common::map_file(path, prot_read));
+        if (!file) {
+            return std::nullopt;
+        }
+
+        const e32img_cache_file_header *header = reinterpret_cast<const e32img_cache_file_header *>(file);
+        std::optional<e32img> result = std::nullopt;
+
+        const std::uint32_t *exports = get_section<std::uint32_t>(file, file_size, header->exports_);
+        const std::uint32_t *iat = get_section<std::uint32_t>(file, file_size, header->iat_);
+        const std::uint64_t *relocations = get_section<std::uint64_t>(file, file_size, header->relocations_);
+        const char *data = get_section<char>(file, file_size, header->data_);
+
+        const bool header_valid = (header->magic_ == E32IMG_CACHE_MAGIC) && (header->version_ == E32IMG_CACHE_VERSION)
+            && (header->header_size_ == sizeof(e32img_cache_file_header)) && (header->file_size_ == static_cast<std::uint64_t>(file_size))
+            && (header->source_hash_ == hash) && (header->source_size_ == size);
+
+        if (header_valid && exports && iat && relocations && data) {
+            e32img img;
+
+            img.epoc_ver = static_cast<epocver>(header->epoc_ver_);
+            img.header = header->header_;
+            img.header_extended = header->header_extended_;
+            img.has_extended_header = (header->has_extended_header_ != 0);
+            img.uncompressed_size = header->uncompressed_size_;
+            img.import_section.size = header->import_section_size_;
+
+            img.data.assign(data, data + header->data_.count_);
+            img.ed.syms.assign(exports, exports + header->exports_.count_);
+            img.iat.its.assign(iat, iat + header->iat_.count_);
+            img.relocation_list.assign(relocations, relocations + header->relocations_.count_);
+
+            // Import blocks are variable sized, walk them
+            std::size_t offset = header->imports_.offset_;
+            bool imports_valid = true;
+
+            if (!get_section<e32img_cache_import_block>(file, file_size, header->imports_)) {
+                imports_valid = false;
+            } else {
+                img.import_section.imports.resize(header->imports_.count_);
+            }
+
+            for (e32img_import_block &import : img.import_section.imports) {
+                if (offset + sizeof(e32img_cache_import_block) > static_cast<std::size_t>(file_size)) {
+                    imports_valid = false;
+                    break;
+                }
+
+                e32img_cache_import_block block;
+                std::memcpy(&block, file + offset, sizeof(e32img_cache_import_block));
+
+                offset += sizeof(e32img_cache_import_block);
+
+                const std::size_t ordinals_size = static_cast<std::size_t>(block.ordinal_count_) * sizeof(std::uint32_t);
+                if (offset + ordinals_size + block.dll_name_length_ > static_cast<std::size_t>(file_size)) {
+                    imports_valid = false;
+                    break;
+                }
+
+                import.dll_name_offset = block.dll_name_offset_;
+                import.number_of_imports = block.number_of_imports_;
+                import.ordinals.resize(block.ordinal_count_);
+
+                std::memcpy(import.ordinals.data(), file + offset, ordinals_size);
+                offset += ordinals_size;
+
+                import.dll_name.assign(reinterpret_cast<const char *>(file + offset), block.dll_name_length_);
+                offset = common::align(offset + block.dll_name_length_, 4);
+
+                img.dll_names.push_back(import.dll_name);
+            }
+
+            if (imports_valid) {
+                result = std::move(img);
+            }
+        }
+
+        common::unmap_file(file, static_cast<std::size_t>(file_size));
+
+        if (!result) {
+            LOG_WARN(LOADER, "E32 image cache file {} is outdated or corrupted, ignored", path);
+        }
+
+        return result;
+    }
+
+    bool e32img_cache::store(const e32img &img, const std::uint64_t hash, const std::uint64_t size) {
+        e32img_cache_file_header header;
+        std::memset(&header, 0, sizeof(e32img_cache_file_header));
+
+        header.magic_ = E32IMG_CACHE_MAGIC;
+        header.version_ = E32IMG_CACHE_VERSION;
+        header.header_size_ = sizeof(e32img_cache_file_header);
+        header.source_hash_ = hash;
+        header.source_size_ = size;
+        header.epoc_ver_ = static_cast<std::uint32_t>(img.epoc_ver);
+        header.uncompressed_size_ = img.uncompressed_size;
+        header.has_extended_header_ = img.has_extended_header ? 1 : 0;
+        header.import_section_size_ = img.import_section.size;
+        header.header_ = img.header;
+        header.header_extended_ = img.header_extended;
+
+        std::vector<std::uint8_t> blob(sizeof(e32img_cache_file_header), 0);
+
+        header.data_ = append_section(blob, img.data.data(), img.data.size());
+        header.exports_ = append_section(blob, img.ed.syms.data(), img.ed.syms.size());
+        header.iat_ = append_section(blob, img.iat.its.data(), img.iat.its.size());
+        header.relocations_ = append_section(blob, img.relocation_list.data(), img.relocation_list.size());
+
+        header.imports_ = append_section<std::uint8_t>(blob, nullptr, 0);
+        header.imports_.count_ = static_cast<std::uint32_t>(img.import_section.imports.size());
+
+        for (const e32img_import_block &import : img.import_section.imports) {
+            const e32img_cache_import_block block{ import.dll_name_offset, import.number_of_imports,
+                static_cast<std::uint32_t>(import.ordinals.size()), static_cast<std::uint32_t>(import.dll_name.size()) };
+
+            const std::uint8_t *block_bytes = reinterpret_cast<const std::uint8_t *>(&block);
+            const std::uint8_t *ordinal_bytes = reinterpret_cast<const std::uint8_t *>(import.ordinals.data());
+
+            blob.insert(blob.end(), block_bytes, block_bytes + sizeof(e32img_cache_import_block));
+            blob.insert(blob.end(), ordinal_bytes, ordinal_bytes + import.ordinals.size() * sizeof(std::uint32_t));
+            blob.insert(blob.end(), import.dll_name.begin(), import.dll_name.end());
+            blob.resize(common::align(blob.size(), 4), 0);
+        }
+
+        header.file_size_ = static_cast<std::uint32_t>(blob.size());
+        std::memcpy(blob.data(), &header, sizeof(e32img_cache_file_header));
+
+        return blobs_.write(hash, size, blob.data(), blob.size());
+    }
+}
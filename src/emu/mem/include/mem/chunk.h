@@ -82,6 +82,13 @@ namespace eka2l1::mem {
         virtual std::size_t commit(const vm_address offset, const std::size_t size, bool ignore_committed = true) = 0;
         virtual void decommit(const vm_address offset, const std::size_t size) = 0;
 
+        /**
+         * \brief Check if a page of the chunk is committed.
+         *
+         * \param page_index Index of the page, counting from the start of the chunk.
+         */
+        virtual bool is_page_committed(const std::uint32_t page_index) = 0;
+
         virtual void *host_base() = 0;
 
         /**
@@ -23,8 +23,11 @@
 
 #include <mem/common.h>
 #include <mem/page.h>
+#include <mem/watch.h>
 
 #include <memory>
+#include <shared_mutex>
+#include <vector>
 
 namespace eka2l1 {
     namespace config {
@@ -50,10 +53,16 @@ namespace eka2l1::mem {
 
     class control_base {
     protected:
+        friend class mmu_base;
+
         page_table_allocator *alloc_;
         config::state *conf_;
 
         arm::exclusive_monitor *exclusive_monitor_;
+        write_watcher write_watcher_;
+
+        std::shared_mutex page_dir_lock_; ///< Guards page directories and tables against lookups from other cores.
+        std::vector<mmu_base *> attached_mmus_;
 
     public:
         std::size_t page_size_bits_; ///< The number of bits of page size.
@@ -89,6 +98,44 @@ namespace eka2l1::mem {
             return mem_map_old_;
         }
 
+        /**
+         * \brief Reserve host memory that will back guest pages.
+         *
+         * When fastmem is enabled, the memory is reserved as shareable, so that the CPU can mirror
+         * committed pages into its host view of the guest address space.
+         *
+         * \param size Size of the memory to reserve.
+         * \returns Pointer to the reserved memory, nullptr on failure.
+         */
+        void *map_host_memory(const std::size_t size);
+
+        write_watcher &get_write_watcher() {
+            return write_watcher_;
+        }
+
+        /**
+         * \brief Get the lock guarding page directories and tables.
+         *
+         * Lookups take it shared. Changes to directories or page entries take it exclusively, and must
+         * not call back into lookups while holding it.
+         */
+        std::shared_mutex &get_page_dir_lock() {
+            return page_dir_lock_;
+        }
+
+        /**
+         * \brief Drop the cached mappings of an unmapped range from every core that may have cached it.
+         *
+         * Cores running guest code are stopped first, so once this returns no core can reach the old
+         * pages anymore. Must be called after the page entries are cleared, without holding the page
+         * directory lock, and before the host memory behind the range is released.
+         *
+         * \param id   ASID of the address space the range was unmapped from, -1 if it's visible to all.
+         * \param addr Start address of the range.
+         * \param size Size of the range.
+         */
+        void shootdown(const asid id, const vm_address addr, const std::size_t size);
+
         /**
          * \brief Get a page table by its ID.
          */
@@ -117,6 +164,7 @@ namespace eka2l1::mem {
                 return -1;
             }
 
+            write_watcher_.note_write(const_cast<T *>(real_ptr));
             return static_cast<std::int32_t>(common::atomic_compare_and_swap<T>(real_ptr, value, expected));
         }
 
@@ -83,6 +83,11 @@ namespace eka2l1 {
         bool read(const address addr, void *data, std::uint32_t size);
         bool write(const address addr, void *data, std::uint32_t size);
 
+        /**
+         * \brief Report a write done by the host to memory backing guest pages, so write watchers see it.
+         */
+        void note_host_write(const void *host_ptr, const std::size_t size);
+
         template <typename T>
         T read(const address addr) {
             T data{};
@@ -22,10 +22,13 @@
 #include <common/atomic.h>
 
 #include <mem/page.h>
+
 #include <memory>
+#include <vector>
 
 namespace eka2l1::arm {
     class core;
+    struct page_table;
 }
 
 namespace eka2l1::config {
@@ -44,6 +47,35 @@ namespace eka2l1::mem {
 
         control_base *manager_;
 
+        std::unique_ptr<arm::page_table> page_table_;
+        std::vector<std::uint32_t> published_pages_;
+
+        /**
+         * \brief Publish the host memory of the page containing the given address to the CPU page table.
+         */
+        void publish_page(const vm_address addr, page_info *info);
+
+        /**
+         * \brief Clear every published entry of the CPU page table.
+         *
+         * Must be called when the current address space changes.
+         */
+        void flush_page_table();
+
+        /**
+         * \brief Clear the published entries of the CPU page table covering the given range.
+         */
+        void unpublish_pages(const vm_address addr, const std::size_t size);
+
+        /**
+         * \brief Give the CPU a cached mapping of the page containing the given address.
+         *
+         * Pages with their writes watched are cached read-only until they are written to.
+         */
+        void cache_page(const vm_address addr, page_info *info, const bool write);
+
+        void note_host_write(const void *host_ptr);
+
         bool read_8bit_data(const vm_address addr, std::uint8_t *data);
         bool read_16bit_data(const vm_address addr, std::uint16_t *data);
         bool read_32bit_data(const vm_address addr, std::uint32_t *data);
@@ -62,11 +94,21 @@ namespace eka2l1::mem {
 
     public:
         explicit mmu_base(control_base *manager, arm::core *cpu, config::state *conf);
-        virtual ~mmu_base() {}
+        virtual ~mmu_base();
 
         void map_to_cpu(const vm_address addr, const std::size_t size, void *ptr, const prot perm);
         void unmap_from_cpu(const vm_address addr, const std::size_t size);
 
+        /**
+         * \brief Drop the CPU's cached mapping of the page containing the given address.
+         */
+        void revoke_cpu_page(const vm_address addr);
+
+        /**
+         * \brief Drop every cached mapping the CPU has.
+         */
+        void flush_cpu_mappings();
+
         /**
          * \brief Get host pointer of a virtual address, in the specified address space.
          */
@@ -85,6 +127,7 @@ namespace eka2l1::mem {
                 return -1;
             }
 
+            note_host_write(const_cast<T *>(real_ptr));
             return static_cast<std::int32_t>(common::atomic_compare_and_swap<T>(real_ptr, value, expected));
         }
 
@@ -82,6 +82,7 @@ namespace eka2l1::mem {
 
         std::size_t commit(const vm_address offset, const std::size_t size, bool ignore_committed = true) override;
         void decommit(const vm_address offset, const std::size_t size) override;
+        bool is_page_committed(const std::uint32_t page_index) override;
 
         std::int32_t allocate(const std::size_t size) override;
 
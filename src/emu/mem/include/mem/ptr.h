@@ -41,6 +41,21 @@ namespace eka2l1 {
 
     void *get_raw_pointer(kernel::process *pr, address addr);
 
+    /**
+     * \brief Report a write done by the host to the memory of a process, so write watchers see it.
+     */
+    void note_host_write(kernel::process *pr, const void *host_ptr, const std::size_t size);
+
+    /**
+     * \brief Get the host pointer of a guest range, if the range is contiguous on the host.
+     */
+    void *get_contiguous_raw_pointer(kernel::process *pr, address addr, const std::uint32_t size);
+
+    /**
+     * \brief Copy between the host and a guest range page by page, allowing the range to cross chunks.
+     */
+    bool copy_on_addr_space(kernel::process *pr, address addr, void *host, const std::uint32_t size, const bool to_addr_space);
+
     template <typename T>
     class ptr {
         address mem_address;
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <mem/common.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace eka2l1::mem {
+    class mmu_base;
+
+    enum write_watch_access {
+        write_watch_access_unwatched, ///< The page is not watched, map it as usual.
+        write_watch_access_armed, ///< The page is write-protected, CPU must not get write access to it.
+        write_watch_access_disarmed ///< This write just marked the page dirty, stale read-only mappings must be dropped.
+    };
+
+    /**
+     * \brief Track guest writes to host memory backing guest pages.
+     *
+     * Watching is done on host addresses, so a page is tracked the same in every address space
+     * it is mapped to. A watched page starts armed: CPUs can only read it through their TLB, and are
+     * not given the page table fast path, so every write goes through the MMU. The first write marks
+     * the page dirty and gives the fast path back, so drawing into it costs nothing more until a
+     * watcher collects the dirty state, which arms the page again.
+     *
+     * A page may be shared by several watchers (small bitmaps packed together), so each of them keeps
+     * a stamp of its last collection, and a page is dirty to a watcher if it was written after that.
+     *
+     * Only 4KB paging is supported, with 1MB pages a write to any watched part would unprotect the
+     * whole page.
+     */
+    class write_watcher {
+    public:
+        static constexpr std::uint32_t PAGE_BITS = 12;
+        static constexpr std::uint32_t PAGE_SIZE = 1 << PAGE_BITS;
+
+    private:
+        struct watched_page {
+            std::uint32_t ref_count_;
+            bool armed_;
+            std::uint64_t write_stamp_; ///< Stamp of the last write seen, or of the last rearm.
+
+            // CPU mappings that were given write access since the page got dirty
+            std::vector<std::pair<mmu_base *, vm_address>> mappings_;
+        };
+
+        std::mutex lock_;
+        std::unordered_map<std::uintptr_t, watched_page> pages_;
+        std::atomic<std::size_t> page_count_;
+        std::uint64_t stamp_;
+
+        // Held while taking mappings away from MMUs, so they are not removed meanwhile. The CPUs are
+        // stopped out of guest code for that, so lock_ must not be held, their accesses may be waiting on it
+        std::mutex mmu_lock_;
+        std::vector<mmu_base *> mmus_;
+        bool supported_;
+
+        void revoke_mappings(const std::vector<std::pair<mmu_base *, vm_address>> &mappings);
+        void flush_all_mappings();
+
+    public:
+        explicit write_watcher(const bool supported);
+
+        void add_mmu(mmu_base *mmu);
+        void remove_mmu(mmu_base *mmu);
+
+        bool is_supported() const {
+            return supported_;
+        }
+
+        /**
+         * \brief Start watching writes to a range of host memory backing guest pages.
+         *
+         * Watches are reference counted per page, each successful call must be paired with an unwatch.
+         *
+         * \returns False if write watching is not available.
+         */
+        bool watch(const void *host_ptr, const std::size_t size);
+        void unwatch(const void *host_ptr, const std::size_t size);
+
+        /**
+         * \brief Get pages in the range that were written to since last collected, and arm them again.
+         *
+         * \param host_ptr     Start of the watched range.
+         * \param size         Size of the watched range.
+         * \param stamp        The caller's stamp of its last collection, 0 at first. Updated on return.
+         * \param dirty_pages  Filled with one entry per page the range touches, non-zero if the page is dirty.
+         *
+         * \returns True if any page in the range is dirty.
+         */
+        bool collect_dirty(const void *host_ptr, const std::size_t size, std::uint64_t &stamp, std::vector<std::uint8_t> &dirty_pages);
+
+        /**
+         * \brief Report a CPU access to a page that the MMU is about to cache.
+         *
+         * \param mmu        The MMU handling the access.
+         * \param host_page  Host address of the page.
+         * \param vaddr      Guest address the page is mapped at.
+         * \param write      True if this is a write access.
+         */
+        write_watch_access access(mmu_base *mmu, const void *host_page, const vm_address vaddr, const bool write);
+
+        /**
+         * \brief Mark watched pages in the range dirty, for writes that do not go through the CPU mapping.
+         */
+        void note_write(const void *host_ptr, const std::size_t size = 1);
+
+        bool empty() const {
+            return page_count_.load(std::memory_order_relaxed) == 0;
+        }
+    };
+}
@@ -17,6 +17,8 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <common/virtualmem.h>
+#include <config/config.h>
 #include <cpu/arm_interface.h>
 
 #include <mem/control.h>
@@ -32,7 +34,8 @@ namespace eka2l1::mem {
         , conf_(conf)
         , page_size_bits_(psize_bits)
         , mem_map_old_(mem_map_old)
-        , exclusive_monitor_(monitor) {
+        , exclusive_monitor_(monitor)
+        , write_watcher_(psize_bits == 12) {
         if (psize_bits == 20) {
             offset_mask_ = OFFSET_MASK_20B;
             page_table_index_shift_ = PAGE_TABLE_INDEX_SHIFT_20B;
@@ -99,6 +102,32 @@ namespace eka2l1::mem {
     control_base::~control_base() {
     }
 
+    void *control_base::map_host_memory(const std::size_t size) {
+        if (conf_ && conf_->enable_fastmem) {
+            return common::map_shared_memory(size);
+        }
+
+        return common::map_memory(size);
+    }
+
+    void control_base::shootdown(const asid id, const vm_address addr, const std::size_t size) {
+        std::vector<mmu_base *> mmus;
+
+        {
+            const std::shared_lock<std::shared_mutex> guard(page_dir_lock_);
+            mmus = attached_mmus_;
+        }
+
+        for (mmu_base *mm : mmus) {
+            // The core may be in the middle of a slow path lookup that got the page before it was cleared
+            const auto guest_guard = mm->cpu_->hold_out_of_guest();
+
+            if ((id < 0) || (mm->current_addr_space() == id)) {
+                mm->unmap_from_cpu(addr, size);
+            }
+        }
+    }
+
     page_table *control_base::create_new_page_table() {
         return alloc_->create_new(page_size_bits_);
     }
@@ -80,9 +80,15 @@ namespace eka2l1 {
         }
 
         std::memcpy(ptr, data, size);
+        note_host_write(ptr, size);
+
         return true;
     }
 
+    void memory_system::note_host_write(const void *host_ptr, const std::size_t size) {
+        impl_->get_write_watcher().note_write(host_ptr, size);
+    }
+
     const int memory_system::get_page_size() const {
         return static_cast<int>(impl_->page_size());
     }
@@ -26,6 +26,8 @@
 #include <mem/model/flexible/mmu.h>
 #include <mem/model/multiple/mmu.h>
 
+#include <algorithm>
+
 namespace eka2l1::mem {
     mmu_base::mmu_base(control_base *manager, arm::core *cpu, config::state *conf)
         : manager_(manager)
@@ -58,6 +60,103 @@ namespace eka2l1::mem {
         cpu->exclusive_write_64bit = [this](const vm_address addr, std::uint64_t value, std::uint64_t expected) {
             return write_exclusive<std::uint64_t>(addr, value, expected);
         };
+
+        // Publish the page table, the callbacks above are now only the slow path
+        page_table_ = std::make_unique<arm::page_table>();
+        cpu->set_page_table(page_table_.get());
+
+        manager_->get_write_watcher().add_mmu(this);
+
+        const std::unique_lock<std::shared_mutex> guard(manager_->page_dir_lock_);
+        manager_->attached_mmus_.push_back(this);
+    }
+
+    mmu_base::~mmu_base() {
+        manager_->get_write_watcher().remove_mmu(this);
+
+        const std::unique_lock<std::shared_mutex> guard(manager_->page_dir_lock_);
+        manager_->attached_mmus_.erase(std::find(manager_->attached_mmus_.begin(), manager_->attached_mmus_.end(), this));
+    }
+
+    void mmu_base::publish_page(const vm_address addr, page_info *info) {
+        const std::uint32_t index = addr >> arm::page_table::PAGE_BITS;
+
+        // The table serves both reads and writes, so pages that can't be written stay on the callbacks
+        if (page_table_->pointers[index] || ((info->perm & prot_read_write) != prot_read_write)) {
+            return;
+        }
+
+        // Guest pages may be larger than the table's page (1MB paging), pick the piece that contains the address
+        page_table_->pointers[index] = reinterpret_cast<std::uint8_t *>(info->host_addr)
+            + ((addr & manager_->offset_mask_) & ~arm::page_table::PAGE_MASK);
+
+        published_pages_.push_back(index);
+    }
+
+    void mmu_base::flush_page_table() {
+        for (const std::uint32_t index : published_pages_) {
+            page_table_->pointers[index] = nullptr;
+        }
+
+        published_pages_.clear();
+    }
+
+    void mmu_base::unpublish_pages(const vm_address addr, const std::size_t size) {
+        if (!size) {
+            return;
+        }
+
+        const std::uint32_t first_index = addr >> arm::page_table::PAGE_BITS;
+        const std::uint32_t last_index = static_cast<std::uint32_t>((static_cast<std::uint64_t>(addr) + size - 1) >> arm::page_table::PAGE_BITS);
+
+        for (std::uint32_t index = first_index; index <= last_index; index++) {
+            page_table_->pointers[index] = nullptr;
+        }
+
+        published_pages_.erase(std::remove_if(published_pages_.begin(), published_pages_.end(), [=](const std::uint32_t index) {
+            return (index >= first_index) && (index <= last_index);
+        }),
+            published_pages_.end());
+    }
+
+    void mmu_base::cache_page(const vm_address addr, page_info *info, const bool write) {
+        const vm_address page_addr = addr & ~manager_->offset_mask_;
+
+        switch (manager_->get_write_watcher().access(this, info->host_addr, page_addr, write)) {
+        case write_watch_access_armed:
+            // Reads can still be cached, writes must come back here
+            cpu_->set_tlb_page(page_addr, reinterpret_cast<std::uint8_t *>(info->host_addr),
+                static_cast<prot>(info->perm & ~prot_write));
+
+            return;
+
+        case write_watch_access_disarmed:
+            // Drop the read-only entry cached while the page was armed
+            cpu_->dirty_tlb_page(page_addr);
+            break;
+
+        default:
+            break;
+        }
+
+        cpu_->set_tlb_page(page_addr, reinterpret_cast<std::uint8_t *>(info->host_addr), info->perm);
+        publish_page(addr, info);
+    }
+
+    void mmu_base::revoke_cpu_page(const vm_address addr) {
+        const vm_address page_addr = addr & ~manager_->offset_mask_;
+
+        cpu_->dirty_tlb_page(page_addr);
+        unpublish_pages(page_addr, manager_->page_size());
+    }
+
+    void mmu_base::flush_cpu_mappings() {
+        cpu_->flush_tlb();
+        flush_page_table();
+    }
+
+    void mmu_base::note_host_write(const void *host_ptr) {
+        manager_->get_write_watcher().note_write(host_ptr);
     }
 
     void mmu_base::map_to_cpu(const vm_address addr, const std::size_t size, void *ptr, const prot perm) {
@@ -72,6 +171,8 @@ namespace eka2l1::mem {
             cpu_->dirty_tlb_page(addr_temp);
             addr_temp += psize;
         }
+
+        unpublish_pages(addr, size);
     }
 
     /// ================== MISCS ====================
@@ -90,8 +191,7 @@ namespace eka2l1::mem {
             LOG_TRACE(MEMORY, "Read 1 byte from address 0x{:X}", addr);
         }
 
-        cpu_->set_tlb_page(addr & ~manager_->offset_mask_, reinterpret_cast<std::uint8_t *>(inf->host_addr),
-            inf->perm);
+        cache_page(addr, inf, false);
 
         return true;
     }
@@ -110,8 +210,7 @@ namespace eka2l1::mem {
             LOG_TRACE(MEMORY, "Read 2 bytes from address 0x{:X}", addr);
         }
 
-        cpu_->set_tlb_page(addr & ~manager_->offset_mask_, reinterpret_cast<std::uint8_t *>(inf->host_addr),
-            inf->perm);
+        cache_page(addr, inf, false);
 
         return true;
     }
@@ -130,8 +229,7 @@ namespace eka2l1::mem {
             LOG_TRACE(MEMORY, "Read 4 bytes from address 0x{:X}", addr);
         }
 
-        cpu_->set_tlb_page(addr & ~manager_->offset_mask_, reinterpret_cast<std::uint8_t *>(inf->host_addr),
-            inf->perm);
+        cache_page(addr, inf, false);
 
         return true;
     }
@@ -150,8 +248,7 @@ namespace eka2l1::mem {
             LOG_TRACE(MEMORY, "Read 8 bytes from address 0x{:X}", addr);
         }
 
-        cpu_->set_tlb_page(addr & ~manager_->offset_mask_, reinterpret_cast<std::uint8_t *>(inf->host_addr),
-            inf->perm);
+        cache_page(addr, inf, false);
 
         return true;
     }
@@ -170,8 +267,7 @@ namespace eka2l1::mem {
             LOG_TRACE(MEMORY, "Write 1 byte to address 0x{:X}", addr);
         }
 
-        cpu_->set_tlb_page(addr & ~manager_->offset_mask_, reinterpret_cast<std::uint8_t *>(inf->host_addr),
-            inf->perm);
+        cache_page(addr, inf, true);
 
         return true;
     }
@@ -190,8 +286,7 @@ namespace eka2l1::mem {
             LOG_TRACE(MEMORY, "Write 2 bytes to address 0x{:X}", addr);
         }
 
-        cpu_->set_tlb_page(addr & ~manager_->offset_mask_, reinterpret_cast<std::uint8_t *>(inf->host_addr),
-            inf->perm);
+        cache_page(addr, inf, true);
 
         return true;
     }
@@ -210,8 +305,7 @@ namespace eka2l1::mem {
             LOG_TRACE(MEMORY, "Write 4 bytes to address 0x{:X}", addr);
         }
 
-        cpu_->set_tlb_page(addr & ~manager_->offset_mask_, reinterpret_cast<std::uint8_t *>(inf->host_addr),
-            inf->perm);
+        cache_page(addr, inf, true);
 
         return true;
     }
@@ -230,8 +324,7 @@ namespace eka2l1::mem {
             LOG_TRACE(MEMORY, "Write 8 bytes to address 0x{:X}", addr);
         }
 
-        cpu_->set_tlb_page(addr & ~manager_->offset_mask_, reinterpret_cast<std::uint8_t *>(inf->host_addr),
-            inf->perm);
+        cache_page(addr, inf, true);
 
         return true;
     }
@@ -27,11 +27,13 @@ namespace eka2l1::mem::flexible {
         , shared_data_sec_(shared_data, ram_drive, control->page_size())
         , ram_code_sec_(ram_code_addr, dll_static_data_flexible, control->page_size())
         , dll_static_data_sec_(dll_static_data_flexible, rom, control->page_size()) {
+        const std::unique_lock<std::shared_mutex> guard(control->get_page_dir_lock());
         dir_ = control->dir_mngr_->allocate(control);
     }
 
     address_space::~address_space() {
         if (dir_) {
+            const std::unique_lock<std::shared_mutex> guard(control_->get_page_dir_lock());
             control_->dir_mngr_->free_one(dir_->id());
         }
 
@@ -119,6 +119,15 @@ namespace eka2l1::mem::flexible {
         committed_ -= static_cast<std::uint32_t>(total_page_to_decommit << control_->page_size_bits_);
     }
 
+    bool flexible_mem_model_chunk::is_page_committed(const std::uint32_t page_index) {
+        if (page_bma_) {
+            return page_bma_->is_allocated(page_index);
+        }
+
+        // Normal chunks only have their bottom to top region committed
+        return (page_index >= bottom_) && (page_index < top_);
+    }
+
     std::int32_t flexible_mem_model_chunk::allocate(const std::size_t size) {
         const int total_page_to_allocate = static_cast<int>((size + control_->page_size() - 1) >> control_->page_size_bits_);
         int page_allocated = total_page_to_allocate;
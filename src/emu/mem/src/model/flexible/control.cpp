@@ -71,6 +71,8 @@ namespace eka2l1::mem::flexible {
     }
 
     void *control_flexible::get_host_pointer(const asid id, const vm_address addr) {
+        const std::shared_lock<std::shared_mutex> guard(page_dir_lock_);
+
         if ((id <= 0) || is_address_all_visible_for_all_processes(addr, mem_map_old_)) {
             // Directory của kernel
             return kern_addr_space_->dir_->get_pointer(addr);
@@ -92,6 +94,8 @@ namespace eka2l1::mem::flexible {
     }
 
     page_info *control_flexible::get_page_info(const asid id, const vm_address addr) {
+        const std::shared_lock<std::shared_mutex> guard(page_dir_lock_);
+
         if ((id <= 0) || is_address_all_visible_for_all_processes(addr, mem_map_old_)) {
             // Directory của kernel
             return kern_addr_space_->dir_->get_page_info(addr);
@@ -113,6 +117,7 @@ namespace eka2l1::mem::flexible {
     }
 
     asid control_flexible::rollover_fresh_addr_space() {
+        const std::unique_lock<std::shared_mutex> guard(page_dir_lock_);
         page_directory *new_dir = dir_mngr_->allocate(this);
 
         if (!new_dir) {
@@ -130,6 +135,8 @@ namespace eka2l1::mem::flexible {
         const std::uint32_t pde_off = linear_addr >> page_table_index_shift_;
         const std::uint32_t last_off = tab ? tab->idx_ : 0;
 
+        const std::unique_lock<std::shared_mutex> guard(page_dir_lock_);
+
         if (tab) {
             tab->idx_ = pde_off;
         }
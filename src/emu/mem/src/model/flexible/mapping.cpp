@@ -108,6 +108,8 @@ namespace eka2l1::mem::flexible {
 
         page_table *faulty = nullptr;
 
+        const std::unique_lock<std::shared_mutex> guard(control->get_page_dir_lock());
+
         while (start_addr < end_addr) {
             const std::uint32_t ptoff = start_addr >> control->page_table_index_shift_;
 
@@ -157,36 +159,44 @@ namespace eka2l1::mem::flexible {
         vm_address start_addr = base_ + (index_start << control->page_size_bits_);
         const vm_address end_addr = start_addr + static_cast<vm_address>(count << control->page_size_bits_);
 
-        const std::size_t page_size = control->page_size();
+        const vm_address unmap_start_addr = start_addr;
 
-        while (start_addr < end_addr) {
-            const std::uint32_t ptoff = start_addr >> control->chunk_shift_;
+        {
+            const std::unique_lock<std::shared_mutex> guard(control->get_page_dir_lock());
 
-            std::uint32_t next_end_addr = ((ptoff + 1) << control->chunk_shift_);
-            next_end_addr = std::min<std::uint32_t>(next_end_addr, end_addr);
+            while (start_addr < end_addr) {
+                const std::uint32_t ptoff = start_addr >> control->chunk_shift_;
 
-            std::uint32_t start_page_index = (start_addr >> control->page_index_shift_);
-            const std::uint32_t end_page_index = (next_end_addr >> control->page_index_shift_);
+                std::uint32_t next_end_addr = ((ptoff + 1) << control->chunk_shift_);
+                next_end_addr = std::min<std::uint32_t>(next_end_addr, end_addr);
 
-            // Try to get the page table from daddy
-            page_table *tbl = owner_->dir_->get_page_table(start_addr);
+                std::uint32_t start_page_index = (start_addr >> control->page_index_shift_);
+                const std::uint32_t end_page_index = (next_end_addr >> control->page_index_shift_);
 
-            if (tbl) {
-                // Proceed with the unmapping
-                while (start_page_index < end_page_index) {
-                    page_info *info = tbl->get_page_info(start_page_index & control->page_index_mask_);
-                    if (info) {
-                        // Empty it out
-                        info->host_addr = nullptr;
-                    }
+                // Try to get the page table from daddy
+                page_table *tbl = owner_->dir_->get_page_table(start_addr);
+
+                if (tbl) {
+                    // Proceed with the unmapping
+                    while (start_page_index < end_page_index) {
+                        page_info *info = tbl->get_page_info(start_page_index & control->page_index_mask_);
+                        if (info) {
+                            // Empty it out
+                            info->host_addr = nullptr;
+                        }
 
-                    start_page_index++;
+                        start_page_index++;
+                    }
                 }
-            }
 
-            start_addr = next_end_addr;
+                start_addr = next_end_addr;
+            }
         }
 
+        // Cores may still have the pages cached. The kernel's address space (ID 0) is seen by every process
+        const asid owner_id = owner_->id();
+        control->shootdown((owner_id == 0) ? -1 : owner_id, unmap_start_addr, end_addr - unmap_start_addr);
+
         return true;
     }
 
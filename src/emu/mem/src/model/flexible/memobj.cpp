@@ -36,7 +36,7 @@ namespace eka2l1::mem::flexible {
         if (data_) {
             external_ = true;
         } else {
-            data_ = common::map_memory(page_count * ctrl->page_size());
+            data_ = ctrl->map_host_memory(page_count * ctrl->page_size());
 
             if (!data_) {
                 LOG_ERROR(MEMORY, "Unable to allocate virtual memory for this memory object (page count = {})",
@@ -82,8 +82,6 @@ namespace eka2l1::mem::flexible {
                 if (mapping->owner_->id() == mm->current_addr_space()) {
                     // Map it to CPU right away
                     mm->map_to_cpu(mapping->base_ + start_offset, size_to_commit, reinterpret_cast<std::uint8_t *>(data_) + start_offset, perm);
-
-                    break;
                 }
             }
         }
@@ -97,36 +95,23 @@ namespace eka2l1::mem::flexible {
             return false;
         }
 
-        const std::uint32_t start_offset = page_offset << control_->page_size_bits_;
-        const std::uint32_t size_to_decommit = static_cast<std::uint32_t>(total_pages << control_->page_size_bits_);
-
-        if (!external_) {
-            const bool deresult = common::decommit(reinterpret_cast<std::uint8_t *>(data_) + start_offset,
-                size_to_decommit);
-
-            if (!deresult) {
-                return false;
-            }
-        }
-
-        control_flexible *ctrl_fx = reinterpret_cast<control_flexible *>(control_);
-
-        // Unmap decomitted memory from all mappings
+        // Unmap decomitted memory from all mappings, they drop the pages from the CPUs too
         for (auto &mapping : mappings_) {
             if (!mapping->unmap(page_offset, total_pages)) {
                 LOG_WARN(MEMORY, "Unable to unmap decommitted memory from a mapping!");
             }
-
-            for (auto &mm : ctrl_fx->mmus_) {
-                if (mapping->owner_->id() == mm->current_addr_space()) {
-                    // Unmap from to CPU right away
-                    mm->unmap_from_cpu(mapping->base_ + start_offset, size_to_decommit);
-                    break;
-                }
-            }
         }
 
         page_arr_.alter(page_offset, static_cast<std::uint32_t>(total_pages), prot_none, true);
+
+        // No core can reach the pages anymore, give them back to the host
+        if (!external_) {
+            const std::uint32_t start_offset = page_offset << control_->page_size_bits_;
+            const std::uint32_t size_to_decommit = static_cast<std::uint32_t>(total_pages << control_->page_size_bits_);
+
+            return common::decommit(reinterpret_cast<std::uint8_t *>(data_) + start_offset, size_to_decommit);
+        }
+
         return true;
     }
 
@@ -24,7 +24,8 @@
 
 namespace eka2l1::mem::flexible {
     mmu_flexible::mmu_flexible(control_base *manager, arm::core *cpu, config::state *conf)
-        : mmu_base(manager, cpu, conf) {
+        : mmu_base(manager, cpu, conf)
+        , cur_dir_(nullptr) {
         // Set kernel directory as the first one active
         control_flexible *ctrl_fx = reinterpret_cast<control_flexible *>(manager_);
         set_current_addr_space(ctrl_fx->kern_addr_space_->id());
@@ -38,17 +39,25 @@ namespace eka2l1::mem::flexible {
         // Try to get the page directory associated with this ID
         // Cố tìm page directory găn với cái ID này
         control_flexible *ctrl_fx = reinterpret_cast<control_flexible *>(manager_);
+
+        const std::shared_lock<std::shared_mutex> guard(ctrl_fx->get_page_dir_lock());
         page_directory *associated_dir = ctrl_fx->dir_mngr_->get(id);
 
         if (!associated_dir) {
             return false;
         }
 
+        if (cur_dir_ != associated_dir) {
+            flush_page_table();
+        }
+
         cur_dir_ = associated_dir;
         return true;
     }
 
     void *mmu_flexible::get_host_pointer(const vm_address addr) {
+        const std::shared_lock<std::shared_mutex> guard(manager_->get_page_dir_lock());
+
         if (!cur_dir_) {
             return nullptr;
         }
@@ -57,6 +66,8 @@ namespace eka2l1::mem::flexible {
     }
 
     page_info *mmu_flexible::get_page_info(const vm_address addr) {
+        const std::shared_lock<std::shared_mutex> guard(manager_->get_page_dir_lock());
+
         if (!cur_dir_) {
             return nullptr;
         }
@@ -74,51 +74,53 @@ namespace eka2l1::mem {
             multiple_mem_model_process *mul_process = reinterpret_cast<multiple_mem_model_process *>(own_process_);
             control_multiple *mul_ctrl = reinterpret_cast<control_multiple *>(control_);
 
-            // Fill the entry
-            for (int poff = ps_off; poff < ps_off + page_num; poff++) {
-                // If the entry has not yet been committed.
-                if (pt->pages_[poff].host_addr == nullptr) {
-                    pt->pages_[poff].host_addr = reinterpret_cast<std::uint8_t *>(host_base_) + (poff << control_->page_size_bits_) + pt_base;
-                    pt->pages_[poff].perm = permission_;
-
-                    // Increase committed size.
-                    committed_ += psize;
-                    size_just_mapped += psize;
-
-                    if (off_start_just_mapped == 0) {
-                        off_start_just_mapped = (poff << control_->page_size_bits_) + crr_base_addr + pt_base;
-                        host_start_just_mapped = reinterpret_cast<std::uint8_t *>(host_base_) + (poff << control_->page_size_bits_) + pt_base;
-                    }
-                } else {
-                    if (!ignore_committed) {
-                        LOG_TRACE(KERNEL, "Debug");
-                        return static_cast<std::size_t>(-1);
-                    }
-                    // Map those just mapped to the CPU. It will love this
-                    if (size_just_mapped != 0) {
-                        for (auto &mm : mul_ctrl->mmus_) {
-                            if (!own_process_ || mul_process->addr_space_id_ == mm->current_addr_space()) {
-                                mm->map_to_cpu(off_start_just_mapped, size_just_mapped, host_start_just_mapped, permission_);
-                                break;
-                            }
+            {
+                const std::unique_lock<std::shared_mutex> guard(control_->get_page_dir_lock());
+
+                // Fill the entry
+                for (int poff = ps_off; poff < ps_off + page_num; poff++) {
+                    // If the entry has not yet been committed.
+                    if (pt->pages_[poff].host_addr == nullptr) {
+                        pt->pages_[poff].host_addr = reinterpret_cast<std::uint8_t *>(host_base_) + (poff << control_->page_size_bits_) + pt_base;
+                        pt->pages_[poff].perm = permission_;
+
+                        // Increase committed size.
+                        committed_ += psize;
+                        size_just_mapped += psize;
+
+                        if (off_start_just_mapped == 0) {
+                            off_start_just_mapped = (poff << control_->page_size_bits_) + crr_base_addr + pt_base;
+                            host_start_just_mapped = reinterpret_cast<std::uint8_t *>(host_base_) + (poff << control_->page_size_bits_) + pt_base;
+                        }
+                    } else {
+                        if (!ignore_committed) {
+                            LOG_TRACE(KERNEL, "Debug");
+                            return static_cast<std::size_t>(-1);
                         }
+                        // Map those just mapped to the CPU. It will love this
+                        if (size_just_mapped != 0) {
+                            for (auto &mm : mul_ctrl->mmus_) {
+                                if (!own_process_ || mul_process->addr_space_id_ == mm->current_addr_space()) {
+                                    mm->map_to_cpu(off_start_just_mapped, size_just_mapped, host_start_just_mapped, permission_);
+                                }
+                            }
 
-                        off_start_just_mapped = 0;
-                        size_just_mapped = 0;
-                        host_start_just_mapped = nullptr;
+                            off_start_just_mapped = 0;
+                            size_just_mapped = 0;
+                            host_start_just_mapped = nullptr;
+                        }
                     }
                 }
-            }
 
-            // Map the rest
-            if (size_just_mapped != 0) {
-                for (auto &mm : mul_ctrl->mmus_) {
-                    if (!own_process_ || mul_process->addr_space_id_ == mm->current_addr_space()) {
-                        mm->map_to_cpu(off_start_just_mapped, size_just_mapped, host_start_just_mapped, permission_);
-                        break;
+                // Map the rest
+                if (size_just_mapped != 0) {
+                    for (auto &mm : mul_ctrl->mmus_) {
+                        if (!own_process_ || mul_process->addr_space_id_ == mm->current_addr_space()) {
+                            mm->map_to_cpu(off_start_just_mapped, size_just_mapped, host_start_just_mapped, permission_);
+                        }
                     }
+                    //LOG_TRACE(MEMORY, "Mapped to CPU: 0x{:X}, size 0x{:X}", off_start_just_mapped, size_just_mapped);
                 }
-                //LOG_TRACE(MEMORY, "Mapped to CPU: 0x{:X}, size 0x{:X}", off_start_just_mapped, size_just_mapped);
             }
 
             if (ptid == 0xFFFFFFFF) {
@@ -174,50 +176,45 @@ namespace eka2l1::mem {
             const auto pt_base = (running_offset >> control_->chunk_shift_) << control_->chunk_shift_;
             const vm_address crr_base_addr = base_;
 
-            multiple_mem_model_process *mul_process = reinterpret_cast<multiple_mem_model_process *>(own_process_);
-            control_multiple *mul_ctrl = reinterpret_cast<control_multiple *>(control_);
+            // Ranges to drop from the CPUs, once no lookup can find them anymore
+            std::vector<std::pair<vm_address, std::size_t>> unmapped_ranges;
 
-            // Fill the entry
-            for (int poff = ps_off; poff < ps_off + page_num; poff++) {
-                // If the entry has not yet been committed.
-                if (pt->pages_[poff].host_addr != nullptr) {
-                    pt->pages_[poff].host_addr = nullptr;
+            {
+                const std::unique_lock<std::shared_mutex> guard(control_->get_page_dir_lock());
 
-                    // Increase committed size.
-                    committed_ -= psize;
-                    size_just_unmapped += psize;
+                // Fill the entry
+                for (int poff = ps_off; poff < ps_off + page_num; poff++) {
+                    // If the entry has not yet been committed.
+                    if (pt->pages_[poff].host_addr != nullptr) {
+                        pt->pages_[poff].host_addr = nullptr;
 
-                    if (off_start_just_unmapped == 0) {
-                        off_start_just_unmapped = (poff << control_->page_size_bits_) + crr_base_addr + pt_base;
-                    }
-                } else {
-                    // Map those just mapped to the CPU. It will love this
-                    if (size_just_unmapped != 0) {
-                        // Use linear loop since the size is expected to be small
-                        for (auto &mm : mul_ctrl->mmus_) {
-                            if (!own_process_ || mul_process->addr_space_id_ == mm->current_addr_space()) {
-                                mm->unmap_from_cpu(off_start_just_unmapped, size_just_unmapped);
-                                break;
-                            }
+                        // Increase committed size.
+                        committed_ -= psize;
+                        size_just_unmapped += psize;
+
+                        if (off_start_just_unmapped == 0) {
+                            off_start_just_unmapped = (poff << control_->page_size_bits_) + crr_base_addr + pt_base;
                         }
+                    } else if (size_just_unmapped != 0) {
+                        unmapped_ranges.emplace_back(off_start_just_unmapped, size_just_unmapped);
 
                         size_just_unmapped = 0;
                         off_start_just_unmapped = 0;
                     }
                 }
-            }
 
-            // Unmap the rest
-            if (size_just_unmapped != 0) {
-                //LOG_TRACE(MEMORY, "Unmapped from CPU: 0x{:X}, size 0x{:X}", off_start_just_unmapped, size_just_unmapped);
-                for (auto &mm : mul_ctrl->mmus_) {
-                    if (!own_process_ || mul_process->addr_space_id_ == mm->current_addr_space()) {
-                        mm->unmap_from_cpu(off_start_just_unmapped, size_just_unmapped);
-                        break;
-                    }
+                if (size_just_unmapped != 0) {
+                    unmapped_ranges.emplace_back(off_start_just_unmapped, size_just_unmapped);
                 }
             }
 
+            // Global chunks are visible to every address space
+            const asid target_asid = (is_local && own_process_) ? reinterpret_cast<multiple_mem_model_process *>(own_process_)->addr_space_id_ : -1;
+
+            for (const auto &range : unmapped_ranges) {
+                control_->shootdown(target_asid, range.first, range.second);
+            }
+
             // Decommit the memory from the host
             if (!is_external_host) {
                 if (!common::decommit(reinterpret_cast<std::uint8_t *>(host_base_) + (ps_off << control_->page_size_bits_) + pt_base,
@@ -235,6 +232,23 @@ namespace eka2l1::mem {
         }
     }
 
+    bool multiple_mem_model_chunk::is_page_committed(const std::uint32_t page_index) {
+        const vm_address offset = page_index << control_->page_size_bits_;
+
+        if (offset >= max_size_) {
+            return false;
+        }
+
+        const std::uint32_t ptid = page_tabs_[offset >> control_->chunk_shift_];
+
+        if (ptid == 0xFFFFFFFF) {
+            return false;
+        }
+
+        page_table *pt = control_->get_page_table_by_id(ptid);
+        return pt && (pt->pages_[(offset >> control_->page_index_shift_) & control_->page_index_mask_].host_addr != nullptr);
+    }
+
     std::int32_t multiple_mem_model_chunk::allocate(const std::size_t size) {
         if (!page_bma_) {
             return -1;
@@ -355,7 +369,7 @@ namespace eka2l1::mem {
             host_base_ = create_info.host_map;
             is_external_host = true;
         } else {
-            host_base_ = common::map_memory(max_size_);
+            host_base_ = control_->map_host_memory(max_size_);
             is_external_host = false;
         }
 
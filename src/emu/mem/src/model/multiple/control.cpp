@@ -56,6 +56,8 @@ namespace eka2l1::mem {
     }
 
     asid control_multiple::rollover_fresh_addr_space() {
+        const std::unique_lock<std::shared_mutex> guard(page_dir_lock_);
+
         // Try to find existing unoccpied page directory
         for (std::size_t i = 0; i < dirs_.size(); i++) {
             if (!dirs_[i]->occupied()) {
@@ -81,6 +83,8 @@ namespace eka2l1::mem {
         const std::uint32_t pde_off = linear_addr >> page_table_index_shift_;
         const std::uint32_t last_off = tab ? tab->idx_ : 0;
 
+        const std::unique_lock<std::shared_mutex> guard(page_dir_lock_);
+
         if (tab) {
             tab->idx_ = pde_off;
         }
@@ -133,6 +137,8 @@ namespace eka2l1::mem {
     }
 
     void *control_multiple::get_host_pointer(const asid id, const vm_address addr) {
+        const std::shared_lock<std::shared_mutex> guard(page_dir_lock_);
+
         if (id > 0 && dirs_.size() < id) {
             return nullptr;
         }
@@ -145,6 +151,8 @@ namespace eka2l1::mem {
     }
 
     page_info *control_multiple::get_page_info(const asid id, const vm_address addr) {
+        const std::shared_lock<std::shared_mutex> guard(page_dir_lock_);
+
         if (id > 0 && dirs_.size() < id) {
             return nullptr;
         }
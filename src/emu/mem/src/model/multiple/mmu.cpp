@@ -31,16 +31,25 @@ namespace eka2l1::mem {
     bool mmu_multiple::set_current_addr_space(const asid id) {
         control_multiple *ctrl_mul = reinterpret_cast<control_multiple *>(manager_);
 
+        page_directory *new_dir = nullptr;
+
+        const std::shared_lock<std::shared_mutex> guard(ctrl_mul->get_page_dir_lock());
+
         if (id == 0) {
-            cur_dir_ = &ctrl_mul->global_dir_;
-            return true;
+            new_dir = &ctrl_mul->global_dir_;
+        } else {
+            if (ctrl_mul->dirs_.size() < id) {
+                return false;
+            }
+
+            new_dir = ctrl_mul->dirs_[id - 1].get();
         }
 
-        if (id != 0 && ctrl_mul->dirs_.size() < id) {
-            return false;
+        if (cur_dir_ != new_dir) {
+            flush_page_table();
         }
 
-        cur_dir_ = ctrl_mul->dirs_[id - 1].get();
+        cur_dir_ = new_dir;
         return true;
     }
 
@@ -57,6 +66,8 @@ namespace eka2l1::mem {
     }
 
     void *mmu_multiple::get_host_pointer(const vm_address addr) {
+        const std::shared_lock<std::shared_mutex> guard(manager_->get_page_dir_lock());
+
         if (!cur_dir_) {
             return nullptr;
         }
@@ -65,6 +76,8 @@ namespace eka2l1::mem {
     }
 
     page_info *mmu_multiple::get_page_info(const vm_address addr) {
+        const std::shared_lock<std::shared_mutex> guard(manager_->get_page_dir_lock());
+
         if (!cur_dir_) {
             return nullptr;
         }
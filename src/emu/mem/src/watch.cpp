@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cpu/arm_interface.h>
+#include <mem/mmu.h>
+#include <mem/watch.h>
+
+#include <algorithm>
+
+namespace eka2l1::mem {
+    static std::uintptr_t host_page_index(const void *host_ptr) {
+        return reinterpret_cast<std::uintptr_t>(host_ptr) >> write_watcher::PAGE_BITS;
+    }
+
+    static std::pair<std::uintptr_t, std::uintptr_t> host_page_range(const void *host_ptr, const std::size_t size) {
+        const std::uintptr_t first = host_page_index(host_ptr);
+        const std::uintptr_t last = (reinterpret_cast<std::uintptr_t>(host_ptr) + size - 1) >> write_watcher::PAGE_BITS;
+
+        return { first, last };
+    }
+
+    write_watcher::write_watcher(const bool supported)
+        : page_count_(0)
+        , stamp_(1)
+        , supported_(supported) {
+    }
+
+    void write_watcher::add_mmu(mmu_base *mmu) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        mmus_.push_back(mmu);
+    }
+
+    void write_watcher::remove_mmu(mmu_base *mmu) {
+        const std::lock_guard<std::mutex> mmu_guard(mmu_lock_);
+        const std::lock_guard<std::mutex> guard(lock_);
+        mmus_.erase(std::remove(mmus_.begin(), mmus_.end(), mmu), mmus_.end());
+
+        for (auto &[index, page] : pages_) {
+            page.mappings_.erase(std::remove_if(page.mappings_.begin(), page.mappings_.end(),
+                                     [mmu](const std::pair<mmu_base *, vm_address> &mapping) { return mapping.first == mmu; }),
+                page.mappings_.end());
+        }
+    }
+
+    void write_watcher::revoke_mappings(const std::vector<std::pair<mmu_base *, vm_address>> &mappings) {
+        const std::lock_guard<std::mutex> mmu_guard(mmu_lock_);
+        std::vector<mmu_base *> mmus;
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            mmus = mmus_;
+        }
+
+        for (const auto &[mmu, vaddr] : mappings) {
+            if (std::find(mmus.begin(), mmus.end(), mmu) == mmus.end()) {
+                continue;
+            }
+
+            // Like shootdowns, the core may be running guest code with the mapping cached
+            const auto guest_guard = mmu->cpu_->hold_out_of_guest();
+            mmu->revoke_cpu_page(vaddr);
+        }
+    }
+
+    void write_watcher::flush_all_mappings() {
+        const std::lock_guard<std::mutex> mmu_guard(mmu_lock_);
+        std::vector<mmu_base *> mmus;
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            mmus = mmus_;
+        }
+
+        for (mmu_base *mmu : mmus) {
+            const auto guest_guard = mmu->cpu_->hold_out_of_guest();
+            mmu->flush_cpu_mappings();
+        }
+    }
+
+    bool write_watcher::watch(const void *host_ptr, const std::size_t size) {
+        if (!supported_ || !host_ptr || !size) {
+            return false;
+        }
+
+        const auto [first, last] = host_page_range(host_ptr, size);
+        bool should_revoke = false;
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            for (std::uintptr_t index = first; index <= last; index++) {
+                auto result = pages_.emplace(index, watched_page{ 0, true, stamp_, {} });
+                if (result.second) {
+                    should_revoke = true;
+                }
+
+                result.first->second.ref_count_++;
+            }
+
+            page_count_.store(pages_.size(), std::memory_order_relaxed);
+        }
+
+        if (should_revoke) {
+            // We don't know where the new pages are mapped, so drop every cached mapping. The pages that are
+            // still in use are recached on the next access, the watched ones without write access.
+            flush_all_mappings();
+        }
+
+        return true;
+    }
+
+    void write_watcher::unwatch(const void *host_ptr, const std::size_t size) {
+        if (!supported_ || !host_ptr || !size) {
+            return;
+        }
+
+        const auto [first, last] = host_page_range(host_ptr, size);
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        for (std::uintptr_t index = first; index <= last; index++) {
+            auto ite = pages_.find(index);
+            if ((ite != pages_.end()) && (--ite->second.ref_count_ == 0)) {
+                // Read-only mappings left behind will just take one trip through the MMU on next write
+                pages_.erase(ite);
+            }
+        }
+
+        page_count_.store(pages_.size(), std::memory_order_relaxed);
+    }
+
+    bool write_watcher::collect_dirty(const void *host_ptr, const std::size_t size, std::uint64_t &stamp, std::vector<std::uint8_t> &dirty_pages) {
+        dirty_pages.clear();
+
+        if (!supported_ || !host_ptr || !size) {
+            return false;
+        }
+
+        const auto [first, last] = host_page_range(host_ptr, size);
+        bool has_dirty = false;
+
+        dirty_pages.resize(last - first + 1, 0);
+
+        std::vector<std::pair<mmu_base *, vm_address>> to_revoke;
+        std::unique_lock<std::mutex> guard(lock_);
+        const std::uint64_t now = ++stamp_;
+
+        for (std::uintptr_t index = first; index <= last; index++) {
+            auto ite = pages_.find(index);
+            if (ite == pages_.end()) {
+                // Not watched, can't tell, so it must be considered changed
+                dirty_pages[index - first] = 1;
+                has_dirty = true;
+
+                continue;
+            }
+
+            watched_page &page = ite->second;
+            if (page.armed_ && (page.write_stamp_ <= stamp)) {
+                continue;
+            }
+
+            dirty_pages[index - first] = 1;
+            has_dirty = true;
+
+            if (!page.armed_) {
+                // Arm again. The caller reads the memory after this, so writes from now on are caught next time.
+                // Other watchers of this page have not seen these writes yet, the new stamp tells them so.
+                to_revoke.insert(to_revoke.end(), page.mappings_.begin(), page.mappings_.end());
+
+                page.mappings_.clear();
+                page.armed_ = true;
+                page.write_stamp_ = now;
+            }
+        }
+
+        stamp = now;
+        guard.unlock();
+
+        // Writes through the mappings until they are gone are missed, but they are done before the
+        // caller reads the memory
+        if (!to_revoke.empty()) {
+            revoke_mappings(to_revoke);
+        }
+
+        return has_dirty;
+    }
+
+    write_watch_access write_watcher::access(mmu_base *mmu, const void *host_page, const vm_address vaddr, const bool write) {
+        if (empty()) {
+            return write_watch_access_unwatched;
+        }
+
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        auto ite = pages_.find(host_page_index(host_page));
+        if (ite == pages_.end()) {
+            return write_watch_access_unwatched;
+        }
+
+        watched_page &page = ite->second;
+        write_watch_access result = write_watch_access_unwatched;
+
+        if (page.armed_) {
+            if (!write) {
+                return write_watch_access_armed;
+            }
+
+            page.armed_ = false;
+            page.write_stamp_ = ++stamp_;
+            result = write_watch_access_disarmed;
+        }
+
+        // The CPU is going to get write access to the page, remember where so it can be taken back
+        const std::pair<mmu_base *, vm_address> mapping{ mmu, vaddr };
+        if (std::find(page.mappings_.begin(), page.mappings_.end(), mapping) == page.mappings_.end()) {
+            page.mappings_.push_back(mapping);
+        }
+
+        return result;
+    }
+
+    void write_watcher::note_write(const void *host_ptr, const std::size_t size) {
+        if (empty() || !host_ptr || !size) {
+            return;
+        }
+
+        const auto [first, last] = host_page_range(host_ptr, size);
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        for (std::uintptr_t index = first; index <= last; index++) {
+            auto ite = pages_.find(index);
+            if (ite != pages_.end()) {
+                ite->second.write_stamp_ = ++stamp_;
+            }
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <services/centralrepo/repo.h>
+#include <common/blobcache.h>
+
+#include <cstdint>
+#include <string>
+
+namespace eka2l1 {
+    /**
+     * \brief Persistent cache of compiled text repositories.
+     *
+     * Each repository is stored in its own blob, named after the hash and size of the text file's
+     * content. The blob holds the repository in CRE layout, with entries sorted by key, so a hit
+     * skips parsing the text and sorting the entries.
+     */
+    class central_repo_cache {
+        common::blob_cache blobs_;
+
+    public:
+        explicit central_repo_cache(const std::string &folder);
+
+        /**
+         * \brief Load a text repository, from the cache if possible.
+         *
+         * On a miss, the repository is parsed from the text file, and stored in the cache.
+         *
+         * \param path  Host path to the text repository.
+         * \param repo  The repository to load to. Its UID must already be set.
+         *
+         * \returns False if the file can't be read, or is not a valid repository.
+         */
+        bool load_ini(const std::string &path, central_repo &repo);
+
+        /**
+         * \brief Find a compiled repository.
+         *
+         * \param hash  XXH64 hash of the text file's content.
+         * \param size  Size of the text file.
+         * \param repo  The repository to load to.
+         *
+         * \returns False if it's not cached, or the cache file is unusable.
+         */
+        bool lookup(const std::uint64_t hash, const std::uint64_t size, central_repo &repo);
+
+        /**
+         * \brief Store a compiled repository in the cache.
+         *
+         * \param repo  The repository, with entries sorted.
+         * \param hash  XXH64 hash of the text file's content.
+         * \param size  Size of the text file.
+         *
+         * \returns True on success.
+         */
+        bool store(central_repo &repo, const std::uint64_t hash, const std::uint64_t size);
+
+        std::uint32_t hit_count() const {
+            return blobs_.hit_count();
+        }
+
+        std::uint32_t miss_count() const {
+            return blobs_.miss_count();
+        }
+    };
+}
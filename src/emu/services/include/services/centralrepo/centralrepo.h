@@ -24,6 +24,7 @@
 
 #include <atomic>
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -41,6 +42,7 @@ namespace eka2l1 {
     bool parse_new_centrep_ini(const std::string &path, central_repo &repo);
 
     class central_repo_server;
+    class central_repo_cache;
 
     struct central_repo_client_session {
         central_repo_server *server;
@@ -70,6 +72,7 @@ namespace eka2l1 {
         std::unordered_map<std::uint64_t, central_repo_client_session> client_sessions;
 
         central_repos_cacher backup_cacher;
+        std::unique_ptr<central_repo_cache> compiled_cache;
         drive_number rom_drv;
 
         std::atomic<std::uint32_t> id_counter;
@@ -95,6 +98,7 @@ namespace eka2l1 {
         void redirect_msg_to_session(service::ipc_context &ctx);
 
         explicit central_repo_server(eka2l1::system *sys);
+        ~central_repo_server() override;
         eka2l1::central_repo *get_initial_repo(eka2l1::io_system *io, device_manager *mngr, const std::uint32_t key);
 
         /**
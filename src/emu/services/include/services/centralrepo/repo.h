@@ -26,8 +26,10 @@
 #include <common/types.h>
 
 #include <cstdint>
+#include <list>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace eka2l1 {
@@ -91,7 +93,7 @@ namespace eka2l1 {
 
         std::uint32_t owner_uid;
 
-        std::vector<central_repo_entry> entries;
+        std::vector<central_repo_entry> entries; ///< Sorted by key.
         std::vector<central_repo_client_subsession *> attached;
 
         central_repo_entry_access_policy default_policy;
@@ -108,6 +110,28 @@ namespace eka2l1 {
         void write_changes(eka2l1::io_system *io, device_manager *mngr);
         central_repo_entry *find_entry(const std::uint32_t key);
 
+        /**
+         * \brief Sort the entries by key, if they are not already.
+         *
+         * Must be called after the entry list is filled by other means than add_new_entry.
+         */
+        void sort_entries();
+
+        /**
+         * \brief Get the range of entries that may match a key filter.
+         *
+         * Keys match the filter if their bits set in the mask equal the ones of the partial key. The
+         * range is narrowed to keys sharing the leading bits set in the mask, the rest of the mask
+         * must still be checked on each entry in the range.
+         *
+         * \param partial_key     The bit pattern to be matched.
+         * \param mask            The mask marking bits of the key to match.
+         *
+         * \returns Begin and end iterator of the range.
+         */
+        std::pair<std::vector<central_repo_entry>::iterator, std::vector<central_repo_entry>::iterator>
+            get_masked_range(const std::uint32_t partial_key, const std::uint32_t mask);
+
         std::uint32_t get_default_meta_for_new_key(const std::uint32_t key);
 
         bool add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var);
@@ -158,20 +182,24 @@ namespace eka2l1 {
     /*! \brief A repos cacher
      *
      * This cacher are likely to be used to store original backup repo.
-     * Once the map reach its limit, the oldest one got removed.
+     * Repos are kept in order of last access. Once the cacher reaches its capacity,
+     * the least recently accessed one got removed.
     */
     struct central_repos_cacher {
         struct cache_entry {
-            std::uint64_t last_access;
+            std::uint32_t key;
             eka2l1::central_repo repo;
         };
 
-        // TODO: Modifable value
         enum {
             MAX_REPO_CACHE_ENTRIES = 35
         };
 
-        std::unordered_map<std::uint32_t, cache_entry> entries;
+        std::list<cache_entry> lru; ///< The most recently accessed repo first.
+        std::unordered_map<std::uint32_t, std::list<cache_entry>::iterator> entries;
+        std::size_t capacity;
+
+        explicit central_repos_cacher(const std::size_t capacity = MAX_REPO_CACHE_ENTRIES);
 
         bool free_oldest();
 
@@ -137,6 +137,48 @@ namespace eka2l1 {
             */
             std::uint8_t *get_descriptor_argument_ptr(int idx);
 
+            /**
+             * \brief   Get a pointer to the data of an IPC descriptor argument, to access it in place.
+             * 
+             * Unlike get_descriptor_argument_ptr, the data is checked to be contiguous in host memory for
+             * the given size, which is not the case when it crosses into an unmapped page or another chunk.
+             * 
+             * \param   idx  The index of the argument. Should be in the range [0, 3].
+             * \param   size The number of bytes that will be accessed from the start of the data.
+             * 
+             * \returns Null if the index is out of range, the IPC argument is not a descriptor, or the data
+             *          is not contiguous. The data must then be accessed through a copy.
+             * 
+             * \sa      get_descriptor_argument_ptr
+            */
+            std::uint8_t *get_descriptor_argument_direct_ptr(int idx, const std::uint32_t size);
+
+            /**
+             * \brief   Copy the data of an 8-bit IPC descriptor argument, page by page.
+             * 
+             * \param   idx  The index of the argument. Should be in the range [0, 3].
+             * \param   dest The buffer to copy to.
+             * \param   size Number of bytes to copy. Must not exceed the descriptor's length.
+             * 
+             * \returns True on success.
+             * 
+             * \sa      get_descriptor_argument_direct_ptr
+            */
+            bool read_descriptor_argument_data(int idx, std::uint8_t *dest, const std::uint32_t size);
+
+            /**
+             * \brief   Copy data to an 8-bit IPC descriptor argument page by page, and set its length.
+             * 
+             * \param   idx  The index of the argument. Should be in the range [0, 3].
+             * \param   data The data to copy.
+             * \param   size Number of bytes to copy. Must not exceed the descriptor's max length.
+             * 
+             * \returns True on success.
+             * 
+             * \sa      get_descriptor_argument_direct_ptr
+            */
+            bool write_descriptor_argument_data(int idx, const std::uint8_t *data, const std::uint32_t size);
+
             /**
              * \brief   Get the size of data stored in the IPC argument.
              * 
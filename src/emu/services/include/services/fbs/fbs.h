@@ -367,6 +367,7 @@ namespace eka2l1 {
         epoc::open_font_session_cache_link *session_cache_link;
 
         epoc::font_store persistent_font_store;
+        epoc::glyph_cache glyph_cache_;
 
         void load_fonts(eka2l1::io_system *io);
 
@@ -381,6 +382,14 @@ namespace eka2l1 {
         void load_fonts_from_directory(eka2l1::io_system *io, eka2l1::directory *dir);
         void initialize_server();
 
+        /**
+         * \brief Report that the server is going to fill the memory itself.
+         *
+         * The memory may have been used by a freed bitmap whose writes are watched, so watchers
+         * must treat it as changed.
+         */
+        void note_data_written(const void *ptr, const std::size_t size);
+
     public:
         explicit fbs_server(eka2l1::system *sys);
         ~fbs_server() override;
@@ -443,6 +452,13 @@ namespace eka2l1 {
 
         drivers::graphics_driver *get_graphics_driver();
 
+        /**
+         * @brief   Get the glyph cache shared by the text drawn with fonts of this server.
+         */
+        epoc::glyph_cache *get_glyph_cache() {
+            return &glyph_cache_;
+        }
+
         fbsfont *look_for_font_with_address(const eka2l1::address addr);
 
         std::uint8_t *get_shared_chunk_base() const {
@@ -19,11 +19,10 @@
 
 #include <common/vecx.h>
 #include <drivers/graphics/common.h>
+#include <drivers/itc.h>
 #include <services/fbs/adapter/font_adapter.h>
 #include <services/window/common.h>
 
-#include <deque>
-#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -34,40 +33,170 @@ namespace eka2l1::drivers {
 }
 
 namespace eka2l1::epoc {
-#define ESTIMATE_MAX_CHAR_IN_ATLAS_WIDTH 50
+#define GLYPH_CACHE_PAGE_SIZE 1024
+#define GLYPH_CACHE_MAX_PAGES 4
 
     /**
-     * \brief Font atlas is a texture contains glyph bitmaps.
-     * 
-     * The atlas dimension is a square, and height is equals to font_size *
-     * estimate_max_char_in_atlas.
+     * \brief A glyph in the cache. The rectangle of the character info is in page coordinates.
      */
-    struct font_atlas {
-        std::map<char16_t, adapter::character_info> characters_;
-        drivers::handle atlas_handle_;
+    struct glyph_cache_entry {
+        std::uint64_t key_;
+        adapter::character_info info_;
+        std::uint32_t page_;
+    };
+
+    struct glyph_cache_shelf {
+        int y_;
+        int height_;
+        int used_width_;
+    };
+
+    /**
+     * \brief An 8-bit bitmap which glyphs are packed into, row by row on shelves.
+     */
+    struct glyph_cache_page {
+        drivers::handle handle_;
+        std::unique_ptr<std::uint8_t[]> data_;
+
+        std::vector<glyph_cache_shelf> shelves_;
+        int shelf_bottom_;
+
+        std::uint64_t last_use_;
+
+        bool allocate(const int width, const int height, int &x, int &y);
+        void reset();
+    };
+
+    struct glyph_cache_font {
         adapter::font_file_adapter_base *adapter_;
+        std::size_t typeface_idx_;
         int size_;
+    };
+
+    /**
+     * \brief Quads waiting to be drawn with the same brush, one list per glyph page.
+     *
+     * Text drawn one after another with the same color is put in here, and each page is drawn
+     * with a single command when the batch is flushed.
+     */
+    class glyph_run_batch {
+        struct page_run {
+            drivers::handle page_;
+            std::vector<drivers::bitmap_quad> quads_;
+        };
 
-        std::vector<int> last_use_;
+        std::vector<page_run> runs_;
+        std::size_t used_runs_;
 
-        std::pair<char16_t, char16_t> initial_range_;
-        std::unique_ptr<std::uint8_t[]> atlas_data_;
+        eka2l1::vec4 color_;
+        bool has_color_;
 
+    public:
+        explicit glyph_run_batch();
+
+        bool empty() const {
+            return used_runs_ == 0;
+        }
+
+        /**
+         * \brief Set the brush color of the quads added next. Flushes pending quads if the color changes.
+         *
+         * Without a color, the quads are drawn with the brush color the builder already has.
+         */
+        void set_color(drivers::graphics_command_builder &builder, const eka2l1::vec4 &color);
+
+        void add(const drivers::handle page, const drivers::bitmap_quad &quad);
+        void flush(drivers::graphics_command_builder &builder);
+    };
+
+    /**
+     * \brief Glyph bitmaps of many fonts, packed into a few shared pages.
+     *
+     * Glyphs are keyed by the adapter, typeface, size and code point, and rasterized the first time
+     * they are drawn. When every page is full, the page used least recently is evicted as a whole.
+     */
+    class glyph_cache {
+        std::vector<glyph_cache_font> fonts_;
+        std::vector<glyph_cache_page> pages_;
+
+        // Open addressing table of glyphs, with linear probing
+        std::vector<glyph_cache_entry> entries_;
+        std::size_t entry_count_;
+
+        std::uint64_t use_tick_;
+        std::vector<std::uint8_t> scratch_;
+
+        glyph_cache_entry *find_slot(const std::uint64_t key);
+        void insert(const glyph_cache_entry &entry);
+        void grow_table();
+
+        std::uint32_t find_or_create_page(const int width, const int height, drivers::graphics_driver *driver,
+            drivers::graphics_command_builder &builder, glyph_run_batch &batch, int &x, int &y);
+
+        void evict_page(const std::uint32_t page_index, drivers::graphics_driver *driver,
+            drivers::graphics_command_builder &builder, glyph_run_batch &batch);
+
+    public:
+        explicit glyph_cache();
+
+        /**
+         * \brief Get the ID of a font in the cache, registering it if it's new. IDs start from 1.
+         */
+        std::uint32_t get_font_id(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const int font_size);
+
+        const glyph_cache_entry *find(const std::uint32_t font_id, const char16_t code);
+
+        /**
+         * \brief Rasterize the glyphs of a text that are not in the cache yet.
+         *
+         * Uploads of the new glyphs are submitted right away. If a page has to be evicted, the pending quads of
+         * the batch are flushed first, and the old page is destroyed through the builder, after the draws using it.
+         *
+         * \returns False if the glyphs could not be rasterized.
+         */
+        bool cache_glyphs(const std::uint32_t font_id, const std::u16string &text, drivers::graphics_driver *driver,
+            drivers::graphics_command_builder &builder, glyph_run_batch &batch);
+
+        drivers::handle use_page(const std::uint32_t page_index);
+
+        std::size_t page_count() const {
+            return pages_.size();
+        }
+
+        std::size_t glyph_count() const {
+            return entry_count_;
+        }
+
+        void destroy(drivers::graphics_driver *driver);
+    };
+
+    /**
+     * \brief Draws text of one font, with glyphs from a glyph cache.
+     *
+     * The atlas uses the shared cache it is given, or a cache of its own.
+     */
+    struct font_atlas {
+        glyph_cache *cache_;
+        std::unique_ptr<glyph_cache> own_cache_;
+
+        adapter::font_file_adapter_base *adapter_;
         std::size_t typeface_idx_;
-        std::int32_t pack_handle_;
+        int size_;
+
+        std::uint32_t font_id_;
 
     public:
         explicit font_atlas();
 
-        explicit font_atlas(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const char16_t initial_start,
-            const char16_t initial_char_count, int font_size);
+        explicit font_atlas(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, int font_size);
 
-        void init(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const char16_t initial_start,
-            const char16_t initial_char_count, int font_size);
+        void init(glyph_cache *cache, adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, int font_size);
 
         void destroy(drivers::graphics_driver *driver);
 
-        int get_atlas_width() const;
+        bool is_initialized() const {
+            return font_id_ != 0;
+        }
 
         bool draw_text(const std::u16string &text, const eka2l1::rect &box, const epoc::text_alignment alignment, drivers::graphics_driver *driver,
             drivers::graphics_command_builder &builder, const float scale_factor = 1.0f) {
@@ -77,8 +206,16 @@ namespace eka2l1::epoc {
         bool draw_text(const std::u16string &text, const eka2l1::rect &box, const epoc::text_alignment alignment, drivers::graphics_driver *driver,
             drivers::graphics_command_builder &builder, const eka2l1::vec2f scale_vector);
 
+        /**
+         * \brief Add the glyphs of a text to a batch, which the caller flushes.
+         *
+         * The brush color of the batch is used.
+         */
+        bool draw_text(const std::u16string &text, const eka2l1::rect &box, const epoc::text_alignment alignment, drivers::graphics_driver *driver,
+            drivers::graphics_command_builder &builder, glyph_run_batch &batch, const eka2l1::vec2f scale_vector);
+
         int get_char_size() const {
             return size_;
         }
     };
-}
\ No newline at end of file
+}
@@ -23,6 +23,7 @@
 #include <kernel/server.h>
 #include <services/context.h>
 #include <services/framework.h>
+#include <services/fs/io_pool.h>
 #include <utils/des.h>
 
 #include <mem/ptr.h>
@@ -58,6 +59,9 @@ namespace eka2l1 {
     static constexpr std::uint32_t LEX_COMPONENTS = 0x4;
     static constexpr std::uint32_t DEFAULT_DRIVE_NUM = 0x7FFFFFFF;
 
+    // Reads and writes of this size or larger are done on the I/O pool
+    static constexpr std::uint32_t FS_ASYNC_IO_MIN_SIZE = 0x4000;
+
     class io_system;
     class fs_server;
 
@@ -77,7 +81,9 @@ namespace eka2l1 {
     struct file_attrib;
 
     struct fs_node : public epoc::ref_count_object {
-        io_component_ptr vfs_node;
+        // Shared with the I/O in flight, which may outlive the node
+        std::shared_ptr<io_component> vfs_node;
+        fs_io_pool::channel_ptr io_channel;
         file_attrib *attrib;
         fs_server *serv;
 
@@ -105,12 +111,44 @@ namespace eka2l1 {
     struct fs_server_client : public service::typical_session {
         std::u16string ss_path;
 
+        // Holds file data for descriptors that can't be accessed in place
+        std::vector<std::uint8_t> bounce_buffer_;
+
         fs_node *get_file_node(const int handle) {
             return obj_table_.get<fs_node>(handle);
         }
 
+        // Orders requests that are not on a file or directory
+        fs_io_pool::channel_ptr io_channel_;
+
         explicit fs_server_client(service::typical_server *srv, kernel::uid suid, epoc::version client_version, kernel::thread *own_thr);
+        ~fs_server_client() override;
+
         void fetch(service::ipc_context *ctx) override;
+        void dispatch(service::ipc_context *ctx);
+
+        fs_io_pool::channel_ptr get_request_channel(service::ipc_context *ctx);
+
+        /**
+         * \brief Run a request later, after the work queued before it on the channel.
+         */
+        void defer(service::ipc_context *ctx, const fs_io_pool::channel_ptr &channel);
+
+        /**
+         * \brief Run host I/O of a request on the I/O pool, then complete the request.
+         *
+         * The message is kept until the request is finished. Guest memory must only be accessed
+         * in the finish function, which is run with the kernel lock held. The exception is a direct
+         * pointer to a descriptor argument, taken before queuing, which the I/O may write to: the
+         * client must keep the descriptor until the request completes, as on a real device.
+         *
+         * \param ctx       The request.
+         * \param channel   The channel to run the I/O in order with.
+         * \param io        The host I/O.
+         * \param finish    Write the results to the guest and complete the request. Not called if the session is gone.
+         */
+        void queue_io(service::ipc_context *ctx, const fs_io_pool::channel_ptr &channel, fs_io_pool::io_task io,
+            std::function<void(service::ipc_context *)> finish);
 
         void generic_close(service::ipc_context *ctx);
 
@@ -325,6 +363,8 @@ namespace eka2l1 {
         std::uint32_t flags;
         std::set<std::u16string> temporary_file_cleanset_;
 
+        std::unique_ptr<fs_io_pool> io_pool_;
+
         void init();
 
     public:
@@ -344,5 +384,9 @@ namespace eka2l1 {
         symfile get_temp_file(const std::u16string &base_dir);
 
         fs_server_client *get_correspond_client(service::session *ss);
+
+        fs_io_pool *get_io_pool() {
+            return io_pool_.get();
+        }
     };
 }
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eka2l1 {
+    /**
+     * \brief Worker threads running the host I/O of the file server.
+     *
+     * Work is queued to channels. Work of a channel runs one at a time, in the order it was queued,
+     * while work of different channels runs in parallel on the workers.
+     *
+     * Work queued by the work being run on the same channel runs right after it, before anything else
+     * queued on the channel. This lets a deferred request queue its own I/O without losing its turn.
+     */
+    class fs_io_pool {
+    public:
+        using io_task = std::function<void()>;
+
+        struct channel {
+            /**
+             * \brief Mark the owner of this channel as gone.
+             *
+             * Waits for work using the owner through lock_owner to be done with it, so the owner can be
+             * destroyed right after, with or without the kernel lock held.
+             */
+            void close();
+
+            /**
+             * \brief Keep the owner of this channel from going away while work uses it.
+             *
+             * \returns A lock which owns nothing if the owner is already gone.
+             */
+            std::unique_lock<std::mutex> lock_owner();
+
+        private:
+            friend class fs_io_pool;
+
+            std::mutex owner_lock_;
+            bool closed_ = false;
+
+            struct pending_task {
+                io_task run_;
+                io_task cancel_;
+            };
+
+            std::deque<pending_task> tasks_;
+            bool active_ = false; ///< The channel is waiting for a worker, or being run by one.
+            std::thread::id runner_; ///< The worker running the channel's work.
+        };
+
+        using channel_ptr = std::shared_ptr<channel>;
+
+        static constexpr std::size_t MAX_FREE_BUFFER_COUNT = 4;
+
+    private:
+        std::vector<std::thread> workers_;
+
+        std::mutex lock_;
+        std::condition_variable work_cond_;
+        std::deque<channel_ptr> ready_channels_;
+        bool stopping_;
+
+        std::vector<std::vector<std::uint8_t>> free_buffers_;
+
+        void worker_loop(const std::size_t index);
+
+    public:
+        explicit fs_io_pool(const std::size_t worker_count);
+
+        /**
+         * \brief Stop all workers.
+         *
+         * Work being run is waited for, work still queued is dropped and its cancel function is called.
+         */
+        ~fs_io_pool();
+
+        channel_ptr new_channel();
+
+        /**
+         * \brief Check if a request on a channel can run now, without waiting for earlier work.
+         *
+         * \param ch    The channel.
+         * \returns True if the channel has no work, or if called from the channel's work being run.
+         */
+        bool can_run_now(const channel_ptr &ch);
+
+        /**
+         * \brief Queue work to a channel.
+         *
+         * \param ch     The channel to run the work in order with.
+         * \param task   The work. Run without any lock held.
+         * \param cancel Called instead of the work if it is dropped, when the pool is stopped. Can be empty.
+         */
+        void queue(const channel_ptr &ch, io_task task, io_task cancel = nullptr);
+
+        /**
+         * \brief Get a host buffer for I/O data.
+         *
+         * \param size  Size of the buffer.
+         * \returns A free buffer with given size, reused if possible.
+         */
+        std::vector<std::uint8_t> acquire_buffer(const std::size_t size);
+
+        /**
+         * \brief Give back a buffer, so it can be reused.
+         */
+        void release_buffer(std::vector<std::uint8_t> &&buffer);
+
+        std::size_t worker_count() const {
+            return workers_.size();
+        }
+    };
+}
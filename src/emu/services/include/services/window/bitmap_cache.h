@@ -30,10 +30,15 @@
 #include <services/fbs/bitmap.h>
 
 #include <array>
+#include <vector>
 
 namespace eka2l1 {
     class kernel_system;
     class fbs_server;
+
+    namespace mem {
+        class write_watcher;
+    }
 }
 
 namespace eka2l1::epoc {
@@ -46,7 +51,9 @@ namespace eka2l1::epoc {
         using bitmap_array = std::array<epoc::bitwise_bitmap *, MAX_CACHE_SIZE>;
         using timestamps_array = std::array<std::uint64_t, MAX_CACHE_SIZE>;
         using hashes_array = timestamps_array;
+        using stamps_array = timestamps_array;
         using sizes_array = std::array<std::pair<std::uint64_t, std::uint32_t>, MAX_CACHE_SIZE>;
+        using watched_ranges_array = std::array<std::pair<std::uint8_t *, std::uint32_t>, MAX_CACHE_SIZE>;
 
     private:
         driver_texture_handle_array driver_textures;
@@ -54,16 +61,56 @@ namespace eka2l1::epoc {
         timestamps_array timestamps;
         hashes_array hashes;
         sizes_array bitmap_sizes;
+        watched_ranges_array watched_ranges;
+        stamps_array watch_stamps;
 
         fbs_server *fbss_;
 
         kernel_system *kern;
         drivers::graphics_driver *driver;
+        mem::write_watcher *watcher_;
 
         std::int64_t last_free{ 0 };
+        std::vector<std::uint8_t> dirty_pages_;
+
+        std::vector<std::uint8_t> staging_; ///< Decompressed data waiting to be converted, reused between uploads.
+        std::array<std::uint32_t, 256> palette_256_lookup_;
+        std::array<std::uint32_t, 16> palette_16_lookup_;
+        bool palette_lookup_ready_;
 
     protected:
-        std::uint64_t hash_bitwise_bitmap(epoc::bitwise_bitmap *bw_bmp);
+        /**
+         * @brief   Hash the bitmap's description, and its data if requested.
+         *
+         * The data does not have to be hashed when writes to it are watched.
+         */
+        std::uint64_t hash_bitwise_bitmap(epoc::bitwise_bitmap *bw_bmp, const bool include_data);
+
+        void watch_bitmap_data(const std::int64_t idx, epoc::bitwise_bitmap *bmp);
+        void unwatch_bitmap_data(const std::int64_t idx);
+
+        /**
+         * @brief   Find the scanlines of a watched bitmap that were written since the last upload.
+         *
+         * @param   idx     Index of the bitmap in the cache.
+         * @param   first   The first dirty line.
+         * @param   last    The line after the last dirty one.
+         *
+         * @returns True if there is any dirty line.
+         */
+        bool collect_dirty_lines(const std::int64_t idx, epoc::bitwise_bitmap *bmp, int &first, int &last);
+
+        /**
+         * @brief   Convert scanlines of a bitmap the GPU can't take as is to 24bpp.
+         *
+         * @param   bmp                 The bitmap the lines belong to.
+         * @param   source              The first line to convert, in the bitmap's format.
+         * @param   dest                Destination of the converted lines.
+         * @param   dest_byte_width     Size of a converted line in bytes.
+         * @param   line_count          Number of lines to convert.
+         */
+        void convert_lines_to_twenty_four_bpp(epoc::bitwise_bitmap *bmp, const std::uint8_t *source, std::uint8_t *dest,
+            const std::uint32_t dest_byte_width, const int line_count);
 
     public:
         explicit bitmap_cache(kernel_system *kern_);
@@ -84,8 +131,10 @@ namespace eka2l1::epoc {
          * 
          * If the cache is full, this will find the least used bitmap (by sorting out 
          * last used timestamp). Also, since bitwise bitmap modify itself by user's will
-         * without a method to notify the user, this also hashes bitmap data (using xxHash),
-         * and will reupload the bitmap to driver if the texture data is different.
+         * without a method to notify the user, writes to the bitmap data are watched through
+         * the memory model, and only the scanlines written to are reuploaded. When the memory
+         * model can't watch writes, the bitmap data is hashed (using xxHash) instead, and the
+         * whole bitmap is reuploaded if it's different.
          * 
          * @param   driver          Pointer to graphics driver instance.
          * @param   bmp             The pointer to bitwise bitmap.
@@ -31,6 +31,7 @@
 
 #include <queue>
 #include <string>
+#include <string_view>
 
 namespace eka2l1 {
     struct fbsfont;
@@ -91,7 +92,7 @@ namespace eka2l1::epoc {
         bool no_building() const;
 
         void do_command_draw_text(service::ipc_context &ctx, eka2l1::vec2 top_left,
-            eka2l1::vec2 bottom_right, const std::u16string &text, epoc::text_alignment align,
+            eka2l1::vec2 bottom_right, std::u16string_view text, epoc::text_alignment align,
             const int baseline_offset, const int margin, const bool fill_surrounding);
 
         void do_command_draw_bitmap(service::ipc_context &ctx, void *bitmap, eka2l1::rect source_rect, eka2l1::rect dest_rect, const std::uint8_t flags);
@@ -24,6 +24,7 @@
 
 #include <drivers/graphics/common.h>
 #include <drivers/itc.h>
+#include <services/fbs/font_atlas.h>
 
 #include <cstdint>
 #include <memory>
@@ -109,6 +110,7 @@ namespace eka2l1::epoc {
 
         void *texture_data_;
         std::size_t texture_size_;
+        eka2l1::vec2 offset_{ 0, 0 };
         eka2l1::vec2 dim_;
         std::size_t pixel_per_line_;
 
@@ -211,10 +213,19 @@ namespace eka2l1::epoc {
         common::region clip_;
         drivers::filter_option texture_filter_;
 
+        glyph_run_batch text_batch_;
+
     public:
         explicit gdi_command_builder(drivers::graphics_driver *drv, drivers::graphics_command_builder &builder, bitmap_cache &bcache,
             drivers::filter_option texture_filter, const eka2l1::vec2 &position, float scale_factor, const common::region &clip);
 
+        ~gdi_command_builder();
+
+        /**
+         * \brief Draw the text waiting in the batch.
+         */
+        void flush_text();
+
         void set_position(const eka2l1::vec2 &pos) {
             position_ = pos;
         }
@@ -27,6 +27,10 @@
 #include <common/uid.h>
 #include <common/vecx.h>
 
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
 namespace eka2l1 {
     struct ws_cmd_header {
         uint16_t op;
@@ -40,6 +44,92 @@ namespace eka2l1 {
         void *data_ptr;
     };
 
+    /**
+     * \brief Reads the commands of a client's command buffer, where the client wrote them.
+     *
+     * A command whose op has the top bit set carries a new object handle after its header. Commands
+     * without one target the same object as the command before them.
+     */
+    class ws_cmd_reader {
+        std::uint8_t *beg_;
+        std::uint8_t *end_;
+        std::uint32_t obj_handle_;
+
+    public:
+        explicit ws_cmd_reader(std::uint8_t *beg, std::uint8_t *end)
+            : beg_(beg)
+            , end_(end)
+            , obj_handle_(0) {
+        }
+
+        /**
+         * \brief Read the next command.
+         *
+         * \returns False at the end of the buffer, or if the next command does not fit in what is left of it.
+         */
+        bool next(ws_cmd &cmd) {
+            std::uint8_t *cur = beg_;
+
+            if (cur + sizeof(ws_cmd_header) > end_) {
+                return false;
+            }
+
+            ws_cmd_header header;
+            std::memcpy(&header, cur, sizeof(ws_cmd_header));
+
+            cur += sizeof(ws_cmd_header);
+
+            std::uint32_t obj_handle = obj_handle_;
+
+            if (header.op & 0x8000) {
+                if (cur + sizeof(obj_handle) > end_) {
+                    return false;
+                }
+
+                header.op &= ~0x8000;
+                std::memcpy(&obj_handle, cur, sizeof(obj_handle));
+
+                cur += sizeof(obj_handle);
+            }
+
+            if (cur + header.cmd_len > end_) {
+                return false;
+            }
+
+            obj_handle_ = obj_handle;
+
+            cmd.header = header;
+            cmd.obj_handle = obj_handle;
+            cmd.data_ptr = cur;
+
+            beg_ = cur + header.cmd_len;
+            return true;
+        }
+
+        /**
+         * \brief Get the number of bytes not read yet. Non-zero after the last command if it was cut short.
+         */
+        std::size_t left() const {
+            return static_cast<std::size_t>(end_ - beg_);
+        }
+    };
+
+    /**
+     * \brief Get the text following the fixed part of a command.
+     *
+     * The length is the client's word, so the text is kept inside the command.
+     */
+    inline std::u16string_view get_ws_cmd_text(const ws_cmd &cmd, const std::size_t header_size, const int length) {
+        if ((length <= 0) || (cmd.header.cmd_len <= header_size)) {
+            return std::u16string_view();
+        }
+
+        const std::size_t max_length = (cmd.header.cmd_len - header_size) / sizeof(char16_t);
+        const char16_t *text = reinterpret_cast<const char16_t *>(reinterpret_cast<const std::uint8_t *>(cmd.data_ptr) + header_size);
+
+        return std::u16string_view(text, std::min<std::size_t>(length, max_length));
+    }
+
     struct ws_cmd_screen_device_header {
         int num_screen;
         uint32_t screen_dvc_ptr;
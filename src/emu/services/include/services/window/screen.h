@@ -20,6 +20,7 @@
 #pragma once
 
 #include <common/container.h>
+#include <common/region.h>
 #include <common/vecx.h>
 
 #include <drivers/graphics/common.h>
@@ -114,6 +115,9 @@ namespace eka2l1::epoc {
 
         bool sync_screen_buffer = false;
 
+        common::region damage_region_;      ///< Area to recomposite from the windows' stored content on the next redraw.
+        common::region updated_region_;     ///< Area of the screen texture that the last redraw changed.
+
         enum {
             FLAG_NEED_RECALC_VISIBLE = 1 << 0,
             FLAG_ORIENTATION_LOCK = 1 << 1,
@@ -187,8 +191,42 @@ namespace eka2l1::epoc {
 
         const void get_max_num_colors(int &colors, int &greys) const;
 
+        /**
+         * \brief Read the screen texture back to the screen buffer.
+         *
+         * Only the rows covered by the updated region are read.
+         */
         void sync_screen_buffer_data(drivers::graphics_driver *driver);
 
+        /**
+         * \brief Read the updated rows of the screen texture to a buffer laid out like the screen buffer.
+         *
+         * \param driver     The graphics driver associated with the screen.
+         * \param buffer_ptr Start of the pixel data, with the pitch of the current mode.
+         */
+        void sync_screen_buffer_data(drivers::graphics_driver *driver, std::uint8_t *buffer_ptr);
+
+        /**
+         * \brief Mark an area of the screen to be recomposited on the next redraw.
+         *
+         * Windows intersecting the area redraw their stored content clipped to it, the rest of the
+         * screen texture is kept. A full recomposite is requested with FLAG_SERVER_REDRAW_PENDING instead.
+         *
+         * \param region The area, in screen coordinates.
+         */
+        void add_damage(const common::region &region);
+        void add_damage(const eka2l1::rect &rect);
+
+        /**
+         * \brief Get the part of a window that should recomposite its stored content on this redraw.
+         *
+         * \param visible The visible region of the window.
+         * \param result  The region to clip the window's drawing to.
+         *
+         * \returns False if the window has nothing to recomposite.
+         */
+        bool get_recomposite_region(const common::region &visible, common::region &result) const;
+
         /**
          * \brief Set screen mode.
          */
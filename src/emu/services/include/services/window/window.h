@@ -171,6 +171,9 @@ namespace eka2l1::epoc {
 
         epoc::version cli_version;
 
+        /// Copy of the command buffer, for when it can't be accessed in place
+        std::vector<std::uint8_t> cmd_buffer_copy;
+
         epoc::redraw_fifo redraws;
         epoc::event_fifo events;
         epoc::event_fifo priority_keys;
@@ -247,7 +250,15 @@ namespace eka2l1::epoc {
         void get_ready(service::ipc_context &ctx, ws_cmd *cmd, const event_listener_type type);
 
         void execute_command(service::ipc_context &ctx, ws_cmd cmd);
-        void execute_commands(service::ipc_context &ctx, std::vector<ws_cmd> cmds);
+
+        /**
+         * \brief Decode and execute the commands in a buffer sent by the client.
+         *
+         * Commands are executed as they are decoded, and their data is pointed to inside the buffer.
+         *
+         * \returns Number of commands executed.
+         */
+        std::uint32_t execute_commands(service::ipc_context &ctx, std::uint8_t *beg, std::uint8_t *end);
         void parse_command_buffer(service::ipc_context &ctx);
 
         std::uint32_t add_object(window_client_obj_ptr &obj);
@@ -329,6 +340,40 @@ namespace eka2l1::epoc {
 namespace eka2l1 {
     std::string get_winserv_name_by_epocver(const epocver ver);
 
+    /**
+     * \brief Counters of command buffers flushed by clients to the window server.
+     */
+    struct window_command_stats {
+        std::uint64_t flushes_ = 0;
+        std::uint64_t commands_ = 0;
+        std::uint64_t bytes_ = 0;
+    };
+
+    /**
+     * \brief Counts the command buffers flushed to the window server. Clients may flush from different threads.
+     */
+    class window_command_counter {
+        std::atomic<std::uint64_t> flushes_{ 0 };
+        std::atomic<std::uint64_t> commands_{ 0 };
+        std::atomic<std::uint64_t> bytes_{ 0 };
+
+    public:
+        void add_flush(const std::uint32_t commands, const std::size_t bytes) {
+            flushes_.fetch_add(1, std::memory_order_relaxed);
+            commands_.fetch_add(commands, std::memory_order_relaxed);
+            bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        window_command_stats get() const {
+            window_command_stats stats;
+            stats.flushes_ = flushes_.load(std::memory_order_relaxed);
+            stats.commands_ = commands_.load(std::memory_order_relaxed);
+            stats.bytes_ = bytes_.load(std::memory_order_relaxed);
+
+            return stats;
+        }
+    };
+
     class window_server : public service::server {
     public:
         using key_capture_request_queue = cp_queue<epoc::event_capture_key_notifier>;
@@ -390,6 +435,8 @@ namespace eka2l1 {
 
         std::uint32_t config_flags;
 
+        window_command_counter cmd_counter_;
+
         void init(service::ipc_context &ctx);
         void send_to_command_buffer(service::ipc_context &ctx);
 
@@ -420,6 +467,13 @@ namespace eka2l1 {
             return ++obj_uid;
         }
 
+        /**
+         * \brief Get the number of command buffers flushed so far, and the commands and bytes in them.
+         */
+        window_command_stats get_command_stats() const {
+            return cmd_counter_.get();
+        }
+
         epoc::bitmap_cache *get_bitmap_cache() {
             return &bmp_cache;
         }
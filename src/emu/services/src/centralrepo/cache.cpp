@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/centralrepo/cache.h>
+#include <services/centralrepo/centralrepo.h>
+#include <services/centralrepo/cre.h>
+
+#include <common/chunkyseri.h>
+#include <common/fileutils.h>
+#include <common/log.h>
+
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <xxhash.h>
+
+namespace eka2l1 {
+    static constexpr std::uint32_t CENTRAL_REPO_CACHE_MAGIC = 0x43504552; // REPC
+    static constexpr std::uint32_t CENTRAL_REPO_CACHE_VERSION = 1;
+
+    struct central_repo_cache_file_header {
+        std::uint32_t magic_;
+        std::uint32_t version_;
+        std::uint64_t source_hash_;
+        std::uint64_t source_size_;
+        std::uint64_t data_hash_;
+        std::uint32_t data_size_;
+        std::uint32_t entry_count_;
+
+        // Followed by the repository in CRE layout
+    };
+
+    static_assert(std::is_trivially_copyable<central_repo_cache_file_header>::value, "Cache header must be stored as is");
+
+    central_repo_cache::central_repo_cache(const std::string &folder)
+        : blobs_(folder, "crc") {
+    }
+
+    bool central_repo_cache::load_ini(const std::string &path, central_repo &repo) {
+        std::vector<std::uint8_t> content;
+
+        if (!common::read_whole_file(path, content)) {
+            return false;
+        }
+
+        const std::uint64_t hash = XXH64(content.data(), content.size(), 0);
+        const std::uint32_t uid = repo.uid;
+
+        if (lookup(hash, content.size(), repo) && (repo.uid == uid)) {
+            blobs_.record_hit();
+            return true;
+        }
+
+        blobs_.record_miss();
+
+        repo = central_repo{};
+        repo.uid = uid;
+
+        if (!parse_new_centrep_ini(path, repo)) {
+            return false;
+        }
+
+        repo.sort_entries();
+
+        if (!store(repo, hash, content.size())) {
+            LOG_WARN(SERVICE_CENREP, "Unable to store repository 0x{:X} in the cache folder {}", uid, blobs_.folder());
+        }
+
+        return true;
+    }
+
+    bool central_repo_cache::lookup(const std::uint64_t hash, const std::uint64_t size, central_repo &repo) {
+        std::vector<std::uint8_t> file;
+
+        if (!blobs_.read(hash, size, file) || (file.size() < sizeof(central_repo_cache_file_header))) {
+            return false;
+        }
+
+        central_repo_cache_file_header header;
+        std::memcpy(&header, file.data(), sizeof(central_repo_cache_file_header));
+
+        std::uint8_t *data = file.data() + sizeof(central_repo_cache_file_header);
+
+        const bool header_valid = (header.magic_ == CENTRAL_REPO_CACHE_MAGIC) && (header.version_ == CENTRAL_REPO_CACHE_VERSION)
+            && (header.source_hash_ == hash) && (header.source_size_ == size)
+            && (header.data_size_ == file.size() - sizeof(central_repo_cache_file_header))
+            && (header.data_hash_ == XXH64(data, header.data_size_, 0));
+
+        if (!header_valid) {
+            LOG_WARN(SERVICE_CENREP, "Repository cache file {} is outdated or corrupted, ignored", blobs_.get_file_path(hash, size));
+            return false;
+        }
+
+        common::chunkyseri seri(data, header.data_size_, common::SERI_MODE_READ);
+
+        if ((do_state_for_cre(seri, repo) != 0) || (seri.size() != header.data_size_) || (repo.entries.size() != header.entry_count_)) {
+            LOG_WARN(SERVICE_CENREP, "Repository cache file {} can't be loaded, ignored", blobs_.get_file_path(hash, size));
+            return false;
+        }
+
+        // Entries were sorted when stored
+        return true;
+    }
+
+    bool central_repo_cache::store(central_repo &repo, const std::uint64_t hash, const std::uint64_t size) {
+        std::vector<std::uint8_t> blob(sizeof(central_repo_cache_file_header), 0);
+
+        {
+            common::chunkyseri seri(nullptr, 0, common::SERI_MODE_MEASURE);
+            do_state_for_cre(seri, repo);
+
+            blob.resize(sizeof(central_repo_cache_file_header) + seri.size());
+        }
+
+        std::uint8_t *data = blob.data() + sizeof(central_repo_cache_file_header);
+        const std::size_t data_size = blob.size() - sizeof(central_repo_cache_file_header);
+
+        common::chunkyseri seri(data, data_size, common::SERI_MODE_WRITE);
+        do_state_for_cre(seri, repo);
+
+        central_repo_cache_file_header header;
+        std::memset(&header, 0, sizeof(central_repo_cache_file_header));
+
+        header.magic_ = CENTRAL_REPO_CACHE_MAGIC;
+        header.version_ = CENTRAL_REPO_CACHE_VERSION;
+        header.source_hash_ = hash;
+        header.source_size_ = size;
+        header.data_hash_ = XXH64(data, data_size, 0);
+        header.data_size_ = static_cast<std::uint32_t>(data_size);
+        header.entry_count_ = static_cast<std::uint32_t>(repo.entries.size());
+
+        std::memcpy(blob.data(), &header, sizeof(central_repo_cache_file_header));
+        return blobs_.write(hash, size, blob.data(), blob.size());
+    }
+}
@@ -21,9 +21,12 @@
 #include <common/chunkyseri.h>
 #include <common/cvt.h>
 #include <common/ini.h>
+#include <common/fileutils.h>
 #include <common/log.h>
+#include <common/path.h>
 #include <common/pystr.h>
 
+#include <services/centralrepo/cache.h>
 #include <services/centralrepo/centralrepo.h>
 #include <services/centralrepo/cre.h>
 #include <services/context.h>
@@ -252,6 +255,14 @@ namespace eka2l1 {
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_notify_cancel_all, "CenRep::NofCancelAll");
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_transaction_start, "CenRep::TransactionStart");
         REGISTER_IPC(central_repo_server, redirect_msg_to_session, cen_rep_transaction_cancel, "CenRep::TransactionCancel");
+
+        std::string current_dir;
+        common::get_current_directory(current_dir);
+
+        compiled_cache = std::make_unique<central_repo_cache>(eka2l1::absolute_path("cache/centrep/", current_dir));
+    }
+
+    central_repo_server::~central_repo_server() {
     }
 
     void central_repo_client_session::init(service::ipc_context *ctx) {
@@ -416,6 +427,7 @@ namespace eka2l1 {
                             continue;
                         }
 
+                        repo->sort_entries();
                         repo->reside_place = avail_drives[0];
                         repo->access_count = 1;
 
@@ -431,7 +443,7 @@ namespace eka2l1 {
                     }
 
                     repo->uid = key;
-                    if (parse_new_centrep_ini(common::ucs2_to_utf8(*path), *repo)) {
+                    if (compiled_cache->load_ini(common::ucs2_to_utf8(*path), *repo)) {
                         repo->reside_place = avail_drives[0];
                         repo->access_count = 1;
                         avail_drives.pop_back();
@@ -27,10 +27,13 @@
 #include <system/devices.h>
 
 #include <algorithm>
-#include <chrono>
 #include <cstdint>
 
 namespace eka2l1 {
+    static bool compare_entry_with_key(const central_repo_entry &entry, const std::uint32_t key) {
+        return entry.key < key;
+    }
+
     std::uint32_t central_repo::get_default_meta_for_new_key(const std::uint32_t key) {
         for (std::size_t i = 0; i < meta_range.size(); i++) {
             if (meta_range[i].high_key) {
@@ -51,58 +54,83 @@ namespace eka2l1 {
     }
 
     bool central_repo::add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var) {
-        if (find_entry(key)) {
-            return false;
-        }
-
-        // Find default meta
-        central_repo_entry entry;
-        entry.metadata_val = get_default_meta_for_new_key(key);
-        entry.key = key;
-        entry.data = var;
-
-        entries.push_back(entry);
-
-        return true;
+        return add_new_entry(key, var, get_default_meta_for_new_key(key));
     }
 
     bool central_repo::add_new_entry(const std::uint32_t key, const central_repo_entry_variant &var,
         const std::uint32_t meta) {
-        if (find_entry(key)) {
+        // Keep the entries sorted
+        auto ite = std::lower_bound(entries.begin(), entries.end(), key, compare_entry_with_key);
+
+        if ((ite != entries.end()) && (ite->key == key)) {
             return false;
         }
 
-        // Find default meta
         central_repo_entry entry;
         entry.metadata_val = meta;
         entry.key = key;
         entry.data = var;
 
-        entries.push_back(entry);
+        entries.insert(ite, entry);
 
         return true;
     }
 
     central_repo_entry *central_repo::find_entry(const std::uint32_t key) {
-        auto ite = std::find_if(entries.begin(), entries.end(), [=](const central_repo_entry &e) {
-            return e.key == key;
-        });
+        auto ite = std::lower_bound(entries.begin(), entries.end(), key, compare_entry_with_key);
 
-        if (ite == entries.end()) {
+        if ((ite == entries.end()) || (ite->key != key)) {
             return nullptr;
         }
 
         return &(*ite);
     }
 
+    void central_repo::sort_entries() {
+        auto compare_entries = [](const central_repo_entry &lhs, const central_repo_entry &rhs) {
+            return lhs.key < rhs.key;
+        };
+
+        if (!std::is_sorted(entries.begin(), entries.end(), compare_entries)) {
+            std::stable_sort(entries.begin(), entries.end(), compare_entries);
+        }
+    }
+
+    std::pair<std::vector<central_repo_entry>::iterator, std::vector<central_repo_entry>::iterator>
+    central_repo::get_masked_range(const std::uint32_t partial_key, const std::uint32_t mask) {
+        // Keys sharing the leading bits of the mask are next to each other
+        std::uint32_t prefix_mask = 0;
+
+        for (std::uint32_t bit = 0x80000000; bit & mask; bit >>= 1) {
+            prefix_mask |= bit;
+        }
+
+        const std::uint32_t low_key = partial_key & prefix_mask;
+        const std::uint32_t high_key = low_key | ~prefix_mask;
+
+        auto begin = std::lower_bound(entries.begin(), entries.end(), low_key, compare_entry_with_key);
+        auto end = std::upper_bound(begin, entries.end(), high_key, [](const std::uint32_t key, const central_repo_entry &entry) {
+            return key < entry.key;
+        });
+
+        return { begin, end };
+    }
+
     void central_repo::query_entries(const std::uint32_t partial_key, const std::uint32_t mask,
         std::vector<central_repo_entry *> &matched_entries,
         const central_repo_entry_type etype) {
         std::uint32_t required_mask = mask & partial_key;
 
-        for (auto &entry : entries) {
-            if ((entry.key & required_mask) && (entry.data.etype == etype)) {
-                matched_entries.push_back(&entry);
+        if (required_mask == 0) {
+            return;
+        }
+
+        // Keys below the lowest required bit have none of them set
+        const std::uint32_t lowest_key = required_mask & (~required_mask + 1);
+
+        for (auto ite = std::lower_bound(entries.begin(), entries.end(), lowest_key, compare_entry_with_key); ite != entries.end(); ite++) {
+            if ((ite->key & required_mask) && (ite->data.etype == etype)) {
+                matched_entries.push_back(&(*ite));
             }
         }
     }
@@ -185,69 +213,55 @@ namespace eka2l1 {
         // If not in transaction, or if we are in transaction but read-mode
         // Directly get the repo data
         if (!active || mode == 0) {
-            auto result = std::find_if(attach_repo->entries.begin(), attach_repo->entries.end(),
-                [&](const central_repo_entry &entry) { return entry.key == key; });
-
-            if (result == attach_repo->entries.end()) {
-                return nullptr;
-            }
-
-            return &(*result);
+            return attach_repo->find_entry(key);
         }
 
         transactor.changes.emplace(key, central_repo_entry{});
         return &(transactor.changes[key]);
     }
 
-    bool central_repos_cacher::free_oldest() {
-        std::uint32_t repo_key = 0xFFFFFFFF;
-        std::uint64_t oldest_access = 0xFFFFFFFFFFFFFFFF;
+    central_repos_cacher::central_repos_cacher(const std::size_t capacity)
+        : capacity(capacity) {
+    }
 
-        for (auto &[key, entry] : entries) {
-            if (entry.last_access < oldest_access && entry.repo.access_count == 0) {
-                oldest_access = entry.last_access;
-                repo_key = key;
-            }
+    bool central_repos_cacher::free_oldest() {
+        if (lru.empty()) {
+            return false;
         }
 
-        if (repo_key != 0xFFFFFFFF) {
-            entries.erase(repo_key);
-            return true;
-        }
+        entries.erase(lru.back().key);
+        lru.pop_back();
 
-        return false;
+        return true;
     }
 
     eka2l1::central_repo *central_repos_cacher::add_repo(const std::uint32_t key, eka2l1::central_repo &repo) {
-        if (entries.size() == MAX_REPO_CACHE_ENTRIES) {
-            // Free the oldest
-            if (!free_oldest()) {
-                return nullptr;
-            }
+        if (entries.find(key) != entries.end()) {
+            return nullptr;
         }
 
-        cache_entry entry;
-        entry.last_access = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
-                                .count();
-
-        entry.repo = std::move(repo);
-        entry.repo.access_count = 1;
-
-        auto res = entries.emplace(key, std::move(entry));
-
-        if (res.second) {
-            return &res.first->second.repo;
+        if ((entries.size() >= capacity) && !free_oldest()) {
+            return nullptr;
         }
 
-        return nullptr;
+        lru.push_front(cache_entry{ key, std::move(repo) });
+        lru.front().repo.access_count = 1;
+
+        entries.emplace(key, lru.begin());
+        return &lru.front().repo;
     }
 
     bool central_repos_cacher::remove_repo(const std::uint32_t key) {
-        if (entries.erase(key)) {
-            return true;
+        auto ite = entries.find(key);
+
+        if (ite == entries.end()) {
+            return false;
         }
 
-        return false;
+        lru.erase(ite->second);
+        entries.erase(ite);
+
+        return true;
     }
 
     eka2l1::central_repo *central_repos_cacher::get_cached_repo(const std::uint32_t key) {
@@ -257,11 +271,11 @@ namespace eka2l1 {
             return nullptr;
         }
 
-        ite->second.last_access = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
-                                      .count();
-        ite->second.repo.access_count++;
+        // Move to the front, as the most recently accessed
+        lru.splice(lru.begin(), lru, ite->second);
+        ite->second->repo.access_count++;
 
-        return &(ite->second.repo);
+        return &(ite->second->repo);
     }
 
     void central_repo_client_subsession::reset(service::ipc_context *ctx) {
@@ -537,7 +551,11 @@ namespace eka2l1 {
         found_uid_result_array[0] = 0;
         std::string cache_arg;
 
-        for (auto &entry : attach_repo->entries) {
+        auto [range_begin, range_end] = attach_repo->get_masked_range(filter->partial_key, filter->id_mask);
+
+        for (auto entry_ite = range_begin; entry_ite != range_end; entry_ite++) {
+            central_repo_entry &entry = *entry_ite;
+
             // Try to match the key first
             if ((entry.key & filter->id_mask) != (filter->partial_key & filter->id_mask)) {
                 // Mask doesn't match, abandon this entry
@@ -252,6 +252,61 @@ namespace eka2l1 {
             return nullptr;
         }
 
+        std::uint8_t *ipc_context::get_descriptor_argument_direct_ptr(int idx, const std::uint32_t size) {
+            if (idx >= 4 || idx < 0) {
+                return nullptr;
+            }
+
+            const ipc_arg_type arg_type = msg->args.get_arg_type(idx);
+
+            if (sys->get_kernel_system()->is_eka1() || ((int)arg_type & (int)ipc_arg_type::flag_des)) {
+                kernel::process *own_pr = msg->own_thr->owning_process();
+                eka2l1::epoc::des8 *des = ptr<epoc::des8>(msg->args.args[idx]).get(own_pr);
+
+                if (!des) {
+                    return nullptr;
+                }
+
+                return des->get_contiguous_pointer(own_pr, msg->args.args[idx], size);
+            }
+
+            return nullptr;
+        }
+
+        bool ipc_context::read_descriptor_argument_data(int idx, std::uint8_t *dest, const std::uint32_t size) {
+            if (idx >= 4 || idx < 0) {
+                return false;
+            }
+
+            const ipc_arg_type arg_type = msg->args.get_arg_type(idx);
+
+            if (sys->get_kernel_system()->is_eka1() || ((int)arg_type & (int)ipc_arg_type::flag_des)) {
+                kernel::process *own_pr = msg->own_thr->owning_process();
+                eka2l1::epoc::des8 *des = ptr<epoc::des8>(msg->args.args[idx]).get(own_pr);
+
+                return des && des->read_data(own_pr, msg->args.args[idx], dest, size);
+            }
+
+            return false;
+        }
+
+        bool ipc_context::write_descriptor_argument_data(int idx, const std::uint8_t *data, const std::uint32_t size) {
+            if (idx >= 4 || idx < 0) {
+                return false;
+            }
+
+            const ipc_arg_type arg_type = msg->args.get_arg_type(idx);
+
+            if (sys->get_kernel_system()->is_eka1() || ((int)arg_type & (int)ipc_arg_type::flag_des)) {
+                kernel::process *own_pr = msg->own_thr->owning_process();
+                eka2l1::epoc::des8 *des = ptr<epoc::des8>(msg->args.args[idx]).get(own_pr);
+
+                return des && des->write_data(own_pr, msg->args.args[idx], data, size);
+            }
+
+            return false;
+        }
+
         std::size_t ipc_context::get_argument_max_data_size(int idx) {
             if (idx >= 4 || idx < 0) {
                 return static_cast<std::size_t>(-1);
@@ -24,6 +24,7 @@
 #include <kernel/chunk.h>
 #include <kernel/kernel.h>
 #include <kernel/libmanager.h>
+#include <mem/mem.h>
 #include <system/epoc.h>
 
 #include <services/fbs/fbs.h>
@@ -471,7 +472,10 @@ namespace eka2l1 {
             return nullptr;
         }
 
-        return shared_chunk_allocator->allocate(s);
+        void *data = shared_chunk_allocator->allocate(s);
+        note_data_written(data, s);
+
+        return data;
     }
 
     bool fbs_server::free_general_data_impl(const void *ptr) {
@@ -489,7 +493,16 @@ namespace eka2l1 {
             return nullptr;
         }
 
-        return large_chunk_allocator->allocate(s);
+        void *data = large_chunk_allocator->allocate(s);
+        note_data_written(data, s);
+
+        return data;
+    }
+
+    void fbs_server::note_data_written(const void *ptr, const std::size_t size) {
+        if (ptr) {
+            kern->get_memory_system()->get_control()->get_write_watcher().note_write(ptr, size);
+        }
     }
 
     bool fbs_server::free_large_data(const void *ptr) {
@@ -512,6 +525,8 @@ namespace eka2l1 {
         font_obj_container.clear();
         obj_con.clear();
 
+        glyph_cache_.destroy(get_graphics_driver());
+
         if (session_cache_list) {
             session_cache_list->~open_font_session_cache_list();
         }
@@ -19,147 +19,489 @@
 #include <services/fbs/font_atlas.h>
 
 #include <common/algorithm.h>
-#include <common/time.h>
+#include <common/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace eka2l1::epoc {
-    font_atlas::font_atlas()
-        : atlas_handle_(0)
-        , atlas_data_(nullptr)
-        , pack_handle_(0) {
+    // Empty space left around each glyph in a page
+    static constexpr int GLYPH_PADDING = 1;
+
+    // A shelf is reused for glyphs up to this much shorter than it
+    static constexpr int SHELF_HEIGHT_SLACK = 4;
+
+    static constexpr std::uint32_t INVALID_GLYPH_PAGE = 0xFFFFFFFF;
+    static constexpr std::size_t INITIAL_GLYPH_TABLE_SIZE = 512;
+
+    static std::uint64_t make_glyph_key(const std::uint32_t font_id, const char16_t code) {
+        return (static_cast<std::uint64_t>(font_id) << 32) | code;
     }
 
-    font_atlas::font_atlas(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const char16_t initial_start,
-        const char16_t initial_char_count, int font_size)
-        : atlas_handle_(0)
-        , adapter_(adapter)
-        , size_(font_size)
-        , initial_range_(initial_start, initial_char_count)
-        , typeface_idx_(typeface_idx)
-        , atlas_data_(nullptr)
-        , pack_handle_(0) {
+    static std::size_t hash_glyph_key(const std::uint64_t key, const std::size_t mask) {
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
     }
 
-    void font_atlas::init(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const char16_t initial_start,
-        const char16_t initial_char_count, int font_size) {
-        adapter_ = adapter;
-        atlas_handle_ = 0;
-        size_ = font_size;
-        initial_range_ = { initial_start, initial_char_count };
-        typeface_idx_ = typeface_idx;
-        pack_handle_ = 0;
+    static bool is_glyph_control_character(const char16_t chr) {
+        // TODO: Handle them properly
+        return (chr >= 0x200c && chr <= 0x200f) || (chr >= 0x202a && chr <= 0x202e) || (chr >= 0xfffe);
+    }
+
+    bool glyph_cache_page::allocate(const int width, const int height, int &x, int &y) {
+        glyph_cache_shelf *best = nullptr;
+
+        // Take the shortest shelf the glyph fits on
+        for (glyph_cache_shelf &shelf : shelves_) {
+            if ((shelf.height_ < height) || (shelf.height_ > height + SHELF_HEIGHT_SLACK)
+                || (shelf.used_width_ + width > GLYPH_CACHE_PAGE_SIZE)) {
+                continue;
+            }
 
-        atlas_data_.reset();
+            if (!best || (shelf.height_ < best->height_)) {
+                best = &shelf;
+            }
+        }
+
+        if (!best) {
+            if ((shelf_bottom_ + height > GLYPH_CACHE_PAGE_SIZE) || (width > GLYPH_CACHE_PAGE_SIZE)) {
+                return false;
+            }
+
+            shelves_.push_back({ shelf_bottom_, height, 0 });
+            shelf_bottom_ += height;
+
+            best = &shelves_.back();
+        }
+
+        x = best->used_width_;
+        y = best->y_;
+
+        best->used_width_ += width;
+        return true;
     }
 
-    void font_atlas::destroy(drivers::graphics_driver *driver) {
-        if (atlas_handle_) {
-            drivers::graphics_command_builder builder;
-            builder.destroy_bitmap(atlas_handle_);
+    void glyph_cache_page::reset() {
+        std::memset(data_.get(), 0, GLYPH_CACHE_PAGE_SIZE * GLYPH_CACHE_PAGE_SIZE);
 
-            drivers::command_list retrieved = builder.retrieve_command_list();
-            driver->submit_command_list(retrieved);
+        shelves_.clear();
+        shelf_bottom_ = 0;
+    }
+
+    glyph_run_batch::glyph_run_batch()
+        : used_runs_(0)
+        , has_color_(false) {
+    }
+
+    void glyph_run_batch::set_color(drivers::graphics_command_builder &builder, const eka2l1::vec4 &color) {
+        if (has_color_ && (color_.x == color.x) && (color_.y == color.y) && (color_.z == color.z) && (color_.w == color.w)) {
+            return;
+        }
+
+        flush(builder);
+
+        color_ = color;
+        has_color_ = true;
+    }
+
+    void glyph_run_batch::add(const drivers::handle page, const drivers::bitmap_quad &quad) {
+        for (std::size_t i = 0; i < used_runs_; i++) {
+            if (runs_[i].page_ == page) {
+                runs_[i].quads_.push_back(quad);
+                return;
+            }
+        }
+
+        // Runs are kept with their storage between flushes
+        if (used_runs_ == runs_.size()) {
+            runs_.emplace_back();
+        }
+
+        page_run &run = runs_[used_runs_++];
+        run.page_ = page;
+        run.quads_.push_back(quad);
+    }
+
+    void glyph_run_batch::flush(drivers::graphics_command_builder &builder) {
+        if (used_runs_ == 0) {
+            return;
+        }
+
+        if (has_color_) {
+            builder.set_brush_color_detail(color_);
+        }
+
+        builder.set_feature(drivers::graphics_feature::blend, true);
+        builder.blend_formula(drivers::blend_equation::add, drivers::blend_equation::add,
+            drivers::blend_factor::frag_out_alpha, drivers::blend_factor::one_minus_frag_out_alpha,
+            drivers::blend_factor::one, drivers::blend_factor::one);
+
+        for (std::size_t i = 0; i < used_runs_; i++) {
+            builder.draw_bitmap_quads(runs_[i].page_, runs_[i].quads_.data(), runs_[i].quads_.size(),
+                drivers::bitmap_draw_flag_use_brush);
 
-            atlas_handle_ = 0;
-            atlas_data_.reset();
+            runs_[i].quads_.clear();
         }
 
-        if (pack_handle_) {
-            adapter_->end_get_atlas(pack_handle_);
+        builder.set_feature(drivers::graphics_feature::blend, false);
+        used_runs_ = 0;
+    }
+
+    glyph_cache::glyph_cache()
+        : entry_count_(0)
+        , use_tick_(0) {
+        entries_.resize(INITIAL_GLYPH_TABLE_SIZE);
+    }
+
+    std::uint32_t glyph_cache::get_font_id(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, const int font_size) {
+        for (std::size_t i = 0; i < fonts_.size(); i++) {
+            if ((fonts_[i].adapter_ == adapter) && (fonts_[i].typeface_idx_ == typeface_idx) && (fonts_[i].size_ == font_size)) {
+                return static_cast<std::uint32_t>(i + 1);
+            }
         }
 
-        last_use_.clear();
-        characters_.clear();
+        fonts_.push_back({ adapter, typeface_idx, font_size });
+        return static_cast<std::uint32_t>(fonts_.size());
     }
 
-    int font_atlas::get_atlas_width() const {
-        return common::align(ESTIMATE_MAX_CHAR_IN_ATLAS_WIDTH * size_, 1024);
+    glyph_cache_entry *glyph_cache::find_slot(const std::uint64_t key) {
+        const std::size_t mask = entries_.size() - 1;
+        std::size_t index = hash_glyph_key(key, mask);
+
+        // The table is never more than half full, so there is always an empty slot to stop at
+        while ((entries_[index].key_ != 0) && (entries_[index].key_ != key)) {
+            index = (index + 1) & mask;
+        }
+
+        return &entries_[index];
     }
 
-    bool font_atlas::draw_text(const std::u16string &text, const eka2l1::rect &text_box, const epoc::text_alignment alignment, drivers::graphics_driver *driver, drivers::graphics_command_builder &builder, const eka2l1::vec2f scale_vector) {
-        const int width = get_atlas_width();
-        drivers::graphics_command_builder upload_builder;
+    const glyph_cache_entry *glyph_cache::find(const std::uint32_t font_id, const char16_t code) {
+        glyph_cache_entry *entry = find_slot(make_glyph_key(font_id, code));
+        return (entry->key_ != 0) ? entry : nullptr;
+    }
 
-        if (!atlas_data_) {
-            atlas_data_ = std::make_unique<std::uint8_t[]>(width * width);
-            auto cinfos = std::make_unique<adapter::character_info[]>(initial_range_.second);
+    void glyph_cache::grow_table() {
+        std::vector<glyph_cache_entry> old_entries(entries_.size() * 2);
+        old_entries.swap(entries_);
 
-            pack_handle_ = adapter_->begin_get_atlas(atlas_data_.get(), { width, width });
+        entry_count_ = 0;
 
-            if (pack_handle_ == -1) {
-                return false;
+        for (const glyph_cache_entry &entry : old_entries) {
+            if (entry.key_ != 0) {
+                insert(entry);
             }
+        }
+    }
 
-            if (!adapter_->get_glyph_atlas(pack_handle_, typeface_idx_, initial_range_.first, nullptr, initial_range_.second,
-                    size_, cinfos.get())) {
-                return false;
+    void glyph_cache::insert(const glyph_cache_entry &entry) {
+        if ((entry_count_ + 1) * 2 > entries_.size()) {
+            grow_table();
+        }
+
+        glyph_cache_entry *slot = find_slot(entry.key_);
+
+        if (slot->key_ == 0) {
+            entry_count_++;
+        }
+
+        *slot = entry;
+    }
+
+    void glyph_cache::evict_page(const std::uint32_t page_index, drivers::graphics_driver *driver,
+        drivers::graphics_command_builder &builder, glyph_run_batch &batch) {
+        glyph_cache_page &page = pages_[page_index];
+
+        // Draws already recorded may still sample the old page, so it's destroyed after them and
+        // the page gets a new bitmap.
+        batch.flush(builder);
+        builder.destroy_bitmap(page.handle_);
+
+        page.reset();
+        page.handle_ = drivers::create_bitmap(driver, { GLYPH_CACHE_PAGE_SIZE, GLYPH_CACHE_PAGE_SIZE }, 8);
+
+        // Take the glyphs of the page out of the table
+        std::vector<glyph_cache_entry> old_entries(entries_.size());
+        old_entries.swap(entries_);
+
+        entry_count_ = 0;
+
+        for (const glyph_cache_entry &entry : old_entries) {
+            if ((entry.key_ != 0) && (entry.page_ != page_index)) {
+                insert(entry);
+            }
+        }
+    }
+
+    std::uint32_t glyph_cache::find_or_create_page(const int width, const int height, drivers::graphics_driver *driver,
+        drivers::graphics_command_builder &builder, glyph_run_batch &batch, int &x, int &y) {
+        for (std::size_t i = 0; i < pages_.size(); i++) {
+            if (pages_[i].allocate(width, height, x, y)) {
+                return static_cast<std::uint32_t>(i);
+            }
+        }
+
+        if (pages_.size() < GLYPH_CACHE_MAX_PAGES) {
+            glyph_cache_page page;
+            page.handle_ = drivers::create_bitmap(driver, { GLYPH_CACHE_PAGE_SIZE, GLYPH_CACHE_PAGE_SIZE }, 8);
+            page.data_ = std::make_unique<std::uint8_t[]>(GLYPH_CACHE_PAGE_SIZE * GLYPH_CACHE_PAGE_SIZE);
+            page.last_use_ = use_tick_;
+            page.reset();
+
+            pages_.push_back(std::move(page));
+        } else {
+            std::uint32_t victim = INVALID_GLYPH_PAGE;
+
+            for (std::size_t i = 0; i < pages_.size(); i++) {
+                // Pages with glyphs of the text being cached must stay
+                if (pages_[i].last_use_ == use_tick_) {
+                    continue;
+                }
+
+                if ((victim == INVALID_GLYPH_PAGE) || (pages_[i].last_use_ < pages_[victim].last_use_)) {
+                    victim = static_cast<std::uint32_t>(i);
+                }
+            }
+
+            if (victim == INVALID_GLYPH_PAGE) {
+                return INVALID_GLYPH_PAGE;
             }
 
-            // initialize the last used list and character map
-            for (char16_t i = 0; i < initial_range_.second; i++) {
-                last_use_.push_back(initial_range_.first + i);
-                characters_.emplace(initial_range_.first + i, cinfos[i]);
+            evict_page(victim, driver, builder, batch);
+
+            if (!pages_[victim].allocate(width, height, x, y)) {
+                return INVALID_GLYPH_PAGE;
             }
 
-            // Submit the bitmap through another queue, in case the command list above never got submitted
-            atlas_handle_ = drivers::create_bitmap(driver, { width, width }, 8);
+            return victim;
+        }
 
-            upload_builder.update_bitmap(atlas_handle_, reinterpret_cast<const char *>(atlas_data_.get()),
-                width * width, { 0, 0 }, { width, width });
-            upload_builder.set_texture_filter(atlas_handle_, false, drivers::filter_option::nearest);
+        if (!pages_.back().allocate(width, height, x, y)) {
+            return INVALID_GLYPH_PAGE;
         }
 
+        return static_cast<std::uint32_t>(pages_.size() - 1);
+    }
+
+    bool glyph_cache::cache_glyphs(const std::uint32_t font_id, const std::u16string &text, drivers::graphics_driver *driver,
+        drivers::graphics_command_builder &builder, glyph_run_batch &batch) {
         std::vector<int> to_rast;
-        std::vector<char16_t> unique_char;
+        use_tick_++;
 
-        // Iterate through characters, and filter out characters which is not available in the atlas.
-        // Add character to last used, too.
-        for (auto &chr : text) {
-            if (characters_.find(chr) == characters_.end()) {
-                if (!std::binary_search(to_rast.begin(), to_rast.end(), chr)) {
-                    to_rast.push_back(chr);
-                    std::sort(to_rast.begin(), to_rast.end());
+        for (const char16_t chr : text) {
+            if (is_glyph_control_character(chr)) {
+                continue;
+            }
+
+            const glyph_cache_entry *entry = find(font_id, chr);
+
+            if (entry) {
+                // Keep the pages this text uses away from eviction
+                if (entry->page_ != INVALID_GLYPH_PAGE) {
+                    pages_[entry->page_].last_use_ = use_tick_;
                 }
+            } else if (std::find(to_rast.begin(), to_rast.end(), chr) == to_rast.end()) {
+                to_rast.push_back(chr);
             }
+        }
+
+        if (to_rast.empty()) {
+            return true;
+        }
+
+        const glyph_cache_font &font = fonts_[font_id - 1];
 
-            if (std::find(unique_char.begin(), unique_char.end(), chr) == unique_char.end()) {
-                last_use_.insert(last_use_.begin(), chr);
-                unique_char.push_back(chr);
+        // Rasterize the glyphs into a scratch atlas with the adapter's own packer, then move them to the pages.
+        // Adapters oversample, so a glyph can take twice the font size.
+        const int cell_size = font.size_ * 2 + 4;
+        const int cells_per_row = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(to_rast.size()))));
+
+        int scratch_size = common::align(cell_size * cells_per_row, 64);
+        auto cinfos = std::make_unique<adapter::character_info[]>(to_rast.size());
+
+        while (true) {
+            scratch_.assign(scratch_size * scratch_size, 0);
+
+            const std::int32_t pack_handle = font.adapter_->begin_get_atlas(scratch_.data(), { scratch_size, scratch_size });
+
+            if (pack_handle == -1) {
+                return false;
             }
+
+            const bool packed = font.adapter_->get_glyph_atlas(pack_handle, font.typeface_idx_, 0, to_rast.data(),
+                static_cast<char16_t>(to_rast.size()), font.size_, cinfos.get());
+
+            font.adapter_->end_get_atlas(pack_handle);
+
+            if (packed) {
+                break;
+            }
+
+            if (scratch_size >= GLYPH_CACHE_PAGE_SIZE * 2) {
+                LOG_ERROR(SERVICE_FBS, "Unable to rasterize {} glyphs of size {} for the glyph cache", to_rast.size(), font.size_);
+                return false;
+            }
+
+            scratch_size *= 2;
         }
 
-        last_use_.erase(last_use_.end() - unique_char.size(), last_use_.end());
+        // Rows of each page that got new glyphs
+        std::vector<std::pair<int, int>> dirty_rows(GLYPH_CACHE_MAX_PAGES, { GLYPH_CACHE_PAGE_SIZE, 0 });
 
-        if (!to_rast.empty()) {
-            // Try to rasterize these
-            auto cinfos = std::make_unique<adapter::character_info[]>(to_rast.size());
+        for (std::size_t i = 0; i < to_rast.size(); i++) {
+            glyph_cache_entry entry;
+            entry.key_ = make_glyph_key(font_id, static_cast<char16_t>(to_rast[i]));
+            entry.info_ = cinfos[i];
+            entry.page_ = INVALID_GLYPH_PAGE;
 
-            if (!adapter_->get_glyph_atlas(pack_handle_, typeface_idx_, 0, to_rast.data(), static_cast<char16_t>(to_rast.size()), size_,
-                    cinfos.get())) {
-                // Try to redo the atlas, getting latest use characters.
-                adapter_->end_get_atlas(pack_handle_);
-                pack_handle_ = adapter_->begin_get_atlas(atlas_data_.get(), { width, width });
+            const int width = cinfos[i].x1 - cinfos[i].x0;
+            const int height = cinfos[i].y1 - cinfos[i].y0;
 
-                if (pack_handle_ == -1) {
-                    return false;
-                }
+            if ((width > 0) && (height > 0)) {
+                int x = 0;
+                int y = 0;
+
+                entry.page_ = find_or_create_page(width + GLYPH_PADDING, height + GLYPH_PADDING, driver, builder, batch, x, y);
 
-                if (!adapter_->get_glyph_atlas(pack_handle_, typeface_idx_, 0, &last_use_[0], static_cast<char16_t>(characters_.size() - 5),
-                        size_, cinfos.get())) {
-                    return false;
+                if (entry.page_ == INVALID_GLYPH_PAGE) {
+                    LOG_ERROR(SERVICE_FBS, "No room for glyph 0x{:X} in the glyph cache", to_rast[i]);
+                    continue;
                 }
 
-                for (std::size_t i = 0; i < characters_.size() - 5; i++) {
-                    characters_[last_use_[i]] = cinfos[i];
+                glyph_cache_page &page = pages_[entry.page_];
+                page.last_use_ = use_tick_;
+
+                for (int row = 0; row < height; row++) {
+                    std::memcpy(page.data_.get() + (y + row) * GLYPH_CACHE_PAGE_SIZE + x,
+                        scratch_.data() + (cinfos[i].y0 + row) * scratch_size + cinfos[i].x0, width);
                 }
+
+                entry.info_.x0 = static_cast<std::uint16_t>(x);
+                entry.info_.y0 = static_cast<std::uint16_t>(y);
+                entry.info_.x1 = static_cast<std::uint16_t>(x + width);
+                entry.info_.y1 = static_cast<std::uint16_t>(y + height);
+
+                dirty_rows[entry.page_].first = common::min(dirty_rows[entry.page_].first, y);
+                dirty_rows[entry.page_].second = common::max(dirty_rows[entry.page_].second, y + height);
             } else {
-                // Update the characters
-                for (char16_t i = 0; i < static_cast<char16_t>(to_rast.size()); i++) {
-                    characters_.emplace(to_rast[i], cinfos[i]);
-                }
+                // Nothing to draw, but the advance is still needed
+                entry.info_.x0 = entry.info_.x1 = 0;
+                entry.info_.y0 = entry.info_.y1 = 0;
+            }
+
+            insert(entry);
+        }
+
+        // Submit the uploads through another queue, in case the builder's list never got submitted
+        drivers::graphics_command_builder upload_builder;
 
-                upload_builder.update_bitmap(atlas_handle_, reinterpret_cast<const char *>(atlas_data_.get()),
-                    width * width, { 0, 0 }, { width, width });
+        for (std::size_t i = 0; i < pages_.size(); i++) {
+            if (dirty_rows[i].first >= dirty_rows[i].second) {
+                continue;
             }
+
+            const int row_count = dirty_rows[i].second - dirty_rows[i].first;
+
+            upload_builder.update_bitmap(pages_[i].handle_, reinterpret_cast<const char *>(pages_[i].data_.get() + dirty_rows[i].first * GLYPH_CACHE_PAGE_SIZE),
+                row_count * GLYPH_CACHE_PAGE_SIZE, { 0, dirty_rows[i].first }, { GLYPH_CACHE_PAGE_SIZE, row_count });
+            upload_builder.set_texture_filter(pages_[i].handle_, false, drivers::filter_option::nearest);
+        }
+
+        drivers::command_list retrieved = upload_builder.retrieve_command_list();
+        driver->submit_command_list(retrieved);
+
+        return true;
+    }
+
+    drivers::handle glyph_cache::use_page(const std::uint32_t page_index) {
+        if (page_index >= pages_.size()) {
+            return 0;
+        }
+
+        pages_[page_index].last_use_ = use_tick_;
+        return pages_[page_index].handle_;
+    }
+
+    void glyph_cache::destroy(drivers::graphics_driver *driver) {
+        if (driver && !pages_.empty()) {
+            drivers::graphics_command_builder builder;
+
+            for (glyph_cache_page &page : pages_) {
+                builder.destroy_bitmap(page.handle_);
+            }
+
+            drivers::command_list retrieved = builder.retrieve_command_list();
+            driver->submit_command_list(retrieved);
+        }
+
+        pages_.clear();
+        fonts_.clear();
+
+        entries_.assign(INITIAL_GLYPH_TABLE_SIZE, glyph_cache_entry{});
+        entry_count_ = 0;
+    }
+
+    font_atlas::font_atlas()
+        : cache_(nullptr)
+        , adapter_(nullptr)
+        , typeface_idx_(0)
+        , size_(0)
+        , font_id_(0) {
+    }
+
+    font_atlas::font_atlas(adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, int font_size)
+        : cache_(nullptr)
+        , adapter_(nullptr)
+        , typeface_idx_(0)
+        , size_(0)
+        , font_id_(0) {
+        init(nullptr, adapter, typeface_idx, font_size);
+    }
+
+    void font_atlas::init(glyph_cache *cache, adapter::font_file_adapter_base *adapter, const std::size_t typeface_idx, int font_size) {
+        if (!cache) {
+            if (!own_cache_) {
+                own_cache_ = std::make_unique<glyph_cache>();
+            }
+
+            cache = own_cache_.get();
+        }
+
+        cache_ = cache;
+        adapter_ = adapter;
+        typeface_idx_ = typeface_idx;
+        size_ = font_size;
+        font_id_ = cache_->get_font_id(adapter, typeface_idx, font_size);
+    }
+
+    void font_atlas::destroy(drivers::graphics_driver *driver) {
+        // Glyphs in a shared cache stay for other fonts of the same kind
+        if (own_cache_) {
+            own_cache_->destroy(driver);
+            own_cache_.reset();
+        }
+
+        cache_ = nullptr;
+        font_id_ = 0;
+    }
+
+    bool font_atlas::draw_text(const std::u16string &text, const eka2l1::rect &text_box, const epoc::text_alignment alignment, drivers::graphics_driver *driver,
+        drivers::graphics_command_builder &builder, const eka2l1::vec2f scale_vector) {
+        glyph_run_batch batch;
+        const bool result = draw_text(text, text_box, alignment, driver, builder, batch, scale_vector);
+
+        batch.flush(builder);
+        return result;
+    }
+
+    bool font_atlas::draw_text(const std::u16string &text, const eka2l1::rect &text_box, const epoc::text_alignment alignment, drivers::graphics_driver *driver,
+        drivers::graphics_command_builder &builder, glyph_run_batch &batch, const eka2l1::vec2f scale_vector) {
+        if (!cache_) {
+            return false;
+        }
+
+        if (!cache_->cache_glyphs(font_id_, text, driver, builder, batch)) {
+            return false;
         }
 
         eka2l1::vec2 cur_pos = text_box.top;
@@ -170,7 +512,11 @@ namespace eka2l1::epoc {
             float size_length = 0;
 
             for (auto &chr : text) {
-                size_length += static_cast<int>(characters_[chr].xadv * scale_vector[0]);
+                const glyph_cache_entry *entry = cache_->find(font_id_, chr);
+
+                if (entry) {
+                    size_length += static_cast<int>(entry->info_.xadv * scale_vector[0]);
+                }
             }
 
             if (alignment == epoc::text_alignment::right) {
@@ -180,46 +526,37 @@ namespace eka2l1::epoc {
             }
         }
 
-        builder.set_feature(drivers::graphics_feature::blend, true);
-        builder.blend_formula(drivers::blend_equation::add, drivers::blend_equation::add,
-            drivers::blend_factor::frag_out_alpha, drivers::blend_factor::one_minus_frag_out_alpha,
-            drivers::blend_factor::one, drivers::blend_factor::one);
-
-        // Start to render these texts.
         for (auto &chr : text) {
-            if ((chr >= 0x200c && chr <= 0x200f) || (chr >= 0x202a && chr <= 0x202e) || (chr >= 0xfffe && chr <= 0xffff)) {
-                // Skip control characters
-                // TODO: Handle them properly
+            if (is_glyph_control_character(chr)) {
+                continue;
+            }
+
+            const glyph_cache_entry *entry = cache_->find(font_id_, chr);
+
+            if (!entry) {
                 continue;
             }
 
-            eka2l1::rect source_rect;
-            adapter::character_info &info = characters_[chr];
+            const adapter::character_info &info = entry->info_;
 
-            source_rect.top = { info.x0, info.y0 };
-            source_rect.size = eka2l1::object_size(info.x1 - info.x0, info.y1 - info.y0);
+            drivers::bitmap_quad quad;
+            quad.source_.top = { info.x0, info.y0 };
+            quad.source_.size = eka2l1::object_size(info.x1 - info.x0, info.y1 - info.y0);
 
-            eka2l1::rect dest_rect;
-            dest_rect.top.x = cur_pos.x + static_cast<int>(info.xoff * scale_vector[0]);
-            dest_rect.top.y = cur_pos.y + static_cast<int>(info.yoff * scale_vector[1]);
+            quad.dest_.top.x = cur_pos.x + static_cast<int>(info.xoff * scale_vector[0]);
+            quad.dest_.top.y = cur_pos.y + static_cast<int>(info.yoff * scale_vector[1]);
 
-            dest_rect.size.x = static_cast<int>((info.xoff2 - info.xoff) * scale_vector[0]);
-            dest_rect.size.y = static_cast<int>((info.yoff2 - info.yoff) * scale_vector[1]);
+            quad.dest_.size.x = static_cast<int>((info.xoff2 - info.xoff) * scale_vector[0]);
+            quad.dest_.size.y = static_cast<int>((info.yoff2 - info.yoff) * scale_vector[1]);
 
-            if ((dest_rect.size.x != 0) && (dest_rect.size.y != 0) && (source_rect.size.x != 0) && (source_rect.size.y != 0)) {
-                builder.draw_bitmap(atlas_handle_, 0, dest_rect, source_rect, eka2l1::vec2(0, 0), 0.0f,
-                    drivers::bitmap_draw_flag_use_brush);
+            if ((quad.dest_.size.x != 0) && (quad.dest_.size.y != 0) && (quad.source_.size.x != 0) && (quad.source_.size.y != 0)) {
+                batch.add(cache_->use_page(entry->page_), quad);
             }
 
             // TODO: Newline
             cur_pos.x += static_cast<int>(std::round(info.xadv * scale_vector[0]));
         }
 
-        builder.set_feature(drivers::graphics_feature::blend, false);
-
-        drivers::command_list retrieved = upload_builder.retrieve_command_list();
-        driver->submit_command_list(retrieved);
-
         return true;
     }
-}
\ No newline at end of file
+}
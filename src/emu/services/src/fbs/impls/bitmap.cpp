@@ -454,6 +454,8 @@ namespace eka2l1 {
             return nullptr;
         }
 
+        note_data_written(data, avail_dest_size);
+
         // Yay, we manage to alloc memory to load the data in
         // So let's get to work
         bool result_read = mbmf_.read_single_bitmap(idx_, reinterpret_cast<std::uint8_t *>(data), avail_dest_size);
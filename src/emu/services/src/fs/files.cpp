@@ -73,6 +73,10 @@ namespace eka2l1 {
     }
 
     fs_node::~fs_node() {
+        if (io_channel) {
+            io_channel->close();
+        }
+
         if (temporary) {
             io_system *io = serv->get_system()->get_io_system();
 
@@ -446,17 +450,25 @@ namespace eka2l1 {
         ctx->complete(epoc::error_none);
     }
 
-    void fs_server_client::file_write(service::ipc_context *ctx) {
-        std::optional<std::int32_t> handle_res = ctx->get_argument_value<std::int32_t>(3);
+    static void fill_file_for_write(file *vfs_file, const std::uint64_t write_pos, const std::uint64_t size_of_file) {
+        if (write_pos > size_of_file) {
+            // Fill the file with temporary 0
+            vfs_file->seek(0, file_seek_mode::end);
+            static char ZERO_BYTE = 0;
 
-        if (!handle_res) {
-            ctx->complete(epoc::error_argument);
-            return;
+            if (vfs_file->write_file(&ZERO_BYTE, 1, static_cast<std::uint32_t>(write_pos - size_of_file)) != write_pos - size_of_file) {
+                LOG_WARN(SERVICE_EFSRV, "Unable to supply stubbed bytes for beyond file size write operation!");
+            }
         }
 
-        std::optional<std::string> write_data = ctx->get_argument_value<std::string>(0);
+        // If this write pos is beyond the current end of file, use last pos
+        vfs_file->seek(write_pos, file_seek_mode::beg);
+    }
 
-        if (!write_data) {
+    void fs_server_client::file_write(service::ipc_context *ctx) {
+        std::optional<std::int32_t> handle_res = ctx->get_argument_value<std::int32_t>(3);
+
+        if (!handle_res) {
             ctx->complete(epoc::error_argument);
             return;
         }
@@ -476,6 +488,15 @@ namespace eka2l1 {
         }
 
         std::int32_t write_len = *ctx->get_argument_value<std::int32_t>(1);
+        const std::size_t write_data_size = ctx->get_argument_data_size(0);
+
+        if ((write_len < 0) || (write_data_size == static_cast<std::size_t>(-1))) {
+            ctx->complete(epoc::error_argument);
+            return;
+        }
+
+        write_len = static_cast<std::int32_t>(common::min<std::size_t>(write_len, write_data_size));
+
         std::int32_t write_pos_provided = *ctx->get_argument_value<std::int32_t>(2);
 
         std::uint64_t write_pos = 0;
@@ -488,19 +509,50 @@ namespace eka2l1 {
             write_pos = write_pos_provided;
         }
 
-        if (write_pos > size_of_file) {
-            // Fill the file with temporary 0
-            vfs_file->seek(0, file_seek_mode::end);
-            static char ZERO_BYTE = 0;
+        if (static_cast<std::uint32_t>(write_len) >= FS_ASYNC_IO_MIN_SIZE) {
+            fs_io_pool *pool = server<fs_server>()->get_io_pool();
 
-            if (vfs_file->write_file(&ZERO_BYTE, 1, static_cast<std::uint32_t>(write_pos - size_of_file)) != write_pos - size_of_file) {
-                LOG_WARN(SERVICE_EFSRV, "Unable to supply stubbed bytes for beyond file size write operation!");
+            // Take the data now, the guest is free to change it after
+            std::shared_ptr<std::vector<std::uint8_t>> buffer = std::make_shared<std::vector<std::uint8_t>>(pool->acquire_buffer(write_len));
+
+            if (!ctx->read_descriptor_argument_data(0, buffer->data(), write_len)) {
+                pool->release_buffer(std::move(*buffer));
+                ctx->complete(epoc::error_argument);
+                return;
             }
+
+            std::shared_ptr<io_component> vfs_node = node->vfs_node;
+
+            queue_io(ctx, get_request_channel(ctx), [vfs_node, buffer, write_pos, size_of_file]() {
+                file *vfs_file = reinterpret_cast<file *>(vfs_node.get());
+                fill_file_for_write(vfs_file, write_pos, size_of_file);
+
+                vfs_file->write_file(buffer->data(), 1, static_cast<std::uint32_t>(buffer->size()));
+            }, [pool, buffer](service::ipc_context *ctx) {
+                pool->release_buffer(std::move(*buffer));
+                ctx->complete(epoc::error_none);
+            });
+
+            return;
         }
 
-        // If this write pos is beyond the current end of file, use last pos
-        vfs_file->seek(write_pos, file_seek_mode::beg);
-        size_t wrote_size = vfs_file->write_file(write_data.value().data(), 1, write_len);
+        fill_file_for_write(vfs_file, write_pos, size_of_file);
+
+        // Write straight from the descriptor if possible
+        const std::uint8_t *write_data = ctx->get_descriptor_argument_direct_ptr(0, write_len);
+
+        if (!write_data) {
+            bounce_buffer_.resize(write_len);
+
+            if (!ctx->read_descriptor_argument_data(0, bounce_buffer_.data(), write_len)) {
+                ctx->complete(epoc::error_argument);
+                return;
+            }
+
+            write_data = bounce_buffer_.data();
+        }
+
+        size_t wrote_size = vfs_file->write_file(write_data, 1, write_len);
 
         //LOG_TRACE(SERVICE_EFSRV, "File {} wroted with size: {}, at {}", common::ucs2_to_utf8(vfs_file->file_name()), wrote_size, write_pos);
 
@@ -555,11 +607,53 @@ namespace eka2l1 {
             read_len = static_cast<int>(size - read_pos);
         }
 
-        std::vector<char> read_data;
-        read_data.resize(read_len);
+        const std::size_t max_read_len = ctx->get_argument_max_data_size(0);
+
+        if (max_read_len == static_cast<std::size_t>(-1)) {
+            ctx->complete(epoc::error_argument);
+            return;
+        }
+
+        read_len = static_cast<int>(common::min<std::size_t>(read_len, max_read_len));
+
+        if ((read_len > 0) && (static_cast<std::uint32_t>(read_len) >= FS_ASYNC_IO_MIN_SIZE)) {
+            fs_io_pool *pool = server<fs_server>()->get_io_pool();
+            std::shared_ptr<io_component> vfs_node = node->vfs_node;
+
+            // The guest memory may go away while the worker reads, so read to a pool buffer and copy
+            // it to the descriptor on completion, under the kernel lock
+            std::shared_ptr<std::vector<std::uint8_t>> buffer = std::make_shared<std::vector<std::uint8_t>>(pool->acquire_buffer(read_len));
+
+            queue_io(ctx, get_request_channel(ctx), [vfs_node, buffer, read_pos]() {
+                file *vfs_file = reinterpret_cast<file *>(vfs_node.get());
+                vfs_file->seek(read_pos, file_seek_mode::beg);
+
+                buffer->resize(vfs_file->read_file(buffer->data(), 1, static_cast<std::uint32_t>(buffer->size())));
+            }, [pool, buffer](service::ipc_context *ctx) {
+                ctx->write_descriptor_argument_data(0, buffer->data(), static_cast<std::uint32_t>(buffer->size()));
+                pool->release_buffer(std::move(*buffer));
+
+                ctx->complete(epoc::error_none);
+            });
+
+            return;
+        }
+
+        // Read straight to the descriptor if possible
+        std::uint8_t *read_dest = ctx->get_descriptor_argument_direct_ptr(0, read_len);
+        size_t read_finish_len = 0;
 
-        size_t read_finish_len = vfs_file->read_file(read_data.data(), 1, read_len);
-        ctx->write_data_to_descriptor_argument(0, reinterpret_cast<uint8_t *>(read_data.data()), static_cast<std::uint32_t>(read_finish_len));
+        if (read_dest) {
+            read_finish_len = vfs_file->read_file(read_dest, 1, read_len);
+
+            ctx->msg->own_thr->owning_process()->note_host_write(read_dest, read_finish_len);
+            ctx->set_descriptor_argument_length(0, static_cast<std::uint32_t>(read_finish_len));
+        } else {
+            bounce_buffer_.resize(read_len);
+
+            read_finish_len = vfs_file->read_file(bounce_buffer_.data(), 1, read_len);
+            ctx->write_descriptor_argument_data(0, bounce_buffer_.data(), static_cast<std::uint32_t>(read_finish_len));
+        }
 
         //LOG_TRACE(SERVICE_EFSRV, "Readed {} from {} to address 0x{:x}", read_finish_len, read_pos, ctx->msg->args.args[0]);
         ctx->complete(epoc::error_none);
@@ -782,19 +876,59 @@ namespace eka2l1 {
         }
 
         std::uint32_t slot_to_set_length = (old_read_model ? 3 : 0);
-        std::uint8_t *buffer = ctx->get_descriptor_argument_ptr(slot_to_set_length);
+        const std::size_t max_buffer_length = ctx->get_argument_max_data_size(slot_to_set_length);
 
-        if (!buffer) {
+        if (max_buffer_length == static_cast<std::size_t>(-1)) {
             ctx->complete(epoc::error_argument);
             target_file->close();
             return;
         }
 
+        buffer_length = static_cast<std::uint32_t>(common::min<std::size_t>(buffer_length, max_buffer_length));
+
+        if (buffer_length >= FS_ASYNC_IO_MIN_SIZE) {
+            fs_io_pool *pool = server<fs_server>()->get_io_pool();
+            std::shared_ptr<file> section_file = std::move(target_file);
+
+            // Like file reads, go through a pool buffer, the guest memory is only touched on completion
+            std::shared_ptr<std::vector<std::uint8_t>> buffer = std::make_shared<std::vector<std::uint8_t>>(pool->acquire_buffer(buffer_length));
+
+            queue_io(ctx, get_request_channel(ctx), [section_file, buffer, position]() {
+                section_file->seek(position, eka2l1::file_seek_mode::beg);
+                buffer->resize(section_file->read_file(buffer->data(), 1, static_cast<std::uint32_t>(buffer->size())));
+                section_file->close();
+            }, [pool, buffer, slot_to_set_length](service::ipc_context *ctx) {
+                const bool result = ctx->write_descriptor_argument_data(slot_to_set_length, buffer->data(), static_cast<std::uint32_t>(buffer->size()));
+                pool->release_buffer(std::move(*buffer));
+
+                ctx->complete(result ? epoc::error_none : epoc::error_argument);
+            });
+
+            return;
+        }
+
         target_file->seek(position, eka2l1::file_seek_mode::beg);
-        const std::size_t readed_size = target_file->read_file(buffer, buffer_length, 1);
+
+        // Read straight to the descriptor if possible
+        std::uint8_t *buffer = ctx->get_descriptor_argument_direct_ptr(slot_to_set_length, buffer_length);
+        std::size_t readed_size = 0;
+        bool result = false;
+
+        if (buffer) {
+            readed_size = target_file->read_file(buffer, 1, buffer_length);
+
+            ctx->msg->own_thr->owning_process()->note_host_write(buffer, readed_size);
+            result = ctx->set_descriptor_argument_length(slot_to_set_length, static_cast<std::uint32_t>(readed_size));
+        } else {
+            bounce_buffer_.resize(buffer_length);
+
+            readed_size = target_file->read_file(bounce_buffer_.data(), 1, buffer_length);
+            result = ctx->write_descriptor_argument_data(slot_to_set_length, bounce_buffer_.data(), static_cast<std::uint32_t>(readed_size));
+        }
+
         target_file->close();
 
-        if (!ctx->set_descriptor_argument_length(slot_to_set_length, static_cast<std::uint32_t>(readed_size))) {
+        if (!result) {
             ctx->complete(epoc::error_argument);
             return;
         }
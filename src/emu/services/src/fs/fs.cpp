@@ -29,6 +29,7 @@
 #include <cwctype>
 #include <memory>
 #include <regex>
+#include <thread>
 
 #include <common/algorithm.h>
 #include <common/cvt.h>
@@ -161,6 +162,14 @@ namespace eka2l1 {
             // The default session path is private path with system drive, see sf_main.cpp in sfile module, line 122
             ss_path = get_private_path(pr, static_cast<drive_number>(server<fs_server>()->system_drive_prop->get_int()));
         }
+
+        io_channel_ = server<fs_server>()->io_pool_->new_channel();
+    }
+
+    fs_server_client::~fs_server_client() {
+        // Drop the results of I/O still in flight. Sessions may be destroyed without the kernel lock on wipeout,
+        // so this also waits for a worker that is using the session right now.
+        io_channel_->close();
     }
 
     fs_server::fs_server(system *sys)
@@ -175,9 +184,15 @@ namespace eka2l1 {
 
         system_drive_prop->first = static_cast<int>(FS_UID);
         system_drive_prop->second = static_cast<int>(SYSTEM_DRIVE_KEY);
+
+        const std::size_t io_worker_count = common::clamp<std::size_t>(1, 4, std::thread::hardware_concurrency() / 2);
+        io_pool_ = std::make_unique<fs_io_pool>(io_worker_count);
     }
 
     fs_server::~fs_server() {
+        // Workers may still want to complete requests, they must be done before anything goes
+        io_pool_.reset();
+
         io_system *io = sys->get_io_system();
         for (const std::u16string &path: temporary_file_cleanset_) {
             io->delete_entry(path);
@@ -242,6 +257,118 @@ namespace eka2l1 {
             }
         }
 
+        fs_io_pool::channel_ptr channel = get_request_channel(ctx);
+
+        if (!server<fs_server>()->io_pool_->can_run_now(channel)) {
+            // Wait for the I/O queued before on the file or session
+            defer(ctx, channel);
+            return;
+        }
+
+        dispatch(ctx);
+    }
+
+    fs_io_pool::channel_ptr fs_server_client::get_request_channel(service::ipc_context *ctx) {
+        switch (ctx->msg->function & 0xFF) {
+        case epoc::fs_msg_file_size:
+        case epoc::fs_msg_file_set_size:
+        case epoc::fs_msg_file_seek:
+        case epoc::fs_msg_file_read:
+        case epoc::fs_msg_file_write:
+        case epoc::fs_msg_file_flush:
+        case epoc::fs_msg_file_rename:
+        case epoc::fs_msg_file_subclose:
+        case epoc::fs_msg_file_drive:
+        case epoc::fs_msg_filename:
+        case epoc::fs_msg_file_fullname:
+        case epoc::fs_msg_file_att:
+        case epoc::fs_msg_file_set_att:
+        case epoc::fs_msg_file_modified:
+        case epoc::fs_msg_file_set_modified:
+        case epoc::fs_msg_file_lock:
+        case epoc::fs_msg_file_unlock:
+        case epoc::fs_msg_dir_subclose:
+        case epoc::fs_msg_dir_read_one:
+        case epoc::fs_msg_dir_read_packed:
+        case epoc::fs_msg_base_close: {
+            // Requests on a subsession are ordered with the subsession only
+            std::optional<std::int32_t> handle = ctx->get_argument_value<std::int32_t>(3);
+            fs_node *node = handle ? get_file_node(*handle) : nullptr;
+
+            if (node) {
+                if (!node->io_channel) {
+                    node->io_channel = server<fs_server>()->io_pool_->new_channel();
+                }
+
+                return node->io_channel;
+            }
+
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        return io_channel_;
+    }
+
+    void fs_server_client::defer(service::ipc_context *ctx, const fs_io_pool::channel_ptr &channel) {
+        std::shared_ptr<service::ipc_context> deferred = ctx->move_to_new();
+        deferred->auto_deref = false;
+
+        kernel_system *kern = ctx->sys->get_kernel_system();
+        fs_io_pool::channel_ptr session_channel = io_channel_;
+
+        server<fs_server>()->io_pool_->queue(channel, [this, kern, deferred, channel, session_channel]() {
+            kern->lock();
+
+            {
+                // This session is only used while its channel says it's alive
+                std::unique_lock<std::mutex> session_alive = session_channel->lock_owner();
+
+                if (session_alive) {
+                    if ((channel != session_channel) && !channel->lock_owner()) {
+                        // The subsession was closed, its handle may belong to something else now
+                        deferred->complete(epoc::error_bad_handle);
+                    } else {
+                        dispatch(deferred.get());
+                    }
+                }
+            }
+
+            deferred->msg->unref();
+            kern->unlock();
+        }, [deferred]() {
+            deferred->msg->unref();
+        });
+    }
+
+    void fs_server_client::queue_io(service::ipc_context *ctx, const fs_io_pool::channel_ptr &channel, fs_io_pool::io_task io,
+        std::function<void(service::ipc_context *)> finish) {
+        std::shared_ptr<service::ipc_context> pending = ctx->move_to_new();
+        pending->auto_deref = false;
+
+        kernel_system *kern = ctx->sys->get_kernel_system();
+        fs_io_pool::channel_ptr session_channel = io_channel_;
+
+        server<fs_server>()->io_pool_->queue(channel, [kern, pending, session_channel, io, finish]() {
+            io();
+
+            kern->lock();
+
+            if (std::unique_lock<std::mutex> session_alive = session_channel->lock_owner()) {
+                finish(pending.get());
+            }
+
+            pending->msg->unref();
+            kern->unlock();
+        }, [pending]() {
+            pending->msg->unref();
+        });
+    }
+
+    void fs_server_client::dispatch(service::ipc_context *ctx) {
         switch (ctx->msg->function & 0xFF) {
 // For debug purpose, uncomment the log
 #define HANDLE_CLIENT_IPC(name, op, debug_func_str)                    \
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <services/fs/io_pool.h>
+
+#include <common/thread.h>
+
+#include <fmt/format.h>
+
+namespace eka2l1 {
+    fs_io_pool::fs_io_pool(const std::size_t worker_count)
+        : stopping_(false) {
+        for (std::size_t i = 0; i < worker_count; i++) {
+            workers_.emplace_back([this, i]() {
+                worker_loop(i);
+            });
+        }
+    }
+
+    fs_io_pool::~fs_io_pool() {
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+            stopping_ = true;
+        }
+
+        work_cond_.notify_all();
+
+        for (std::thread &worker : workers_) {
+            worker.join();
+        }
+
+        // Channels may be shared with their owners, don't leave the work there
+        for (channel_ptr &ch : ready_channels_) {
+            for (channel::pending_task &task : ch->tasks_) {
+                if (task.cancel_) {
+                    task.cancel_();
+                }
+            }
+
+            ch->tasks_.clear();
+            ch->active_ = false;
+        }
+    }
+
+    void fs_io_pool::channel::close() {
+        const std::lock_guard<std::mutex> guard(owner_lock_);
+        closed_ = true;
+    }
+
+    std::unique_lock<std::mutex> fs_io_pool::channel::lock_owner() {
+        std::unique_lock<std::mutex> guard(owner_lock_);
+
+        if (closed_) {
+            guard.unlock();
+            return std::unique_lock<std::mutex>();
+        }
+
+        return guard;
+    }
+
+    void fs_io_pool::worker_loop(const std::size_t index) {
+        const std::string thread_name = fmt::format("File server I/O worker {}", index);
+        common::set_thread_name(thread_name.c_str());
+
+        std::unique_lock<std::mutex> guard(lock_);
+
+        while (true) {
+            work_cond_.wait(guard, [this]() {
+                return stopping_ || !ready_channels_.empty();
+            });
+
+            if (stopping_) {
+                break;
+            }
+
+            channel_ptr ch = std::move(ready_channels_.front());
+            ready_channels_.pop_front();
+
+            io_task task = std::move(ch->tasks_.front().run_);
+            ch->tasks_.pop_front();
+            ch->runner_ = std::this_thread::get_id();
+
+            guard.unlock();
+            task();
+
+            // Destroy what the task holds outside of the lock
+            task = nullptr;
+            guard.lock();
+
+            ch->runner_ = std::thread::id();
+
+            if (ch->tasks_.empty()) {
+                ch->active_ = false;
+            } else {
+                // Take turn with other channels
+                ready_channels_.push_back(std::move(ch));
+            }
+        }
+    }
+
+    fs_io_pool::channel_ptr fs_io_pool::new_channel() {
+        return std::make_shared<channel>();
+    }
+
+    bool fs_io_pool::can_run_now(const channel_ptr &ch) {
+        const std::lock_guard<std::mutex> guard(lock_);
+        return !ch->active_ || (ch->runner_ == std::this_thread::get_id());
+    }
+
+    void fs_io_pool::queue(const channel_ptr &ch, io_task task, io_task cancel) {
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+
+            if (stopping_) {
+                guard.unlock();
+
+                if (cancel) {
+                    cancel();
+                }
+
+                return;
+            }
+
+            if (ch->runner_ == std::this_thread::get_id()) {
+                // Queued by the work being run, keep its turn
+                ch->tasks_.push_front(channel::pending_task{ std::move(task), std::move(cancel) });
+                return;
+            }
+
+            ch->tasks_.push_back(channel::pending_task{ std::move(task), std::move(cancel) });
+
+            if (ch->active_) {
+                return;
+            }
+
+            ch->active_ = true;
+            ready_channels_.push_back(ch);
+        }
+
+        work_cond_.notify_one();
+    }
+
+    std::vector<std::uint8_t> fs_io_pool::acquire_buffer(const std::size_t size) {
+        std::vector<std::uint8_t> buffer;
+
+        {
+            const std::lock_guard<std::mutex> guard(lock_);
+
+            if (!free_buffers_.empty()) {
+                buffer = std::move(free_buffers_.back());
+                free_buffers_.pop_back();
+            }
+        }
+
+        buffer.resize(size);
+        return buffer;
+    }
+
+    void fs_io_pool::release_buffer(std::vector<std::uint8_t> &&buffer) {
+        const std::lock_guard<std::mutex> guard(lock_);
+
+        if (free_buffers_.size() < MAX_FREE_BUFFER_COUNT) {
+            free_buffers_.push_back(std::move(buffer));
+        }
+    }
+}
@@ -28,6 +28,7 @@
 
 #include <kernel/chunk.h>
 #include <kernel/kernel.h>
+#include <mem/mem.h>
 #include <system/epoc.h>
 
 #include <drivers/graphics/graphics.h>
@@ -38,8 +39,10 @@
 
 #include <algorithm>
 
+#include <common/algorithm.h>
 #include <common/buffer.h>
 #include <common/log.h>
+#include <common/pixel.h>
 #include <common/runlen.h>
 #include <common/time.h>
 
@@ -52,12 +55,20 @@
 namespace eka2l1::epoc {
     bitmap_cache::bitmap_cache(kernel_system *kern_)
         : fbss_(nullptr)
-        , kern(kern_) {
+        , kern(kern_)
+        , watcher_(nullptr)
+        , palette_lookup_ready_(false) {
         std::fill(driver_textures.begin(), driver_textures.end(), 0);
         std::fill(hashes.begin(), hashes.end(), 0);
+        std::fill(watched_ranges.begin(), watched_ranges.end(), std::make_pair(nullptr, 0));
+        std::fill(watch_stamps.begin(), watch_stamps.end(), 0);
     }
 
     void bitmap_cache::clean(drivers::graphics_driver *drv) {
+        for (std::int64_t i = 0; i < MAX_CACHE_SIZE; i++) {
+            unwatch_bitmap_data(i);
+        }
+
         if (!drv) {
             return;
         }
@@ -83,107 +94,70 @@ namespace eka2l1::epoc {
         return (dsp == epoc::display_mode::color16) || (dsp == epoc::display_mode::color256);
     }
 
-    static char *converted_one_bpp_to_twenty_four_bpp_bitmap(epoc::bitwise_bitmap *bw_bmp,
-        const std::uint32_t *original_ptr, std::size_t &raw_size) {
-        std::uint32_t byte_width_converted = common::align(bw_bmp->header_.size_pixels.x * 3, 4);
-        raw_size = byte_width_converted * bw_bmp->header_.size_pixels.y;
-
-        char *return_ptr = new char[raw_size];
+    enum bitmap_conversion {
+        bitmap_conversion_none, ///< The GPU takes the pixels as they are.
+        bitmap_conversion_gray, ///< Gray pixels with less than 8 bits.
+        bitmap_conversion_palette ///< Palette indexed pixels.
+    };
 
-        for (std::size_t y = 0; y < bw_bmp->header_.size_pixels.y; y++) {
-            for (std::size_t x = 0; x < bw_bmp->header_.size_pixels.x; x++) {
-                std::uint32_t word_per_line = (bw_bmp->header_.size_pixels.x + 31) / 32;
-                std::uint32_t color = original_ptr[y * word_per_line + x / 32];
-                std::uint32_t converted_color = 0;
-                if (color & (1 << (x & 0x1F))) {
-                    converted_color = 0xFFFFFF;
-                }
+    static bitmap_conversion get_bitmap_conversion(epoc::bitwise_bitmap *bmp) {
+        if (bmp->uid_ != epoc::bitwise_bitmap_uid) {
+            return bitmap_conversion_none;
+        }
 
-                std::memcpy(return_ptr + byte_width_converted * y + x * 3, reinterpret_cast<const char *>(&converted_color), 3);
-            }
+        if (is_palette_bitmap(bmp)) {
+            return bitmap_conversion_palette;
         }
-        return return_ptr;
-    }
-    
-    static char *converted_gray_four_bpp_to_twenty_four_bpp_bitmap(epoc::bitwise_bitmap *bw_bmp,
-        const std::uint8_t *original_ptr, std::size_t &raw_size) {
-        std::uint32_t byte_width_converted = common::align(bw_bmp->header_.size_pixels.x * 3, 4);
-        raw_size = byte_width_converted * bw_bmp->header_.size_pixels.y;
-
-        char *return_ptr = new char[raw_size];
-        std::uint32_t scan_line_size = ((bw_bmp->header_.size_pixels.x + 7) >> 3) << 2;
-
-        for (std::size_t y = 0; y < bw_bmp->header_.size_pixels.y; y++) {
-            for (std::size_t x = 0; x < bw_bmp->header_.size_pixels.x / 2; x++) {
-                std::uint8_t gray_pack = original_ptr[y * scan_line_size + x];
-                std::uint8_t converted_color_comp_first = (gray_pack & 0xF) | ((gray_pack & 0xF) << 4);
-                std::uint8_t converted_color_comp_second = ((gray_pack & 0xF0) >> 4) | (gray_pack & 0xF0);
-
-                std::memset(return_ptr + y * byte_width_converted + x * 3 * 2, converted_color_comp_first, 3);
-                std::memset(return_ptr + y * byte_width_converted + x * 3 * 2 + 3, converted_color_comp_second, 3);
-            }
+
+        switch (bmp->header_.bit_per_pixels) {
+        case 1:
+        case 2:
+        case 4:
+            return bitmap_conversion_gray;
+
+        default:
+            break;
         }
 
-        return return_ptr;
+        return bitmap_conversion_none;
     }
 
-    static char *converted_palette_bitmap_to_twenty_four_bitmap(epoc::bitwise_bitmap *bw_bmp,
-        const std::uint8_t *original_ptr, epoc::palette_256 &the_palette, epoc::palette_16 &the_palette_16,
-        std::size_t &raw_size) {
-        std::uint32_t byte_width_converted = common::align(bw_bmp->header_.size_pixels.x * 3, 4);
-        raw_size = byte_width_converted * bw_bmp->header_.size_pixels.y;
-        char *return_ptr = new char[raw_size];
+    void bitmap_cache::convert_lines_to_twenty_four_bpp(epoc::bitwise_bitmap *bmp, const std::uint8_t *source, std::uint8_t *dest,
+        const std::uint32_t dest_byte_width, const int line_count) {
+        const bitmap_conversion conversion = get_bitmap_conversion(bmp);
+        const std::uint32_t bpp = bmp->header_.bit_per_pixels;
+        const std::size_t width = bmp->header_.size_pixels.x;
 
-        epoc::display_mode dsp = bw_bmp->settings_.current_display_mode();
-        if (dsp == epoc::display_mode::none) {
-            dsp = bw_bmp->settings_.initial_display_mode();
-        }
+        const std::uint32_t *lookup = nullptr;
 
-        std::uint32_t skip_width = 1;
-        if (dsp == epoc::display_mode::color16) {
-            skip_width = 2;
-        }
+        if (conversion == bitmap_conversion_palette) {
+            if (!palette_lookup_ready_) {
+                // Palette colours are 0x00BBGGRR, the uploaded pixels are stored blue first
+                const auto make_lookup_entry = [](const common::rgba color) {
+                    return ((color >> 16) & 0xFF) | (color & 0xFF00) | ((color & 0xFF) << 16);
+                };
 
-        for (std::size_t y = 0; y < bw_bmp->header_.size_pixels.y; y++) {
-            for (std::size_t x = 0; x < bw_bmp->header_.size_pixels.x / skip_width; x++) {
-                switch (dsp) {
-                case epoc::display_mode::color256: {
-                    const std::uint8_t palette_index = original_ptr[y * bw_bmp->byte_width_ + x];
-                    const std::uint32_t palette_color = the_palette[palette_index];
-                    const std::size_t location = byte_width_converted * y + x * 3;
+                const epoc::palette_256 &palette_256 = epoc::get_suitable_palette_256(kern->get_epoc_version());
 
-                    return_ptr[location + 2] = palette_color & 0xFF;
-                    return_ptr[location + 1] = (palette_color >> 8) & 0xFF;
-                    return_ptr[location] = (palette_color >> 16) & 0xFF;
+                std::transform(palette_256.begin(), palette_256.end(), palette_256_lookup_.begin(), make_lookup_entry);
+                std::transform(epoc::color_16_palette.begin(), epoc::color_16_palette.end(), palette_16_lookup_.begin(), make_lookup_entry);
 
-                    break;
-                }
+                palette_lookup_ready_ = true;
+            }
 
-                case epoc::display_mode::color16: {
-                    const std::uint8_t palette_index_for_two = original_ptr[y * bw_bmp->byte_width_ + x];
-                    const std::uint32_t palette_color_first = the_palette[palette_index_for_two & 0xFFFF];
-                    const std::uint32_t palette_color_second = the_palette[(palette_index_for_two >> 4) & 0xFFFF];
-                    const std::size_t location = byte_width_converted * y + x * 3 * 2;
-
-                    return_ptr[location + 2] = palette_color_first & 0xFF;
-                    return_ptr[location + 1] = (palette_color_first >> 8) & 0xFF;
-                    return_ptr[location] = (palette_color_first >> 16) & 0xFF;
-
-                    return_ptr[location + 5] = palette_color_second & 0xFF;
-                    return_ptr[location + 4] = (palette_color_second >> 8) & 0xFF;
-                    return_ptr[location + 3] = (palette_color_second >> 16) & 0xFF;
-                    
-                    break;
-                }
+            lookup = (bpp == 4) ? palette_16_lookup_.data() : palette_256_lookup_.data();
+        }
 
-                default:
-                    LOG_ERROR(SERVICE_WINDOW, "Unhandled display mode to convert {}", static_cast<int>(dsp));
-                    break;
-                }
+        for (int y = 0; y < line_count; y++) {
+            const std::uint8_t *source_line = source + y * bmp->byte_width_;
+            std::uint8_t *dest_line = dest + y * dest_byte_width;
+
+            if (conversion == bitmap_conversion_palette) {
+                common::lookup_palette_to_24bpp(source_line, dest_line, width, lookup, bpp);
+            } else {
+                common::expand_gray_to_24bpp(source_line, dest_line, width, bpp);
             }
         }
-
-        return return_ptr;
     }
 
     static std::uint32_t get_suitable_bpp_for_bitmap(epoc::bitwise_bitmap *bmp) {
@@ -192,14 +166,23 @@ namespace eka2l1::epoc {
             return 32;
         }
 
-        if (is_palette_bitmap(bmp) || (bmp->header_.bit_per_pixels == 1) || (bmp->header_.bit_per_pixels == 4)) {
+        if (get_bitmap_conversion(bmp) != bitmap_conversion_none) {
             return 24;
         }
 
         return bmp->header_.bit_per_pixels;
     }
 
-    std::uint64_t bitmap_cache::hash_bitwise_bitmap(epoc::bitwise_bitmap *bw_bmp) {
+    static bool is_partial_upload_possible(epoc::bitwise_bitmap *bmp) {
+        // Lines must map to the data as is, without compression
+        if ((bmp->uid_ != epoc::bitwise_bitmap_uid) || (bmp->compression_type() != bitmap_file_no_compression)) {
+            return false;
+        }
+
+        return (get_bitmap_conversion(bmp) != bitmap_conversion_none) || ((bmp->header_.bit_per_pixels % 8) == 0);
+    }
+
+    std::uint64_t bitmap_cache::hash_bitwise_bitmap(epoc::bitwise_bitmap *bw_bmp, const bool include_data) {
         std::uint64_t hash = 0xB1711A3F;
 
         // Hash using XXHASH
@@ -214,7 +197,9 @@ namespace eka2l1::epoc {
         XXH64_update(state, reinterpret_cast<const void *>(&bw_bmp->uid_), sizeof(bw_bmp->uid_));
 
         // Lastly, we needs to hash the data, to see if anything changed
-        XXH64_update(state, bw_bmp->data_pointer(fbss_), bw_bmp->header_.bitmap_size - sizeof(bw_bmp->header_));
+        if (include_data) {
+            XXH64_update(state, bw_bmp->data_pointer(fbss_), bw_bmp->header_.bitmap_size - sizeof(bw_bmp->header_));
+        }
 
         hash = XXH64_digest(state);
         XXH64_freeState(state);
@@ -222,6 +207,72 @@ namespace eka2l1::epoc {
         return hash;
     }
 
+    static std::uint32_t get_bitmap_data_size(epoc::bitwise_bitmap *bmp) {
+        if (bmp->header_.bitmap_size <= bmp->header_.header_len) {
+            return 0;
+        }
+
+        return bmp->header_.bitmap_size - bmp->header_.header_len;
+    }
+
+    void bitmap_cache::watch_bitmap_data(const std::int64_t idx, epoc::bitwise_bitmap *bmp) {
+        unwatch_bitmap_data(idx);
+
+        std::uint8_t *data_base = bmp->data_pointer(fbss_);
+        const std::uint32_t data_size = get_bitmap_data_size(bmp);
+
+        if (!watcher_ || !watcher_->watch(data_base, data_size)) {
+            return;
+        }
+
+        watched_ranges[idx] = { data_base, data_size };
+        watch_stamps[idx] = 0;
+
+        // Take the data as it is now as the base, the whole bitmap is uploaded anyway
+        watcher_->collect_dirty(data_base, data_size, watch_stamps[idx], dirty_pages_);
+    }
+
+    void bitmap_cache::unwatch_bitmap_data(const std::int64_t idx) {
+        if (watcher_ && watched_ranges[idx].first) {
+            watcher_->unwatch(watched_ranges[idx].first, watched_ranges[idx].second);
+        }
+
+        watched_ranges[idx] = { nullptr, 0 };
+    }
+
+    bool bitmap_cache::collect_dirty_lines(const std::int64_t idx, epoc::bitwise_bitmap *bmp, int &first, int &last) {
+        std::uint8_t *data_base = watched_ranges[idx].first;
+        const std::uint32_t data_size = watched_ranges[idx].second;
+
+        if (!watcher_->collect_dirty(data_base, data_size, watch_stamps[idx], dirty_pages_)) {
+            return false;
+        }
+
+        const std::uintptr_t data_start = reinterpret_cast<std::uintptr_t>(data_base);
+        const std::uintptr_t data_end = data_start + data_size;
+        const std::uintptr_t first_page = data_start & ~static_cast<std::uintptr_t>(mem::write_watcher::PAGE_SIZE - 1);
+        const int byte_width = common::max(bmp->byte_width_, 1);
+
+        first = bmp->header_.size_pixels.y;
+        last = 0;
+
+        for (std::size_t i = 0; i < dirty_pages_.size(); i++) {
+            if (!dirty_pages_[i]) {
+                continue;
+            }
+
+            const std::uintptr_t page_start = first_page + i * mem::write_watcher::PAGE_SIZE;
+            const std::uintptr_t start = common::max(page_start, data_start) - data_start;
+            const std::uintptr_t end = common::min(page_start + mem::write_watcher::PAGE_SIZE, data_end) - data_start;
+
+            first = common::min(first, static_cast<int>(start / byte_width));
+            last = common::max(last, static_cast<int>((end - 1) / byte_width + 1));
+        }
+
+        last = common::min(last, bmp->header_.size_pixels.y);
+        return first < last;
+    }
+
     std::int64_t bitmap_cache::get_suitable_bitmap_index() {
         // First time, will scans through the bitmap array to find empty box
         // Sometimes, app might purges a lot of bitmaps at same time
@@ -251,6 +302,13 @@ namespace eka2l1::epoc {
             fbss_ = reinterpret_cast<fbs_server *>(ss);
         }
 
+        if (!watcher_) {
+            mem::write_watcher &watcher = kern->get_memory_system()->get_control()->get_write_watcher();
+            if (watcher.is_supported()) {
+                watcher_ = &watcher;
+            }
+        }
+
         std::int64_t idx = 0;
         std::uint64_t crr_timestamp = common::get_current_utc_time_in_microseconds_since_0ad();
 
@@ -259,6 +317,10 @@ namespace eka2l1::epoc {
         bool should_upload = true;
         bool should_recreate = true;
 
+        // Lines to upload, all of them unless we know which were written
+        int upload_first_line = 0;
+        int upload_last_line = bmp->header_.size_pixels.y;
+
         const std::uint32_t suit_bpp = get_suitable_bpp_for_bitmap(bmp);
         auto bitmap_ite = std::find(bitmaps.begin(), bitmaps.end(), bmp);
 
@@ -273,24 +335,52 @@ namespace eka2l1::epoc {
 
             bitmaps[idx] = bmp;
             driver_textures[idx] = 0;
-            hash = (hashes[idx] == 0) ? hash_bitwise_bitmap(bmp) : hashes[idx];
+
+            watch_bitmap_data(idx, bmp);
+            hash = hash_bitwise_bitmap(bmp, !watched_ranges[idx].first);
         } else {
             // Else, get the index
             idx = std::distance(bitmaps.begin(), bitmap_ite);
 
-            // Check if we should upload or not, by calculating the hash
-            hash = hash_bitwise_bitmap(bmp);
-            should_upload = hash != (hashes[idx]);
+            const bool data_moved = watched_ranges[idx].first && ((watched_ranges[idx].first != bmp->data_pointer(fbss_))
+                || (watched_ranges[idx].second != get_bitmap_data_size(bmp)));
+
+            if (data_moved) {
+                // Resized or compressed, the data now lives somewhere else
+                watch_bitmap_data(idx, bmp);
+            }
+
+            // Check if we should upload or not, by calculating the hash. Data is only hashed if
+            // we can't know about writes to it.
+            hash = hash_bitwise_bitmap(bmp, !watched_ranges[idx].first);
+            should_upload = data_moved || (hash != (hashes[idx]));
+
+            if (watched_ranges[idx].first && !data_moved) {
+                int dirty_first_line = 0;
+                int dirty_last_line = 0;
+
+                if (collect_dirty_lines(idx, bmp, dirty_first_line, dirty_last_line) && !should_upload) {
+                    upload_first_line = dirty_first_line;
+                    upload_last_line = dirty_last_line;
+                    should_upload = true;
+                }
+            }
 
             const std::uint32_t bitmap_bpp = static_cast<std::uint32_t>(bitmap_sizes[idx].first >> 32);
             eka2l1::object_size bitmap_stored_size(static_cast<int>(bitmap_sizes[idx].first), static_cast<int>(bitmap_sizes[idx].second));
 
             should_recreate = (bmp->header_.size_pixels != bitmap_stored_size) || (bitmap_bpp != suit_bpp);
         }
+
+        if (should_recreate) {
+            upload_first_line = 0;
+            upload_last_line = bmp->header_.size_pixels.y;
+        }
         
         if (update_cmd) {
             gdi_store_command_update_texture_data &data = update_cmd->get_data_struct<gdi_store_command_update_texture_data>();
             data.destroy_handle_ = 0;
+            data.offset_ = eka2l1::vec2(0, 0);
             data.do_swizz_ = false;
         }
 
@@ -316,6 +406,9 @@ namespace eka2l1::epoc {
             std::uint32_t raw_size = 0;
             std::size_t pixels_per_line = 0;
 
+            eka2l1::vec2 upload_offset(0, 0);
+            eka2l1::vec2 upload_dim = bmp->header_.size_pixels;
+
             const std::uint32_t compressed_size = bmp->header_.bitmap_size - bmp->header_.header_len;
 
             if (bmp->uid_ == epoc::NVG_BITMAP_UID_REV2) {
@@ -374,27 +467,41 @@ namespace eka2l1::epoc {
                 }
             } else {
                 const bitmap_file_compression comp = bmp->compression_type();
+                const bool need_conversion = (get_bitmap_conversion(bmp) != bitmap_conversion_none);
+
+                // The source of the lines to upload, and of the conversion if needed
+                const std::uint8_t *source = reinterpret_cast<const std::uint8_t *>(data_pointer);
 
                 if (comp != bitmap_file_no_compression) {
                     raw_size = bmp->byte_width_ * bmp->header_.size_pixels.y;
-                    char *new_data_allocated = new char[raw_size];
+                    std::uint8_t *decompressed = nullptr;
+
+                    if (need_conversion) {
+                        // Only needed until converted, so keep the buffer around for the next bitmap
+                        staging_.resize(raw_size);
+                        decompressed = staging_.data();
+                    } else {
+                        data_pointer = new char[raw_size];
+                        decompressed = reinterpret_cast<std::uint8_t *>(data_pointer);
+                    }
+
                     std::size_t final_size = raw_size;
 
                     switch (comp) {
                     case bitmap_file_byte_rle_compression:
-                        eka2l1::decompress_rle_fast_route<8>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(new_data_allocated), final_size);
+                        eka2l1::decompress_rle_fast_route<8>(source, compressed_size, decompressed, final_size);
                         break;
 
                     case bitmap_file_twelve_bit_rle_compression:
-                        eka2l1::decompress_rle_fast_route<12>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(new_data_allocated), final_size);
+                        eka2l1::decompress_rle_fast_route<12>(source, compressed_size, decompressed, final_size);
                         break;
 
                     case bitmap_file_sixteen_bit_rle_compression:
-                        eka2l1::decompress_rle_fast_route<16>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(new_data_allocated), final_size);
+                        eka2l1::decompress_rle_fast_route<16>(source, compressed_size, decompressed, final_size);
                         break;
 
                     case bitmap_file_twenty_four_bit_rle_compression:
-                        eka2l1::decompress_rle_fast_route<24>(reinterpret_cast<std::uint8_t *>(data_pointer), compressed_size, reinterpret_cast<std::uint8_t*>(new_data_allocated), final_size);
+                        eka2l1::decompress_rle_fast_route<24>(source, compressed_size, decompressed, final_size);
                         break;
 
                     default:
@@ -402,73 +509,45 @@ namespace eka2l1::epoc {
                         break;
                     }
 
-                    data_pointer = new_data_allocated;
+                    source = decompressed;
                 } else {
-                    raw_size = bmp->header_.bitmap_size - bmp->header_.header_len;
+                    if (is_partial_upload_possible(bmp) && ((upload_first_line != 0) || (upload_last_line != bmp->header_.size_pixels.y))) {
+                        // Only the lines that were written to
+                        source += bmp->byte_width_ * upload_first_line;
 
-                    char *new_data_pointer = new char[raw_size];
-                    std::memcpy(new_data_pointer, data_pointer, raw_size);
+                        upload_offset.y = upload_first_line;
+                        upload_dim.y = upload_last_line - upload_first_line;
 
-                    data_pointer = new_data_pointer;
-                }
+                        raw_size = bmp->byte_width_ * upload_dim.y;
+                    } else {
+                        raw_size = bmp->header_.bitmap_size - bmp->header_.header_len;
+                    }
 
-                std::uint32_t bpp = bmp->header_.bit_per_pixels;
+                    if (!need_conversion) {
+                        data_pointer = new char[raw_size];
+                        std::memcpy(data_pointer, source, raw_size);
+                    }
+                }
 
                 if ((bmp->header_.bit_per_pixels % 8) == 0) {
                     pixels_per_line = bmp->byte_width_ / (bmp->header_.bit_per_pixels >> 3);
                 }
 
-                std::size_t raw_size_big = 0;
-                
-                epoc::display_mode dsp = bmp->settings_.current_display_mode();
-                if (dsp == epoc::display_mode::none) {
-                    dsp = bmp->settings_.initial_display_mode();
-                }
-
-                // GPU don't support them. Convert them on CPU
-                if (is_palette_bitmap(bmp) || (dsp == epoc::display_mode::gray16)) {
-                    char *new_pointer = nullptr;
-                    if (dsp == epoc::display_mode::gray16) {
-                        new_pointer = converted_gray_four_bpp_to_twenty_four_bpp_bitmap(bmp, reinterpret_cast<const std::uint8_t *>(data_pointer), raw_size_big);
-                    } else {
-                        new_pointer = converted_palette_bitmap_to_twenty_four_bitmap(bmp, reinterpret_cast<const std::uint8_t *>(data_pointer),
-                            epoc::get_suitable_palette_256(kern->get_epoc_version()), epoc::color_16_palette, raw_size_big);
-                    }
-
-                    bpp = 24;
-                    raw_size = static_cast<std::uint32_t>(raw_size_big);
+                // GPU don't support them. Convert them on CPU, straight to the buffer given to the driver
+                if (need_conversion) {
+                    const std::uint32_t dest_byte_width = common::align(bmp->header_.size_pixels.x * 3, 4);
+                    raw_size = dest_byte_width * upload_dim.y;
 
-                    delete[] data_pointer;
-                    data_pointer = new_pointer;
+                    data_pointer = new char[raw_size];
+                    convert_lines_to_twenty_four_bpp(bmp, source, reinterpret_cast<std::uint8_t *>(data_pointer), dest_byte_width, upload_dim.y);
 
                     // Use default
                     pixels_per_line = 0;
                 }
-
-                char *newly_pointer = nullptr;
-
-                switch (bpp) {
-                case 1:
-                    newly_pointer = converted_one_bpp_to_twenty_four_bpp_bitmap(bmp, reinterpret_cast<const std::uint32_t *>(data_pointer),
-                        raw_size_big);
-                    bpp = 24;
-                    raw_size = static_cast<std::uint32_t>(raw_size_big);
-                    pixels_per_line = 0;
-
-                    break;
-
-                default:
-                    break;
-                }
-
-                if (newly_pointer) {
-                    delete[] data_pointer;
-                    data_pointer = newly_pointer;
-                }
             }
 
             if (builder) {
-                builder->update_bitmap(driver_textures[idx], data_pointer, raw_size, { 0, 0 }, bmp->header_.size_pixels, pixels_per_line, false);
+                builder->update_bitmap(driver_textures[idx], data_pointer, raw_size, upload_offset, upload_dim, pixels_per_line, false);
             }
 
             if (update_cmd) {
@@ -478,7 +557,8 @@ namespace eka2l1::epoc {
                 data.handle_ = driver_textures[idx];
                 data.texture_data_ = data_pointer;
                 data.pixel_per_line_ = pixels_per_line;
-                data.dim_ = bmp->header_.size_pixels;
+                data.offset_ = upload_offset;
+                data.dim_ = upload_dim;
                 data.texture_size_ = raw_size;
             }
 
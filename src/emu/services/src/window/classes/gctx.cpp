@@ -37,6 +37,8 @@
 
 #include <utils/err.h>
 
+#include <algorithm>
+
 namespace eka2l1::epoc {
     static void *decide_bitmap_pointer_to_pass(wsbitmap *server_bmp, std::uint8_t &affected_flags, const bool is_mask) {
         if (server_bmp->parent_) {
@@ -112,7 +114,7 @@ namespace eka2l1::epoc {
     }
 
     void graphic_context::do_command_draw_text(service::ipc_context &ctx, eka2l1::vec2 top_left,
-        eka2l1::vec2 bottom_right, const std::u16string &text, epoc::text_alignment align,
+        eka2l1::vec2 bottom_right, std::u16string_view text, epoc::text_alignment align,
         const int baseline_offset, const int margin, const bool fill_surrounding) {
         // Complete it first, cause we gonna open up the kernel
         ctx.complete(epoc::error_none);
@@ -152,7 +154,9 @@ namespace eka2l1::epoc {
         draw_text_cmd.opcode_ = epoc::gdi_store_command_draw_text;
         draw_text_data.string_ = reinterpret_cast<char16_t*>(draw_text_cmd.allocate_dynamic_data((text.length() + 1) * sizeof(char16_t)));
 
-        std::memcpy(draw_text_data.string_, text.data(), (text.length() + 1) * sizeof(char16_t));
+        // The view points into the client's command buffer, which has no terminator
+        std::memcpy(draw_text_data.string_, text.data(), text.length() * sizeof(char16_t));
+        draw_text_data.string_[text.length()] = u'\0';
 
         draw_text_data.alignment_ = static_cast<std::uint32_t>(align);
         draw_text_data.text_box_ = area;
@@ -230,7 +234,7 @@ namespace eka2l1::epoc {
         eka2l1::rect the_clip;
         common::region *the_region = nullptr;
 
-        std::unique_ptr<common::region> clip_region_temp = std::make_unique<common::region>();
+        common::region clip_region_temp;
 
         bool use_clipping = false;
         bool stencil_one_for_valid = true;
@@ -254,12 +258,12 @@ namespace eka2l1::epoc {
         } else {
             if (attached_window->flags & epoc::canvas_base::flags_in_redraw) {
                 epoc::redraw_msg_canvas *attached_fm_window = reinterpret_cast<epoc::redraw_msg_canvas*>(attached_window);
-                clip_region_temp->add_rect(attached_fm_window->redraw_rect_curr);
+                clip_region_temp.add_rect(attached_fm_window->redraw_rect_curr);
             } else {
-                clip_region_temp->add_rect(attached_window->bounding_rect());
+                clip_region_temp.add_rect(attached_window->bounding_rect());
 
                 // Following the upper comment, assume there's no invalid region.
-                // clip_region_temp->eliminate(attached_window->redraw_region);
+                // clip_region_temp.eliminate(attached_window->redraw_region);
             }
 
             common::region personal_clipping;
@@ -272,17 +276,17 @@ namespace eka2l1::epoc {
                 personal_clipping = (personal_clipping.empty()) ? clipping_region : personal_clipping.intersect(clipping_region);
             }
 
-            *clip_region_temp = clip_region_temp->intersect(personal_clipping);
+            clip_region_temp = clip_region_temp.intersect(personal_clipping);
 
-            if (clip_region_temp->rects_.size() <= 1) {
+            if (clip_region_temp.rects_.size() <= 1) {
                 // We can use clipping directly
                 use_clipping = true;
-                the_clip = clip_region_temp->empty() ? eka2l1::rect({ 0, 0 }, { 0, 0 }) : clip_region_temp->rects_[0];
+                the_clip = clip_region_temp.empty() ? eka2l1::rect({ 0, 0 }, { 0, 0 }) : clip_region_temp.rects_[0];
             } else {
                 use_clipping = false;
                 stencil_one_for_valid = true;
 
-                the_region = clip_region_temp.get();
+                the_region = &clip_region_temp;
             }
         }
 
@@ -803,7 +807,7 @@ namespace eka2l1::epoc {
 
     void graphic_context::draw_text(service::ipc_context &context, ws_cmd &cmd) {
         ws_cmd_draw_text *info = reinterpret_cast<decltype(info)>(cmd.data_ptr);
-        std::u16string text(reinterpret_cast<char16_t *>(reinterpret_cast<std::uint8_t *>(cmd.data_ptr) + sizeof(ws_cmd_draw_text)), info->length);
+        const std::u16string_view text = get_ws_cmd_text(cmd, sizeof(ws_cmd_draw_text), info->length);
 
         do_command_draw_text(context, info->pos, info->pos, text,
             epoc::text_alignment::left, 0, 0, false);
@@ -811,7 +815,7 @@ namespace eka2l1::epoc {
 
     void graphic_context::draw_box_text_optimised1(service::ipc_context &context, ws_cmd &cmd) {
         ws_cmd_draw_box_text_optimised1 *info = reinterpret_cast<decltype(info)>(cmd.data_ptr);
-        std::u16string text(reinterpret_cast<char16_t *>(reinterpret_cast<std::uint8_t *>(cmd.data_ptr) + sizeof(ws_cmd_draw_box_text_optimised1)), info->length);
+        const std::u16string_view text = get_ws_cmd_text(cmd, sizeof(ws_cmd_draw_box_text_optimised1), info->length);
 
         do_command_draw_text(context, info->left_top_pos, info->right_bottom_pos, text,
             epoc::text_alignment::left, info->baseline_offset, 0, true);
@@ -819,7 +823,7 @@ namespace eka2l1::epoc {
 
     void graphic_context::draw_box_text_optimised2(service::ipc_context &context, ws_cmd &cmd) {
         ws_cmd_draw_box_text_optimised2 *info = reinterpret_cast<decltype(info)>(cmd.data_ptr);
-        std::u16string text(reinterpret_cast<char16_t *>(reinterpret_cast<std::uint8_t *>(cmd.data_ptr) + sizeof(ws_cmd_draw_box_text_optimised2)), info->length);
+        const std::u16string_view text = get_ws_cmd_text(cmd, sizeof(ws_cmd_draw_box_text_optimised2), info->length);
 
         do_command_draw_text(context, info->left_top_pos, info->right_bottom_pos, text,
             info->horiz, info->baseline_offset, info->left_mgr, true);
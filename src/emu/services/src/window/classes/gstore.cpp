@@ -200,13 +200,28 @@ namespace eka2l1::epoc {
         , texture_filter_(texture_filter) {
     }
 
+    gdi_command_builder::~gdi_command_builder() {
+        flush_text();
+    }
+
+    void gdi_command_builder::flush_text() {
+        text_batch_.flush(builder_);
+    }
+
     void gdi_command_builder::build_segment(const gdi_store_command_segment &segment) {
         for (std::size_t i = 0; i < segment.commands_.size(); i++) {
             build_single_command(segment.commands_[i]);
         }
+
+        flush_text();
     }
 
     void gdi_command_builder::build_single_command(const gdi_store_command &command) {
+        if (command.opcode_ != gdi_store_command_draw_text) {
+            // Anything else may draw over the pending text or change the state it's drawn with
+            flush_text();
+        }
+
         switch (command.opcode_) {
         case gdi_store_command_draw_rect:
             build_command_draw_rect(command.get_data_struct_const<gdi_store_command_draw_rect_data>());
@@ -302,7 +317,6 @@ namespace eka2l1::epoc {
     }
 
     void gdi_command_builder::build_command_draw_text(const gdi_store_command_draw_text_data &cmd) {
-        builder_.set_brush_color_detail(cmd.color_);
         fbsfont *text_font = reinterpret_cast<fbsfont*>(cmd.fbs_font_ptr_);
         
         std::int16_t scaled_font_size = text_font->of_info.metrics.max_height;
@@ -310,16 +324,13 @@ namespace eka2l1::epoc {
 
         if (text_font->of_info.adapter->vectorizable()) {
             scaled_font_size = static_cast<std::int16_t>(scaled_font_size * scale_factor_);
-            
-            if ((text_font->atlas.atlas_handle_ != 0) && (scaled_font_size != text_font->atlas.get_char_size())) {
-                text_font->atlas.destroy(driver_);
-            }
         } else {
             scale_to_pass = scale_factor_;
         }
 
-        if (text_font->atlas.atlas_handle_ == 0) {
-            text_font->atlas.init(text_font->of_info.adapter, text_font->of_info.idx, 0x20, 0xFF - 0x20,
+        // Glyphs of every size live in the shared cache, so a new size only needs a new font entry
+        if (!text_font->atlas.is_initialized() || (scaled_font_size != text_font->atlas.get_char_size())) {
+            text_font->atlas.init(text_font->serv->get_glyph_cache(), text_font->of_info.adapter, text_font->of_info.idx,
                 scaled_font_size);
         }
 
@@ -328,8 +339,10 @@ namespace eka2l1::epoc {
 
         scale_rectangle(scaled_text_box, scale_factor_);
 
+        // Text in a row with the same color is drawn together
+        text_batch_.set_color(builder_, cmd.color_);
         text_font->atlas.draw_text(cmd.string_, scaled_text_box, static_cast<epoc::text_alignment>(cmd.alignment_),
-            driver_, builder_, scale_to_pass);
+            driver_, builder_, text_batch_, { scale_to_pass, scale_to_pass });
     }
 
     void gdi_command_builder::build_command_draw_raw_texture(const gdi_store_command_draw_raw_texture_data &cmd) {
@@ -498,7 +511,7 @@ namespace eka2l1::epoc {
         }
 
         builder_.update_bitmap(cmd.handle_, reinterpret_cast<const char*>(cmd.texture_data_), cmd.texture_size_,
-            eka2l1::vec2(0, 0), cmd.dim_, cmd.pixel_per_line_, false);
+            cmd.offset_, cmd.dim_, cmd.pixel_per_line_, false);
 
         if (cmd.do_swizz_) {
             builder_.set_swizzle(cmd.handle_, cmd.swizz_[0], cmd.swizz_[1], cmd.swizz_[2], cmd.swizz_[3]);
@@ -121,6 +121,8 @@ namespace eka2l1::epoc {
         remove_from_sibling_list();
 
         if (scr) {
+            // The window is out of the tree now, so recalculating won't find the area it used to cover
+            scr->add_damage(visible_region);
             scr->need_update_visible_regions(true);
         }
 
@@ -929,7 +931,9 @@ namespace eka2l1::epoc {
             return false;
         }
 
-        if ((scr->flags_ & screen::FLAG_SERVER_REDRAW_PENDING) == 0) {
+        common::region redraw_region;
+
+        if (!scr->get_recomposite_region(visible_region, redraw_region)) {
             return false;
         }
 
@@ -939,7 +943,7 @@ namespace eka2l1::epoc {
         auto color_extracted = common::rgba_to_vec(clear_color);
 
         builder.set_feature(drivers::graphics_feature::blend, false);
-        builder.clip_bitmap_region(visible_region, scr->display_scale_factor);
+        builder.clip_bitmap_region(redraw_region, scr->display_scale_factor);
 
         if (display_mode() <= epoc::display_mode::color16mu) {
             color_extracted.w = 255;
@@ -1167,12 +1171,15 @@ namespace eka2l1::epoc {
             return false;
         }
 
+        common::region redraw_region;
+        bool drawn = false;
+
         // If it does not have content drawn to it, it makes no sense to draw the background
         // Else, there's a flag in window server that enables clear on any siutation
         auto draw_background_color = [&]() {
             if ((scr->is_screenplay_architecture() || !scr->scr_config.blt_offscreen) && clear_color_enable && !background_region.empty()) {        
                 background_region.advance(abs_rect.top);
-                background_region = background_region.intersect(visible_region);
+                background_region = background_region.intersect(redraw_region);
 
                 builder.clip_bitmap_region(background_region, scr->display_scale_factor);
 
@@ -1197,7 +1204,7 @@ namespace eka2l1::epoc {
         eka2l1::drivers::filter_option filter = (client->get_ws().get_kernel_system()->get_config()->nearest_neighbor_filtering ?
             eka2l1::drivers::filter_option::nearest : eka2l1::drivers::filter_option::linear);
 
-        if (scr->flags_ & screen::FLAG_SERVER_REDRAW_PENDING) {
+        if (scr->get_recomposite_region(visible_region, redraw_region)) {
             auto &segments = redraw_segments_.get_segments();
 
             if (!segments.empty()) {
@@ -1208,22 +1215,26 @@ namespace eka2l1::epoc {
                     }
                 }
 
-                builder.clip_bitmap_region(visible_region, scr->display_scale_factor);
+                builder.clip_bitmap_region(redraw_region, scr->display_scale_factor);
 
                 gdi_command_builder gdi_builder(client->get_ws().get_graphics_driver(), builder,
                     *client->get_ws().get_bitmap_cache(), filter, abs_rect.top, scr->display_scale_factor,
-                    visible_region);
+                    redraw_region);
 
                 for (std::size_t i = 0; i < segments.size(); i++) {
                     if (segments[i]->type_ != gdi_store_command_segment_pending_redraw) {
                         gdi_builder.build_segment(*segments[i]);
                     }
                 }
+
+                drawn = true;
             }
         }
 
         if (scr->flags_ & screen::FLAG_CLIENT_REDRAW_PENDING) {
             drivers::command_list cmd_list = driver_builder_.retrieve_command_list();
+            bool client_drawn = false;
+
             if (pending_segment_) {
                 builder.clip_bitmap_region(visible_region, scr->display_scale_factor);
 
@@ -1233,28 +1244,27 @@ namespace eka2l1::epoc {
 
                 gdi_builder.build_segment(*pending_segment_);
                 pending_segment_.reset();
+
+                client_drawn = true;
             }
 
             if (!cmd_list.empty()) {
+                client_drawn = true;
+
                 builder.clip_bitmap_region(visible_region, scr->display_scale_factor);
                 builder.draw_rectangle(abs_rect);
 
-                if (!builder.merge(cmd_list)) {
-                    // Full, need to flush the old one maybe
-                    drivers::command_list screen_draw_prev_list = builder.retrieve_command_list();
-                    drivers::graphics_driver *drv = client->get_ws().get_graphics_driver();
-
-                    drv->submit_command_list(screen_draw_prev_list);
-                    builder.bind_bitmap(scr->screen_texture);
+                builder.merge(cmd_list);
+            }
 
-                    if (!builder.merge(cmd_list)) {
-                        LOG_ERROR(SERVICE_WINDOW, "Unable to merge redraw window's command list to screen draw's command list!");
-                    }
-                }
+            if (client_drawn) {
+                // Drawn over what the screen already has, so only this window's part changed
+                scr->updated_region_.add_region(visible_region);
+                drawn = true;
             }
         }
 
-        return true;
+        return drawn;
     }
 
     bool redraw_msg_canvas::execute_command(service::ipc_context &ctx, ws_cmd &cmd) {
@@ -1452,6 +1462,8 @@ namespace eka2l1::epoc {
             }
         }
 
+        // The window texture is blended onto the screen, so what's below it must be drawn again too
+        scr->add_damage(visible_region);
         return canvas_base::try_update(drawer);
     }
 
@@ -1531,6 +1543,8 @@ namespace eka2l1::epoc {
         sync_from_bitmap(reg_clip);
 
         ctx.complete(epoc::error_none);
+
+        scr->add_damage(visible_region);
         canvas_base::try_update(ctx.msg->own_thr);
     }
 
@@ -1581,8 +1595,15 @@ namespace eka2l1::epoc {
             return false;
         }
 
+        common::region redraw_region;
+
+        if (!scr->get_recomposite_region(visible_region, redraw_region)) {
+            // The screen still has what the window last showed
+            return false;
+        }
+
         builder.set_feature(drivers::graphics_feature::blend, false);
-        builder.clip_bitmap_region(visible_region, scr->display_scale_factor);
+        builder.clip_bitmap_region(redraw_region, scr->display_scale_factor);
 
         eka2l1::rect draw_dest_rect = abs_rect;
         scale_rectangle(draw_dest_rect, scr->display_scale_factor);
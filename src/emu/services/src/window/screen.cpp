@@ -24,6 +24,7 @@
 #include <services/window/screen.h>
 #include <services/window/window.h>
 
+#include <common/algorithm.h>
 #include <common/rgb.h>
 #include <common/time.h>
 #include <config/app_settings.h>
@@ -31,6 +32,8 @@
 
 #include <kernel/kernel.h>
 #include <kernel/timing.h>
+
+#include <algorithm>
 #include <thread>
 
 namespace eka2l1::epoc {
@@ -151,27 +154,109 @@ namespace eka2l1::epoc {
             std::memmove(buffer + (line_count - y - 1) * line_pitch, pitcher, line_pitch);
         }
 
-        delete pitcher;
+        delete[] pitcher;
     }
 
     void screen::sync_screen_buffer_data(drivers::graphics_driver *driver) {
-        std::uint8_t *buffer_ptr = screen_buffer_ptr();
+        if (updated_region_.empty()) {
+            return;
+        }
+
+        sync_screen_buffer_data(driver, screen_buffer_ptr());
+    }
+
+    void screen::sync_screen_buffer_data(drivers::graphics_driver *driver, std::uint8_t *buffer_ptr) {
+        if (updated_region_.empty()) {
+            return;
+        }
+
         const config::screen_mode &crrmode = current_mode();
 
-        drivers::read_bitmap(driver, screen_texture, eka2l1::point(0, 0), eka2l1::object_size(crrmode.size),
-            get_bpp_from_display_mode(disp_mode), buffer_ptr);
+        const std::uint32_t bpp = get_bpp_from_display_mode(disp_mode);
+        const std::uint32_t current_pitch = epoc::get_byte_width(crrmode.size.x, bpp);
+        const bool flipped = (crrmode.rotation == 90) || (crrmode.rotation == 180);
+
+        // Rows are read whole, so they land in the buffer with its pitch. Merge the rows of the
+        // updated rectangles into bands, to read each row once.
+        std::vector<std::pair<int, int>> bands;
+
+        for (const eka2l1::rect &updated : updated_region_.rects_) {
+            const int begin = common::max(updated.top.y, 0);
+            const int end = common::min(updated.top.y + updated.size.y, crrmode.size.y);
+
+            if (begin < end) {
+                bands.emplace_back(begin, end);
+            }
+        }
+
+        std::sort(bands.begin(), bands.end());
 
-        if ((crrmode.rotation == 90) || (crrmode.rotation == 180)) {
-            const std::uint32_t current_pitch = epoc::get_byte_width(crrmode.size.x, epoc::get_bpp_from_display_mode(disp_mode));
-            flip_screen_image(buffer_ptr, current_pitch, crrmode.size.y);
+        std::size_t merged_count = 0;
+
+        for (std::size_t i = 0; i < bands.size(); i++) {
+            if ((merged_count != 0) && (bands[i].first <= bands[merged_count - 1].second)) {
+                bands[merged_count - 1].second = common::max(bands[merged_count - 1].second, bands[i].second);
+            } else {
+                bands[merged_count++] = bands[i];
+            }
+        }
+
+        for (std::size_t i = 0; i < merged_count; i++) {
+            const int begin = bands[i].first;
+            const int end = bands[i].second;
+
+            std::uint8_t *band_ptr = buffer_ptr + begin * current_pitch;
+
+            // The texture is upside down compared to the buffer in these modes
+            const int read_y = flipped ? (crrmode.size.y - end) : begin;
+
+            drivers::read_bitmap(driver, screen_texture, eka2l1::point(0, read_y), eka2l1::object_size(crrmode.size.x, end - begin),
+                bpp, band_ptr);
+
+            if (flipped) {
+                flip_screen_image(band_ptr, current_pitch, end - begin);
+            }
         }
     }
 
+    void screen::add_damage(const common::region &region) {
+        if (!(flags_ & FLAG_SERVER_REDRAW_PENDING)) {
+            damage_region_.add_region(region);
+        }
+    }
+
+    void screen::add_damage(const eka2l1::rect &rect) {
+        if (!(flags_ & FLAG_SERVER_REDRAW_PENDING) && !rect.empty()) {
+            damage_region_.add_rect(rect);
+        }
+    }
+
+    bool screen::get_recomposite_region(const common::region &visible, common::region &result) const {
+        if (flags_ & FLAG_SERVER_REDRAW_PENDING) {
+            result = visible;
+        } else if (!damage_region_.empty()) {
+            result = visible.intersect(damage_region_);
+        } else {
+            return false;
+        }
+
+        return !result.empty();
+    }
+
     bool screen::redraw(drivers::graphics_command_builder &builder, const bool need_bind) {
         if (need_update_visible_regions()) {
             recalculate_visible_regions();
         }
 
+        const bool full_redraw = (flags_ & FLAG_SERVER_REDRAW_PENDING);
+
+        updated_region_.make_empty();
+
+        if (!full_redraw && damage_region_.empty() && !(flags_ & FLAG_CLIENT_REDRAW_PENDING)) {
+            // Nothing changed since the last redraw, the screen texture is still good
+            return false;
+        }
+
         if (need_bind) {
             builder.bind_bitmap(screen_texture);
         }
@@ -182,15 +267,26 @@ namespace eka2l1::epoc {
         builder.set_feature(eka2l1::drivers::graphics_feature::clipping, false);
 
         builder.clear(eka2l1::vecx<float, 6>({ 0.0, 0.0, 0.0, 0.0, 1.0, 0.0 }), drivers::draw_buffer_bit_depth_buffer
-            | drivers::draw_buffer_bit_stencil_buffer | ((flags_ & FLAG_SERVER_REDRAW_PENDING) ? drivers::draw_buffer_bit_color_buffer : 0));
+            | drivers::draw_buffer_bit_stencil_buffer | (full_redraw ? drivers::draw_buffer_bit_color_buffer : 0));
+
+        if (full_redraw) {
+            damage_region_.make_empty();
+            updated_region_.add_rect(eka2l1::rect(eka2l1::vec2(0, 0), current_mode().size));
+        } else if (!damage_region_.empty()) {
+            // Clear only the damaged area. The windows covering it then draw there again
+            builder.clip_bitmap_region(damage_region_, display_scale_factor);
+            builder.set_brush_color_detail(eka2l1::vec4(0, 0, 0, 0));
+            builder.draw_rectangle(eka2l1::rect(eka2l1::vec2(0, 0), eka2l1::vec2(0, 0)));
+
+            updated_region_.add_region(damage_region_);
+        }
 
         builder.blend_formula(drivers::blend_equation::add, drivers::blend_equation::add,
             drivers::blend_factor::frag_out_alpha, drivers::blend_factor::one_minus_frag_out_alpha,
             drivers::blend_factor::one, drivers::blend_factor::one);
 
-        // Walk through the window tree in recursive order, and do draw
-        // We dont care about visible regions. Nowadays, detect visible region to reduce pixel plotting is
-        // just not really worth the time, since GPU draws so fast. Symbian code still has it though.
+        // Walk through the window tree in recursive order, and do draw. Windows with nothing new to show
+        // and outside the damage skip themselves, their pixels are already on the screen texture.
         window_drawer_walker adrawwalker(builder);
         root->walk_tree(&adrawwalker, window_tree_walk_style::bonjour_children);
 
@@ -199,8 +295,9 @@ namespace eka2l1::epoc {
 
         // Remove pending draw flags...
         flags_ &= ~(FLAG_SERVER_REDRAW_PENDING | FLAG_CLIENT_REDRAW_PENDING);
+        damage_region_.make_empty();
 
-        return adrawwalker.total_redrawed_;
+        return !updated_region_.empty();
     }
 
     void screen::redraw(drivers::graphics_driver *driver) {
@@ -215,7 +312,12 @@ namespace eka2l1::epoc {
         eka2l1::drivers::command_list retrieved = builder.retrieve_command_list();
         driver->submit_command_list(retrieved);
 
-        if (performed && sync_screen_buffer && (display_scale_factor == 1.0f)) {
+        if (!performed) {
+            // Nothing on the screen changed, so there's nothing new to sync or present
+            return;
+        }
+
+        if (sync_screen_buffer && (display_scale_factor == 1.0f)) {
             sync_screen_buffer_data(driver);
         }
 
@@ -266,6 +368,9 @@ namespace eka2l1::epoc {
             need_bind = false;
         }
 
+        // The texture content is lost, everything must be drawn again
+        flags_ |= FLAG_SERVER_REDRAW_PENDING;
+
         const bool performed = redraw(builder, need_bind);
 
         eka2l1::drivers::command_list retrieved = builder.retrieve_command_list();
@@ -575,6 +680,7 @@ namespace eka2l1::epoc {
 
     struct window_visible_region_calc_walker: public window_tree_walker {
         common::region visible_left_region_;
+        common::region damage_region_;
 
         explicit window_visible_region_calc_walker(const common::region &master_region)
             : visible_left_region_(master_region) {
@@ -603,6 +709,10 @@ namespace eka2l1::epoc {
                 }
 
                 if (!previous_region.identical(winuser->visible_region)) {
+                    // What was shown there before and what will be shown now both need drawing
+                    damage_region_.add_region(previous_region);
+                    damage_region_.add_region(winuser->visible_region);
+
                     if (winuser->is_dsa_active()) {
                         std::vector<dsa*> dsa_residents = winuser->directs_;
 
@@ -629,8 +739,9 @@ namespace eka2l1::epoc {
         root->walk_tree(&walker, epoc::window_tree_walk_style::bonjour_children);
         need_update_visible_regions(false);
 
-        // The server side causes a change (maybe position or visiblity, so a redraw requested from server is needed)
-        flags_ |= FLAG_SERVER_REDRAW_PENDING;
+        // The server side causes a change (maybe position or visiblity), so the windows that moved around
+        // need to be recomposited by the server
+        add_damage(walker.damage_region_);
     }
 
     void screen::ref_dsa_usage() {
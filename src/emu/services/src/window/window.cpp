@@ -60,6 +60,7 @@
 
 #include <loader/rom.h>
 
+#include <cstring>
 #include <optional>
 #include <string>
 
@@ -128,38 +129,28 @@ namespace eka2l1::epoc {
     }
 
     void window_server_client::parse_command_buffer(service::ipc_context &ctx) {
-        std::optional<std::string> dat = ctx.get_argument_value<std::string>(cmd_slot);
+        const std::size_t size = ctx.get_argument_data_size(cmd_slot);
 
-        if (!dat) {
+        if ((size == 0) || (size == static_cast<std::size_t>(-1))) {
             return;
         }
 
-        char *beg = dat->data();
-        char *end = dat->data() + dat->size();
+        // The buffer is usually in one chunk, so commands can be decoded where the client wrote them
+        std::uint8_t *beg = ctx.get_descriptor_argument_direct_ptr(cmd_slot, static_cast<std::uint32_t>(size));
 
-        std::vector<ws_cmd> cmds;
+        if (!beg) {
+            cmd_buffer_copy.resize(size);
 
-        while (beg < end) {
-            ws_cmd cmd;
-
-            cmd.header = *reinterpret_cast<ws_cmd_header *>(beg);
-
-            if (cmd.header.op & 0x8000) {
-                cmd.header.op &= ~0x8000;
-                cmd.obj_handle = *reinterpret_cast<std::uint32_t *>(beg + sizeof(ws_cmd_header));
-
-                beg += sizeof(ws_cmd_header) + sizeof(cmd.obj_handle);
-            } else {
-                beg += sizeof(ws_cmd_header);
+            if (!ctx.read_descriptor_argument_data(cmd_slot, cmd_buffer_copy.data(), static_cast<std::uint32_t>(size))) {
+                return;
             }
 
-            cmd.data_ptr = reinterpret_cast<void *>(beg);
-            beg += cmd.header.cmd_len;
-
-            cmds.push_back(std::move(cmd));
+            beg = cmd_buffer_copy.data();
         }
 
-        execute_commands(ctx, std::move(cmds));
+        const std::uint32_t count = execute_commands(ctx, beg, beg + size);
+
+        get_ws().cmd_counter_.add_flush(count, size);
     }
 
     window_server_client::window_server_client(service::session *guest_session, kernel::thread *own_thread, epoc::version ver)
@@ -171,8 +162,15 @@ namespace eka2l1::epoc {
         , uid_counter(0) {
     }
 
-    void window_server_client::execute_commands(service::ipc_context &ctx, std::vector<ws_cmd> cmds) {
-        for (auto &cmd : cmds) {
+    std::uint32_t window_server_client::execute_commands(service::ipc_context &ctx, std::uint8_t *beg, std::uint8_t *end) {
+        ws_cmd_reader reader(beg, end);
+        ws_cmd cmd;
+
+        std::uint32_t count = 0;
+
+        while (reader.next(cmd)) {
+            count++;
+
             if (cmd.obj_handle == guest_session->unique_id()) {
                 if (last_obj) {
                     last_obj->on_command_batch_done(ctx);
@@ -198,10 +196,16 @@ namespace eka2l1::epoc {
             }
         }
 
+        if (reader.left()) {
+            LOG_WARN(SERVICE_WINDOW, "The last {} bytes of the command buffer are not a whole command, dropped", reader.left());
+        }
+
         if (last_obj) {
             last_obj->on_command_batch_done(ctx);
             last_obj = nullptr;
         }
+
+        return count;
     }
 
     std::uint32_t window_server_client::queue_redraw(epoc::canvas_base *user, const eka2l1::rect &redraw_rect) {
@@ -27,6 +27,7 @@
 #include <mutex>
 #include <optional>
 #include <tuple>
+#include <vector>
 
 namespace eka2l1 {
     class memory_system;
@@ -149,7 +150,26 @@ namespace eka2l1 {
 
         int loop();
 
-        void do_state(common::chunkyseri &seri);
+        /**
+         * @brief Save or restore the state of the guest machine.
+         *
+         * Guest cores are stopped while this is done. HLE services are not part of the state, so
+         * a state can only be restored in the session it was saved in, and not while any session to
+         * an HLE server is open.
+         *
+         * @returns False if the state can't be restored.
+         */
+        bool do_state(common::chunkyseri &seri);
+
+        /**
+         * @brief Save the state of the guest machine to a buffer.
+         */
+        bool save_state(std::vector<std::uint8_t> &state);
+
+        /**
+         * @brief Restore a state saved by save_state.
+         */
+        bool load_state(const std::vector<std::uint8_t> &state);
 
         device_manager *get_device_manager();
         manager::packages *get_packages();
@@ -109,6 +109,7 @@ namespace eka2l1 {
         std::mutex mut;
 
         arm::core_instance cpu;
+        std::vector<arm::core_instance> secondary_cpus;
         arm::exclusive_monitor_instance exmonitor;
 
         arm_emulator_type cpu_type;
@@ -330,6 +331,7 @@ namespace eka2l1 {
 
             if (kern_) {
                 kern_->stop_cores_idling();
+                kern_->pause_secondary_cores();
             }
 
             mut.lock();
@@ -337,6 +339,11 @@ namespace eka2l1 {
 
         void end_access() {
             paused = false;
+
+            if (kern_) {
+                kern_->resume_secondary_cores();
+            }
+
             mut.unlock();
         }
 
@@ -538,7 +545,7 @@ namespace eka2l1 {
         }
 
         arm::core *get_cpu() {
-            return cpu.get();
+            return kern_ ? kern_->get_cpu() : cpu.get();
         }
 
         dispatch::dispatcher *get_dispatcher() {
@@ -556,7 +563,14 @@ namespace eka2l1 {
         bool get_ngage_game_info_mounted(apa_app_registry &result);
 
         bool reset(const bool lock_sys, const std::int32_t new_index = -1);
-        void do_state(common::chunkyseri &seri);
+
+        void stop_for_state();
+        void resume_after_state();
+        bool do_state_stopped(common::chunkyseri &seri);
+
+        bool do_state(common::chunkyseri &seri);
+        bool save_state(std::vector<std::uint8_t> &state);
+        bool load_state(const std::vector<std::uint8_t> &state);
 
         package::installation_result install_package(std::u16string path, drive_number drv);
         bool load_rom(const std::string &path);
@@ -572,10 +586,88 @@ namespace eka2l1 {
         void initialize_user_parties();
     };
 
-    void system_impl::do_state(common::chunkyseri &seri) {
+    void system_impl::stop_for_state() {
+        // Same order as pausing, secondary cores may be waiting for the system lock
+        kern_->stop_cores_idling();
+        kern_->pause_secondary_cores();
+
+        mut.lock();
+        kern_->lock();
+    }
+
+    void system_impl::resume_after_state() {
+        kern_->unlock();
+        mut.unlock();
+
+        if (!paused) {
+            kern_->resume_secondary_cores();
+        }
+    }
+
+    bool system_impl::do_state_stopped(common::chunkyseri &seri) {
+        auto s = seri.section("System", 1);
+
+        if (!s) {
+            return false;
+        }
+
+        if (seri.get_seri_mode() == common::SERI_MODE_READ) {
+            // The kernel state is applied before the timing state is read, so check both first
+            common::chunkyseri checker(seri.current(), seri.left(), common::SERI_MODE_READ);
+
+            if (!kern_->do_state(checker, true) || !timing_->do_state(checker, true)) {
+                return false;
+            }
+        }
+
+        if (!kern_->do_state(seri)) {
+            return false;
+        }
+
+        return timing_->do_state(seri);
+    }
+
+    bool system_impl::do_state(common::chunkyseri &seri) {
+        if (!kern_) {
+            return false;
+        }
+
+        stop_for_state();
+        const bool result = do_state_stopped(seri);
+        resume_after_state();
+
+        return result;
+    }
+
+    bool system_impl::save_state(std::vector<std::uint8_t> &state) {
+        if (!kern_) {
+            return false;
+        }
+
+        // Measure and write must see the same machine, so keep it stopped for both
+        stop_for_state();
+
+        common::chunkyseri measurer(nullptr, 0, common::SERI_MODE_MEASURE);
+        bool result = do_state_stopped(measurer);
+
+        if (result) {
+            state.resize(measurer.size());
+
+            common::chunkyseri writer(state.data(), state.size(), common::SERI_MODE_WRITE);
+            result = do_state_stopped(writer);
+        }
+
+        resume_after_state();
+        return result;
+    }
+
+    bool system_impl::load_state(const std::vector<std::uint8_t> &state) {
+        common::chunkyseri reader(const_cast<std::uint8_t *>(state.data()), state.size(), common::SERI_MODE_READ);
+        return do_state(reader);
     }
 
     static constexpr std::uint32_t DEFAULT_CPU_HZ = 484000000;
+    static constexpr int MAX_GUEST_CORE_COUNT = 4;
 
     void system_impl::startup() {
         exit = false;
@@ -587,12 +679,22 @@ namespace eka2l1 {
         file_system_inst physical_fs = create_physical_filesystem(epocver::epoc94, "");
         physical_fs_id_ = io_->add_filesystem(physical_fs);
 
-        exmonitor = arm::create_exclusive_monitor(cpu_type, 1);
-        cpu = arm::create_core(exmonitor.get(), cpu_type);
+        const std::size_t core_count = static_cast<std::size_t>(common::clamp(1, MAX_GUEST_CORE_COUNT, conf_->cpu_core_count));
+
+        exmonitor = arm::create_exclusive_monitor(cpu_type, core_count);
+        cpu = arm::create_core(exmonitor.get(), cpu_type, conf_->enable_fastmem);
 
         kern_ = std::make_unique<kernel_system>(parent_, timing_.get(), io_.get(), conf_, app_settings_, &romf_, cpu.get(),
             disassembler_.get());
 
+        // Other cores run on their own host thread, driven by the kernel
+        for (std::size_t i = 1; i < core_count; i++) {
+            secondary_cpus.push_back(arm::create_core(exmonitor.get(), cpu_type, conf_->enable_fastmem));
+            secondary_cpus.back()->set_core_number(i);
+
+            kern_->add_core(secondary_cpus.back().get());
+        }
+
         epoc::init_panic_descriptions();
     }
 
@@ -650,8 +752,10 @@ namespace eka2l1 {
     bool system_impl::pause() {
         paused = true;
 
-        if (kern_)
+        if (kern_) {
             kern_->stop_cores_idling();
+            kern_->pause_secondary_cores();
+        }
 
         const std::lock_guard<std::mutex> guard(mut);
 
@@ -669,6 +773,9 @@ namespace eka2l1 {
         if (timing_)
             timing_->set_paused(false);
 
+        if (kern_)
+            kern_->resume_secondary_cores();
+
         return true;
     }
 
@@ -713,6 +820,8 @@ namespace eka2l1 {
         }
 
         if (to_run != nullptr) {
+            cpu->enter_guest();
+
             if (!should_step) {
                 cpu->run(to_run->get_remaining_screenticks());
             } else {
@@ -724,7 +833,12 @@ namespace eka2l1 {
 #endif
             }
 
-            to_run->add_ticks(cpu->get_num_instruction_executed());
+            cpu->leave_guest();
+
+            const std::uint32_t executed = cpu->get_num_instruction_executed();
+            to_run->add_ticks(executed);
+
+            kern_->get_counters().instructions_executed_.fetch_add(executed, std::memory_order_relaxed);
         }
 
         if (!kern_->should_terminate()) {
@@ -1426,10 +1540,18 @@ namespace eka2l1 {
         return impl->get_hal(category);
     }
 
-    void system::do_state(common::chunkyseri &seri) {
+    bool system::do_state(common::chunkyseri &seri) {
         return impl->do_state(seri);
     }
 
+    bool system::save_state(std::vector<std::uint8_t> &state) {
+        return impl->save_state(state);
+    }
+
+    bool system::load_state(const std::vector<std::uint8_t> &state) {
+        return impl->load_state(state);
+    }
+
     const language system::get_system_language() const {
         return impl->get_system_language();
     }
@@ -88,6 +88,39 @@ namespace eka2l1::epoc {
 
         void *get_pointer_raw(eka2l1::kernel::process *pr);
 
+        /**
+         * \brief Get the guest address of the descriptor's data.
+         *
+         * \param pr           The process which the descriptor belongs.
+         * \param des_address  Guest address of this descriptor.
+         */
+        eka2l1::address get_pointer_address(eka2l1::kernel::process *pr, const eka2l1::address des_address);
+
+        /**
+         * \brief Get the host pointer of the descriptor's data, if the given size of it is contiguous on the host.
+         *
+         * \param pr           The process which the descriptor belongs.
+         * \param des_address  Guest address of this descriptor.
+         * \param size         Number of bytes that will be accessed from the start of the data.
+         *
+         * \returns Null if the data crosses into an unmapped page or another chunk.
+         */
+        std::uint8_t *get_contiguous_pointer(eka2l1::kernel::process *pr, const eka2l1::address des_address, const std::uint32_t size);
+
+        /**
+         * \brief Copy the descriptor's data to the host page by page.
+         *
+         * \returns False if the size exceeds the length, or the data is not mapped.
+         */
+        bool read_data(eka2l1::kernel::process *pr, const eka2l1::address des_address, std::uint8_t *dest, const std::uint32_t size);
+
+        /**
+         * \brief Copy host data to the descriptor page by page, and set its length.
+         *
+         * \returns False if the size exceeds the max length, or the data is not mapped.
+         */
+        bool write_data(eka2l1::kernel::process *pr, const eka2l1::address des_address, const std::uint8_t *data, const std::uint32_t size);
+
         int assign_raw(eka2l1::kernel::process *pr, const std::uint8_t *data,
             const std::uint32_t size);
 
@@ -141,6 +174,10 @@ namespace eka2l1::epoc {
                 }
 
                 std::memcpy(des_buf, data, size);
+
+                if (pr) {
+                    eka2l1::note_host_write(pr, des_buf, size);
+                }
             }
 
             set_length(pr, real_len);
@@ -107,6 +107,84 @@ namespace eka2l1::epoc {
         return nullptr;
     }
 
+    eka2l1::address desc_base::get_pointer_address(eka2l1::kernel::process *pr, const eka2l1::address des_address) {
+        des_type dtype = get_descriptor_type();
+        const std::uint8_t *self = reinterpret_cast<const std::uint8_t *>(this);
+
+        switch (dtype) {
+        case ptr_const: {
+            ptr_desc<std::uint8_t> *des = reinterpret_cast<decltype(des)>(this);
+            return des->data.ptr_address();
+        }
+
+        case ptr: {
+            ptr_des<std::uint8_t> *des = reinterpret_cast<decltype(des)>(this);
+            return des->data.ptr_address();
+        }
+
+        case buf_const: {
+            buf_desc<std::uint8_t> *des = reinterpret_cast<decltype(des)>(this);
+            return des_address + static_cast<eka2l1::address>(&(des->data[0]) - self);
+        }
+
+        case buf: {
+            buf_des<std::uint8_t> *des = reinterpret_cast<decltype(des)>(this);
+            return des_address + static_cast<eka2l1::address>(&(des->data[0]) - self);
+        }
+
+        case ptr_to_buf: {
+            ptr_des<std::uint8_t> *pbuf = reinterpret_cast<decltype(pbuf)>(this);
+            buf_desc<std::uint8_t> *hbufc = pbuf->data.cast<buf_desc<std::uint8_t>>().get(pr);
+
+            if (!hbufc) {
+                return 0;
+            }
+
+            return pbuf->data.ptr_address() + static_cast<eka2l1::address>(reinterpret_cast<const std::uint8_t *>(&(hbufc->data[0]))
+                - reinterpret_cast<const std::uint8_t *>(hbufc));
+        }
+
+        default:
+            break;
+        }
+
+        return 0;
+    }
+
+    std::uint8_t *desc_base::get_contiguous_pointer(eka2l1::kernel::process *pr, const eka2l1::address des_address, const std::uint32_t size) {
+        const eka2l1::address data_address = get_pointer_address(pr, des_address);
+
+        if (!data_address) {
+            return nullptr;
+        }
+
+        return reinterpret_cast<std::uint8_t *>(get_contiguous_raw_pointer(pr, data_address, size));
+    }
+
+    bool desc_base::read_data(eka2l1::kernel::process *pr, const eka2l1::address des_address, std::uint8_t *dest, const std::uint32_t size) {
+        if (get_length() < size) {
+            return false;
+        }
+
+        const eka2l1::address data_address = get_pointer_address(pr, des_address);
+        return data_address && copy_on_addr_space(pr, data_address, dest, size, false);
+    }
+
+    bool desc_base::write_data(eka2l1::kernel::process *pr, const eka2l1::address des_address, const std::uint8_t *data, const std::uint32_t size) {
+        if (get_max_length(pr) < size) {
+            return false;
+        }
+
+        const eka2l1::address data_address = get_pointer_address(pr, des_address);
+
+        if (!data_address || !copy_on_addr_space(pr, data_address, const_cast<std::uint8_t *>(data), size, true)) {
+            return false;
+        }
+
+        set_length(pr, size);
+        return true;
+    }
+
     rw_des_stream::rw_des_stream(epoc::des8 *des, kernel::process *pr)
         : des_(des)
         , pr_(pr)
@@ -39,6 +39,8 @@
 #include <regex>
 #include <stack>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <string.h>
 
@@ -1011,11 +1013,119 @@ namespace eka2l1 {
         loader::rom *rom_cache;
         memory_system *mem;
 
+        static constexpr std::size_t MAX_MISSING_PATH_CACHED = 8192;
+
+        std::mutex index_lock_;
+
+        // Every file in the burn tree, keyed by its lowercased path without the drive
+        std::unordered_map<std::u16string, const loader::rom_entry *> rom_index_;
+        std::uint32_t rom_index_checksum_;
+        bool rom_index_dirty_;
+
+        // Lowercased paths with drive, known to be absent from both the ROM and the host dump
+        std::unordered_set<std::u16string> missing_paths_;
+
+        static std::u16string normalize_path(const std::u16string &path) {
+            std::u16string result = common::lowercase_ucs2_string(path);
+
+            for (auto &c : result) {
+                if (c == u'/') {
+                    c = u'\\';
+                }
+            }
+
+            return result;
+        }
+
+        void add_dir_to_index(const loader::rom_dir &dir, const std::u16string &dir_path) {
+            for (const loader::rom_entry &entry : dir.entries) {
+                if (!entry.dir) {
+                    rom_index_.emplace(dir_path + u'\\' + common::lowercase_ucs2_string(entry.name), &entry);
+                }
+            }
+
+            for (const loader::rom_dir &subdir : dir.subdirs) {
+                add_dir_to_index(subdir, dir_path + u'\\' + common::lowercase_ucs2_string(subdir.name));
+            }
+        }
+
+        void build_rom_index() {
+            rom_index_.clear();
+            missing_paths_.clear();
+
+            if (rom_cache && !rom_cache->root.root_dirs.empty()) {
+                add_dir_to_index(rom_cache->root.root_dirs[0].dir, u"");
+                rom_index_checksum_ = rom_cache->header.checksum;
+            }
+
+            rom_index_dirty_ = false;
+        }
+
+        void invalidate_rom_index() {
+            const std::lock_guard<std::mutex> guard(index_lock_);
+            rom_index_dirty_ = true;
+        }
+
+        // Must be called with the index lock held
+        void validate_rom_index() {
+            // The ROM is reloaded in place when the device changes
+            if (rom_index_dirty_ || (rom_cache->header.checksum != rom_index_checksum_)) {
+                build_rom_index();
+            }
+        }
+
+        bool is_rom_drive(const std::u16string &path) {
+            if ((path.length() < 2) || (path[1] != u':')) {
+                return false;
+            }
+
+            const char16_t drive_char = static_cast<char16_t>(std::towlower(path[0]));
+
+            if ((drive_char < u'a') || (drive_char > u'z')) {
+                return false;
+            }
+
+            const auto &mapping = mappings[drive_char - u'a'];
+            return mapping.second && (mapping.first.media_type == drive_media::rom);
+        }
+
+        std::optional<loader::rom_entry> find_rom_entry(const std::u16string &path) {
+            const std::lock_guard<std::mutex> guard(index_lock_);
+            validate_rom_index();
+
+            auto ite = rom_index_.find(normalize_path(path.substr(2)));
+
+            if (ite == rom_index_.end()) {
+                return std::nullopt;
+            }
+
+            return *ite->second;
+        }
+
+        bool is_known_missing(const std::u16string &path) {
+            const std::lock_guard<std::mutex> guard(index_lock_);
+            validate_rom_index();
+
+            return missing_paths_.find(normalize_path(path)) != missing_paths_.end();
+        }
+
+        void mark_missing(const std::u16string &path) {
+            const std::lock_guard<std::mutex> guard(index_lock_);
+
+            if (missing_paths_.size() >= MAX_MISSING_PATH_CACHED) {
+                missing_paths_.clear();
+            }
+
+            missing_paths_.insert(normalize_path(path));
+        }
+
     public:
         explicit rom_file_system(loader::rom *cache, memory_system *mem, epocver ver, const std::string &product_code)
             : physical_file_system(ver, product_code)
             , rom_cache(cache)
-            , mem(mem) {
+            , mem(mem)
+            , rom_index_checksum_(0)
+            , rom_index_dirty_(true) {
         }
 
         bool delete_entry(const std::u16string &path) override {
@@ -1039,22 +1149,27 @@ namespace eka2l1 {
             return true;
         }
 
+        void set_product_code(const std::string &pc) override {
+            physical_file_system::set_product_code(pc);
+            invalidate_rom_index();
+        }
+
         bool mount_volume_from_path(const drive_number drv, const drive_media media, const std::uint32_t attrib,
             const std::u16string &physical_path) override {
             if (media != drive_media::rom) {
                 return false;
             }
 
+            invalidate_rom_index();
             return do_mount(drv, media, attrib, physical_path);
         }
 
         abstract_file_system_err_code is_entry_in_rom(const std::u16string &path) override {
-            // Don't bother getting an entry if it's not even available on host
-            if (!exists(path)) {
+            if (!is_rom_drive(path)) {
                 return abstract_file_system_err_code::no;
             }
 
-            if (rom_cache->burn_tree_find_entry(common::ucs2_to_utf8(path))) {
+            if (find_rom_entry(path)) {
                 return abstract_file_system_err_code::ok;
             }
 
@@ -1067,8 +1182,7 @@ namespace eka2l1 {
                 return nullptr;
             }
 
-            // Don't bother getting an entry if it's not even available on host
-            if (!exists(path)) {
+            if (!is_rom_drive(path)) {
                 return nullptr;
             }
 
@@ -1082,27 +1196,53 @@ namespace eka2l1 {
                 }
             }
 
-            auto entry = rom_cache->burn_tree_find_entry(common::ucs2_to_utf8(new_path));
-            auto ff = physical_file_system::open_file(new_path, mode);
+            auto entry = find_rom_entry(new_path);
+
+            if (!entry) {
+                // Only in the dump (ROFS), or nowhere
+                if (is_known_missing(new_path)) {
+                    return nullptr;
+                }
+
+                auto ff = physical_file_system::open_file(new_path, mode);
+
+                if (!ff) {
+                    mark_missing(new_path);
+                }
 
-            // Dont change order!
-            if (!entry || ((mode & PREFER_PHYSICAL) && (ff->size() != entry->size))) {
                 return ff;
             }
 
+            if (mode & PREFER_PHYSICAL) {
+                auto ff = physical_file_system::open_file(new_path, mode);
+
+                if (ff && (ff->size() != entry->size)) {
+                    return ff;
+                }
+            }
+
             return std::make_unique<rom_file>(mem, rom_cache, *entry, path);
         }
 
         std::optional<entry_info> get_entry_info(const std::u16string &path) override {
-            // Don't bother getting an entry if it's not even available on host
-            if (!exists(path)) {
+            if (!is_rom_drive(path)) {
                 return std::nullopt;
             }
 
-            auto entry = rom_cache->burn_tree_find_entry(common::ucs2_to_utf8(path));
+            auto entry = find_rom_entry(path);
 
             if (!entry) {
-                return physical_file_system::get_entry_info(path);
+                if (is_known_missing(path)) {
+                    return std::nullopt;
+                }
+
+                std::optional<entry_info> info = physical_file_system::get_entry_info(path);
+
+                if (!info) {
+                    mark_missing(path);
+                }
+
+                return info;
             }
 
             entry_info info;
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/blobcache.h>
+#include <common/fileutils.h>
+#include <common/path.h>
+
+#include <vector>
+
+using namespace eka2l1;
+
+TEST_CASE("blob_cache_write_then_read", "blob_cache") {
+    const std::string cache_folder = "blobcachetest/";
+    common::blob_cache cache(cache_folder, "blob");
+
+    REQUIRE(cache.get_file_path(0xABCDEF, 0x1F) == eka2l1::add_path(cache_folder, "0000000000ABCDEF_1F.blob"));
+
+    std::vector<std::uint8_t> blob;
+    REQUIRE(!cache.read(0xABCDEF, 0x1F, blob));
+
+    const std::vector<std::uint8_t> content = { 1, 2, 3, 4, 5 };
+    REQUIRE(cache.write(0xABCDEF, 0x1F, content.data(), content.size()));
+    REQUIRE(!common::exists(cache.get_file_path(0xABCDEF, 0x1F) + ".tmp"));
+
+    REQUIRE(cache.read(0xABCDEF, 0x1F, blob));
+    REQUIRE(blob == content);
+
+    // Another size of the same hash is another source
+    REQUIRE(!cache.read(0xABCDEF, 0x20, blob));
+
+    // Written again, the old blob is replaced
+    const std::vector<std::uint8_t> new_content = { 9, 8 };
+    REQUIRE(cache.write(0xABCDEF, 0x1F, new_content.data(), new_content.size()));
+    REQUIRE(cache.read(0xABCDEF, 0x1F, blob));
+    REQUIRE(blob == new_content);
+
+    cache.record_hit();
+    cache.record_miss();
+    cache.record_miss();
+
+    REQUIRE(cache.hit_count() == 1);
+    REQUIRE(cache.miss_count() == 2);
+
+    common::delete_folder(cache_folder);
+}
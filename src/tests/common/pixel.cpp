@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/algorithm.h>
+#include <common/log.h>
+#include <common/pixel.h>
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace eka2l1;
+
+// Pixel by pixel, like the bitmap cache used to convert
+static void reference_convert_to_24bpp(const std::uint8_t *source, std::uint8_t *dest, const std::size_t pixel_count,
+    const std::uint32_t *lookup, const std::uint32_t bits_per_pixel) {
+    for (std::size_t x = 0; x < pixel_count; x++) {
+        const std::uint32_t max_value = (1 << bits_per_pixel) - 1;
+        const std::uint32_t value = (source[x * bits_per_pixel / 8] >> ((x * bits_per_pixel) % 8)) & max_value;
+
+        if (lookup) {
+            std::memcpy(dest + x * 3, lookup + value, 3);
+        } else {
+            std::memset(dest + x * 3, value * 0xFF / max_value, 3);
+        }
+    }
+}
+
+static std::vector<std::uint8_t> make_random_bytes(const std::size_t size) {
+    std::mt19937 generator(0x1E4A);
+    std::uniform_int_distribution<int> distribution(0, 255);
+
+    std::vector<std::uint8_t> bytes(size);
+    for (std::uint8_t &byte : bytes) {
+        byte = static_cast<std::uint8_t>(distribution(generator));
+    }
+
+    return bytes;
+}
+
+static std::vector<std::uint32_t> make_lookup() {
+    std::vector<std::uint32_t> lookup(256);
+    for (std::uint32_t i = 0; i < 256; i++) {
+        lookup[i] = (i * 0x9E3779B9) & 0xFFFFFF;
+    }
+
+    return lookup;
+}
+
+TEST_CASE("pack_32bpp_to_24bpp_all_lengths", "pixel") {
+    const std::vector<std::uint32_t> lookup = make_lookup();
+
+    for (std::size_t count = 0; count < 70; count++) {
+        // Guard bytes after the pixels must be untouched
+        std::vector<std::uint8_t> dest(count * 3 + 8, 0xCD);
+        common::pack_32bpp_to_24bpp(lookup.data(), dest.data(), count);
+
+        for (std::size_t i = 0; i < count; i++) {
+            REQUIRE(std::memcmp(dest.data() + i * 3, lookup.data() + i, 3) == 0);
+        }
+
+        for (std::size_t i = count * 3; i < dest.size(); i++) {
+            REQUIRE(dest[i] == 0xCD);
+        }
+    }
+}
+
+TEST_CASE("pixel_conversions_match_reference", "pixel") {
+    const std::vector<std::uint8_t> source = make_random_bytes(1024);
+    const std::vector<std::uint32_t> lookup = make_lookup();
+
+    // Odd widths and widths crossing the kernels' chunk size
+    const std::size_t widths[] = { 1, 3, 7, 17, 31, 33, 176, 255, 257, 361, 640 };
+
+    for (const std::uint32_t bpp : { 1, 2, 4, 8 }) {
+        for (const bool palette : { false, true }) {
+            if (palette && (bpp < 4)) {
+                continue;
+            }
+
+            for (const std::size_t width : widths) {
+                std::vector<std::uint8_t> expected(width * 3, 0);
+                std::vector<std::uint8_t> result(width * 3 + 8, 0xCD);
+
+                reference_convert_to_24bpp(source.data(), expected.data(), width, palette ? lookup.data() : nullptr, bpp);
+
+                if (palette) {
+                    common::lookup_palette_to_24bpp(source.data(), result.data(), width, lookup.data(), bpp);
+                } else {
+                    common::expand_gray_to_24bpp(source.data(), result.data(), width, bpp);
+                }
+
+                REQUIRE(std::memcmp(expected.data(), result.data(), expected.size()) == 0);
+                REQUIRE(result[width * 3] == 0xCD);
+            }
+        }
+    }
+}
+
+// Hidden, run it explicitly with: ekatests "[pixel_bench]"
+TEST_CASE("pixel_conversions_bench", "[.][pixel_bench]") {
+    struct screen_size {
+        int width_;
+        int height_;
+    };
+
+    struct conversion_mode {
+        const char *name_;
+        std::uint32_t bpp_;
+        bool palette_;
+    };
+
+    // Common S60 screens, in both orientations where it matters
+    const screen_size sizes[] = { { 176, 208 }, { 240, 320 }, { 320, 240 }, { 360, 640 }, { 640, 360 } };
+
+    // Every display mode that is converted on the CPU before upload
+    const conversion_mode modes[] = {
+        { "Gray2", 1, false },
+        { "Gray4", 2, false },
+        { "Gray16", 4, false },
+        { "Color16", 4, true },
+        { "Color256", 8, true }
+    };
+
+    static constexpr int ROUND_COUNT = 20;
+
+    const std::vector<std::uint32_t> lookup = make_lookup();
+    const std::vector<std::uint8_t> source = make_random_bytes(640 * 640);
+
+    LOG_INFO(COMMON, "Pixel conversion kernels built with: {}", common::pixel_kernels_instruction_set());
+
+    for (const conversion_mode &mode : modes) {
+        for (const screen_size &size : sizes) {
+            const std::size_t source_line_size = common::align(size.width_ * mode.bpp_, 32) / 8;
+            const std::size_t dest_line_size = common::align(size.width_ * 3, 4);
+
+            std::vector<std::uint8_t> expected(dest_line_size * size.height_);
+            std::vector<std::uint8_t> result(dest_line_size * size.height_);
+
+            const std::uint32_t *mode_lookup = mode.palette_ ? lookup.data() : nullptr;
+
+            const auto reference_start = std::chrono::steady_clock::now();
+
+            for (int round = 0; round < ROUND_COUNT; round++) {
+                for (int y = 0; y < size.height_; y++) {
+                    reference_convert_to_24bpp(source.data() + y * source_line_size, expected.data() + y * dest_line_size,
+                        size.width_, mode_lookup, mode.bpp_);
+                }
+            }
+
+            const auto kernel_start = std::chrono::steady_clock::now();
+
+            for (int round = 0; round < ROUND_COUNT; round++) {
+                for (int y = 0; y < size.height_; y++) {
+                    if (mode.palette_) {
+                        common::lookup_palette_to_24bpp(source.data() + y * source_line_size, result.data() + y * dest_line_size,
+                            size.width_, mode_lookup, mode.bpp_);
+                    } else {
+                        common::expand_gray_to_24bpp(source.data() + y * source_line_size, result.data() + y * dest_line_size,
+                            size.width_, mode.bpp_);
+                    }
+                }
+            }
+
+            const auto end = std::chrono::steady_clock::now();
+
+            REQUIRE(expected == result);
+
+            LOG_INFO(COMMON, "{} {}x{} to 24bpp, {} rounds: per pixel {}us, kernels {}us", mode.name_, size.width_, size.height_,
+                ROUND_COUNT, std::chrono::duration_cast<std::chrono::microseconds>(kernel_start - reference_start).count(),
+                std::chrono::duration_cast<std::chrono::microseconds>(end - kernel_start).count());
+        }
+    }
+}
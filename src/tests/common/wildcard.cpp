@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/log.h>
+#include <common/wildcard.h>
+
+#include <chrono>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace eka2l1;
+
+TEST_CASE("wildcard_matcher_exact", "wildcard") {
+    common::wildcard_matcher matcher("!AppListServer", true);
+
+    REQUIRE(!matcher.has_wildcard());
+    REQUIRE(matcher.match("!AppListServer"));
+    REQUIRE(matcher.match("!applistserver"));
+    REQUIRE(!matcher.match("!AppListServer2"));
+    REQUIRE(!matcher.match("!AppList"));
+
+    common::wildcard_matcher matcher_case("Main", false);
+    REQUIRE(!matcher_case.match("main"));
+}
+
+TEST_CASE("wildcard_matcher_stars_and_questions", "wildcard") {
+    common::wildcard_matcher full_name_matcher("*::Main", true);
+
+    REQUIRE(full_name_matcher.has_wildcard());
+    REQUIRE(full_name_matcher.match("Shell[10005a09]0001::Main"));
+    REQUIRE(full_name_matcher.match("::main"));
+    REQUIRE(!full_name_matcher.match("Shell[10005a09]0001::Main2"));
+
+    common::wildcard_matcher process_matcher("Shell[????????]*", true);
+
+    REQUIRE(process_matcher.match("shell[10005a09]0001"));
+    REQUIRE(!process_matcher.match("shell[10005a0]0001"));
+
+    common::wildcard_matcher middle_matcher("a*b*a", true);
+
+    REQUIRE(middle_matcher.match("aba"));
+    REQUIRE(middle_matcher.match("abbbcbba"));
+    REQUIRE(!middle_matcher.match("ab"));
+    REQUIRE(!middle_matcher.match("a"));
+
+    REQUIRE(common::wildcard_matcher("*", true).match(""));
+    REQUIRE(common::wildcard_matcher("**", true).match("anything"));
+    REQUIRE(common::wildcard_matcher("", true).match(""));
+    REQUIRE(!common::wildcard_matcher("", true).match("a"));
+
+    // Characters that mean something in a regex are literals here
+    REQUIRE(common::wildcard_matcher("(x+)*", true).match("(x+)yz"));
+}
+
+static std::vector<std::string> make_thread_names(const int count) {
+    std::vector<std::string> names;
+
+    for (int i = 0; i < count; i++) {
+        names.push_back("Process" + std::to_string(i) + "[10005a09]0001::Thread" + std::to_string(i));
+    }
+
+    return names;
+}
+
+TEST_CASE("wildcard_matcher_same_as_regex", "wildcard") {
+    const std::vector<std::string> names = make_thread_names(300);
+    const std::string patterns[] = { "*::Thread1?9", "process1*", "*[10005A09]*", "Process?[*]0001::Thread?", "*2", "Process12" };
+
+    for (const std::string &pattern : patterns) {
+        // What the kernel used to do on each find
+        const std::regex filter(common::wildcard_to_regex_string(pattern), std::regex_constants::icase);
+        const common::wildcard_matcher matcher(pattern, true);
+
+        for (const std::string &name : names) {
+            REQUIRE(matcher.match(name) == std::regex_match(name, filter));
+        }
+    }
+}
+
+// Hidden, run it explicitly with: ekatests "[wildcard_bench]"
+TEST_CASE("wildcard_matcher_vs_regex_bench", "[.][wildcard_bench]") {
+    static constexpr int NAME_COUNT = 2000;
+    static constexpr int ROUND_COUNT = 20;
+
+    const std::vector<std::string> names = make_thread_names(NAME_COUNT);
+    const std::string pattern = "*::Thread1?9";
+
+    std::size_t regex_matches = 0;
+    std::size_t matcher_matches = 0;
+
+    const auto regex_start = std::chrono::steady_clock::now();
+
+    for (int round = 0; round < ROUND_COUNT; round++) {
+        std::regex filter(common::wildcard_to_regex_string(pattern), std::regex_constants::icase);
+
+        for (const std::string &name : names) {
+            regex_matches += std::regex_match(name, filter) ? 1 : 0;
+        }
+    }
+
+    const auto matcher_start = std::chrono::steady_clock::now();
+    const common::wildcard_matcher matcher(pattern, true);
+
+    for (int round = 0; round < ROUND_COUNT; round++) {
+        for (const std::string &name : names) {
+            matcher_matches += matcher.match(name) ? 1 : 0;
+        }
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+
+    REQUIRE(regex_matches == matcher_matches);
+
+    LOG_INFO(COMMON, "Wildcard search over {} names: regex {}us, matcher {}us", NAME_COUNT * ROUND_COUNT,
+        std::chrono::duration_cast<std::chrono::microseconds>(matcher_start - regex_start).count(),
+        std::chrono::duration_cast<std::chrono::microseconds>(end - matcher_start).count());
+}
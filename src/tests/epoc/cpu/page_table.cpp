@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/log.h>
+#include <common/platform.h>
+#include <cpu/arm_factory.h>
+#include <cpu/arm_interface.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace eka2l1::arm {
+    static constexpr std::uint32_t BENCH_CODE_ADDR = 0x10000;
+    static constexpr std::uint32_t BENCH_SRC_ADDR = 0x100000;
+    static constexpr std::uint32_t BENCH_DEST_ADDR = 0x600000;
+    static constexpr std::uint32_t BENCH_COPY_PAGES = 0x400;
+    static constexpr std::uint32_t BENCH_WORDS_PER_PAGE = 0x400;
+    static constexpr std::uint32_t BENCH_COPY_WORDS = BENCH_COPY_PAGES * BENCH_WORDS_PER_PAGE;
+    static constexpr std::uint32_t CHECK_COPY_PAGES = 0x20;
+    static constexpr std::uint32_t BENCH_MEM_SIZE = 0xA00000;
+
+    // Column-major memcpy, like a bitmap blit by columns: every access lands on a different page,
+    // so the working set is way over the TLB reach. Ended by a SVC.
+    static const std::uint32_t BENCH_MEMCPY_CODE[] = {
+        0xe1a06000, // mov r6, r0
+        0xe1a07001, // mov r7, r1
+        0xe1a08002, // mov r8, r2
+        0xe6973004, // ldr r3, [r7], r4
+        0xe6863004, // str r3, [r6], r4
+        0xe2588001, // subs r8, r8, #1
+        0x1afffffb, // bne #-0x14
+        0xe2800004, // add r0, r0, #4
+        0xe2811004, // add r1, r1, #4
+        0xe2555001, // subs r5, r5, #1
+        0x1afffff4, // bne #-0x30
+        0xef000000, // svc #0
+        0xeafffffe // b +#0 (infinite loop)
+    };
+
+    /**
+     * @brief Memory environment mimicking the MMU's slow path: a page walk on each callback, and
+     *        a TLB fill after each successful access.
+     */
+    struct memcpy_bench_env {
+        std::vector<std::uint8_t> memory_;
+        std::unordered_map<address, std::uint8_t *> pages_;
+        std::unique_ptr<page_table> table_;
+
+        core *core_;
+        bool done_;
+
+        explicit memcpy_bench_env()
+            : memory_(BENCH_MEM_SIZE)
+            , table_(std::make_unique<page_table>())
+            , core_(nullptr)
+            , done_(false) {
+            for (address addr = 0; addr < BENCH_MEM_SIZE; addr += page_table::PAGE_SIZE) {
+                pages_.emplace(addr >> page_table::PAGE_BITS, memory_.data() + addr);
+            }
+
+            std::memcpy(memory_.data() + BENCH_CODE_ADDR, BENCH_MEMCPY_CODE, sizeof(BENCH_MEMCPY_CODE));
+
+            for (std::uint32_t i = 0; i < BENCH_COPY_WORDS; i++) {
+                reinterpret_cast<std::uint32_t *>(memory_.data() + BENCH_SRC_ADDR)[i] = i * 3;
+            }
+        }
+
+        template <typename T>
+        bool access(const address addr, T *data, const bool write) {
+            auto ite = pages_.find(addr >> page_table::PAGE_BITS);
+            if (ite == pages_.end()) {
+                return false;
+            }
+
+            std::uint8_t *ptr = ite->second + (addr & page_table::PAGE_MASK);
+            write ? std::memcpy(ptr, data, sizeof(T)) : std::memcpy(data, ptr, sizeof(T));
+
+            core_->set_tlb_page(addr & ~page_table::PAGE_MASK, ite->second, prot_read_write_exec);
+
+            // Mimic the MMU publishing the page it walked to
+            if (core_->get_page_table()) {
+                table_->pointers[addr >> page_table::PAGE_BITS] = ite->second;
+            }
+
+            return true;
+        }
+
+        void bind(core *cc) {
+            core_ = cc;
+
+            cc->read_8bit = [this](const address addr, std::uint8_t *data) { return access(addr, data, false); };
+            cc->read_16bit = [this](const address addr, std::uint16_t *data) { return access(addr, data, false); };
+            cc->read_32bit = [this](const address addr, std::uint32_t *data) { return access(addr, data, false); };
+            cc->read_64bit = [this](const address addr, std::uint64_t *data) { return access(addr, data, false); };
+            cc->read_code = [this](const address addr, std::uint32_t *data) { return access(addr, data, false); };
+            cc->write_8bit = [this](const address addr, std::uint8_t *data) { return access(addr, data, true); };
+            cc->write_16bit = [this](const address addr, std::uint16_t *data) { return access(addr, data, true); };
+            cc->write_32bit = [this](const address addr, std::uint32_t *data) { return access(addr, data, true); };
+            cc->write_64bit = [this](const address addr, std::uint64_t *data) { return access(addr, data, true); };
+
+            cc->exception_handler = [](exception_type, const std::uint32_t) { return false; };
+            cc->system_call_handler = [this](const std::uint32_t) {
+                done_ = true;
+                core_->stop();
+            };
+        }
+    };
+
+    /**
+     * @brief Run the column-major memcpy of the given number of pages.
+     *
+     * @param copied  Filled with the destination memory after the copy.
+     * @returns Microseconds spent, or -1 if the backend is not available.
+     */
+    static std::int64_t run_memcpy(const arm_emulator_type type, const bool use_page_table, const std::uint32_t copy_pages,
+        std::vector<std::uint8_t> &copied) {
+        exclusive_monitor_instance monitor = create_exclusive_monitor(type, 1);
+        core_instance cc = create_core(monitor.get(), type);
+
+        if (!cc) {
+            return -1;
+        }
+
+        memcpy_bench_env env;
+        env.bind(cc.get());
+
+        if (use_page_table) {
+            cc->set_page_table(env.table_.get());
+        }
+
+        cc->set_reg(0, BENCH_DEST_ADDR);
+        cc->set_reg(1, BENCH_SRC_ADDR);
+        cc->set_reg(2, copy_pages);
+        cc->set_reg(4, page_table::PAGE_SIZE);
+        cc->set_reg(5, BENCH_WORDS_PER_PAGE);
+        cc->set_cpsr(0x10);
+        cc->set_pc(BENCH_CODE_ADDR);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        while (!env.done_) {
+            cc->run(1000000);
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        copied.assign(env.memory_.begin() + BENCH_DEST_ADDR, env.memory_.begin() + BENCH_DEST_ADDR + copy_pages * page_table::PAGE_SIZE);
+        return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    }
+
+    static void check_backend(const arm_emulator_type type) {
+        std::vector<std::uint8_t> through_callbacks;
+        std::vector<std::uint8_t> through_page_table;
+
+        if (run_memcpy(type, false, CHECK_COPY_PAGES, through_callbacks) < 0) {
+            return;
+        }
+
+        REQUIRE(run_memcpy(type, true, CHECK_COPY_PAGES, through_page_table) >= 0);
+
+        std::vector<std::uint32_t> expected(CHECK_COPY_PAGES * BENCH_WORDS_PER_PAGE);
+
+        for (std::uint32_t i = 0; i < expected.size(); i++) {
+            expected[i] = i * 3;
+        }
+
+        REQUIRE(through_callbacks.size() == expected.size() * sizeof(std::uint32_t));
+        REQUIRE(std::memcmp(through_callbacks.data(), expected.data(), through_callbacks.size()) == 0);
+        REQUIRE(through_callbacks == through_page_table);
+    }
+
+    static void bench_backend(const arm_emulator_type type, const char *name) {
+        std::vector<std::uint8_t> copied;
+
+        const std::int64_t callback_us = run_memcpy(type, false, BENCH_COPY_PAGES, copied);
+        const std::int64_t page_table_us = run_memcpy(type, true, BENCH_COPY_PAGES, copied);
+
+        LOG_INFO(CPU, "Memcpy of {} bytes on {}: {} us through callbacks, {} us with page table", BENCH_COPY_WORDS * 4,
+            name, callback_us, page_table_us);
+    }
+}
+
+TEST_CASE("memcpy_loop_same_with_page_table", "cpu") {
+    eka2l1::arm::check_backend(arm_emulator_type::dyncom);
+
+#if EKA2L1_ARCH(ARM)
+    eka2l1::arm::check_backend(arm_emulator_type::r12l1);
+#else
+    eka2l1::arm::check_backend(arm_emulator_type::dynarmic);
+#endif
+}
+
+// Hidden, run it explicitly with: ekatests "[page_table_bench]"
+TEST_CASE("memcpy_loop_page_table_bench", "[.][page_table_bench]") {
+    eka2l1::arm::bench_backend(arm_emulator_type::dyncom, "dyncom");
+
+#if EKA2L1_ARCH(ARM)
+    eka2l1::arm::bench_backend(arm_emulator_type::r12l1, "12l1r");
+#else
+    eka2l1::arm::bench_backend(arm_emulator_type::dynarmic, "dynarmic");
+#endif
+}
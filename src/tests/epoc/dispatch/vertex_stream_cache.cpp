@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2022 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <dispatch/libraries/vertex_stream_cache.h>
+#include <drivers/graphics/backend/software/graphics_software.h>
+#include <drivers/itc.h>
+#include <mem/watch.h>
+
+#include <cstring>
+#include <thread>
+
+using namespace eka2l1;
+
+static void submit(drivers::graphics_driver *driver, drivers::graphics_command_builder &builder) {
+    drivers::command_list list = builder.retrieve_command_list();
+    driver->submit_command_list(list);
+}
+
+static constexpr std::size_t STREAM_SIZE = mem::write_watcher::PAGE_SIZE * 2;
+static constexpr std::size_t STREAM_OFFSET = 16;
+
+static dispatch::vertex_stream_cache::stream_key make_stream_key(const std::uint32_t stride) {
+    dispatch::vertex_stream_cache::stream_key key;
+    key.owner_ = 1;
+    key.addr_ = 0x400000;
+    key.stride_ = stride;
+    key.size_ = static_cast<std::uint32_t>(STREAM_SIZE);
+
+    return key;
+}
+
+TEST_CASE("vertex_stream_cache_reuses_watched_streams", "vertex_stream_cache") {
+    alignas(mem::write_watcher::PAGE_SIZE) static std::uint8_t memory[mem::write_watcher::PAGE_SIZE * 3];
+    std::memset(memory, 0x42, sizeof(memory));
+
+    drivers::software_graphics_driver driver(1);
+    std::thread driver_thread([&]() { driver.run(); });
+
+    mem::write_watcher watcher(true);
+    dispatch::vertex_stream_cache cache;
+    cache.attach_write_watcher(&watcher);
+
+    drivers::graphics_command_builder builder;
+
+    // The range starts inside the first page and ends inside the third
+    const std::uint8_t *data = memory + STREAM_OFFSET;
+    const auto key = make_stream_key(12);
+
+    REQUIRE(cache.get_stream(&driver, builder, key, data) == 0);
+    REQUIRE(!watcher.empty());
+
+    const drivers::handle buffer = cache.get_stream(&driver, builder, key, data);
+    REQUIRE(buffer != 0);
+    REQUIRE(!builder.is_empty());
+
+    submit(&driver, builder);
+
+    // Nothing written, no upload and no hashing
+    REQUIRE(cache.get_stream(&driver, builder, key, data) == buffer);
+    REQUIRE(builder.is_empty());
+
+    // Only the part of the range inside the written page is uploaded
+    memory[mem::write_watcher::PAGE_SIZE + 5] = 0x11;
+    watcher.note_write(memory + mem::write_watcher::PAGE_SIZE + 5);
+
+    REQUIRE(cache.get_stream(&driver, builder, key, data) == buffer);
+    REQUIRE(!builder.is_empty());
+
+    dispatch::vertex_stream_stats stats = cache.done_frame(builder);
+    REQUIRE(stats.bytes_uploaded_ == STREAM_SIZE + mem::write_watcher::PAGE_SIZE);
+    REQUIRE(stats.bytes_reused_ == STREAM_SIZE);
+
+    // Nothing was evicted, so the end of the frame has nothing to clean up
+    submit(&driver, builder);
+    cache.done_frame(builder);
+    REQUIRE(builder.is_empty());
+
+    REQUIRE(cache.get_stream(&driver, builder, key, data) == buffer);
+    REQUIRE(builder.is_empty());
+
+    // Changing on every use gives the range back to the pusher, and stops watching it
+    for (std::uint32_t i = 0; i < dispatch::vertex_stream_cache::MAX_CHANGE_STREAK - 1; i++) {
+        watcher.note_write(memory + STREAM_OFFSET);
+        REQUIRE(cache.get_stream(&driver, builder, key, data) == buffer);
+    }
+
+    watcher.note_write(memory + STREAM_OFFSET);
+    REQUIRE(cache.get_stream(&driver, builder, key, data) == 0);
+    REQUIRE(watcher.empty());
+
+    cache.destroy(builder);
+    submit(&driver, builder);
+
+    REQUIRE(watcher.empty());
+
+    driver.abort();
+    driver_thread.join();
+}
+
+TEST_CASE("vertex_stream_cache_hashes_without_watcher", "vertex_stream_cache") {
+    static std::uint8_t memory[STREAM_SIZE];
+    std::memset(memory, 0x42, sizeof(memory));
+
+    drivers::software_graphics_driver driver(1);
+    std::thread driver_thread([&]() { driver.run(); });
+
+    // An unsupported watcher is not used
+    mem::write_watcher watcher(false);
+    dispatch::vertex_stream_cache cache;
+    cache.attach_write_watcher(&watcher);
+
+    drivers::graphics_command_builder builder;
+
+    // Index streams are cached the same, with the index size as the stride
+    const auto key = make_stream_key(2);
+
+    REQUIRE(cache.get_stream(&driver, builder, key, memory) == 0);
+
+    const drivers::handle buffer = cache.get_stream(&driver, builder, key, memory);
+    REQUIRE(buffer != 0);
+
+    submit(&driver, builder);
+
+    REQUIRE(cache.get_stream(&driver, builder, key, memory) == buffer);
+    REQUIRE(builder.is_empty());
+
+    // Only the bytes that differ are uploaded
+    memory[100] = 0x11;
+    memory[103] = 0x11;
+
+    REQUIRE(cache.get_stream(&driver, builder, key, memory) == buffer);
+    REQUIRE(!builder.is_empty());
+
+    const dispatch::vertex_stream_stats stats = cache.done_frame(builder);
+    REQUIRE(stats.bytes_uploaded_ == STREAM_SIZE + 4);
+    REQUIRE(stats.bytes_reused_ == STREAM_SIZE);
+
+    // Different stride is a different stream
+    REQUIRE(cache.get_stream(&driver, builder, make_stream_key(4), memory) == 0);
+
+    cache.destroy(builder);
+    submit(&driver, builder);
+
+    driver.abort();
+    driver_thread.join();
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/driver.h>
+
+#include <cstring>
+
+using namespace eka2l1;
+
+TEST_CASE("command_stream_round_trip", "command_list") {
+    drivers::command_list list;
+    int status = -100;
+
+    drivers::command *cmd = list.retrieve_next();
+    cmd->opcode_ = 7;
+    cmd->data_[0] = 0x1122334455667788ULL;
+    cmd->data_[2] = 3;
+
+    cmd = list.retrieve_next();
+    cmd->opcode_ = 9;
+    cmd->status_ = &status;
+
+    drivers::command full(12);
+
+    for (std::size_t i = 0; i < drivers::COMMAND_MAX_DATA_WORD; i++) {
+        full.data_[i] = i + 1;
+    }
+
+    list.push(full);
+
+    REQUIRE(list.size_ == 3);
+
+    // Zero words are not stored
+    REQUIRE(list.stream_size() == (4 + 2 * 8) + (4 + sizeof(int *)) + (4 + drivers::COMMAND_MAX_DATA_WORD * 8));
+
+    drivers::command_reader reader(list);
+    drivers::command decoded;
+
+    REQUIRE(reader.next(decoded));
+    REQUIRE(decoded.opcode_ == 7);
+    REQUIRE(decoded.data_[0] == 0x1122334455667788ULL);
+    REQUIRE(decoded.data_[1] == 0);
+    REQUIRE(decoded.data_[2] == 3);
+    REQUIRE(decoded.status_ == nullptr);
+
+    REQUIRE(reader.next(decoded));
+    REQUIRE(decoded.opcode_ == 9);
+    REQUIRE(decoded.status_ == &status);
+    REQUIRE(decoded.data_[0] == 0);
+    REQUIRE(decoded.data_[2] == 0);
+
+    REQUIRE(reader.next(decoded));
+    REQUIRE(decoded.opcode_ == 12);
+    REQUIRE(std::memcmp(decoded.data_, full.data_, sizeof(full.data_)) == 0);
+
+    REQUIRE_FALSE(reader.next(decoded));
+
+    list.retire();
+    REQUIRE(list.empty());
+    REQUIRE(list.stream_size() == 0);
+}
+
+TEST_CASE("command_stream_spans_blocks_and_appends", "command_list") {
+    drivers::command_list first;
+    drivers::command_list second;
+
+    // Enough to fill more than one block
+    const std::size_t count = (drivers::COMMAND_BLOCK_SIZE / 12) * 2;
+
+    for (std::size_t i = 0; i < count; i++) {
+        drivers::command cmd(1);
+        cmd.data_[0] = i + 1;
+
+        first.push(cmd);
+    }
+
+    std::uint8_t *small_payload = first.allocate_payload(100);
+    std::uint8_t *big_payload = second.allocate_payload(drivers::COMMAND_BLOCK_SIZE * 2);
+
+    std::memset(small_payload, 0xAB, 100);
+    std::memset(big_payload, 0xCD, drivers::COMMAND_BLOCK_SIZE * 2);
+
+    REQUIRE(reinterpret_cast<std::uintptr_t>(small_payload) % 16 == 0);
+
+    drivers::command *cmd = second.retrieve_next();
+    cmd->opcode_ = 2;
+    cmd->data_[0] = reinterpret_cast<std::uint64_t>(big_payload);
+
+    second.adopt_payload(new std::uint8_t[32], 32);
+    first.append(second);
+
+    REQUIRE(second.empty());
+    REQUIRE(first.size_ == count + 1);
+
+    drivers::command_reader reader(first);
+    drivers::command decoded;
+
+    for (std::size_t i = 0; i < count; i++) {
+        REQUIRE(reader.next(decoded));
+        REQUIRE(decoded.data_[0] == i + 1);
+    }
+
+    REQUIRE(reader.next(decoded));
+    REQUIRE(decoded.opcode_ == 2);
+    REQUIRE(reinterpret_cast<std::uint8_t *>(decoded.data_[0])[drivers::COMMAND_BLOCK_SIZE] == 0xCD);
+    REQUIRE_FALSE(reader.next(decoded));
+
+    first.retire();
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/audio/backend/dsp_shared.h>
+#include <drivers/audio/backend/null/audio_null.h>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+namespace {
+    /**
+     * \brief Stream whose "compressed" data is a sample count, decoded to that many increasing samples.
+     */
+    struct counting_dsp_output_stream : public drivers::dsp_output_stream_shared {
+        std::vector<std::uint32_t> queued_counts_;
+        std::int16_t next_sample_ = 0;
+
+        std::thread::id decode_thread_id_;
+
+        explicit counting_dsp_output_stream(drivers::audio_driver *aud)
+            : drivers::dsp_output_stream_shared(aud) {
+        }
+
+        ~counting_dsp_output_stream() override {
+            stop_decode_thread();
+        }
+
+        void get_supported_formats(std::vector<drivers::four_cc> &cc_list) override {
+            cc_list.push_back(drivers::MP3_FOUR_CC_CODE);
+        }
+
+        void queue_data_decode(const std::uint8_t *original, const std::size_t original_size) override {
+            const std::lock_guard<std::mutex> guard(decode_lock_);
+
+            std::uint32_t count = 0;
+            std::memcpy(&count, original, sizeof(std::uint32_t));
+
+            queued_counts_.push_back(count);
+        }
+
+        bool decode_data(std::vector<std::uint8_t> &dest) override {
+            dest.clear();
+            decode_thread_id_ = std::this_thread::get_id();
+
+            if (queued_counts_.empty()) {
+                return false;
+            }
+
+            dest.resize(queued_counts_.front() * sizeof(std::int16_t));
+            queued_counts_.erase(queued_counts_.begin());
+
+            std::int16_t *samples = reinterpret_cast<std::int16_t *>(dest.data());
+
+            for (std::size_t i = 0; i < dest.size() / sizeof(std::int16_t); i++) {
+                samples[i] = next_sample_++;
+            }
+
+            return true;
+        }
+
+        std::size_t decoded_sample_count() {
+            return buffer_.size();
+        }
+    };
+}
+
+TEST_CASE("dsp_decode_ahead_of_callback", "dsp") {
+    drivers::null_audio_driver driver;
+    counting_dsp_output_stream stream(&driver);
+
+    stream.format(drivers::MP3_FOUR_CC_CODE);
+    stream.set_properties(8000, 1);
+    stream.decode_lookahead(100);
+
+    REQUIRE(stream.start());
+
+    // 100ms of audio at 8kHz mono
+    for (int i = 0; i < 8; i++) {
+        const std::uint32_t count = 100;
+        stream.write(reinterpret_cast<const std::uint8_t *>(&count), sizeof(std::uint32_t));
+    }
+
+    for (int wait = 0; (wait < 200) && (stream.decoded_sample_count() < 800); wait++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    REQUIRE(stream.decoded_sample_count() == 800);
+    REQUIRE(stream.decode_thread_id_ != std::this_thread::get_id());
+
+    std::vector<std::int16_t> played(500);
+    stream.data_callback(played.data(), played.size());
+
+    for (std::size_t i = 0; i < played.size(); i++) {
+        REQUIRE(played[i] == static_cast<std::int16_t>(i));
+    }
+
+    REQUIRE(stream.underrun_count() == 0);
+
+    // Only 300 samples are left
+    stream.data_callback(played.data(), played.size());
+
+    REQUIRE(played[299] == 799);
+    REQUIRE(played[300] == 0);
+    REQUIRE(stream.underrun_count() == 1);
+    REQUIRE(stream.underrun_frame_count() == 200);
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/audio/backend/null/audio_null.h>
+#include <drivers/audio/mixer.h>
+
+#include <vector>
+
+using namespace eka2l1;
+
+static drivers::data_callback make_constant_callback(const std::int16_t value, const std::uint8_t channels) {
+    return [value, channels](std::int16_t *buffer, const std::size_t frame_count) {
+        std::fill(buffer, buffer + frame_count * channels, value);
+        return frame_count;
+    };
+}
+
+TEST_CASE("mix_samples_saturated", "audio_mixer") {
+    std::vector<std::int16_t> dest = { 1, -1, 30000, -30000, 100, 32767, -32768, 0, 20000, -20000, 5 };
+    const std::vector<std::int16_t> source = { 1, 1, 10000, -10000, -200, 1, -1, 0, 20000, -20000, 5 };
+    const std::vector<std::int16_t> expected = { 2, 0, 32767, -32768, -100, 32767, -32768, 0, 32767, -32768, 10 };
+
+    drivers::mix_samples_saturated(dest.data(), source.data(), dest.size());
+    REQUIRE(dest == expected);
+}
+
+TEST_CASE("audio_mixer_convert_and_mix", "audio_mixer") {
+    drivers::null_audio_driver driver;
+    drivers::audio_mixer mixer(&driver, 48000, false);
+
+    // Stereo at the host rate, and mono at half of it with half the volume
+    auto loud = mixer.new_output_stream(48000, 2, make_constant_callback(30000, 2));
+    auto quiet = mixer.new_output_stream(24000, 1, make_constant_callback(1000, 1));
+
+    REQUIRE(loud);
+    REQUIRE(quiet);
+    REQUIRE(mixer.source_count() == 2);
+
+    quiet->set_volume(0.5f);
+    quiet->start();
+
+    std::vector<std::int16_t> output(1000 * drivers::audio_mixer::CHANNEL_COUNT);
+    mixer.mix(output.data(), 1000);
+
+    for (const std::int16_t sample : output) {
+        REQUIRE(sample == 500);
+    }
+
+    // Frames up to the one after the last output frame are pulled
+    std::uint64_t position = 0;
+    REQUIRE(quiet->current_frame_position(&position));
+    REQUIRE(position == 501);
+
+    loud->start();
+    mixer.mix(output.data(), 1000);
+
+    for (const std::int16_t sample : output) {
+        REQUIRE(sample == 30500);
+    }
+
+    quiet->pause();
+    loud->set_volume(2.0f);
+    mixer.mix(output.data(), 1000);
+
+    for (const std::int16_t sample : output) {
+        REQUIRE(sample == 30000);
+    }
+
+    loud.reset();
+    quiet.reset();
+
+    REQUIRE(mixer.source_count() == 0);
+    mixer.mix(output.data(), 1000);
+
+    for (const std::int16_t sample : output) {
+        REQUIRE(sample == 0);
+    }
+}
+
+TEST_CASE("audio_mixer_resample_keeps_every_frame", "audio_mixer") {
+    static constexpr std::uint32_t HOST_SAMPLE_RATE = 48000;
+
+    // Uneven sizes, so blocks end between source frames
+    const std::size_t mix_sizes[] = { 1, 7, 333, 1000, 2, 511, 4096 };
+    const std::uint32_t rates[] = { 8000, 22050, 44100 };
+
+    drivers::null_audio_driver driver;
+
+    for (const std::uint32_t rate : rates) {
+        for (std::uint8_t channels = 1; channels <= 2; channels++) {
+            drivers::audio_mixer mixer(&driver, HOST_SAMPLE_RATE, false);
+            std::int16_t next_frame = 0;
+
+            // Each frame holds its own index, so output frames tell which source frame they come from
+            auto stream = mixer.new_output_stream(rate, channels, [&next_frame, channels](std::int16_t *buffer, const std::size_t frame_count) {
+                for (std::size_t frame = 0; frame < frame_count; frame++, next_frame++) {
+                    for (std::uint8_t channel = 0; channel < channels; channel++) {
+                        buffer[frame * channels + channel] = next_frame;
+                    }
+                }
+
+                return frame_count;
+            });
+
+            REQUIRE(stream);
+            stream->start();
+
+            const std::uint64_t step = (static_cast<std::uint64_t>(rate) << 32) / HOST_SAMPLE_RATE;
+            std::uint64_t output_frame = 0;
+
+            for (const std::size_t size : mix_sizes) {
+                std::vector<std::int16_t> output(size * drivers::audio_mixer::CHANNEL_COUNT);
+                mixer.mix(output.data(), size);
+
+                for (std::size_t i = 0; i < size; i++, output_frame++) {
+                    const std::int16_t expected = static_cast<std::int16_t>((output_frame * step) >> 32);
+
+                    REQUIRE(output[i * drivers::audio_mixer::CHANNEL_COUNT] == expected);
+                    REQUIRE(output[i * drivers::audio_mixer::CHANNEL_COUNT + 1] == expected);
+                }
+            }
+
+            // Nothing is pulled past the frame after the last output frame
+            std::uint64_t position = 0;
+            REQUIRE(stream->current_frame_position(&position));
+            REQUIRE(position == ((output_frame - 1) * step >> 32) + 2);
+            REQUIRE(next_frame == static_cast<std::int16_t>(position));
+        }
+    }
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/region.h>
+#include <drivers/graphics/backend/software/graphics_software.h>
+#include <drivers/itc.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+static std::uint32_t read_pixel(const std::vector<std::uint8_t> &data, const int width, const int x, const int y) {
+    std::uint32_t pixel = 0;
+    std::memcpy(&pixel, data.data() + (y * width + x) * 4, 4);
+
+    return pixel;
+}
+
+static void submit(drivers::graphics_driver *driver, drivers::graphics_command_builder &builder) {
+    drivers::command_list list = builder.retrieve_command_list();
+    driver->submit_command_list(list);
+}
+
+TEST_CASE("software_driver_fills_and_blits_pixel_exact", "graphics_driver") {
+    // Two worker threads, so the tiles of the 100x70 target are split between them
+    drivers::software_graphics_driver driver(3);
+    std::thread driver_thread([&]() { driver.run(); });
+
+    const drivers::handle target = drivers::create_bitmap(&driver, eka2l1::vec2(100, 70), 32);
+    const drivers::handle source = drivers::create_bitmap(&driver, eka2l1::vec2(2, 2), 16);
+
+    // Red, green, blue, white in RGB565
+    const std::uint16_t source_data[4] = { 0xF800, 0x07E0, 0x001F, 0xFFFF };
+
+    drivers::graphics_command_builder builder;
+    builder.update_bitmap(source, reinterpret_cast<const char *>(source_data), sizeof(source_data), { 0, 0 }, { 2, 2 });
+    builder.bind_bitmap(target);
+    builder.clear({ 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f }, drivers::draw_buffer_bit_color_buffer);
+
+    // Half transparent white over the whole target, then a solid blue bar crossing tile edges
+    builder.set_feature(drivers::graphics_feature::blend, true);
+    builder.blend_formula(drivers::blend_equation::add, drivers::blend_equation::add,
+        drivers::blend_factor::frag_out_alpha, drivers::blend_factor::one_minus_frag_out_alpha,
+        drivers::blend_factor::one, drivers::blend_factor::one);
+    builder.set_brush_color_detail({ 255, 255, 255, 128 });
+    builder.draw_rectangle(eka2l1::rect({ 0, 0 }, { 0, 0 }));
+    builder.set_feature(drivers::graphics_feature::blend, false);
+    builder.set_brush_color_detail({ 0, 0, 255, 255 });
+    builder.draw_rectangle(eka2l1::rect({ 60, 60 }, { 10, 5 }));
+
+    // Scale the 2x2 bitmap up to 4x4
+    builder.draw_bitmap(source, 0, eka2l1::rect({ 10, 10 }, { 4, 4 }), eka2l1::rect({ 0, 0 }, { 0, 0 }));
+    submit(&driver, builder);
+
+    std::vector<std::uint8_t> pixels(100 * 70 * 4);
+    REQUIRE(drivers::read_bitmap(&driver, target, { 0, 0 }, { 100, 70 }, 32, pixels.data()));
+
+    REQUIRE(read_pixel(pixels, 100, 0, 0) == 0xFF808080);
+    REQUIRE(read_pixel(pixels, 100, 99, 69) == 0xFF808080);
+    REQUIRE(read_pixel(pixels, 100, 60, 60) == 0xFFFF0000);
+    REQUIRE(read_pixel(pixels, 100, 69, 64) == 0xFFFF0000);
+    REQUIRE(read_pixel(pixels, 100, 70, 64) == 0xFF808080);
+
+    REQUIRE(read_pixel(pixels, 100, 10, 10) == 0xFF0000FF);
+    REQUIRE(read_pixel(pixels, 100, 11, 11) == 0xFF0000FF);
+    REQUIRE(read_pixel(pixels, 100, 12, 10) == 0xFF00FF00);
+    REQUIRE(read_pixel(pixels, 100, 10, 12) == 0xFFFF0000);
+    REQUIRE(read_pixel(pixels, 100, 13, 13) == 0xFFFFFFFF);
+    REQUIRE(read_pixel(pixels, 100, 14, 14) == 0xFF808080);
+
+    driver.abort();
+    driver_thread.join();
+}
+
+TEST_CASE("software_driver_clips_to_region_and_masks", "graphics_driver") {
+    drivers::software_graphics_driver driver(2);
+    std::thread driver_thread([&]() { driver.run(); });
+
+    const drivers::handle target = drivers::create_bitmap(&driver, eka2l1::vec2(8, 8), 32);
+    const drivers::handle mask = drivers::create_bitmap(&driver, eka2l1::vec2(2, 1), 8);
+    const drivers::handle source = drivers::create_bitmap(&driver, eka2l1::vec2(2, 1), 32);
+
+    const std::uint8_t mask_data[4] = { 0xFF, 0x00, 0, 0 };
+    const std::uint8_t source_data[8] = { 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00, 0xFF, 0xFF };
+
+    common::region clip;
+    clip.add_rect(eka2l1::rect({ 0, 0 }, { 2, 2 }));
+    clip.add_rect(eka2l1::rect({ 4, 4 }, { 2, 2 }));
+
+    drivers::graphics_command_builder builder;
+    builder.update_bitmap(mask, reinterpret_cast<const char *>(mask_data), sizeof(mask_data), { 0, 0 }, { 2, 1 });
+    builder.update_bitmap(source, reinterpret_cast<const char *>(source_data), sizeof(source_data), { 0, 0 }, { 2, 1 });
+    builder.bind_bitmap(target);
+    builder.clear({ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }, drivers::draw_buffer_bit_color_buffer);
+    builder.set_feature(drivers::graphics_feature::stencil_test, true);
+    builder.clip_bitmap_region(clip);
+    builder.set_brush_color_detail({ 0, 255, 0, 255 });
+    builder.draw_rectangle(eka2l1::rect({ 0, 0 }, { 8, 8 }));
+    builder.set_feature(drivers::graphics_feature::stencil_test, false);
+
+    // Left texel of the mask is set, the right one is not
+    builder.draw_bitmap(source, mask, eka2l1::rect({ 0, 7 }, { 2, 1 }), eka2l1::rect({ 0, 0 }, { 0, 0 }));
+    submit(&driver, builder);
+
+    std::vector<std::uint8_t> pixels(8 * 8 * 4);
+    REQUIRE(drivers::read_bitmap(&driver, target, { 0, 0 }, { 8, 8 }, 32, pixels.data()));
+
+    REQUIRE(read_pixel(pixels, 8, 1, 1) == 0xFF00FF00);
+    REQUIRE(read_pixel(pixels, 8, 5, 5) == 0xFF00FF00);
+    REQUIRE(read_pixel(pixels, 8, 2, 2) == 0);
+    REQUIRE(read_pixel(pixels, 8, 3, 4) == 0);
+
+    REQUIRE(read_pixel(pixels, 8, 0, 7) == 0xFF0000FF);
+    REQUIRE(read_pixel(pixels, 8, 1, 7) == 0x000000FF);
+
+    driver.abort();
+    driver_thread.join();
+}
+
+TEST_CASE("software_driver_reports_no_shader_draws", "graphics_driver") {
+    drivers::software_graphics_driver driver(1);
+    std::thread driver_thread([&]() { driver.run(); });
+
+    // EGL looks at this to refuse GLES and VG
+    REQUIRE(!driver.support_shader_draw());
+
+    const char shader_source[] = "void main() {}";
+    const drivers::handle vertex_module = drivers::create_shader_module(&driver, shader_source, sizeof(shader_source),
+        drivers::shader_module_type::vertex);
+    const drivers::handle fragment_module = drivers::create_shader_module(&driver, shader_source, sizeof(shader_source),
+        drivers::shader_module_type::fragment);
+
+    REQUIRE(drivers::create_shader_program(&driver, vertex_module, fragment_module, nullptr) == 0);
+
+    driver.abort();
+    driver_thread.join();
+}
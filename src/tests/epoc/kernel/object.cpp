@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <config/config.h>
+#include <cpu/arm_factory.h>
+#include <kernel/kernel.h>
+#include <kernel/mutex.h>
+#include <kernel/timing.h>
+#include <mem/mem.h>
+
+#include <memory>
+
+using namespace eka2l1;
+
+TEST_CASE("objects_added_out_of_uid_order_are_found", "kernel") {
+    config::state conf;
+    ntimer timing(484000000);
+
+    arm::exclusive_monitor_instance monitor = arm::create_exclusive_monitor(arm_emulator_type::dyncom, 1);
+    memory_system mem(monitor.get(), &conf, mem::mem_model_type::multiple, false);
+    arm::core_instance core = arm::create_core(monitor.get(), arm_emulator_type::dyncom);
+
+    kernel_system kern(nullptr, &timing, nullptr, &conf, nullptr, nullptr, core.get(), nullptr);
+    kern.install_memory(&mem);
+
+    // Take an ID first, but only hand the object to the kernel after a newer one was created,
+    // like servers made by the HLE side do
+    std::unique_ptr<kernel::mutex> early_obj = std::make_unique<kernel::mutex>(&kern, &timing, nullptr, "OrderTestEarly", false);
+    kernel::mutex *late = kern.create<kernel::mutex>(&timing, nullptr, "OrderTestLate", false);
+    kernel::mutex *early = kern.add_object<kernel::mutex>(early_obj);
+
+    REQUIRE(early);
+    REQUIRE(late);
+    REQUIRE(early->unique_id() < late->unique_id());
+
+    REQUIRE(kern.get_by_id<kernel::mutex>(early->unique_id()) == early);
+    REQUIRE(kern.get_by_id<kernel::mutex>(late->unique_id()) == late);
+
+    // A wildcard find walks the objects in ID order, from after the last one found
+    std::optional<find_handle> first = kern.find_object("OrderTest*", 0, kernel::object_type::mutex);
+
+    REQUIRE(first);
+    REQUIRE(first->obj == early);
+    REQUIRE(kern.get_object_from_find_handle(first->index) == early);
+
+    std::optional<find_handle> second = kern.find_object("OrderTest*", static_cast<int>(first->index), kernel::object_type::mutex);
+
+    REQUIRE(second);
+    REQUIRE(second->obj == late);
+    REQUIRE(kern.get_object_from_find_handle(second->index) == late);
+
+    REQUIRE(!kern.find_object("OrderTest*", static_cast<int>(second->index), kernel::object_type::mutex));
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <config/config.h>
+#include <cpu/arm_factory.h>
+#include <kernel/chunk.h>
+#include <kernel/kernel.h>
+#include <kernel/process.h>
+#include <kernel/timing.h>
+#include <mem/control.h>
+#include <mem/mem.h>
+#include <utils/des.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace eka2l1;
+
+static constexpr std::uint32_t FIRST_CHUNK_SIZE = 0x100000;
+
+// Puts a buffer descriptor with the given length and maximum length at an offset of guest memory
+static void make_guest_buf_descriptor(std::uint8_t *host, const std::uint32_t offset, const std::uint32_t length,
+    const std::uint32_t max_length) {
+    const std::uint32_t info = length | (static_cast<std::uint32_t>(epoc::buf) << 28);
+
+    std::memcpy(host + offset, &info, sizeof(info));
+    std::memcpy(host + offset + 4, &max_length, sizeof(max_length));
+}
+
+// Puts a pointer descriptor to the given guest data at an offset of guest memory
+static void make_guest_ptr_descriptor(std::uint8_t *host, const std::uint32_t offset, const std::uint32_t length,
+    const std::uint32_t max_length, const address data) {
+    const std::uint32_t info = length | (static_cast<std::uint32_t>(epoc::ptr) << 28);
+
+    std::memcpy(host + offset, &info, sizeof(info));
+    std::memcpy(host + offset + 4, &max_length, sizeof(max_length));
+    std::memcpy(host + offset + 8, &data, sizeof(data));
+}
+
+TEST_CASE("addr_space_access_inside_and_across_chunks", "kernel") {
+    config::state conf;
+    ntimer timing(484000000);
+
+    arm::exclusive_monitor_instance monitor = arm::create_exclusive_monitor(arm_emulator_type::dyncom, 1);
+    memory_system mem(monitor.get(), &conf, mem::mem_model_type::multiple, false);
+    arm::core_instance core = arm::create_core(monitor.get(), arm_emulator_type::dyncom);
+
+    kernel_system kern(nullptr, &timing, nullptr, &conf, nullptr, nullptr, core.get(), nullptr);
+    kern.install_memory(&mem);
+
+    kernel::process *pr = kern.create<kernel::process>(&mem, "AddrSpaceTest", u"", u"");
+
+    // The first chunk takes a whole page table span, so the second one is placed right after it,
+    // with its own host mapping
+    kernel::chunk *first = kern.create<kernel::chunk>(&mem, pr, "AddrSpaceTestFirst", 0, FIRST_CHUNK_SIZE, FIRST_CHUNK_SIZE,
+        prot_read_write, kernel::chunk_type::normal, kernel::chunk_access::local, kernel::chunk_attrib::none);
+    kernel::chunk *second = kern.create<kernel::chunk>(&mem, pr, "AddrSpaceTestSecond", 0, 0x1000, 0x10000,
+        prot_read_write, kernel::chunk_type::normal, kernel::chunk_access::local, kernel::chunk_attrib::none);
+
+    REQUIRE(pr);
+    REQUIRE(first);
+    REQUIRE(second);
+
+    const address first_base = first->base(pr).ptr_address();
+    const address second_base = second->base(pr).ptr_address();
+
+    REQUIRE(second_base == first_base + FIRST_CHUNK_SIZE);
+
+    std::uint8_t *first_host = reinterpret_cast<std::uint8_t *>(first->host_base());
+    std::uint8_t *second_host = reinterpret_cast<std::uint8_t *>(second->host_base());
+
+    const std::uint32_t page_size = static_cast<std::uint32_t>(mem.get_control()->page_size());
+
+    SECTION("contiguous ranges are accessed in place") {
+        // Inside a page, and across a page boundary of the same chunk
+        REQUIRE(pr->get_contiguous_ptr_on_addr_space(first_base + 0x10, 0x20) == first_host + 0x10);
+        REQUIRE(pr->get_contiguous_ptr_on_addr_space(first_base + page_size - 8, 16) == first_host + page_size - 8);
+        REQUIRE(pr->get_contiguous_ptr_on_addr_space(second_base, 0x1000) == second_host);
+
+        std::memset(first_host + page_size - 8, 0x3C, 16);
+
+        std::uint8_t read_back[16] = {};
+        REQUIRE(pr->copy_on_addr_space(first_base + page_size - 8, read_back, 16, false));
+        REQUIRE(read_back[0] == 0x3C);
+        REQUIRE(read_back[15] == 0x3C);
+    }
+
+    SECTION("ranges crossing into another chunk are bounced") {
+        const address crossing = second_base - 8;
+        REQUIRE(!pr->get_contiguous_ptr_on_addr_space(crossing, 16));
+
+        const std::uint8_t pattern[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+        REQUIRE(pr->copy_on_addr_space(crossing, const_cast<std::uint8_t *>(pattern), sizeof(pattern), true));
+
+        REQUIRE(std::memcmp(first_host + FIRST_CHUNK_SIZE - 8, pattern, 8) == 0);
+        REQUIRE(std::memcmp(second_host, pattern + 8, 8) == 0);
+
+        std::uint8_t read_back[16] = {};
+        REQUIRE(pr->copy_on_addr_space(crossing, read_back, sizeof(read_back), false));
+        REQUIRE(std::memcmp(read_back, pattern, sizeof(pattern)) == 0);
+    }
+
+    SECTION("ranges crossing into an uncommitted page fail") {
+        const address crossing = second_base + 0x1000 - 8;
+        std::uint8_t data[16] = {};
+
+        REQUIRE(!pr->get_contiguous_ptr_on_addr_space(crossing, 16));
+        REQUIRE(!pr->copy_on_addr_space(crossing, data, sizeof(data), false));
+        REQUIRE(!pr->copy_on_addr_space(crossing, data, sizeof(data), true));
+
+        // The part before the boundary is still fine
+        REQUIRE(pr->get_contiguous_ptr_on_addr_space(crossing, 8) == second_host + 0x1000 - 8);
+    }
+}
+
+TEST_CASE("descriptor_data_access_direct_and_bounced", "kernel") {
+    config::state conf;
+    ntimer timing(484000000);
+
+    arm::exclusive_monitor_instance monitor = arm::create_exclusive_monitor(arm_emulator_type::dyncom, 1);
+    memory_system mem(monitor.get(), &conf, mem::mem_model_type::multiple, false);
+    arm::core_instance core = arm::create_core(monitor.get(), arm_emulator_type::dyncom);
+
+    kernel_system kern(nullptr, &timing, nullptr, &conf, nullptr, nullptr, core.get(), nullptr);
+    kern.install_memory(&mem);
+
+    kernel::process *pr = kern.create<kernel::process>(&mem, "DesAccessTest", u"", u"");
+    kernel::chunk *first = kern.create<kernel::chunk>(&mem, pr, "DesAccessTestFirst", 0, FIRST_CHUNK_SIZE, FIRST_CHUNK_SIZE,
+        prot_read_write, kernel::chunk_type::normal, kernel::chunk_access::local, kernel::chunk_attrib::none);
+    kernel::chunk *second = kern.create<kernel::chunk>(&mem, pr, "DesAccessTestSecond", 0, 0x1000, 0x10000,
+        prot_read_write, kernel::chunk_type::normal, kernel::chunk_access::local, kernel::chunk_attrib::none);
+
+    REQUIRE(pr);
+    REQUIRE(first);
+    REQUIRE(second);
+
+    const address first_base = first->base(pr).ptr_address();
+    const address second_base = second->base(pr).ptr_address();
+
+    REQUIRE(second_base == first_base + FIRST_CHUNK_SIZE);
+
+    std::uint8_t *first_host = reinterpret_cast<std::uint8_t *>(first->host_base());
+    std::uint8_t *second_host = reinterpret_cast<std::uint8_t *>(second->host_base());
+
+    const std::uint8_t pattern[24] = { 'E', 'K', 'A', '2', 'L', '1', '-', 'D', 'E', 'S', 'C', 'R',
+        'I', 'P', 'T', 'O', 'R', '-', 'T', 'E', 'S', 'T', '!', '!' };
+
+    SECTION("buffer descriptor inside one chunk") {
+        make_guest_buf_descriptor(first_host, 0x100, 0, sizeof(pattern));
+        epoc::des8 *des = ptr<epoc::des8>(first_base + 0x100).get(pr);
+
+        REQUIRE(des);
+        REQUIRE(des->get_contiguous_pointer(pr, first_base + 0x100, sizeof(pattern)) == first_host + 0x108);
+
+        // Writing over the max length or reading over the length is refused
+        REQUIRE(!des->write_data(pr, first_base + 0x100, pattern, sizeof(pattern) + 1));
+        REQUIRE(!des->read_data(pr, first_base + 0x100, nullptr, 1));
+
+        REQUIRE(des->write_data(pr, first_base + 0x100, pattern, sizeof(pattern)));
+        REQUIRE(des->get_length() == sizeof(pattern));
+        REQUIRE(std::memcmp(first_host + 0x108, pattern, sizeof(pattern)) == 0);
+
+        std::uint8_t read_back[sizeof(pattern)] = {};
+        REQUIRE(des->read_data(pr, first_base + 0x100, read_back, sizeof(read_back)));
+        REQUIRE(std::memcmp(read_back, pattern, sizeof(pattern)) == 0);
+    }
+
+    SECTION("pointer descriptor to data across chunks") {
+        const address data_address = second_base - 10;
+
+        make_guest_ptr_descriptor(second_host, 0x100, 0, sizeof(pattern), data_address);
+        epoc::des8 *des = ptr<epoc::des8>(second_base + 0x100).get(pr);
+
+        REQUIRE(des);
+
+        // The start of the data is direct, but not the whole of it
+        REQUIRE(des->get_contiguous_pointer(pr, second_base + 0x100, 10) == first_host + FIRST_CHUNK_SIZE - 10);
+        REQUIRE(!des->get_contiguous_pointer(pr, second_base + 0x100, sizeof(pattern)));
+
+        REQUIRE(des->write_data(pr, second_base + 0x100, pattern, sizeof(pattern)));
+        REQUIRE(des->get_length() == sizeof(pattern));
+        REQUIRE(std::memcmp(first_host + FIRST_CHUNK_SIZE - 10, pattern, 10) == 0);
+        REQUIRE(std::memcmp(second_host, pattern + 10, sizeof(pattern) - 10) == 0);
+
+        std::uint8_t read_back[sizeof(pattern)] = {};
+        REQUIRE(des->read_data(pr, second_base + 0x100, read_back, sizeof(read_back)));
+        REQUIRE(std::memcmp(read_back, pattern, sizeof(pattern)) == 0);
+    }
+
+    SECTION("pointer descriptor to data running into an uncommitted page") {
+        const address data_address = second_base + 0x1000 - 10;
+
+        make_guest_ptr_descriptor(second_host, 0x100, sizeof(pattern), sizeof(pattern), data_address);
+        epoc::des8 *des = ptr<epoc::des8>(second_base + 0x100).get(pr);
+
+        REQUIRE(des);
+        REQUIRE(!des->get_contiguous_pointer(pr, second_base + 0x100, sizeof(pattern)));
+
+        std::uint8_t read_back[sizeof(pattern)] = {};
+        REQUIRE(!des->read_data(pr, second_base + 0x100, read_back, sizeof(read_back)));
+
+        // A failed write leaves the length alone
+        make_guest_ptr_descriptor(second_host, 0x100, 0, sizeof(pattern), data_address);
+        REQUIRE(!des->write_data(pr, second_base + 0x100, pattern, sizeof(pattern)));
+        REQUIRE(des->get_length() == 0);
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <kernel/profiler.h>
+
+#include <memory>
+
+using namespace eka2l1;
+
+TEST_CASE("profiler_ring_drops_when_full", "kernel") {
+    auto ring = std::make_unique<kernel::profiler_sample_ring>();
+    kernel::profiler_sample sample;
+
+    for (std::size_t i = 0; i < kernel::profiler_sample_ring::CAPACITY; i++) {
+        sample.pc_ = static_cast<address>(i);
+        REQUIRE(ring->push(sample));
+    }
+
+    REQUIRE_FALSE(ring->push(sample));
+
+    for (std::size_t i = 0; i < kernel::profiler_sample_ring::CAPACITY; i++) {
+        REQUIRE(ring->pop(sample));
+        REQUIRE(sample.pc_ == static_cast<address>(i));
+    }
+
+    REQUIRE_FALSE(ring->pop(sample));
+    REQUIRE(ring->push(sample));
+}
+
+TEST_CASE("profiler_symbols_resolve_to_nearest_export", "kernel") {
+    kernel::profiler_symbol_map symbols;
+
+    kernel::profiler_module rom_mod;
+    rom_mod.name_ = "euser.dll";
+    rom_mod.begin_ = 0x80001000;
+    rom_mod.end_ = 0x80002000;
+    rom_mod.exports_ = { { 0x80001800, 2 }, { 0x80001100, 1 } };
+
+    kernel::profiler_module app_mod;
+    app_mod.name_ = "game.exe";
+    app_mod.begin_ = 0x00400000;
+    app_mod.end_ = 0x00410000;
+
+    REQUIRE(symbols.add_module(0, rom_mod));
+    REQUIRE(symbols.add_module(5, app_mod));
+    REQUIRE_FALSE(symbols.add_module(5, app_mod));
+
+    REQUIRE(symbols.resolve(5, 0x80001000) == "euser.dll");
+    REQUIRE(symbols.resolve(5, 0x80001104) == "euser.dll!ord1");
+    REQUIRE(symbols.resolve(5, 0x80001FFC) == "euser.dll!ord2");
+    REQUIRE(symbols.resolve(5, 0x80002000) == "[unknown]");
+
+    REQUIRE(symbols.resolve(5, 0x00400020) == "game.exe");
+    REQUIRE(symbols.resolve(6, 0x00400020) == "[unknown]");
+}
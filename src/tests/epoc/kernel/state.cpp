@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/chunkyseri.h>
+#include <config/config.h>
+#include <cpu/arm_factory.h>
+#include <kernel/chunk.h>
+#include <kernel/kernel.h>
+#include <kernel/sema.h>
+#include <kernel/timing.h>
+#include <mem/mem.h>
+
+#include <cstring>
+#include <vector>
+
+namespace eka2l1 {
+    static std::vector<std::uint8_t> save_kernel_state(kernel_system &kern) {
+        common::chunkyseri measurer(nullptr, 0, common::SERI_MODE_MEASURE);
+        REQUIRE(kern.do_state(measurer));
+
+        std::vector<std::uint8_t> state(measurer.size());
+        common::chunkyseri writer(state.data(), state.size(), common::SERI_MODE_WRITE);
+        REQUIRE(kern.do_state(writer));
+
+        return state;
+    }
+
+    static bool load_kernel_state(kernel_system &kern, std::vector<std::uint8_t> &state) {
+        common::chunkyseri reader(state.data(), state.size(), common::SERI_MODE_READ);
+        return kern.do_state(reader);
+    }
+
+    TEST_CASE("kernel_state_round_trip", "kernel") {
+        config::state conf;
+        ntimer timing(484000000);
+
+        arm::exclusive_monitor_instance monitor = arm::create_exclusive_monitor(arm_emulator_type::dyncom, 1);
+        memory_system mem(monitor.get(), &conf, mem::mem_model_type::multiple, false);
+        arm::core_instance core = arm::create_core(monitor.get(), arm_emulator_type::dyncom);
+
+        kernel_system kern(nullptr, &timing, nullptr, &conf, nullptr, nullptr, core.get(), nullptr);
+        kern.install_memory(&mem);
+
+        kernel::chunk *chunk = kern.create<kernel::chunk>(&mem, nullptr, "StateTestChunk", 0, 0x2000, 0x10000, prot_read_write,
+            kernel::chunk_type::normal, kernel::chunk_access::global, kernel::chunk_attrib::none);
+        kernel::semaphore *sema = kern.create<kernel::semaphore>(nullptr, "StateTestSema", 2);
+
+        REQUIRE(chunk);
+        REQUIRE(sema);
+
+        std::uint8_t *data = reinterpret_cast<std::uint8_t *>(chunk->host_base());
+        std::memset(data, 0x5A, 0x1000);
+
+        std::vector<std::uint8_t> state = save_kernel_state(kern);
+
+        // Change memory on both sides of a page boundary, and grow the chunk
+        std::memset(data + 0xFF0, 0xA5, 0x20);
+        REQUIRE(chunk->adjust(0x4000));
+        std::memset(data + 0x3000, 0x11, 0x1000);
+
+        sema->signal(3);
+        REQUIRE(sema->count() == 5);
+
+        REQUIRE(load_kernel_state(kern, state));
+
+        REQUIRE(sema->count() == 2);
+        REQUIRE(chunk->committed() == 0x2000);
+        REQUIRE(data[0xFEF] == 0x5A);
+        REQUIRE(data[0xFF0] == 0x5A);
+        REQUIRE(data[0x100F] == 0x00);
+
+        // Loading the same state again is fine, it does not consume anything
+        REQUIRE(load_kernel_state(kern, state));
+        REQUIRE(sema->count() == 2);
+    }
+
+    TEST_CASE("kernel_state_refuses_changed_objects", "kernel") {
+        config::state conf;
+        ntimer timing(484000000);
+
+        arm::exclusive_monitor_instance monitor = arm::create_exclusive_monitor(arm_emulator_type::dyncom, 1);
+        memory_system mem(monitor.get(), &conf, mem::mem_model_type::multiple, false);
+        arm::core_instance core = arm::create_core(monitor.get(), arm_emulator_type::dyncom);
+
+        kernel_system kern(nullptr, &timing, nullptr, &conf, nullptr, nullptr, core.get(), nullptr);
+        kern.install_memory(&mem);
+
+        kernel::chunk *chunk = kern.create<kernel::chunk>(&mem, nullptr, "StateTestChunk", 0, 0x1000, 0x10000, prot_read_write,
+            kernel::chunk_type::normal, kernel::chunk_access::global, kernel::chunk_attrib::none);
+        kernel::semaphore *sema = kern.create<kernel::semaphore>(nullptr, "StateTestSema", 1);
+
+        std::uint8_t *data = reinterpret_cast<std::uint8_t *>(chunk->host_base());
+        std::memset(data, 0x33, 0x1000);
+
+        std::vector<std::uint8_t> state = save_kernel_state(kern);
+        std::memset(data, 0x77, 0x1000);
+        sema->signal(1);
+
+        SECTION("a new object") {
+            kern.create<kernel::semaphore>(nullptr, "StateTestNewSema", 0);
+            REQUIRE(!load_kernel_state(kern, state));
+        }
+
+        SECTION("a truncated state") {
+            state.resize(state.size() - 1);
+            REQUIRE(!load_kernel_state(kern, state));
+        }
+
+        // Nothing is partially restored
+        REQUIRE(data[0] == 0x77);
+        REQUIRE(data[0xFFF] == 0x77);
+        REQUIRE(sema->count() == 2);
+    }
+}
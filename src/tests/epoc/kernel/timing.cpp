@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <common/chunkyseri.h>
+#include <common/log.h>
+#include <kernel/timing.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace eka2l1 {
+    static event make_test_event(const int type, const std::uint64_t time, const std::uint64_t userdata) {
+        event evt;
+        evt.event_type = type;
+        evt.event_time = time;
+        evt.event_user_data = userdata;
+
+        return evt;
+    }
+
+    TEST_CASE("timer_queue_fifo_on_equal_deadline", "kernel") {
+        timer_queue queue;
+
+        queue.push(make_test_event(0, 100, 3));
+        queue.push(make_test_event(0, 50, 1));
+        queue.push(make_test_event(1, 100, 4));
+        queue.push(make_test_event(0, 50, 2));
+        queue.push(make_test_event(2, 100, 5));
+
+        for (std::uint64_t expected = 1; expected <= 5; expected++) {
+            const std::optional<event> evt = queue.pop();
+
+            REQUIRE(evt.has_value());
+            REQUIRE(evt->event_user_data == expected);
+        }
+
+        REQUIRE(queue.empty());
+        REQUIRE(!queue.pop().has_value());
+    }
+
+    TEST_CASE("timer_queue_cancel", "kernel") {
+        timer_queue queue;
+
+        queue.push(make_test_event(0, 10, 1));
+        queue.push(make_test_event(0, 20, 2));
+        queue.push(make_test_event(1, 30, 1));
+        queue.push(make_test_event(0, 40, 1));
+
+        // The match with the latest deadline goes first
+        REQUIRE(queue.cancel(0, 1));
+        REQUIRE(queue.size() == 3);
+
+        REQUIRE(queue.cancel(0, 1));
+        REQUIRE(!queue.cancel(0, 1));
+        REQUIRE(!queue.cancel(3, 2));
+
+        REQUIRE(queue.top()->event_user_data == 2);
+        REQUIRE(queue.pop()->event_time == 20);
+        REQUIRE(queue.pop()->event_time == 30);
+        REQUIRE(queue.empty());
+
+        // Slots are reused after cancelled entries are dropped
+        queue.push(make_test_event(0, 5, 7));
+        REQUIRE(queue.cancel(0, 7));
+        REQUIRE(queue.top() == nullptr);
+    }
+
+    TEST_CASE("timer_queue_cancel_picks_latest_deadline", "kernel") {
+        timer_queue queue;
+
+        queue.push(make_test_event(0, 40, 1));
+        queue.push(make_test_event(0, 10, 1));
+        queue.push(make_test_event(0, 30, 1));
+
+        // Not the most recently scheduled one
+        REQUIRE(queue.cancel(0, 1));
+        REQUIRE(queue.pop()->event_time == 10);
+        REQUIRE(queue.pop()->event_time == 30);
+        REQUIRE(queue.empty());
+
+        // Of equal deadlines, the one scheduled first goes
+        queue.push(make_test_event(1, 20, 1));
+        queue.push(make_test_event(2, 20, 5));
+        queue.push(make_test_event(1, 20, 1));
+        queue.push(make_test_event(3, 20, 6));
+
+        REQUIRE(queue.cancel(1, 1));
+
+        const std::vector<event> left = queue.pending();
+        REQUIRE(left.size() == 3);
+        REQUIRE(left[0].event_type == 2);
+        REQUIRE(left[1].event_type == 1);
+        REQUIRE(left[2].event_type == 3);
+    }
+
+    TEST_CASE("ntimer_state_round_trip", "kernel") {
+        static constexpr std::int64_t SECOND_US = 1000000;
+
+        ntimer timing(484000000);
+        const int first_type = timing.register_event("first", [](std::uint64_t, int) {});
+        const int second_type = timing.register_event("second", [](std::uint64_t, int) {});
+
+        timing.schedule_event(2 * SECOND_US, second_type, 2);
+        timing.schedule_event(SECOND_US, first_type, 1);
+        timing.schedule_event(3 * SECOND_US, first_type, 3);
+        REQUIRE(timing.unschedule_event(first_type, 3));
+
+        common::chunkyseri measurer(nullptr, 0, common::SERI_MODE_MEASURE);
+        REQUIRE(timing.do_state(measurer));
+
+        std::vector<std::uint8_t> state(measurer.size());
+        common::chunkyseri writer(state.data(), state.size(), common::SERI_MODE_WRITE);
+        REQUIRE(timing.do_state(writer));
+
+        REQUIRE(timing.unschedule_event(first_type, 1));
+        REQUIRE(timing.unschedule_event(second_type, 2));
+        timing.schedule_event(10 * SECOND_US, second_type, 4);
+
+        common::chunkyseri reader(state.data(), state.size(), common::SERI_MODE_READ);
+        REQUIRE(timing.do_state(reader));
+
+        // Only the events pending when saved are back
+        const std::optional<std::uint64_t> next_us = timing.advance();
+        REQUIRE(next_us.has_value());
+        REQUIRE(next_us.value() <= SECOND_US);
+        REQUIRE(timing.unschedule_event(first_type, 1));
+        REQUIRE(timing.unschedule_event(second_type, 2));
+        REQUIRE(!timing.unschedule_event(first_type, 3));
+        REQUIRE(!timing.unschedule_event(second_type, 4));
+
+        // Event types that are not registered the same way can't be restored
+        ntimer other_timing(484000000);
+        other_timing.register_event("second", [](std::uint64_t, int) {});
+
+        common::chunkyseri other_reader(state.data(), state.size(), common::SERI_MODE_READ);
+        REQUIRE(!other_timing.do_state(other_reader));
+    }
+
+    // Schedules, cancels and drains events, checking their order. Returns the microseconds spent.
+    static std::int64_t run_timer_queue_stress(const std::uint64_t event_count) {
+        static constexpr int EVENT_TYPE_COUNT = 8;
+
+        timer_queue queue;
+        std::mt19937_64 rng(0x12345678);
+        std::uniform_int_distribution<std::uint64_t> deadline_dist(0, 100000);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (std::uint64_t i = 0; i < event_count; i++) {
+            queue.push(make_test_event(static_cast<int>(i % EVENT_TYPE_COUNT), deadline_dist(rng), i));
+        }
+
+        REQUIRE(queue.size() == event_count);
+
+        // Cancel a third of them, as timers that got reset or completed early would
+        std::uint64_t cancelled = 0;
+
+        for (std::uint64_t i = 0; i < event_count; i += 3) {
+            REQUIRE(queue.cancel(static_cast<int>(i % EVENT_TYPE_COUNT), i));
+            cancelled++;
+        }
+
+        // Reschedule while draining, as periodic timers do on expiry
+        std::uint64_t last_time = 0;
+        std::uint64_t fired = 0;
+        std::uint64_t rescheduled = 0;
+
+        while (std::optional<event> evt = queue.pop()) {
+            REQUIRE(evt->event_time >= last_time);
+            REQUIRE((evt->event_user_data % 3) != 0);
+
+            last_time = evt->event_time;
+            fired++;
+
+            if ((rescheduled < event_count / 4) && (evt->event_user_data % 5 == 1)) {
+                queue.push(make_test_event(evt->event_type, evt->event_time + deadline_dist(rng) / 8,
+                    evt->event_user_data + event_count * 3));
+
+                rescheduled++;
+            }
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+
+        REQUIRE(fired == event_count - cancelled + rescheduled);
+        return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    }
+
+    TEST_CASE("timer_queue_keeps_order_through_cancels", "kernel") {
+        run_timer_queue_stress(2000);
+    }
+
+    // Hidden, run it explicitly with: ekatests "[timer_queue_bench]"
+    TEST_CASE("timer_queue_stress_bench", "[.][timer_queue_bench]") {
+        static constexpr std::uint64_t EVENT_COUNT = 20000;
+        const std::int64_t elapsed_us = run_timer_queue_stress(EVENT_COUNT);
+
+        LOG_INFO(KERNEL, "Timer queue: {} events scheduled, cancelled and drained in {}us", EVENT_COUNT, elapsed_us);
+    }
+}
@@ -18,7 +18,128 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <catch2/catch.hpp>
+
 #include <kernel/libmanager.h>
 #include <loader/e32img.h>
+#include <loader/e32img_cache.h>
+
+#include <common/algorithm.h>
+#include <common/buffer.h>
+#include <common/crypt.h>
+#include <common/fileutils.h>
 
 #include <vfs/vfs.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace eka2l1;
+
+// Build an uncompressed EKA2 image with an export, an import and a relocation block
+static std::vector<std::uint8_t> make_sample_e32img() {
+    static constexpr std::uint32_t CODE_SIZE = 32;
+    static constexpr std::uint32_t TEXT_SIZE = 24;
+    static constexpr std::uint32_t DATA_SIZE = 16;
+
+    loader::e32img_header header;
+    std::memset(&header, 0, sizeof(loader::e32img_header));
+
+    header.uid1 = loader::e32_img_type::dll;
+    header.uid2 = 0x1000008D;
+    header.uid3 = 0xE0000001;
+
+    const std::uint32_t uids[3] = { static_cast<std::uint32_t>(header.uid1), header.uid2, header.uid3 };
+    header.check = crypt::calculate_checked_uid_checksum(uids);
+    header.sig = 0x434F5045;
+    header.cpu = loader::e32_cpu::armv5;
+
+    header.code_offset = common::align(sizeof(loader::e32img_header), 4);
+    header.code_size = CODE_SIZE;
+    header.text_size = TEXT_SIZE;
+    header.export_dir_offset = header.code_offset + 4;
+    header.export_dir_count = 2;
+    header.data_offset = header.code_offset + CODE_SIZE;
+    header.data_size = DATA_SIZE;
+    header.import_offset = header.data_offset + DATA_SIZE;
+    header.dll_ref_table_count = 1;
+
+    std::vector<std::uint8_t> image(header.import_offset);
+
+    const auto write_word = [&](const std::uint32_t offset, const std::uint32_t value) {
+        std::memcpy(image.data() + offset, &value, 4);
+    };
+
+    // Exports and the import address table
+    write_word(header.export_dir_offset, 0x10);
+    write_word(header.export_dir_offset + 4, 0x14);
+    write_word(header.code_offset + TEXT_SIZE, 0x2001);
+
+    const auto append_words = [&](std::initializer_list<std::uint32_t> words) {
+        for (const std::uint32_t word : words) {
+            const std::size_t offset = image.size();
+
+            image.resize(offset + 4);
+            write_word(static_cast<std::uint32_t>(offset), word);
+        }
+    };
+
+    // Import section: size, one block with two ordinals, then the DLL name
+    append_words({ 28, 20, 2, 5, 9 });
+    const char dll_name[] = "euser.dll";
+    image.insert(image.end(), dll_name, dll_name + sizeof(dll_name));
+    image.resize(common::align(image.size(), 4), 0);
+
+    // One relocation block of two text relocations
+    header.code_reloc_offset = static_cast<std::uint32_t>(image.size());
+    append_words({ 20, 2, 0x1000, 12, 0x30083004 });
+
+    std::memcpy(image.data(), &header, sizeof(loader::e32img_header));
+    return image;
+}
+
+TEST_CASE("e32img_cache_hit_skips_parse", "e32img") {
+    const std::string cache_folder = "e32imgcachetest/";
+    common::delete_folder(cache_folder);
+
+    std::vector<std::uint8_t> image = make_sample_e32img();
+    common::ro_buf_stream image_stream(image.data(), image.size());
+
+    auto parsed = loader::parse_e32img(reinterpret_cast<common::ro_stream *>(&image_stream));
+    REQUIRE(parsed);
+    REQUIRE(parsed->relocation_list.size() == 2);
+    REQUIRE(parsed->import_section.imports[0].dll_name == "euser.dll");
+
+    loader::e32img_cache cache(cache_folder);
+
+    auto missed = cache.load(reinterpret_cast<common::ro_stream *>(&image_stream));
+    REQUIRE(missed);
+    REQUIRE(cache.miss_count() == 1);
+
+    auto cached = cache.load(reinterpret_cast<common::ro_stream *>(&image_stream));
+    REQUIRE(cached);
+    REQUIRE(cache.hit_count() == 1);
+
+    REQUIRE(std::memcmp(&cached->header, &parsed->header, sizeof(loader::e32img_header)) == 0);
+    REQUIRE(cached->epoc_ver == parsed->epoc_ver);
+    REQUIRE(cached->data == parsed->data);
+    REQUIRE(cached->ed.syms == parsed->ed.syms);
+    REQUIRE(cached->iat.its == parsed->iat.its);
+    REQUIRE(cached->relocation_list == parsed->relocation_list);
+    REQUIRE(cached->dll_names == parsed->dll_names);
+    REQUIRE(cached->import_section.size == parsed->import_section.size);
+    REQUIRE(cached->import_section.imports.size() == 1);
+    REQUIRE(cached->import_section.imports[0].dll_name == "euser.dll");
+    REQUIRE(cached->import_section.imports[0].ordinals == parsed->import_section.imports[0].ordinals);
+
+    // A different image must not hit the same entry
+    image[parsed->header.data_offset] ^= 0xFF;
+    common::ro_buf_stream changed_stream(image.data(), image.size());
+
+    auto changed = cache.load(reinterpret_cast<common::ro_stream *>(&changed_stream));
+    REQUIRE(changed);
+    REQUIRE(cache.miss_count() == 2);
+    REQUIRE(changed->data != cached->data);
+
+    common::delete_folder(cache_folder);
+}
@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <config/config.h>
+#include <cpu/arm_factory.h>
+#include <mem/chunk.h>
+#include <mem/mem.h>
+#include <mem/process.h>
+#include <mem/watch.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace eka2l1::mem {
+    TEST_CASE("write_watcher_shared_page_stamps", "mem") {
+        alignas(write_watcher::PAGE_SIZE) static std::uint8_t memory[write_watcher::PAGE_SIZE * 4];
+
+        write_watcher watcher(true);
+        std::vector<std::uint8_t> dirty;
+
+        // Two ranges sharing the second page
+        std::uint8_t *first_range = memory;
+        std::uint8_t *second_range = memory + write_watcher::PAGE_SIZE + 16;
+
+        REQUIRE(watcher.watch(first_range, write_watcher::PAGE_SIZE + 32));
+        REQUIRE(watcher.watch(second_range, write_watcher::PAGE_SIZE * 2 - 32));
+
+        std::uint64_t first_stamp = 0;
+        std::uint64_t second_stamp = 0;
+
+        watcher.collect_dirty(first_range, write_watcher::PAGE_SIZE + 32, first_stamp, dirty);
+        watcher.collect_dirty(second_range, write_watcher::PAGE_SIZE * 2 - 32, second_stamp, dirty);
+
+        REQUIRE(!watcher.collect_dirty(first_range, write_watcher::PAGE_SIZE + 32, first_stamp, dirty));
+        REQUIRE(dirty.size() == 2);
+
+        // Armed pages can be read, but not written through the CPU mapping
+        REQUIRE(watcher.access(nullptr, memory + write_watcher::PAGE_SIZE, 0x1000, false) == write_watch_access_armed);
+        REQUIRE(watcher.access(nullptr, memory + write_watcher::PAGE_SIZE * 3, 0x3000, false) == write_watch_access_unwatched);
+
+        watcher.note_write(second_range + 4);
+
+        // Both watchers see the write to the shared page, no matter who collects first
+        REQUIRE(watcher.collect_dirty(first_range, write_watcher::PAGE_SIZE + 32, first_stamp, dirty));
+        REQUIRE(dirty == std::vector<std::uint8_t>{ 0, 1 });
+
+        REQUIRE(watcher.collect_dirty(second_range, write_watcher::PAGE_SIZE * 2 - 32, second_stamp, dirty));
+        REQUIRE(dirty == std::vector<std::uint8_t>{ 1, 0 });
+
+        REQUIRE(!watcher.collect_dirty(first_range, write_watcher::PAGE_SIZE + 32, first_stamp, dirty));
+        REQUIRE(!watcher.collect_dirty(second_range, write_watcher::PAGE_SIZE * 2 - 32, second_stamp, dirty));
+
+        // Once unwatched, nothing can be told about the page
+        watcher.unwatch(first_range, write_watcher::PAGE_SIZE + 32);
+        REQUIRE(watcher.collect_dirty(first_range, write_watcher::PAGE_SIZE + 32, first_stamp, dirty));
+        REQUIRE(dirty == std::vector<std::uint8_t>{ 1, 0 });
+
+        watcher.unwatch(second_range, write_watcher::PAGE_SIZE * 2 - 32);
+        REQUIRE(watcher.empty());
+
+        write_watcher unsupported_watcher(false);
+        REQUIRE(!unsupported_watcher.watch(first_range, 16));
+    }
+
+    // Reads the word at R0 forever
+    static const std::uint32_t READ_LOOP_CODE[] = {
+        0xe5901000, // ldr r1, [r0]
+        0xeafffffd // b #-4
+    };
+
+    TEST_CASE("decommit_shoots_down_every_core", "mem") {
+        config::state conf;
+
+        arm::exclusive_monitor_instance monitor = arm::create_exclusive_monitor(arm_emulator_type::dyncom, 2);
+        memory_system mem(monitor.get(), &conf, mem_model_type::multiple, false);
+
+        arm::core_instance cores[2] = { arm::create_core(monitor.get(), arm_emulator_type::dyncom),
+            arm::create_core(monitor.get(), arm_emulator_type::dyncom) };
+
+        mem_model_process_impl process = make_new_mem_model_process(mem.get_control(), mem_model_type::multiple);
+
+        mem_model_chunk *chunk = nullptr;
+        mem_model_chunk_creation_info create_info{};
+        create_info.size = 0x10000;
+        create_info.flags = MEM_MODEL_CHUNK_REGION_USER_LOCAL | MEM_MODEL_CHUNK_TYPE_NORMAL;
+        create_info.perm = prot_read_write_exec;
+
+        REQUIRE(process->create_chunk(chunk, create_info) == MEM_MODEL_CHUNK_ERR_OK);
+        REQUIRE(chunk->commit(0, 0x2000) == 0x2000);
+
+        const vm_address code_addr = chunk->base(process.get());
+        const vm_address data_addr = code_addr + 0x1000;
+
+        std::memcpy(chunk->host_base(), READ_LOOP_CODE, sizeof(READ_LOOP_CODE));
+
+        std::atomic<bool> faulted = false;
+
+        for (arm::core_instance &cc : cores) {
+            REQUIRE(mem.get_mmu(cc.get())->set_current_addr_space(process->address_space_id()));
+
+            cc->set_reg(0, data_addr);
+            cc->set_cpsr(0x10);
+            cc->set_pc(code_addr);
+        }
+
+        cores[1]->exception_handler = [&](arm::exception_type type, const std::uint32_t data) {
+            faulted = true;
+            cores[1]->stop();
+
+            return false;
+        };
+
+        // Core 0 reads the page once, then stays out of guest code
+        cores[0]->run(2);
+        REQUIRE(cores[0]->get_page_table()->pointers[data_addr >> arm::page_table::PAGE_BITS]);
+
+        std::thread core_thread([&]() {
+            while (!faulted) {
+                cores[1]->enter_guest();
+                cores[1]->run(1000);
+                cores[1]->leave_guest();
+            }
+        });
+
+        // Wait for core 1 to cache the page too
+        while (!cores[1]->get_page_table()->pointers[data_addr >> arm::page_table::PAGE_BITS]) {
+            std::this_thread::yield();
+        }
+
+        // Core 1 is stopped while its mappings are dropped, and faults on its next read
+        chunk->decommit(0x1000, 0x1000);
+
+        REQUIRE(!cores[0]->get_page_table()->pointers[data_addr >> arm::page_table::PAGE_BITS]);
+
+        core_thread.join();
+
+        REQUIRE(faulted);
+        REQUIRE(!cores[1]->get_page_table()->pointers[data_addr >> arm::page_table::PAGE_BITS]);
+
+        process->delete_chunk(chunk);
+    }
+
+    TEST_CASE("read_only_page_stays_off_the_page_table", "mem") {
+        config::state conf;
+
+        arm::exclusive_monitor_instance monitor = arm::create_exclusive_monitor(arm_emulator_type::dyncom, 1);
+        memory_system mem(monitor.get(), &conf, mem_model_type::multiple, false);
+        arm::core_instance core = arm::create_core(monitor.get(), arm_emulator_type::dyncom);
+
+        mem_model_process_impl process = make_new_mem_model_process(mem.get_control(), mem_model_type::multiple);
+
+        mem_model_chunk *code_chunk = nullptr;
+        mem_model_chunk *data_chunk = nullptr;
+
+        mem_model_chunk_creation_info create_info{};
+        create_info.size = 0x10000;
+        create_info.flags = MEM_MODEL_CHUNK_REGION_USER_LOCAL | MEM_MODEL_CHUNK_TYPE_NORMAL;
+        create_info.perm = prot_read_write_exec;
+
+        REQUIRE(process->create_chunk(code_chunk, create_info) == MEM_MODEL_CHUNK_ERR_OK);
+        REQUIRE(code_chunk->commit(0, 0x2000) == 0x2000);
+
+        create_info.perm = prot_read;
+
+        REQUIRE(process->create_chunk(data_chunk, create_info) == MEM_MODEL_CHUNK_ERR_OK);
+        REQUIRE(data_chunk->commit(0, 0x1000) == 0x1000);
+
+        const vm_address code_addr = code_chunk->base(process.get());
+        const vm_address writable_addr = code_addr + 0x1000;
+        const vm_address read_only_addr = data_chunk->base(process.get());
+
+        std::memcpy(code_chunk->host_base(), READ_LOOP_CODE, sizeof(READ_LOOP_CODE));
+
+        REQUIRE(mem.get_mmu(core.get())->set_current_addr_space(process->address_space_id()));
+
+        core->set_cpsr(0x10);
+
+        // Writes through the table can't be refused, so only writable pages go there
+        core->set_reg(0, writable_addr);
+        core->set_pc(code_addr);
+        core->run(2);
+
+        REQUIRE(core->get_page_table()->pointers[writable_addr >> arm::page_table::PAGE_BITS]);
+
+        core->set_reg(0, read_only_addr);
+        core->set_pc(code_addr);
+        core->run(2);
+
+        REQUIRE(!core->get_page_table()->pointers[read_only_addr >> arm::page_table::PAGE_BITS]);
+
+        // Unmapping drops what was published
+        code_chunk->decommit(0x1000, 0x1000);
+        REQUIRE(!core->get_page_table()->pointers[writable_addr >> arm::page_table::PAGE_BITS]);
+
+        process->delete_chunk(data_chunk);
+        process->delete_chunk(code_chunk);
+    }
+
+    // Reads the word at R0, then writes R2 to it
+    static const std::uint32_t READ_THEN_WRITE_CODE[] = {
+        0xe5901000, // ldr r1, [r0]
+        0xe5802000, // str r2, [r0]
+        0xeafffffe // b #0
+    };
+
+    TEST_CASE("write_to_armed_page_through_dyncom_marks_it_dirty", "mem") {
+        config::state conf;
+
+        arm::exclusive_monitor_instance monitor = arm::create_exclusive_monitor(arm_emulator_type::dyncom, 1);
+        memory_system mem(monitor.get(), &conf, mem_model_type::multiple, false);
+        arm::core_instance core = arm::create_core(monitor.get(), arm_emulator_type::dyncom);
+
+        mem_model_process_impl process = make_new_mem_model_process(mem.get_control(), mem_model_type::multiple);
+
+        mem_model_chunk *chunk = nullptr;
+        mem_model_chunk_creation_info create_info{};
+        create_info.size = 0x10000;
+        create_info.flags = MEM_MODEL_CHUNK_REGION_USER_LOCAL | MEM_MODEL_CHUNK_TYPE_NORMAL;
+        create_info.perm = prot_read_write_exec;
+
+        REQUIRE(process->create_chunk(chunk, create_info) == MEM_MODEL_CHUNK_ERR_OK);
+        REQUIRE(chunk->commit(0, 0x2000) == 0x2000);
+
+        const vm_address code_addr = chunk->base(process.get());
+        std::uint8_t *data = reinterpret_cast<std::uint8_t *>(chunk->host_base()) + 0x1000;
+
+        std::memcpy(chunk->host_base(), READ_THEN_WRITE_CODE, sizeof(READ_THEN_WRITE_CODE));
+
+        write_watcher &watcher = mem.get_control()->get_write_watcher();
+        std::uint64_t stamp = 0;
+        std::vector<std::uint8_t> dirty;
+
+        REQUIRE(watcher.watch(data, 4));
+        watcher.collect_dirty(data, 4, stamp, dirty);
+        REQUIRE(!watcher.collect_dirty(data, 4, stamp, dirty));
+
+        REQUIRE(mem.get_mmu(core.get())->set_current_addr_space(process->address_space_id()));
+
+        core->set_reg(0, code_addr + 0x1000);
+        core->set_reg(2, 0xCAFEBABE);
+        core->set_cpsr(0x10);
+        core->set_pc(code_addr);
+
+        // The read caches the armed page read-only, the write must not go through that entry
+        core->run(3);
+
+        std::uint32_t value = 0;
+        std::memcpy(&value, data, sizeof(value));
+
+        REQUIRE(value == 0xCAFEBABE);
+        REQUIRE(watcher.collect_dirty(data, 4, stamp, dirty));
+
+        watcher.unwatch(data, 4);
+        process->delete_chunk(chunk);
+    }
+
+    // Writes R2 to the word at R0 forever
+    static const std::uint32_t WRITE_LOOP_CODE[] = {
+        0xe5802000, // str r2, [r0]
+        0xeafffffd // b #-4
+    };
+
+    TEST_CASE("collect_dirty_rearms_page_on_running_core", "mem") {
+        config::state conf;
+
+        arm::exclusive_monitor_instance monitor = arm::create_exclusive_monitor(arm_emulator_type::dyncom, 1);
+        memory_system mem(monitor.get(), &conf, mem_model_type::multiple, false);
+        arm::core_instance core = arm::create_core(monitor.get(), arm_emulator_type::dyncom);
+
+        mem_model_process_impl process = make_new_mem_model_process(mem.get_control(), mem_model_type::multiple);
+
+        mem_model_chunk *chunk = nullptr;
+        mem_model_chunk_creation_info create_info{};
+        create_info.size = 0x10000;
+        create_info.flags = MEM_MODEL_CHUNK_REGION_USER_LOCAL | MEM_MODEL_CHUNK_TYPE_NORMAL;
+        create_info.perm = prot_read_write_exec;
+
+        REQUIRE(process->create_chunk(chunk, create_info) == MEM_MODEL_CHUNK_ERR_OK);
+        REQUIRE(chunk->commit(0, 0x2000) == 0x2000);
+
+        const vm_address code_addr = chunk->base(process.get());
+        std::uint8_t *data = reinterpret_cast<std::uint8_t *>(chunk->host_base()) + 0x1000;
+
+        std::memcpy(chunk->host_base(), WRITE_LOOP_CODE, sizeof(WRITE_LOOP_CODE));
+
+        write_watcher &watcher = mem.get_control()->get_write_watcher();
+        std::uint64_t stamp = 0;
+        std::vector<std::uint8_t> dirty;
+
+        REQUIRE(watcher.watch(data, 4));
+        watcher.collect_dirty(data, 4, stamp, dirty);
+
+        REQUIRE(mem.get_mmu(core.get())->set_current_addr_space(process->address_space_id()));
+
+        core->set_reg(0, code_addr + 0x1000);
+        core->set_cpsr(0x10);
+        core->set_pc(code_addr);
+
+        std::atomic<bool> should_stop = false;
+        std::atomic<std::uint32_t> value = 0;
+
+        std::thread core_thread([&]() {
+            while (!should_stop) {
+                core->enter_guest();
+                core->set_reg(2, ++value);
+                core->run(1000);
+                core->leave_guest();
+            }
+        });
+
+        // Each collection arms the page again while the core runs. A writable mapping left in its TLB
+        // would hide every later write, so the page must keep getting dirty.
+        for (int round = 0; round < 8; round++) {
+            bool written = false;
+
+            for (int tries = 0; (tries < 100000) && !written; tries++) {
+                written = watcher.collect_dirty(data, 4, stamp, dirty);
+
+                if (!written) {
+                    std::this_thread::yield();
+                }
+            }
+
+            REQUIRE(written);
+        }
+
+        should_stop = true;
+        core_thread.join();
+
+        watcher.unwatch(data, 4);
+        process->delete_chunk(chunk);
+    }
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/centralrepo/cache.h>
+#include <services/centralrepo/centralrepo.h>
+
+#include <common/fileutils.h>
+
+using namespace eka2l1;
+
+TEST_CASE("repo_entries_sorted_and_masked_range", "centralrepo") {
+    central_repo repo;
+    central_repo_entry_variant var;
+    var.etype = central_repo_entry_type::integer;
+
+    const std::uint32_t keys[] = { 0x0300, 0x0101, 0x0102, 0x0201, 0x0100, 0x1101 };
+
+    for (const std::uint32_t key : keys) {
+        var.intd = key;
+        REQUIRE(repo.add_new_entry(key, var));
+    }
+
+    REQUIRE_FALSE(repo.add_new_entry(0x0102, var));
+    REQUIRE(repo.entries.size() == 6);
+
+    for (std::size_t i = 1; i < repo.entries.size(); i++) {
+        REQUIRE(repo.entries[i - 1].key < repo.entries[i].key);
+    }
+
+    REQUIRE(repo.find_entry(0x0201)->data.intd == 0x0201);
+    REQUIRE(repo.find_entry(0x0202) == nullptr);
+
+    // Keys with 0x01 as the second byte
+    auto [begin, end] = repo.get_masked_range(0x0100, 0xFFFFFF00);
+    REQUIRE(end - begin == 3);
+    REQUIRE(begin->key == 0x0100);
+
+    // The leading bit of the mask is not set, so the whole list is the range
+    std::vector<std::uint32_t> matched;
+    auto [all_begin, all_end] = repo.get_masked_range(0x0001, 0x000000FF);
+
+    for (auto ite = all_begin; ite != all_end; ite++) {
+        if ((ite->key & 0xFF) == 0x01) {
+            matched.push_back(ite->key);
+        }
+    }
+
+    REQUIRE(matched == std::vector<std::uint32_t>{ 0x0101, 0x0201, 0x1101 });
+}
+
+TEST_CASE("repo_cacher_evicts_least_recently_used", "centralrepo") {
+    central_repos_cacher cacher(2);
+
+    central_repo repo1;
+    central_repo repo2;
+    central_repo repo3;
+
+    repo1.uid = 1;
+    repo2.uid = 2;
+    repo3.uid = 3;
+
+    REQUIRE(cacher.add_repo(1, repo1));
+    REQUIRE(cacher.add_repo(2, repo2));
+
+    // Touch the first one, so the second one is the oldest
+    REQUIRE(cacher.get_cached_repo(1)->uid == 1);
+    REQUIRE(cacher.add_repo(3, repo3));
+
+    REQUIRE(cacher.get_cached_repo(2) == nullptr);
+    REQUIRE(cacher.get_cached_repo(1)->uid == 1);
+    REQUIRE(cacher.get_cached_repo(3)->uid == 3);
+}
+
+TEST_CASE("repo_cache_compiles_ini", "centralrepo") {
+    const std::string cache_folder = "centralrepocachetest/";
+
+    central_repo_cache cache(cache_folder);
+
+    central_repo repo;
+    repo.uid = 0xEFFF0001;
+
+    REQUIRE(cache.load_ini("centralrepoassets/EFFF0001.ini", repo));
+    REQUIRE(cache.miss_count() == 1);
+
+    central_repo cached_repo;
+    cached_repo.uid = 0xEFFF0001;
+
+    REQUIRE(cache.load_ini("centralrepoassets/EFFF0001.ini", cached_repo));
+    REQUIRE(cache.hit_count() == 1);
+
+    REQUIRE(cached_repo.owner_uid == 0x3FFFFFFF);
+    REQUIRE(cached_repo.entries.size() == 2);
+    REQUIRE(cached_repo.find_entry(5)->data.intd == 16);
+    REQUIRE(cached_repo.find_entry(5)->metadata_val == 10);
+    REQUIRE(cached_repo.find_entry(0x42)->metadata_val == 12);
+    REQUIRE(cached_repo.find_entry(0x42)->data.strd == repo.find_entry(0x42)->data.strd);
+    REQUIRE(cached_repo.meta_range.size() == 1);
+
+    common::delete_folder(cache_folder);
+}
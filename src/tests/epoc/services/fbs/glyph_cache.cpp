@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/graphics/backend/software/graphics_software.h>
+#include <drivers/itc.h>
+#include <services/fbs/font_atlas.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+/**
+ * \brief Adapter whose glyphs are solid squares of the font size, packed left to right.
+ */
+class square_font_adapter : public epoc::adapter::font_file_adapter_base {
+    struct pack_context {
+        std::uint8_t *dest_;
+        eka2l1::vec2 size_;
+        int x_;
+    } context_;
+
+protected:
+    std::uint32_t get_glyph_advance(const std::size_t face_index, const std::uint32_t codepoint, const std::uint16_t font_size, const bool vertical) override {
+        return font_size;
+    }
+
+public:
+    int rasterized_count_ = 0;
+
+    bool is_valid() override {
+        return true;
+    }
+
+    bool vectorizable() const override {
+        return true;
+    }
+
+    bool get_face_attrib(const std::size_t idx, epoc::open_font_face_attrib &face_attrib) override {
+        return false;
+    }
+
+    bool get_metrics(const std::size_t idx, epoc::open_font_metrics &metrics) override {
+        return false;
+    }
+
+    bool get_glyph_metric(const std::size_t idx, std::uint32_t code, epoc::open_font_character_metric &metric,
+        const std::int32_t baseline_horz_off, const std::uint16_t font_size) override {
+        return false;
+    }
+
+    std::uint8_t *get_glyph_bitmap(const std::size_t idx, std::uint32_t code, const std::uint16_t font_size,
+        int *rasterized_width, int *rasterized_height, std::uint32_t &total_size, epoc::glyph_bitmap_type *bmp_type) override {
+        return nullptr;
+    }
+
+    void free_glyph_bitmap(std::uint8_t *data) override {
+    }
+
+    epoc::glyph_bitmap_type get_output_bitmap_type() const override {
+        return epoc::glyph_bitmap_type::antialised_glyph_bitmap;
+    }
+
+    bool does_glyph_exist(std::size_t idx, std::uint32_t code) override {
+        return true;
+    }
+
+    std::int32_t begin_get_atlas(std::uint8_t *atlas_ptr, const eka2l1::vec2 atlas_size) override {
+        context_ = { atlas_ptr, atlas_size, 0 };
+        return 1;
+    }
+
+    bool get_glyph_atlas(const std::int32_t handle, const std::size_t idx, const char16_t start_code, int *unicode_point,
+        const char16_t num_code, const int font_size, epoc::adapter::character_info *info) override {
+        if ((context_.x_ + num_code * font_size > context_.size_.x) || (font_size > context_.size_.y)) {
+            return false;
+        }
+
+        for (char16_t i = 0; i < num_code; i++) {
+            // A space has no bitmap
+            const bool empty = (unicode_point[i] == ' ');
+            const int width = empty ? 0 : font_size;
+
+            for (int y = 0; y < font_size; y++) {
+                std::memset(context_.dest_ + y * context_.size_.x + context_.x_, 0xFF, width);
+            }
+
+            info[i].x0 = static_cast<std::uint16_t>(context_.x_);
+            info[i].y0 = 0;
+            info[i].x1 = static_cast<std::uint16_t>(context_.x_ + width);
+            info[i].y1 = static_cast<std::uint16_t>(empty ? 0 : font_size);
+            info[i].xoff = 0.0f;
+            info[i].yoff = static_cast<float>(-font_size);
+            info[i].xoff2 = static_cast<float>(width);
+            info[i].yoff2 = 0.0f;
+            info[i].xadv = static_cast<float>(font_size);
+
+            context_.x_ += width;
+            rasterized_count_++;
+        }
+
+        return true;
+    }
+
+    void end_get_atlas(const std::int32_t handle) override {
+    }
+
+    std::size_t count() override {
+        return 1;
+    }
+
+    std::uint32_t unique_id(const std::size_t face_index) override {
+        return 1;
+    }
+
+    bool has_character(const std::size_t face_index, const std::int32_t codepoint) override {
+        return true;
+    }
+};
+
+static std::uint32_t read_pixel(const std::vector<std::uint8_t> &data, const int width, const int x, const int y) {
+    std::uint32_t pixel = 0;
+    std::memcpy(&pixel, data.data() + (y * width + x) * 4, 4);
+
+    return pixel;
+}
+
+static std::size_t count_quad_lists(const drivers::command_list &list) {
+    drivers::command_reader reader(list);
+    drivers::command cmd;
+
+    std::size_t count = 0;
+
+    while (reader.next(cmd)) {
+        if (cmd.opcode_ == drivers::graphics_driver_draw_bitmap_quads) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+TEST_CASE("glyph_cache_shares_pages_and_batches_text", "fbs") {
+    drivers::software_graphics_driver driver(2);
+    std::thread driver_thread([&]() { driver.run(); });
+
+    square_font_adapter adapter;
+    epoc::glyph_cache cache;
+
+    epoc::font_atlas small_font;
+    epoc::font_atlas large_font;
+
+    small_font.init(&cache, &adapter, 0, 4);
+    large_font.init(&cache, &adapter, 0, 6);
+
+    const drivers::handle target = drivers::create_bitmap(&driver, eka2l1::vec2(32, 16), 32);
+
+    drivers::graphics_command_builder builder;
+    builder.bind_bitmap(target);
+    builder.clear({ 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f }, drivers::draw_buffer_bit_color_buffer);
+
+    epoc::glyph_run_batch batch;
+    batch.set_color(builder, { 255, 0, 0, 255 });
+
+    REQUIRE(small_font.draw_text(u"AB A", eka2l1::rect({ 0, 8 }, { 32, 8 }), epoc::text_alignment::left, &driver, builder, batch, { 1.0f, 1.0f }));
+    REQUIRE(large_font.draw_text(u"A", eka2l1::rect({ 20, 14 }, { 12, 8 }), epoc::text_alignment::left, &driver, builder, batch, { 1.0f, 1.0f }));
+
+    batch.flush(builder);
+
+    // Both fonts are on the same page, so all text is a single quad list
+    REQUIRE(cache.page_count() == 1);
+    REQUIRE(cache.glyph_count() == 4);
+    REQUIRE(adapter.rasterized_count_ == 4);
+
+    drivers::command_list list = builder.retrieve_command_list();
+    REQUIRE(count_quad_lists(list) == 1);
+    driver.submit_command_list(list);
+
+    std::vector<std::uint8_t> pixels(32 * 16 * 4);
+    REQUIRE(drivers::read_bitmap(&driver, target, { 0, 0 }, { 32, 16 }, 32, pixels.data()));
+
+    // A and B, then the space, then A again
+    REQUIRE(read_pixel(pixels, 32, 0, 4) == 0xFF0000FF);
+    REQUIRE(read_pixel(pixels, 32, 7, 7) == 0xFF0000FF);
+    REQUIRE(read_pixel(pixels, 32, 8, 4) == 0xFF000000);
+    REQUIRE(read_pixel(pixels, 32, 12, 4) == 0xFF0000FF);
+    REQUIRE(read_pixel(pixels, 32, 0, 3) == 0xFF000000);
+    REQUIRE(read_pixel(pixels, 32, 20, 8) == 0xFF0000FF);
+    REQUIRE(read_pixel(pixels, 32, 25, 13) == 0xFF0000FF);
+    REQUIRE(read_pixel(pixels, 32, 26, 13) == 0xFF000000);
+
+    // Cached glyphs are not rasterized again
+    REQUIRE(small_font.draw_text(u"BA", eka2l1::rect({ 0, 8 }, { 32, 8 }), epoc::text_alignment::left, &driver, builder));
+    REQUIRE(adapter.rasterized_count_ == 4);
+
+    builder.reset_list();
+    cache.destroy(&driver);
+
+    // Wait for the pages to be destroyed before stopping the driver
+    REQUIRE(drivers::read_bitmap(&driver, target, { 0, 0 }, { 32, 16 }, 32, pixels.data()));
+
+    driver.abort();
+    driver_thread.join();
+}
+
+TEST_CASE("glyph_cache_evicts_least_recently_used_page", "fbs") {
+    drivers::software_graphics_driver driver(1);
+    std::thread driver_thread([&]() { driver.run(); });
+
+    square_font_adapter adapter;
+    epoc::glyph_cache cache;
+    epoc::font_atlas font;
+
+    const drivers::handle target = drivers::create_bitmap(&driver, eka2l1::vec2(1, 1), 32);
+    std::uint32_t pixel = 0;
+
+    // Four glyphs fit in a page
+    font.init(&cache, &adapter, 0, 500);
+
+    drivers::graphics_command_builder builder;
+    builder.bind_bitmap(target);
+
+    std::u16string text(1, u'A');
+
+    for (int i = 0; i < GLYPH_CACHE_MAX_PAGES * 4; i++) {
+        text[0] = static_cast<char16_t>(u'A' + i);
+        REQUIRE(font.draw_text(text, eka2l1::rect({ 0, 0 }, { 0, 0 }), epoc::text_alignment::left, &driver, builder));
+    }
+
+    REQUIRE(cache.page_count() == GLYPH_CACHE_MAX_PAGES);
+    REQUIRE(cache.glyph_count() == GLYPH_CACHE_MAX_PAGES * 4);
+
+    // Use the first page again, so the second one is the oldest
+    REQUIRE(font.draw_text(u"A", eka2l1::rect({ 0, 0 }, { 0, 0 }), epoc::text_alignment::left, &driver, builder));
+    REQUIRE(font.draw_text(u"Z", eka2l1::rect({ 0, 0 }, { 0, 0 }), epoc::text_alignment::left, &driver, builder));
+
+    REQUIRE(cache.page_count() == GLYPH_CACHE_MAX_PAGES);
+    REQUIRE(cache.glyph_count() == GLYPH_CACHE_MAX_PAGES * 4 - 3);
+
+    REQUIRE(cache.find(font.font_id_, u'A'));
+    REQUIRE(cache.find(font.font_id_, u'Z'));
+    REQUIRE_FALSE(cache.find(font.font_id_, u'E'));
+    REQUIRE_FALSE(cache.find(font.font_id_, u'H'));
+    REQUIRE(cache.find(font.font_id_, u'I'));
+
+    // Evicted pages are destroyed by the list
+    drivers::command_list list = builder.retrieve_command_list();
+    driver.submit_command_list(list);
+    cache.destroy(&driver);
+
+    REQUIRE(drivers::read_bitmap(&driver, target, { 0, 0 }, { 1, 1 }, 32, reinterpret_cast<std::uint8_t *>(&pixel)));
+
+    driver.abort();
+    driver_thread.join();
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/fs/io_pool.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+TEST_CASE("fs_io_pool_keeps_channel_order", "fs_io_pool") {
+    static constexpr int CHANNEL_COUNT = 4;
+    static constexpr int TASK_COUNT = 64;
+
+    std::mutex results_lock;
+    std::vector<int> results[CHANNEL_COUNT];
+    std::atomic<int> done_count{ 0 };
+
+    {
+        fs_io_pool pool(3);
+        fs_io_pool::channel_ptr channels[CHANNEL_COUNT];
+
+        for (int i = 0; i < CHANNEL_COUNT; i++) {
+            channels[i] = pool.new_channel();
+        }
+
+        for (int task = 0; task < TASK_COUNT; task++) {
+            for (int i = 0; i < CHANNEL_COUNT; i++) {
+                pool.queue(channels[i], [&, i, task]() {
+                    // Give other workers a chance to jump ahead, if the order is not kept
+                    if (task % 7 == 0) {
+                        std::this_thread::sleep_for(std::chrono::microseconds(200));
+                    }
+
+                    {
+                        const std::lock_guard<std::mutex> guard(results_lock);
+                        results[i].push_back(task);
+                    }
+
+                    done_count++;
+                });
+            }
+        }
+
+        while (done_count < CHANNEL_COUNT * TASK_COUNT) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        for (int i = 0; i < CHANNEL_COUNT; i++) {
+            REQUIRE(pool.can_run_now(channels[i]));
+        }
+    }
+
+    for (int i = 0; i < CHANNEL_COUNT; i++) {
+        REQUIRE(results[i].size() == TASK_COUNT);
+
+        for (int task = 0; task < TASK_COUNT; task++) {
+            REQUIRE(results[i][task] == task);
+        }
+    }
+}
+
+TEST_CASE("fs_io_pool_work_queued_by_work_runs_next", "fs_io_pool") {
+    std::vector<int> results;
+    std::atomic<bool> done{ false };
+    bool first_can_run_now = false;
+
+    fs_io_pool pool(2);
+    fs_io_pool::channel_ptr channel = pool.new_channel();
+
+    std::mutex first_lock;
+    first_lock.lock();
+
+    pool.queue(channel, [&]() {
+        // Hold until the later work is queued
+        const std::lock_guard<std::mutex> guard(first_lock);
+        results.push_back(0);
+
+        first_can_run_now = pool.can_run_now(channel);
+
+        pool.queue(channel, [&]() {
+            results.push_back(1);
+        });
+    });
+
+    REQUIRE_FALSE(pool.can_run_now(channel));
+
+    pool.queue(channel, [&]() {
+        results.push_back(2);
+        done = true;
+    });
+
+    first_lock.unlock();
+
+    while (!done) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    REQUIRE(first_can_run_now);
+    REQUIRE(results == std::vector<int>{ 0, 1, 2 });
+}
+
+TEST_CASE("fs_io_pool_cancels_dropped_work", "fs_io_pool") {
+    std::atomic<int> run_count{ 0 };
+    std::atomic<int> cancel_count{ 0 };
+    std::atomic<bool> started{ false };
+    std::atomic<bool> released{ false };
+    std::thread releaser;
+
+    {
+        fs_io_pool pool(1);
+        fs_io_pool::channel_ptr channel = pool.new_channel();
+
+        pool.queue(channel, [&]() {
+            started = true;
+
+            while (!released) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            run_count++;
+        }, [&]() {
+            cancel_count++;
+        });
+
+        for (int i = 0; i < 3; i++) {
+            pool.queue(channel, [&]() {
+                run_count++;
+            }, [&]() {
+                cancel_count++;
+            });
+        }
+
+        while (!started) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // Let the running work finish only once the pool is stopping
+        releaser = std::thread([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            released = true;
+        });
+    }
+
+    releaser.join();
+
+    REQUIRE(run_count == 1);
+    REQUIRE(cancel_count == 3);
+}
+
+TEST_CASE("fs_io_pool_channel_close_waits_for_owner_user", "fs_io_pool") {
+    fs_io_pool pool(1);
+    fs_io_pool::channel_ptr channel = pool.new_channel();
+
+    std::atomic<bool> using_owner{ false };
+    std::atomic<bool> owner_alive{ true };
+    bool saw_owner_alive = false;
+
+    pool.queue(channel, [&]() {
+        std::unique_lock<std::mutex> alive = channel->lock_owner();
+        using_owner = true;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        saw_owner_alive = alive && owner_alive;
+    });
+
+    while (!using_owner) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    channel->close();
+    owner_alive = false;
+
+    REQUIRE(saw_owner_alive);
+    REQUIRE_FALSE(channel->lock_owner());
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <services/window/opheader.h>
+#include <services/window/window.h>
+
+#include <cstring>
+#include <vector>
+
+using namespace eka2l1;
+
+// Writes a command the way the client side does, the handle only when it's given
+static void append_command(std::vector<std::uint8_t> &buffer, const std::uint16_t op, const std::vector<std::uint8_t> &data,
+    const std::uint32_t *obj_handle = nullptr) {
+    ws_cmd_header header;
+    header.op = op | (obj_handle ? 0x8000 : 0);
+    header.cmd_len = static_cast<std::uint16_t>(data.size());
+
+    const std::size_t header_pos = buffer.size();
+    buffer.resize(header_pos + sizeof(header));
+    std::memcpy(buffer.data() + header_pos, &header, sizeof(header));
+
+    if (obj_handle) {
+        const std::size_t handle_pos = buffer.size();
+        buffer.resize(handle_pos + sizeof(*obj_handle));
+        std::memcpy(buffer.data() + handle_pos, obj_handle, sizeof(*obj_handle));
+    }
+
+    buffer.insert(buffer.end(), data.begin(), data.end());
+}
+
+TEST_CASE("ws_cmd_reader_carries_handle_forward", "window") {
+    const std::uint32_t first_handle = 0x10002;
+    const std::uint32_t second_handle = 0x20005;
+
+    std::vector<std::uint8_t> buffer;
+    append_command(buffer, 1, { 1, 2, 3, 4 }, &first_handle);
+    append_command(buffer, 2, {});
+    append_command(buffer, 3, { 5, 6 });
+    append_command(buffer, 4, { 7, 8, 9, 10, 11, 12, 13, 14 }, &second_handle);
+    append_command(buffer, 5, { 15, 16, 17, 18 });
+
+    ws_cmd_reader reader(buffer.data(), buffer.data() + buffer.size());
+    ws_cmd cmd;
+
+    const std::uint16_t expected_ops[] = { 1, 2, 3, 4, 5 };
+    const std::uint32_t expected_handles[] = { first_handle, first_handle, first_handle, second_handle, second_handle };
+    const std::uint8_t expected_first_bytes[] = { 1, 0, 5, 7, 15 };
+
+    for (int i = 0; i < 5; i++) {
+        REQUIRE(reader.next(cmd));
+        REQUIRE(cmd.header.op == expected_ops[i]);
+        REQUIRE(cmd.obj_handle == expected_handles[i]);
+
+        // Data is read where it is, right after the header and the handle
+        if (cmd.header.cmd_len) {
+            REQUIRE(*reinterpret_cast<std::uint8_t *>(cmd.data_ptr) == expected_first_bytes[i]);
+        }
+    }
+
+    REQUIRE(!reader.next(cmd));
+    REQUIRE(reader.left() == 0);
+}
+
+TEST_CASE("ws_cmd_reader_stops_at_truncated_command", "window") {
+    const std::uint32_t handle = 0x10001;
+
+    std::vector<std::uint8_t> complete;
+    append_command(complete, 1, { 1, 2, 3, 4 }, &handle);
+
+    SECTION("data cut short") {
+        std::vector<std::uint8_t> buffer = complete;
+        append_command(buffer, 2, std::vector<std::uint8_t>(16, 0xCC));
+        buffer.resize(buffer.size() - 12);
+
+        // Sized to the buffer, so reading past it is caught by the address sanitizer
+        std::vector<std::uint8_t> exact(buffer.begin(), buffer.end());
+        ws_cmd_reader reader(exact.data(), exact.data() + exact.size());
+        ws_cmd cmd;
+
+        REQUIRE(reader.next(cmd));
+        REQUIRE(!reader.next(cmd));
+        REQUIRE(reader.left() == sizeof(ws_cmd_header) + 4);
+    }
+
+    SECTION("handle cut short") {
+        std::vector<std::uint8_t> buffer = complete;
+        append_command(buffer, 2, {}, &handle);
+        buffer.resize(buffer.size() - 2);
+
+        std::vector<std::uint8_t> exact(buffer.begin(), buffer.end());
+        ws_cmd_reader reader(exact.data(), exact.data() + exact.size());
+        ws_cmd cmd;
+
+        REQUIRE(reader.next(cmd));
+        REQUIRE(!reader.next(cmd));
+        REQUIRE(reader.left() == sizeof(ws_cmd_header) + 2);
+
+        // Nothing of the cut command is taken
+        REQUIRE(cmd.header.op == 1);
+        REQUIRE(cmd.obj_handle == handle);
+    }
+
+    SECTION("header cut short") {
+        std::vector<std::uint8_t> buffer = complete;
+        buffer.push_back(0x02);
+
+        std::vector<std::uint8_t> exact(buffer.begin(), buffer.end());
+        ws_cmd_reader reader(exact.data(), exact.data() + exact.size());
+        ws_cmd cmd;
+
+        REQUIRE(reader.next(cmd));
+        REQUIRE(!reader.next(cmd));
+        REQUIRE(reader.left() == 1);
+    }
+}
+
+TEST_CASE("ws_cmd_text_length_clamped_to_command", "window") {
+    static constexpr std::size_t FIXED_SIZE = 8;
+
+    std::vector<std::uint8_t> data(FIXED_SIZE + 3 * sizeof(char16_t));
+    const char16_t text[] = u"abc";
+    std::memcpy(data.data() + FIXED_SIZE, text, 3 * sizeof(char16_t));
+
+    ws_cmd cmd;
+    cmd.header.op = 1;
+    cmd.header.cmd_len = static_cast<std::uint16_t>(data.size());
+    cmd.obj_handle = 0;
+    cmd.data_ptr = data.data();
+
+    REQUIRE(get_ws_cmd_text(cmd, FIXED_SIZE, 2) == u"ab");
+    REQUIRE(get_ws_cmd_text(cmd, FIXED_SIZE, 3) == u"abc");
+
+    // The client asks for more than it sent
+    REQUIRE(get_ws_cmd_text(cmd, FIXED_SIZE, 0x7FFFFFFF) == u"abc");
+
+    REQUIRE(get_ws_cmd_text(cmd, FIXED_SIZE, 0).empty());
+    REQUIRE(get_ws_cmd_text(cmd, FIXED_SIZE, -5).empty());
+
+    // A command too short to even hold its fixed part
+    cmd.header.cmd_len = FIXED_SIZE - 2;
+    REQUIRE(get_ws_cmd_text(cmd, FIXED_SIZE, 3).empty());
+}
+
+TEST_CASE("window_command_counter_adds_flushes", "window") {
+    window_command_counter counter;
+
+    window_command_stats stats = counter.get();
+    REQUIRE(stats.flushes_ == 0);
+    REQUIRE(stats.commands_ == 0);
+    REQUIRE(stats.bytes_ == 0);
+
+    counter.add_flush(3, 40);
+    counter.add_flush(0, 6);
+    counter.add_flush(5, 100);
+
+    stats = counter.get();
+    REQUIRE(stats.flushes_ == 3);
+    REQUIRE(stats.commands_ == 8);
+    REQUIRE(stats.bytes_ == 146);
+}
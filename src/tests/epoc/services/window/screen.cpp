@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <catch2/catch.hpp>
+#include <drivers/graphics/backend/software/graphics_software.h>
+#include <drivers/itc.h>
+#include <services/window/classes/winbase.h>
+#include <services/window/screen.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace eka2l1;
+
+static constexpr int SCREEN_WIDTH = 4;
+static constexpr int SCREEN_HEIGHT = 10;
+static constexpr std::uint32_t UNTOUCHED_PIXEL = 0xDEADBEEF;
+
+// Counts the command lists submitted, a sync read is one list
+class counting_software_driver : public drivers::software_graphics_driver {
+public:
+    std::atomic<int> submit_count_{ 0 };
+
+    void submit_command_list(drivers::command_list &cmd_list) override {
+        submit_count_++;
+        drivers::software_graphics_driver::submit_command_list(cmd_list);
+    }
+};
+
+static epoc::config::screen make_screen_config() {
+    epoc::config::screen conf{};
+    conf.screen_number = 0;
+    conf.disp_mode = epoc::display_mode::color16ma;
+
+    // The size of a rotated mode is already given in its orientation
+    conf.modes.push_back({ 0, 0, eka2l1::vec2(SCREEN_WIDTH, SCREEN_HEIGHT), 0, "" });
+    conf.modes.push_back({ 0, 1, eka2l1::vec2(SCREEN_WIDTH, SCREEN_HEIGHT), 90, "" });
+    conf.modes.push_back({ 0, 2, eka2l1::vec2(SCREEN_WIDTH, SCREEN_HEIGHT), 180, "" });
+
+    return conf;
+}
+
+// Grey, so it reads back the same whatever the channel order
+static std::uint32_t row_pixel(const int y) {
+    return 0xFF000000 | (static_cast<std::uint32_t>(y) * 0x010101);
+}
+
+static std::uint32_t buffer_pixel(const std::vector<std::uint32_t> &buffer, const int x, const int y) {
+    return buffer[y * SCREEN_WIDTH + x];
+}
+
+static bool same_rect(const eka2l1::rect &lhs, const eka2l1::rect &rhs) {
+    return (lhs.top == rhs.top) && (lhs.size == rhs.size);
+}
+
+TEST_CASE("screen_sync_reads_merged_bands_once", "window") {
+    counting_software_driver driver;
+    std::thread driver_thread([&]() { driver.run(); });
+
+    epoc::config::screen conf = make_screen_config();
+    epoc::screen scr(0, conf);
+
+    // Each texture row is filled with its own index
+    std::vector<std::uint32_t> texture_data(SCREEN_WIDTH * SCREEN_HEIGHT);
+
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            texture_data[y * SCREEN_WIDTH + x] = row_pixel(y);
+        }
+    }
+
+    scr.screen_texture = drivers::create_bitmap(&driver, eka2l1::vec2(SCREEN_WIDTH, SCREEN_HEIGHT), 32);
+    REQUIRE(scr.screen_texture);
+
+    drivers::graphics_command_builder builder;
+    builder.update_bitmap(scr.screen_texture, reinterpret_cast<const char *>(texture_data.data()),
+        texture_data.size() * sizeof(std::uint32_t), { 0, 0 }, { SCREEN_WIDTH, SCREEN_HEIGHT });
+
+    drivers::command_list list = builder.retrieve_command_list();
+    driver.submit_command_list(list);
+
+    std::vector<std::uint32_t> buffer(SCREEN_WIDTH * SCREEN_HEIGHT, UNTOUCHED_PIXEL);
+
+    SECTION("nothing updated reads nothing") {
+        const int submit_before = driver.submit_count_;
+        scr.sync_screen_buffer_data(&driver, reinterpret_cast<std::uint8_t *>(buffer.data()));
+
+        REQUIRE(driver.submit_count_ == submit_before);
+        REQUIRE(buffer_pixel(buffer, 0, 0) == UNTOUCHED_PIXEL);
+    }
+
+    SECTION("overlapping and touching rows are merged") {
+        // Rows 1-4 from two overlapping rects, which touch rows 5-6 of a narrow one. Rows 8-9
+        // are apart, and the part of the last rect outside the screen is dropped.
+        scr.updated_region_.add_rect(eka2l1::rect({ 0, 1 }, { 2, 3 }));
+        scr.updated_region_.add_rect(eka2l1::rect({ 2, 2 }, { 2, 3 }));
+        scr.updated_region_.add_rect(eka2l1::rect({ 1, 5 }, { 1, 2 }));
+        scr.updated_region_.add_rect(eka2l1::rect({ 0, 8 }, { 4, 6 }));
+
+        const int submit_before = driver.submit_count_;
+        scr.sync_screen_buffer_data(&driver, reinterpret_cast<std::uint8_t *>(buffer.data()));
+
+        REQUIRE(driver.submit_count_ - submit_before == 2);
+
+        for (int y = 0; y < SCREEN_HEIGHT; y++) {
+            const bool read = ((y >= 1) && (y < 7)) || (y >= 8);
+
+            // Rows are read whole, even where the rects are narrower
+            for (int x = 0; x < SCREEN_WIDTH; x++) {
+                REQUIRE(buffer_pixel(buffer, x, y) == (read ? row_pixel(y) : UNTOUCHED_PIXEL));
+            }
+        }
+    }
+
+    SECTION("flipped modes read the mirrored rows") {
+        scr.crr_mode = GENERATE(1, 2);
+
+        scr.updated_region_.add_rect(eka2l1::rect({ 0, 0 }, { 4, 2 }));
+        scr.updated_region_.add_rect(eka2l1::rect({ 0, 5 }, { 4, 3 }));
+
+        const int submit_before = driver.submit_count_;
+        scr.sync_screen_buffer_data(&driver, reinterpret_cast<std::uint8_t *>(buffer.data()));
+
+        REQUIRE(driver.submit_count_ - submit_before == 2);
+
+        for (int y = 0; y < SCREEN_HEIGHT; y++) {
+            const bool read = (y < 2) || ((y >= 5) && (y < 8));
+
+            // The texture is upside down, so each buffer row comes from the opposite texture row
+            REQUIRE(buffer_pixel(buffer, 0, y) == (read ? row_pixel(SCREEN_HEIGHT - 1 - y) : UNTOUCHED_PIXEL));
+            REQUIRE(buffer_pixel(buffer, SCREEN_WIDTH - 1, y) == (read ? row_pixel(SCREEN_HEIGHT - 1 - y) : UNTOUCHED_PIXEL));
+        }
+    }
+
+    driver.abort();
+    driver_thread.join();
+}
+
+TEST_CASE("screen_recomposite_region_follows_damage", "window") {
+    epoc::config::screen conf = make_screen_config();
+    epoc::screen scr(0, conf);
+
+    common::region visible;
+    visible.add_rect(eka2l1::rect({ 0, 0 }, { 4, 4 }));
+
+    common::region result;
+
+    SECTION("no damage") {
+        scr.flags_ &= ~epoc::screen::FLAG_SERVER_REDRAW_PENDING;
+        REQUIRE(!scr.get_recomposite_region(visible, result));
+    }
+
+    SECTION("damage elsewhere") {
+        scr.flags_ &= ~epoc::screen::FLAG_SERVER_REDRAW_PENDING;
+        scr.add_damage(eka2l1::rect({ 6, 6 }, { 2, 2 }));
+
+        REQUIRE(!scr.get_recomposite_region(visible, result));
+    }
+
+    SECTION("damage overlapping the window") {
+        scr.flags_ &= ~epoc::screen::FLAG_SERVER_REDRAW_PENDING;
+        scr.add_damage(eka2l1::rect({ 2, 3 }, { 4, 4 }));
+
+        REQUIRE(scr.get_recomposite_region(visible, result));
+        REQUIRE(result.rects_.size() == 1);
+        REQUIRE(same_rect(result.rects_[0], eka2l1::rect({ 2, 3 }, { 2, 1 })));
+    }
+
+    SECTION("a full recomposite takes the whole visible region") {
+        scr.flags_ &= ~epoc::screen::FLAG_SERVER_REDRAW_PENDING;
+        scr.add_damage(eka2l1::rect({ 2, 3 }, { 4, 4 }));
+        scr.flags_ |= epoc::screen::FLAG_SERVER_REDRAW_PENDING;
+
+        // Damage added while a full recomposite is pending is not even recorded
+        scr.add_damage(eka2l1::rect({ 0, 0 }, { 1, 1 }));
+
+        REQUIRE(scr.get_recomposite_region(visible, result));
+        REQUIRE(result.rects_.size() == 1);
+        REQUIRE(same_rect(result.rects_[0], eka2l1::rect({ 0, 0 }, { 4, 4 })));
+
+        scr.flags_ &= ~epoc::screen::FLAG_SERVER_REDRAW_PENDING;
+        REQUIRE(scr.get_recomposite_region(visible, result));
+        REQUIRE(same_rect(result.rects_[0], eka2l1::rect({ 2, 3 }, { 2, 1 })));
+    }
+}
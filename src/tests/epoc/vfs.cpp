@@ -2,6 +2,7 @@
 #include <common/algorithm.h>
 #include <common/path.h>
 #include <common/types.h>
+#include <loader/rom.h>
 #include <vfs/vfs.h>
 
 struct io_scope_guard {
@@ -37,3 +38,59 @@ TEST_CASE("get_physical", "vfs") {
 
     REQUIRE(eka2l1::common::compare_ignore_case(*actual_path_b, std::u16string(u"drive_b") + static_cast<char16_t>(eka2l1::get_separator()) + u"despacito3leak") == 0);
 }
+
+static eka2l1::loader::rom_entry make_rom_file_entry(const std::u16string &name, const std::uint32_t size) {
+    eka2l1::loader::rom_entry entry;
+    entry.name = name;
+    entry.name_len = static_cast<std::uint8_t>(name.length());
+    entry.size = size;
+    entry.address_lin = 0;
+    entry.attrib = 0;
+
+    return entry;
+}
+
+TEST_CASE("rom_fs_index_lookup", "vfs") {
+    eka2l1::loader::rom rom_info{};
+
+    eka2l1::loader::rom_dir bin_dir;
+    bin_dir.name = u"bin";
+    bin_dir.entries.push_back(make_rom_file_entry(u"Euser.dll", 0x1234));
+
+    eka2l1::loader::rom_dir sys_dir;
+    sys_dir.name = u"sys";
+    sys_dir.subdirs.push_back(bin_dir);
+
+    eka2l1::loader::root_dir root;
+    root.dir.subdirs.push_back(sys_dir);
+    root.dir.entries.push_back(make_rom_file_entry(u"Readme.txt", 10));
+
+    rom_info.root.root_dirs.push_back(root);
+    rom_info.root.num_root_dirs = 1;
+
+    eka2l1::io_system io;
+    auto rom_fs = eka2l1::create_rom_filesystem(&rom_info, nullptr, epocver::epoc94, "rm-000");
+    io.add_filesystem(rom_fs);
+
+    io.mount_physical_path(drive_number::drive_z, drive_media::rom, io_attrib_internal, u"rom_drive_that_does_not_exist");
+
+    // Answered from the burn tree, no host file needed
+    REQUIRE(io.is_entry_in_rom(u"Z:\\Sys\\Bin\\EUSER.DLL"));
+    REQUIRE(io.is_entry_in_rom(u"z:/sys/bin/euser.dll"));
+    REQUIRE(io.is_entry_in_rom(u"Z:\\readme.txt"));
+    REQUIRE(!io.is_entry_in_rom(u"Z:\\sys\\bin\\efsrv.dll"));
+    REQUIRE(!io.is_entry_in_rom(u"Z:\\sys\\bin"));
+
+    // Not a ROM drive
+    REQUIRE(!io.is_entry_in_rom(u"C:\\sys\\bin\\euser.dll"));
+
+    std::optional<eka2l1::entry_info> info = io.get_entry_info(u"Z:\\sys\\bin\\euser.dll");
+
+    REQUIRE(info);
+    REQUIRE(info->size == 0x1234);
+    REQUIRE(info->type == eka2l1::io_component_type::file);
+
+    // Missing everywhere, and stays so when asked again
+    REQUIRE(!io.get_entry_info(u"Z:\\sys\\bin\\missing.dll"));
+    REQUIRE(!io.get_entry_info(u"Z:\\sys\\bin\\missing.dll"));
+}
@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/arghandler.h>
+#include <common/log.h>
+#include <common/pystr.h>
+#include <common/region.h>
+
+#include <drivers/driver.h>
+#include <drivers/graphics/graphics.h>
+#include <drivers/itc.h>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace eka2l1;
+
+struct bench_options {
+    std::uint32_t frames_ = 2000;
+    std::uint32_t windows_ = 8;
+};
+
+/**
+ * \brief A command of a captured frame, with a copy of the payload it points to.
+ */
+struct captured_command {
+    drivers::command cmd_;
+    std::vector<std::uint8_t> payload_;
+    int payload_word_ = -1;
+};
+
+// The fixed size list that commands were stored in before the byte stream
+static constexpr std::size_t FIXED_LIST_CAPACITY = 12800;
+
+/**
+ * \brief Builder which gives back what it recorded, as the driver would see it.
+ */
+class frame_recorder : public drivers::graphics_command_builder {
+public:
+    std::vector<captured_command> capture() {
+        list_.flush();
+
+        std::vector<captured_command> result;
+        drivers::command_reader reader(list_);
+        captured_command captured;
+
+        while (reader.next(captured.cmd_)) {
+            captured.payload_.clear();
+            captured.payload_word_ = -1;
+
+            std::size_t payload_size = 0;
+
+            switch (captured.cmd_.opcode_) {
+            case drivers::graphics_driver_clip_region:
+                payload_size = captured.cmd_.data_[0] * sizeof(eka2l1::rect);
+                captured.payload_word_ = 1;
+                break;
+
+            case drivers::graphics_driver_update_bitmap:
+                payload_size = captured.cmd_.data_[2];
+                captured.payload_word_ = 1;
+                break;
+
+            case drivers::graphics_driver_draw_polygon:
+                payload_size = captured.cmd_.data_[0] * sizeof(eka2l1::point);
+                captured.payload_word_ = 1;
+                break;
+
+            case drivers::graphics_driver_draw_bitmap_quads:
+                payload_size = captured.cmd_.data_[2] * sizeof(drivers::bitmap_quad);
+                captured.payload_word_ = 1;
+                break;
+
+            default:
+                break;
+            }
+
+            if (captured.payload_word_ >= 0) {
+                const std::uint8_t *payload = reinterpret_cast<const std::uint8_t *>(captured.cmd_.data_[captured.payload_word_]);
+                captured.payload_.assign(payload, payload + payload_size);
+            }
+
+            result.push_back(captured);
+        }
+
+        return result;
+    }
+};
+
+/**
+ * \brief How the text of a window is drawn.
+ */
+enum text_draw_mode {
+    text_draw_mode_per_glyph, ///< One bitmap draw per character from a font atlas.
+    text_draw_mode_quads ///< One quad list for all characters, from a shared glyph cache page.
+};
+
+struct bench_scenario {
+    const char *name_;
+    text_draw_mode text_mode_;
+};
+
+static const bench_scenario SCENARIOS[] = {
+    { "per-glyph text", text_draw_mode_per_glyph },
+    { "quad list text", text_draw_mode_quads }
+};
+
+// What the window server emits to redraw a screen of windows, each with some text and an icon
+static std::vector<captured_command> capture_window_server_frame(const std::uint32_t window_count, const text_draw_mode text_mode) {
+    frame_recorder recorder;
+    std::vector<char> icon_data(24 * 24 * 4, 0x55);
+
+    recorder.bind_bitmap(1);
+    recorder.set_feature(drivers::graphics_feature::blend, true);
+    recorder.blend_formula(drivers::blend_equation::add, drivers::blend_equation::add,
+        drivers::blend_factor::frag_out_alpha, drivers::blend_factor::one_minus_frag_out_alpha,
+        drivers::blend_factor::one, drivers::blend_factor::one);
+
+    for (std::uint32_t i = 0; i < window_count; i++) {
+        const int top = static_cast<int>(i * 36);
+
+        common::region visible;
+        visible.add_rect(eka2l1::rect({ 0, top }, { 240, 36 }));
+        visible.eliminate(eka2l1::rect({ 200, top }, { 40, 12 }));
+
+        recorder.clip_bitmap_region(visible);
+        recorder.set_brush_color_detail({ 255, 255, 255, 255 });
+        recorder.draw_rectangle(eka2l1::rect({ 0, top }, { 240, 36 }));
+        recorder.draw_bitmap(10 + i, 0, eka2l1::rect({ 0, top }, { 240, 36 }), eka2l1::rect({ 0, 0 }, { 240, 36 }));
+
+        recorder.update_bitmap(100 + i, icon_data.data(), icon_data.size(), { 0, 0 }, { 24, 24 });
+        recorder.draw_bitmap(100 + i, 0, eka2l1::rect({ 4, top + 6 }, { 24, 24 }), eka2l1::rect({ 0, 0 }, { 24, 24 }));
+
+        recorder.set_brush_color_detail({ 0, 0, 0, 255 });
+
+        if (text_mode == text_draw_mode_per_glyph) {
+            for (int glyph = 0; glyph < 24; glyph++) {
+                recorder.draw_bitmap(5, 0, eka2l1::rect({ 32 + glyph * 7, top + 10 }, { 7, 12 }),
+                    eka2l1::rect({ glyph * 7, 0 }, { 7, 12 }), { 0, 0 }, 0.0f, 1);
+            }
+        } else {
+            drivers::bitmap_quad glyphs[24];
+
+            for (int glyph = 0; glyph < 24; glyph++) {
+                glyphs[glyph].dest_ = eka2l1::rect({ 32 + glyph * 7, top + 10 }, { 7, 12 });
+                glyphs[glyph].source_ = eka2l1::rect({ glyph * 7, 0 }, { 7, 12 });
+            }
+
+            recorder.draw_bitmap_quads(5, glyphs, 24, drivers::bitmap_draw_flag_use_brush);
+        }
+
+        const eka2l1::point separator[] = { { 0, top + 35 }, { 120, top + 35 }, { 240, top + 35 } };
+        recorder.draw_polygons(separator, 3);
+    }
+
+    recorder.set_feature(drivers::graphics_feature::clipping, false);
+    recorder.bind_bitmap(0);
+
+    std::vector<captured_command> frame = recorder.capture();
+    recorder.reset_list();
+
+    return frame;
+}
+
+static std::uint64_t consume_command(const drivers::command &cmd, const int payload_word) {
+    std::uint64_t checksum = cmd.opcode_;
+
+    for (std::size_t i = 0; i < drivers::COMMAND_MAX_DATA_WORD; i++) {
+        checksum += cmd.data_[i];
+    }
+
+    if ((payload_word >= 0) && cmd.data_[payload_word]) {
+        checksum += *reinterpret_cast<const std::uint8_t *>(cmd.data_[payload_word]);
+    }
+
+    return checksum;
+}
+
+static int find_payload_word(const std::uint32_t opcode) {
+    switch (opcode) {
+    case drivers::graphics_driver_clip_region:
+    case drivers::graphics_driver_update_bitmap:
+    case drivers::graphics_driver_draw_polygon:
+    case drivers::graphics_driver_draw_bitmap_quads:
+        return 1;
+
+    default:
+        break;
+    }
+
+    return -1;
+}
+
+// Fixed records in a list allocated for each frame, and payloads copied to the heap then freed by the driver
+static std::uint64_t replay_fixed(const std::vector<captured_command> &frame, std::size_t &list_bytes) {
+    drivers::command *base = new drivers::command[FIXED_LIST_CAPACITY];
+    std::size_t size = 0;
+
+    for (const captured_command &captured : frame) {
+        drivers::command &cmd = base[size++];
+        cmd = captured.cmd_;
+
+        if (captured.payload_word_ >= 0) {
+            std::uint8_t *copy = new std::uint8_t[captured.payload_.size()];
+            std::memcpy(copy, captured.payload_.data(), captured.payload_.size());
+
+            cmd.data_[captured.payload_word_] = reinterpret_cast<std::uint64_t>(copy);
+        }
+    }
+
+    std::uint64_t checksum = 0;
+
+    for (std::size_t i = 0; i < size; i++) {
+        const int payload_word = find_payload_word(base[i].opcode_);
+        checksum += consume_command(base[i], payload_word);
+
+        if (payload_word >= 0) {
+            delete[] reinterpret_cast<std::uint8_t *>(base[i].data_[payload_word]);
+        }
+    }
+
+    list_bytes = size * sizeof(drivers::command);
+    delete[] base;
+
+    return checksum;
+}
+
+// Byte stream, with payloads in the list's blocks that go back to the pool when the list is retired
+static std::uint64_t replay_stream(const std::vector<captured_command> &frame, std::size_t &list_bytes) {
+    drivers::command_list list;
+
+    for (const captured_command &captured : frame) {
+        if (captured.payload_word_ < 0) {
+            list.push(captured.cmd_);
+            continue;
+        }
+
+        drivers::command cmd = captured.cmd_;
+        std::uint8_t *copy = list.allocate_payload(captured.payload_.size());
+
+        std::memcpy(copy, captured.payload_.data(), captured.payload_.size());
+        cmd.data_[captured.payload_word_] = reinterpret_cast<std::uint64_t>(copy);
+
+        list.push(cmd);
+    }
+
+    std::uint64_t checksum = 0;
+
+    drivers::command_reader reader(list);
+    drivers::command cmd;
+
+    while (reader.next(cmd)) {
+        checksum += consume_command(cmd, find_payload_word(cmd.opcode_));
+    }
+
+    list_bytes = list.stream_size();
+    list.retire();
+
+    return checksum;
+}
+
+template <typename F>
+static double time_replay(const std::uint32_t frames, F replay, std::uint64_t &checksum) {
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::uint32_t i = 0; i < frames; i++) {
+        checksum += replay();
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / frames;
+}
+
+static bool frames_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *frames = parser->next_token();
+
+    if (!frames) {
+        *err = "No frame count specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->frames_ = common::pystr(frames).as_int<std::uint32_t>(2000, 10);
+    return true;
+}
+
+static bool windows_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *windows = parser->next_token();
+
+    if (!windows) {
+        *err = "No window count specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->windows_ = common::pystr(windows).as_int<std::uint32_t>(8, 10);
+    return true;
+}
+
+static bool help_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    std::cout << "Usage: cmdbench [options]. Replays window server frames through both graphics command encodings." << std::endl;
+    std::cout << parser->get_help_string();
+
+    return false;
+}
+
+int main(int argc, const char **argv) {
+    log::setup_log(nullptr);
+
+    bench_options options;
+    common::arg_parser parser(argc, argv);
+
+    parser.add("--help, -h", "Display helps menu", help_option_handler);
+    parser.add("--frames, -n", "Number of frames to replay with each encoding. Default is 2000.", frames_option_handler);
+    parser.add("--windows, -w", "Number of windows on the captured screen. Default is 8.", windows_option_handler);
+
+    std::string err;
+
+    if (!parser.parse(&options, &err)) {
+        if (!err.empty()) {
+            LOG_ERROR(SYSTEM, "{}", err);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    for (const bench_scenario &scenario : SCENARIOS) {
+        const std::vector<captured_command> frame = capture_window_server_frame(options.windows_, scenario.text_mode_);
+
+        if (frame.size() > FIXED_LIST_CAPACITY) {
+            LOG_ERROR(SYSTEM, "Frame with {} has {} commands, more than a fixed list holds", scenario.name_, frame.size());
+            return -1;
+        }
+
+        std::size_t fixed_bytes = 0;
+        std::size_t stream_bytes = 0;
+        std::uint64_t fixed_checksum = 0;
+        std::uint64_t stream_checksum = 0;
+
+        // Warm up the block pool and the heap, so neither side pays for the first allocations
+        replay_fixed(frame, fixed_bytes);
+        replay_stream(frame, stream_bytes);
+
+        const double fixed_us = time_replay(options.frames_, [&]() { return replay_fixed(frame, fixed_bytes); }, fixed_checksum);
+        const double stream_us = time_replay(options.frames_, [&]() { return replay_stream(frame, stream_bytes); }, stream_checksum);
+
+        // Payload addresses differ between the two, only the checksum of each side is meaningful
+        std::cout << fmt::format("{}: {} commands per frame, {} frames\n", scenario.name_, frame.size(), options.frames_);
+        std::cout << fmt::format("  fixed:  {:>8} bytes/frame {:>10.2f} us/frame (checksum {:x})\n", fixed_bytes, fixed_us, fixed_checksum);
+        std::cout << fmt::format("  stream: {:>8} bytes/frame {:>10.2f} us/frame (checksum {:x})\n", stream_bytes, stream_us, stream_checksum);
+        std::cout << fmt::format("  stream is {:.2f}x the speed, with {:.1f}% of the bytes\n", fixed_us / stream_us,
+            stream_bytes * 100.0 / fixed_bytes);
+    }
+
+    return 0;
+}
@@ -0,0 +1,653 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/arghandler.h>
+#include <common/cvt.h>
+#include <common/fileutils.h>
+#include <common/log.h>
+#include <common/path.h>
+#include <common/platform.h>
+#include <common/pystr.h>
+
+#include <config/app_settings.h>
+#include <config/config.h>
+
+#include <cpu/arm_interface.h>
+#include <cpu/arm_utils.h>
+
+#include <drivers/audio/audio.h>
+#include <drivers/graphics/graphics.h>
+
+#include <kernel/kernel.h>
+#include <kernel/profiler.h>
+#include <mem/mem.h>
+#include <services/applist/applist.h>
+#include <services/window/window.h>
+#include <system/devices.h>
+#include <system/epoc.h>
+#include <utils/apacmd.h>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if EKA2L1_PLATFORM(WIN32)
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace eka2l1;
+
+struct bench_options {
+    std::string device_;
+    std::vector<std::string> apps_;
+    std::vector<arm_emulator_type> backends_;
+    std::uint32_t seconds_ = 10;
+    std::string output_path_;
+    std::string profile_prefix_;
+    bool software_graphics_ = false;
+};
+
+struct counter_snapshot {
+    std::uint64_t instructions_ = 0;
+    std::uint64_t svc_calls_ = 0;
+    std::uint64_t ipc_messages_ = 0;
+    std::uint64_t jit_compile_time_ = 0;
+    window_command_stats ws_commands_;
+
+    counter_snapshot operator-(const counter_snapshot &rhs) const {
+        counter_snapshot result;
+        result.instructions_ = instructions_ - rhs.instructions_;
+        result.svc_calls_ = svc_calls_ - rhs.svc_calls_;
+        result.ipc_messages_ = ipc_messages_ - rhs.ipc_messages_;
+        result.jit_compile_time_ = jit_compile_time_ - rhs.jit_compile_time_;
+        result.ws_commands_.flushes_ = ws_commands_.flushes_ - rhs.ws_commands_.flushes_;
+        result.ws_commands_.commands_ = ws_commands_.commands_ - rhs.ws_commands_.commands_;
+        result.ws_commands_.bytes_ = ws_commands_.bytes_ - rhs.ws_commands_.bytes_;
+
+        return result;
+    }
+};
+
+struct app_result {
+    std::string name_;
+    bool launched_ = false;
+    double seconds_ = 0.0;
+    counter_snapshot counters_;
+};
+
+struct backend_result {
+    arm_emulator_type type_;
+    bool booted_ = false;
+    double boot_seconds_ = 0.0;
+    std::string device_;
+    std::string epoc_version_;
+    std::string memory_model_;
+    counter_snapshot boot_counters_;
+    std::vector<app_result> apps_;
+
+    // The peak is for the whole process, so only the first run's peak is its own
+    std::uint64_t process_peak_rss_ = 0;
+    std::uint64_t peak_rss_growth_ = 0;
+};
+
+static bool device_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *device = parser->next_token();
+
+    if (!device) {
+        *err = "No device specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->device_ = device;
+    return true;
+}
+
+static bool app_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *app = parser->next_token();
+
+    if (!app) {
+        *err = "No application specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->apps_.push_back(app);
+    return true;
+}
+
+static bool cpu_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *cpu = parser->next_token();
+
+    if (!cpu) {
+        *err = "No CPU backend specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->backends_.push_back(arm::string_to_arm_emulator_type(cpu));
+    return true;
+}
+
+static bool seconds_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *seconds = parser->next_token();
+
+    if (!seconds) {
+        *err = "No duration specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->seconds_ = common::pystr(seconds).as_int<std::uint32_t>(10, 10);
+    return true;
+}
+
+static bool output_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *path = parser->next_token();
+
+    if (!path) {
+        *err = "No output path specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->output_path_ = path;
+    return true;
+}
+
+static bool profile_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *prefix = parser->next_token();
+
+    if (!prefix) {
+        *err = "No profile path prefix specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->profile_prefix_ = prefix;
+    return true;
+}
+
+static bool software_graphics_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    reinterpret_cast<bench_options *>(userdata)->software_graphics_ = true;
+    return true;
+}
+
+static bool help_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    std::cout << "Usage: ekabench [options]. Run from the emulator folder, where the configuration and data are." << std::endl;
+    std::cout << parser->get_help_string();
+
+    return false;
+}
+
+static std::uint64_t get_peak_rss() {
+#if EKA2L1_PLATFORM(WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<std::uint64_t>(counters.PeakWorkingSetSize);
+    }
+
+    return 0;
+#else
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+
+#if EKA2L1_PLATFORM(DARWIN)
+    return static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+    // Kilobytes on Linux and BSDs
+    return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+static counter_snapshot take_snapshot(eka2l1::system *sys) {
+    kernel_system *kern = sys->get_kernel_system();
+    kernel_counters &counters = kern->get_counters();
+
+    counter_snapshot snapshot;
+    snapshot.instructions_ = counters.instructions_executed_.load(std::memory_order_relaxed);
+    snapshot.svc_calls_ = counters.svc_calls_.load(std::memory_order_relaxed);
+    snapshot.ipc_messages_ = counters.ipc_messages_.load(std::memory_order_relaxed);
+
+    for (std::size_t i = 0; i < kern->get_core_count(); i++) {
+        kernel::thread_scheduler *scheduler = kern->get_core_scheduler(i);
+
+        if (scheduler && scheduler->get_core()) {
+            snapshot.jit_compile_time_ += scheduler->get_core()->get_total_jit_compile_time();
+        }
+    }
+
+    window_server *winserv = reinterpret_cast<window_server *>(kern->get_by_name<service::server>(
+        get_winserv_name_by_epocver(kern->get_epoc_version())));
+
+    if (winserv) {
+        snapshot.ws_commands_ = winserv->get_command_stats();
+    }
+
+    return snapshot;
+}
+
+static double seconds_since(const std::chrono::steady_clock::time_point &start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static const char *mem_model_type_to_string(const mem::mem_model_type type) {
+    switch (type) {
+    case mem::mem_model_type::moving:
+        return "moving";
+
+    case mem::mem_model_type::multiple:
+        return "multiple";
+
+    case mem::mem_model_type::flexible:
+        return "flexible";
+
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+/**
+ * \brief Launch an app, by UID (starting with 0x), absolute virtual path, or caption.
+ *
+ * \returns The process of the app, nullptr on failure.
+ */
+static kernel::process *launch_app(eka2l1::system *sys, const std::string &app) {
+    kernel_system *kern = sys->get_kernel_system();
+    applist_server *svr = reinterpret_cast<applist_server *>(kern->get_by_name<service::server>(
+        get_app_list_server_name_by_epocver(kern->get_epoc_version())));
+
+    if (eka2l1::has_root_dir(app)) {
+        kernel::process *pr = kern->spawn_new_process(common::utf8_to_ucs2(app), u"");
+
+        if (pr) {
+            pr->run();
+        }
+
+        return pr;
+    }
+
+    if (!svr) {
+        LOG_ERROR(SYSTEM, "Can't get app list server to launch {}", app);
+        return nullptr;
+    }
+
+    apa_app_registry *registry = nullptr;
+
+    if ((app.length() > 2) && (app.substr(0, 2) == "0x")) {
+        registry = svr->get_registration(common::pystr(app).as_int<std::uint32_t>());
+    } else {
+        for (auto &reg : svr->get_registerations()) {
+            if (common::ucs2_to_utf8(reg.mandatory_info.long_caption.to_std_string(nullptr)) == app) {
+                registry = &reg;
+                break;
+            }
+        }
+    }
+
+    if (!registry) {
+        LOG_ERROR(SYSTEM, "No app found with the UID or name {}", app);
+        return nullptr;
+    }
+
+    epoc::apa::command_line cmdline;
+    cmdline.launch_cmd_ = epoc::apa::command_create;
+
+    kernel::uid thread_id = 0;
+
+    if (!svr->launch_app(*registry, cmdline, &thread_id)) {
+        return nullptr;
+    }
+
+    kernel::thread *thr = kern->get_by_id<kernel::thread>(thread_id);
+    return thr ? thr->owning_process() : nullptr;
+}
+
+static void run_for(eka2l1::system *sys, const double seconds, kernel::guest_profiler *profiler) {
+    const auto start = std::chrono::steady_clock::now();
+
+    while ((seconds_since(start) < seconds) && !sys->should_exit()) {
+        sys->loop();
+
+        if (profiler) {
+            profiler->drain();
+        }
+    }
+}
+
+static void write_profile(kernel::guest_profiler &profiler, const std::string &path_prefix) {
+    profiler.stop();
+
+    profiler.write_collapsed_stacks(path_prefix + ".folded");
+    profiler.write_top_report(path_prefix + ".txt");
+
+    LOG_INFO(SYSTEM, "Profile written to {}.folded and {}.txt ({} samples, {} dropped)", path_prefix, path_prefix,
+        profiler.sample_count(), profiler.dropped_count());
+}
+
+static backend_result run_backend(config::state &conf, config::app_settings &settings, const bench_options &options,
+    const arm_emulator_type type) {
+    backend_result result;
+    result.type_ = type;
+
+    const std::uint64_t peak_rss_before = get_peak_rss();
+
+    drivers::graphics_driver_ptr graphics_driver = drivers::create_graphics_driver(options.software_graphics_ ?
+        drivers::graphic_api::software : drivers::graphic_api::null, {});
+    std::unique_ptr<drivers::audio_driver> audio_driver = drivers::make_audio_driver(drivers::audio_driver_backend::null,
+        conf.audio_master_volume, drivers::player_type_tsf);
+
+    std::thread graphics_thread([&]() {
+        graphics_driver->run();
+    });
+
+    const auto boot_start = std::chrono::steady_clock::now();
+
+    system_create_components comp;
+    comp.graphics_ = graphics_driver.get();
+    comp.audio_ = audio_driver.get();
+    comp.conf_ = &conf;
+    comp.settings_ = &settings;
+
+    std::unique_ptr<eka2l1::system> symsys = std::make_unique<eka2l1::system>(comp);
+    symsys->set_cpu_executor_type(type);
+
+    device_manager *dvcmngr = symsys->get_device_manager();
+    std::uint8_t device_index = static_cast<std::uint8_t>(conf.device);
+
+    for (std::size_t i = 0; i < dvcmngr->get_devices().size(); i++) {
+        if (dvcmngr->get_devices()[i].firmware_code == options.device_) {
+            device_index = static_cast<std::uint8_t>(i);
+            break;
+        }
+    }
+
+    if (dvcmngr->total() > 0) {
+        symsys->startup();
+
+        if (symsys->set_device(device_index)) {
+            symsys->mount(drive_c, drive_media::physical, eka2l1::add_path(conf.storage, "/drives/c/"), io_attrib_internal);
+            symsys->mount(drive_d, drive_media::physical, eka2l1::add_path(conf.storage, "/drives/d/"), io_attrib_internal);
+            symsys->mount(drive_e, drive_media::physical, eka2l1::add_path(conf.storage, "/drives/e/"), io_attrib_removeable);
+            symsys->mount(drive_z, drive_media::rom, eka2l1::add_path(conf.storage, "/drives/z/"),
+                io_attrib_internal | io_attrib_write_protected);
+
+            symsys->initialize_user_parties();
+            result.booted_ = true;
+        }
+    }
+
+    if (!result.booted_) {
+        LOG_ERROR(SYSTEM, "Failed to boot a device. Make sure one is installed, and the firmware code is right");
+    } else {
+        result.boot_seconds_ = seconds_since(boot_start);
+        result.boot_counters_ = take_snapshot(symsys.get());
+
+        device *dvc = dvcmngr->get_current();
+        result.device_ = dvc->firmware_code;
+        result.epoc_version_ = epocver_to_string(dvc->ver);
+        result.memory_model_ = mem_model_type_to_string(symsys->get_memory_system()->get_control()->model_type());
+
+        LOG_INFO(SYSTEM, "Booted {} with {} in {:.3f}s", result.device_, arm::arm_emulator_type_to_string(type), result.boot_seconds_);
+
+        kernel_system *kern = symsys->get_kernel_system();
+
+        for (const std::string &app : options.apps_) {
+            app_result app_res;
+            app_res.name_ = app;
+
+            kern->lock();
+            kernel::process *pr = launch_app(symsys.get(), app);
+            kern->unlock();
+
+            if (!pr) {
+                LOG_ERROR(SYSTEM, "Failed to launch {}", app);
+                result.apps_.push_back(app_res);
+
+                continue;
+            }
+
+            app_res.launched_ = true;
+
+            std::unique_ptr<kernel::guest_profiler> profiler;
+
+            if (!options.profile_prefix_.empty()) {
+                profiler = std::make_unique<kernel::guest_profiler>(kern);
+                profiler->start();
+            }
+
+            const counter_snapshot before = take_snapshot(symsys.get());
+            const auto app_start = std::chrono::steady_clock::now();
+
+            run_for(symsys.get(), static_cast<double>(options.seconds_), profiler.get());
+
+            app_res.seconds_ = seconds_since(app_start);
+            app_res.counters_ = take_snapshot(symsys.get()) - before;
+
+            if (profiler) {
+                write_profile(*profiler, fmt::format("{}_{}_{}", options.profile_prefix_, arm::arm_emulator_type_to_string(type),
+                    result.apps_.size()));
+
+                profiler.reset();
+            }
+
+            kern->lock();
+            pr->kill(kernel::entity_exit_type::kill, u"Benchmark", 0);
+            kern->unlock();
+
+            LOG_INFO(SYSTEM, "{}: {} instructions in {:.3f}s", app, app_res.counters_.instructions_, app_res.seconds_);
+            result.apps_.push_back(app_res);
+
+            if (symsys->should_exit()) {
+                break;
+            }
+        }
+    }
+
+    // The system may still talk to the graphics driver while shutting down
+    symsys.reset();
+
+    graphics_driver->abort();
+    graphics_thread.join();
+
+    result.process_peak_rss_ = get_peak_rss();
+    result.peak_rss_growth_ = result.process_peak_rss_ - peak_rss_before;
+
+    return result;
+}
+
+static std::string escape_json_string(const std::string &str) {
+    std::string result;
+    result.reserve(str.size());
+
+    for (const char c : str) {
+        switch (c) {
+        case '"':
+            result += "\\\"";
+            break;
+
+        case '\\':
+            result += "\\\\";
+            break;
+
+        case '\n':
+            result += "\\n";
+            break;
+
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                result += fmt::format("\\u{:04x}", static_cast<int>(c));
+            } else {
+                result += c;
+            }
+
+            break;
+        }
+    }
+
+    return result;
+}
+
+static double per_second(const std::uint64_t count, const double seconds) {
+    return (seconds > 0.0) ? static_cast<double>(count) / seconds : 0.0;
+}
+
+static double per_flush(const std::uint64_t count, const std::uint64_t flushes) {
+    return (flushes > 0) ? static_cast<double>(count) / static_cast<double>(flushes) : 0.0;
+}
+
+static std::string make_report(const bench_options &options, const std::vector<backend_result> &results) {
+    std::string report = fmt::format("{{\n  \"seconds_per_app\": {},\n  \"graphics\": \"{}\",\n  \"backends\": [", options.seconds_,
+        options.software_graphics_ ? "software" : "null");
+
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const backend_result &res = results[i];
+
+        report += fmt::format("{}\n    {{\n      \"cpu_backend\": \"{}\",\n      \"booted\": {},\n", (i == 0) ? "" : ",",
+            arm::arm_emulator_type_to_string(res.type_), res.booted_);
+
+        report += fmt::format("      \"device\": \"{}\",\n      \"epoc_version\": \"{}\",\n      \"memory_model\": \"{}\",\n",
+            escape_json_string(res.device_), res.epoc_version_, res.memory_model_);
+
+        report += fmt::format("      \"boot_seconds\": {:.6f},\n      \"boot_instructions\": {},\n      \"boot_svc_calls\": {},\n"
+                              "      \"boot_ipc_messages\": {},\n      \"boot_jit_compile_ms\": {:.3f},\n",
+            res.boot_seconds_, res.boot_counters_.instructions_, res.boot_counters_.svc_calls_, res.boot_counters_.ipc_messages_,
+            static_cast<double>(res.boot_counters_.jit_compile_time_) / 1000000.0);
+
+        report += fmt::format("      \"process_peak_rss_bytes\": {},\n      \"peak_rss_growth_bytes\": {},\n      \"apps\": [",
+            res.process_peak_rss_, res.peak_rss_growth_);
+
+        for (std::size_t j = 0; j < res.apps_.size(); j++) {
+            const app_result &app = res.apps_[j];
+
+            report += fmt::format("{}\n        {{\n          \"app\": \"{}\",\n          \"launched\": {},\n          \"seconds\": {:.6f},\n",
+                (j == 0) ? "" : ",", escape_json_string(app.name_), app.launched_, app.seconds_);
+
+            report += fmt::format("          \"instructions\": {},\n          \"instructions_per_second\": {:.1f},\n",
+                app.counters_.instructions_, per_second(app.counters_.instructions_, app.seconds_));
+
+            report += fmt::format("          \"svc_calls\": {},\n          \"svc_calls_per_second\": {:.1f},\n",
+                app.counters_.svc_calls_, per_second(app.counters_.svc_calls_, app.seconds_));
+
+            report += fmt::format("          \"ipc_messages\": {},\n          \"ipc_messages_per_second\": {:.1f},\n",
+                app.counters_.ipc_messages_, per_second(app.counters_.ipc_messages_, app.seconds_));
+
+            const window_command_stats &ws_commands = app.counters_.ws_commands_;
+
+            report += fmt::format("          \"ws_flushes\": {},\n          \"ws_commands_per_flush\": {:.2f},\n"
+                                  "          \"ws_bytes_per_flush\": {:.1f},\n",
+                ws_commands.flushes_, per_flush(ws_commands.commands_, ws_commands.flushes_),
+                per_flush(ws_commands.bytes_, ws_commands.flushes_));
+
+            report += fmt::format("          \"jit_compile_ms\": {:.3f}\n        }}",
+                static_cast<double>(app.counters_.jit_compile_time_) / 1000000.0);
+        }
+
+        report += res.apps_.empty() ? "]\n    }" : "\n      ]\n    }";
+    }
+
+    report += "\n  ]\n}\n";
+    return report;
+}
+
+int main(int argc, const char **argv) {
+    log::setup_log(nullptr);
+
+    bench_options options;
+    common::arg_parser parser(argc, argv);
+
+    parser.add("--help, -h", "Display helps menu", help_option_handler);
+    parser.add("--device, -dvc", "Firmware code of the device to boot. The device in the configuration is used if not given.",
+        device_option_handler);
+    parser.add("--app, -a", "An app to run: its UID (starting with 0x), name, or absolute virtual path to the executable. Can be repeated.",
+        app_option_handler);
+    parser.add("--cpu, -c", "A CPU backend to run with: dynarmic, dyncom, r12l1 or unicorn. Can be repeated, each gets its own boot. "
+        "All boots share the process, so each reports the process peak RSS and how much it raised it.",
+        cpu_option_handler);
+    parser.add("--seconds, -s", "How long each app runs, in seconds. Default is 10.", seconds_option_handler);
+    parser.add("--output, -o", "Path to write the JSON report to. The report is printed if not given.", output_option_handler);
+    parser.add("--profile, -p", "Sample guest code while each app runs, and write a collapsed stack file (.folded) and a top "
+        "functions report (.txt) per app, named with this prefix, the CPU backend and the app index.", profile_option_handler);
+    parser.add("--software-graphics, -g", "Rasterize 2D graphics on the CPU, instead of dropping them. Slower, but the screen "
+        "content is real. GLES and VG are not supported, apps using them get no EGL.", software_graphics_option_handler);
+
+    std::string err;
+
+    if (!parser.parse(&options, &err)) {
+        if (!err.empty()) {
+            LOG_ERROR(SYSTEM, "{}", err);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    config::state conf;
+    conf.deserialize();
+
+    if (log::filterings) {
+        log::filterings->parse_filter_string(conf.log_filter);
+    }
+
+    config::app_settings settings(&conf);
+
+    if (options.backends_.empty()) {
+        options.backends_.push_back(arm::string_to_arm_emulator_type(conf.cpu_backend));
+    }
+
+    std::vector<backend_result> results;
+
+    for (const arm_emulator_type type : options.backends_) {
+        results.push_back(run_backend(conf, settings, options, type));
+    }
+
+    const std::string report = make_report(options, results);
+
+    if (options.output_path_.empty()) {
+        std::cout << report;
+    } else {
+        FILE *file = common::open_c_file(options.output_path_, "wb");
+
+        if (!file) {
+            LOG_ERROR(SYSTEM, "Unable to open {} to write the report", options.output_path_);
+            return -2;
+        }
+
+        fwrite(report.data(), 1, report.size(), file);
+        fclose(file);
+    }
+
+    for (const backend_result &res : results) {
+        if (!res.booted_) {
+            return -3;
+        }
+    }
+
+    return 0;
+}
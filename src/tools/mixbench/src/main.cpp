@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2021 EKA2L1 Team.
+ *
+ * This file is part of EKA2L1 project.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <common/arghandler.h>
+#include <common/log.h>
+#include <common/pystr.h>
+
+#include <drivers/audio/backend/null/audio_null.h>
+#include <drivers/audio/mixer.h>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace eka2l1;
+
+struct bench_options {
+    std::uint32_t seconds_ = 10;
+};
+
+static constexpr std::uint32_t HOST_SAMPLE_RATE = 48000;
+static constexpr std::size_t HOST_BUFFER_FRAME_COUNT = 1024;
+
+// Rates that games commonly play their DSP streams at
+static const std::uint32_t STREAM_RATES[] = { 8000, 11025, 16000, 22050, 32000, 44100, 48000 };
+static const std::size_t STREAM_COUNTS[] = { 1, 2, 4, 8, 16, 32 };
+
+/**
+ * \brief Mix the given number of sine streams for some seconds of audio.
+ *
+ * \returns Microseconds spent per second of audio, or a negative value if a stream could not be created.
+ */
+static double bench_streams(drivers::audio_driver *driver, const std::size_t stream_count, const std::uint32_t seconds) {
+    drivers::audio_mixer mixer(driver, HOST_SAMPLE_RATE, false);
+    std::vector<std::unique_ptr<drivers::audio_output_stream>> streams;
+
+    for (std::size_t i = 0; i < stream_count; i++) {
+        const std::uint32_t rate = STREAM_RATES[i % (sizeof(STREAM_RATES) / sizeof(std::uint32_t))];
+        const std::uint8_t channels = static_cast<std::uint8_t>((i & 1) + 1);
+
+        double phase = 0.0;
+        const double phase_step = 2.0 * 3.14159265358979 * (220.0 + i * 55.0) / rate;
+
+        streams.push_back(mixer.new_output_stream(rate, channels, [channels, phase, phase_step](std::int16_t *buffer, const std::size_t frame_count) mutable {
+            for (std::size_t frame = 0; frame < frame_count; frame++, phase += phase_step) {
+                const std::int16_t sample = static_cast<std::int16_t>(std::sin(phase) * 8000.0);
+
+                for (std::uint8_t channel = 0; channel < channels; channel++) {
+                    buffer[frame * channels + channel] = sample;
+                }
+            }
+
+            return frame_count;
+        }));
+
+        if (!streams.back()) {
+            return -1.0;
+        }
+
+        streams.back()->set_volume(0.8f);
+        streams.back()->start();
+    }
+
+    std::vector<std::int16_t> output(HOST_BUFFER_FRAME_COUNT * drivers::audio_mixer::CHANNEL_COUNT);
+    const std::size_t buffer_count = seconds * HOST_SAMPLE_RATE / HOST_BUFFER_FRAME_COUNT;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < buffer_count; i++) {
+        mixer.mix(output.data(), HOST_BUFFER_FRAME_COUNT);
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / seconds;
+}
+
+static bool seconds_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    const char *seconds = parser->next_token();
+
+    if (!seconds) {
+        *err = "No second count specified";
+        return false;
+    }
+
+    reinterpret_cast<bench_options *>(userdata)->seconds_ = common::pystr(seconds).as_int<std::uint32_t>(10, 10);
+    return true;
+}
+
+static bool help_option_handler(common::arg_parser *parser, void *userdata, std::string *err) {
+    std::cout << "Usage: mixbench [options]. Mixes sine streams at common DSP rates through the audio mixer." << std::endl;
+    std::cout << parser->get_help_string();
+
+    return false;
+}
+
+int main(int argc, const char **argv) {
+    log::setup_log(nullptr);
+
+    bench_options options;
+    common::arg_parser parser(argc, argv);
+
+    parser.add("--help, -h", "Display helps menu", help_option_handler);
+    parser.add("--seconds, -s", "Seconds of audio to mix for each stream count. Default is 10.", seconds_option_handler);
+
+    std::string err;
+
+    if (!parser.parse(&options, &err)) {
+        if (!err.empty()) {
+            LOG_ERROR(SYSTEM, "{}", err);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    if (options.seconds_ == 0) {
+        LOG_ERROR(SYSTEM, "Can't mix zero seconds of audio");
+        return -1;
+    }
+
+    drivers::null_audio_driver driver;
+
+    for (const std::size_t stream_count : STREAM_COUNTS) {
+        const double us_per_second = bench_streams(&driver, stream_count, options.seconds_);
+
+        if (us_per_second < 0.0) {
+            LOG_ERROR(SYSTEM, "Can't create {} output streams", stream_count);
+            return -1;
+        }
+
+        std::cout << fmt::format("{:>2} streams: {:>10.1f} us per second of audio\n", stream_count, us_per_second);
+    }
+
+    return 0;
+}